@@ -0,0 +1,61 @@
+# Обучающая нагрузка для сборки с профилем выполнения (PGO).
+#
+# Запускается целью pgo-train: cmake -DIMAGE_TRANSFORM=<программа> -DWORK_DIR=<каталог> -P pgo_train.cmake
+# Нагрузка повторяет типичное использование: встроенные замеры ядер на синтетическом изображении,
+# чтение, смена ориентации и запись во всех форматах, вырезание, уменьшение, цветовые операции и фильтры,
+# несколько результатов из одного исходного, сравнение и пакетная обработка.
+# Так профиль покрывает и горячие циклы, и разбор заголовков и выбор ядер.
+cmake_minimum_required(VERSION 3.12)
+
+if (NOT IMAGE_TRANSFORM OR NOT WORK_DIR)
+    message(FATAL_ERROR "Нужны параметры -DIMAGE_TRANSFORM=<программа> и -DWORK_DIR=<каталог>")
+endif ()
+
+file(MAKE_DIRECTORY "${WORK_DIR}")
+# Профиль машины пользователя не должен влиять на выбор ядер при обучении
+set(ENV{IMAGE_TRANSFORM_PROFILE} "${WORK_DIR}/profile")
+file(REMOVE "${WORK_DIR}/profile")
+
+# Синтетический исходный PPM 640x480: пиксельные данные - повторяющийся узор из печатных символов
+set(pattern "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ!#%&()*+,-./:<=>?@^_{|}~")
+math(EXPR pixel_bytes "640 * 480 * 3")
+# Узор удваивается, пока не покроет все пиксели (string(REPEAT) появился только в CMake 3.15)
+set(pixels "${pattern}")
+string(LENGTH "${pixels}" pixels_length)
+while (pixels_length LESS pixel_bytes)
+    set(pixels "${pixels}${pixels}")
+    string(LENGTH "${pixels}" pixels_length)
+endwhile ()
+string(SUBSTRING "${pixels}" 0 ${pixel_bytes} pixels)
+file(WRITE "${WORK_DIR}/source.ppm" "P6\n640 480\n255\n${pixels}")
+
+# Запускает программу и прерывает обучение, если она завершилась с ошибкой
+function(train)
+    execute_process(COMMAND "${IMAGE_TRANSFORM}" ${ARGN} WORKING_DIRECTORY "${WORK_DIR}"
+                    RESULT_VARIABLE result OUTPUT_QUIET ERROR_QUIET)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "Обучающий запуск завершился с кодом ${result}: ${ARGN}")
+    endif ()
+endfunction()
+
+train(--bench 1024x768)
+train(source.ppm source.bmp)
+train(--orient cw90 source.bmp rotated.qoi)
+train(--orient 180 rotated.qoi rotated.bmp)
+train(--orient transpose --format tiff source.bmp rotated.tiff)
+train(--orient none --crop 32,16,320,240 source.bmp cropped.bmp)
+train(--shrink 2 --orient flip-h source.bmp shrunk.bmp)
+train(--resize 1280x0 --filter lanczos source.bmp resized.qoi)
+train(--grayscale --contrast 1.2 --gamma 0.9 --gaussian 1.5 source.bmp filtered.bmp)
+train(--sparse --stats source.bmp sparse.bmp)
+train(--compare source.bmp source.bmp)
+train(source.bmp fanout1.bmp --orient cw90 fanout2.bmp --orient 180 fanout3.bmp --resize 160x0 fanout4.qoi)
+
+file(WRITE "${WORK_DIR}/jobs.txt"
+     "--priority 2 --orient cw90 source.bmp batch1.bmp\n"
+     "--priority 1 --resize 160x0 source.bmp batch2.qoi\n"
+     "--orient flip-v rotated.qoi batch3.bmp\n"
+     "--crop 0,0,100,100 --invert source.ppm batch4.bmp\n")
+train(--batch jobs.txt --workers 2)
+
+message(STATUS "Обучающая нагрузка PGO выполнена в ${WORK_DIR}")
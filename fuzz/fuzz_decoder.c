@@ -0,0 +1,70 @@
+/**
+ * @file fuzz_decoder.c
+ * @brief Цель libFuzzer для разбора заголовков и чтения строк всех входных форматов.
+ *
+ * Входные данные записываются во временный файл, поэтому проверка размера заголовка
+ * по размеру файла (`raster_check_size`, fstat) работает так же, как при чтении с диска.
+ * Для каждого входа читаются заголовок, затем все изображение и центральная область;
+ * строки отбрасываются. Сборка: -DIMAGE_TRANSFORM_FUZZ=ON с Clang (см. README.md).
+ */
+#include "decoder.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define FUZZ_MAX_PIXELS (1ull << 22) // Большие изображения читаются только до заголовка, чтобы вход не занимал секунды
+
+/**
+ * @brief Обработчик строк, отбрасывающий их.
+ */
+static int discard_row(void *ctx, uint64_t y, const struct pixel *row) {
+    (void) ctx;
+    (void) y;
+    (void) row;
+    return 0;
+}
+
+/**
+ * @brief Читает заголовок с начала файла и, если он корректен, строки области.
+ *
+ * @param in Временный файл с входными данными.
+ * @param crop 0 - читать все изображение, 1 - центральную область половинного размера.
+ */
+static void read_file(FILE *in, int crop) {
+    rewind(in);
+    struct image_header header;
+    if (decoder_read_header(in, &header) != READ_OK || header.width == 0 || header.height == 0
+        || header.width > FUZZ_MAX_PIXELS / header.height) {
+        return;
+    }
+    struct image_rect region = {0, 0, header.width, header.height};
+    if (crop) {
+        region.x = header.width / 4;
+        region.y = header.height / 4;
+        region.width = header.width / 2 ? header.width / 2 : 1;
+        region.height = header.height / 2 ? header.height / 2 : 1;
+    }
+    decoder_read_region(in, &header, &region, discard_row, NULL);
+}
+
+/**
+ * @brief Точка входа libFuzzer: обрабатывает один вход.
+ *
+ * @param data Входные данные - содержимое файла изображения.
+ * @param size Размер данных в байтах.
+ * @return Всегда 0.
+ */
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size);
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    FILE *in = tmpfile();
+    if (!in) {
+        return 0;
+    }
+    if (fwrite(data, 1, size, in) == size && fflush(in) == 0) {
+        read_file(in, 0);
+        read_file(in, 1);
+    }
+    fclose(in);
+    return 0;
+}
@@ -0,0 +1,35 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "pipeline.h"
+
+/**
+ * @brief Параметры пакетной обработки.
+ */
+struct batch_options {
+    const char *path;                // Путь к файлу заданий ("-" - стандартный ввод; NULL - режим выключен)
+    unsigned workers;                // Количество потоков (0 - по количеству процессоров)
+    uint64_t memory_budget;          // Бюджет памяти одновременно выполняемых заданий в байтах (0 - без ограничения)
+};
+
+/**
+ * @brief Выполняет задания из файла на планировщике с перехватом работы (см. scheduler.h).
+ *
+ * Каждая непустая строка файла, не начинающаяся с `#`, - одно задание: параметры операций,
+ * исходный и выходной путь через пробелы (пути с пробелами не поддерживаются, стандартные потоки
+ * недоступны). Параметр `--priority N` (0..3, по умолчанию 0) задает приоритет задания: задания
+ * с большим приоритетом начинаются раньше. Параметры, заданные в командной строке, действуют
+ * для всех заданий; параметры строки дополняют их.
+ *
+ * Задания начинают выполняться по мере чтения файла. Память каждого оценивается по заголовку
+ * исходного изображения (`pipeline_memory_estimate`) и учитывается при допуске к выполнению.
+ * В конце в стандартный вывод выводятся количество заданий и ошибок и задержки заданий
+ * от постановки в очередь до завершения по приоритетам.
+ *
+ * @param options Указатель на параметры пакетной обработки.
+ * @param defaults Указатель на операции, заданные в командной строке.
+ * @return 0, если все задания выполнены успешно, или 1, если хотя бы одно не выполнено.
+ */
+int batch_run(const struct batch_options *options, const struct pipeline *defaults);
+
+#endif // BATCH_H
@@ -0,0 +1,58 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "profile.h"
+
+/**
+ * @brief Параметры встроенного измерения производительности.
+ */
+struct bench_options {
+    uint64_t width;                  // Ширина синтетического изображения в пикселях
+    uint64_t height;                 // Высота синтетического изображения в пикселях
+    unsigned repeats;                // Количество повторов каждого замера (берется лучший)
+};
+
+/**
+ * @brief Заполняет параметры измерения значениями по умолчанию.
+ *
+ * @param options Указатель на параметры.
+ */
+void bench_options_init(struct bench_options *options);
+
+/**
+ * @brief Заполняет параметры подбора профиля значениями по умолчанию (изображение меньше, повторов меньше).
+ *
+ * @param options Указатель на параметры.
+ */
+void bench_tune_options_init(struct bench_options *options);
+
+/**
+ * @brief Измеряет скорость основных ядер на синтетическом изображении и выводит таблицу в стандартный вывод.
+ *
+ * Для каждого замера выводится лучшее время из нескольких повторов и пропускная способность памяти:
+ * объем прочитанных и записанных пикселей, деленный на время. Запись в BMP, QOI и TIFF сравнивается по скорости
+ * и размеру файла на сжимаемом изображении, а сравнение изображений измеряется для равных, различающихся
+ * в начале и с подсчетом статистики различий, а также сбор гистограмм каналов и отклонение поддельных файлов,
+ * заголовок которых заявляет изображение больше самого файла. В конце подбирается дальность программной
+ * предвыборки для смены ориентации и выводится лучшая для этой машины.
+ *
+ * @param options Указатель на параметры измерения.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int bench_run(const struct bench_options *options);
+
+/**
+ * @brief Подбирает настройки механизма смены ориентации для текущей машины.
+ *
+ * Настройки перебираются по очереди (набор ядер, сторона тайла, дальность предвыборки, количество потоков,
+ * порог потоковой записи): для каждой выбирается самое быстрое значение при уже подобранных предыдущих.
+ * Таблица замеров выводится в стандартный вывод, подобранный профиль остается примененным.
+ *
+ * @param options Указатель на параметры измерения.
+ * @param profile Указатель на профиль: начальные настройки и результат подбора.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int bench_tune(const struct bench_options *options, struct transform_profile *profile);
+
+#endif // BENCH_H
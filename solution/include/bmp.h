@@ -9,6 +9,8 @@ static const uint16_t BMP_SIGNATURE = 0x4D42;  // Сигнатура файла
 static const uint16_t BMP_BPP = 24;            // Количество бит на пиксель (24 для RGB)
 static const uint32_t BITMAPINFOHEADER_SIZE = 40;
 #define BMP_PADDING 4                          // BMP строки должны быть кратны 4 байтам
+#define BMP_MAX_DIMENSION INT32_MAX            // Ширина и высота в заголовке - знаковые 32-битные числа
+#define BMP_MAX_FILE_SIZE UINT32_MAX           // Больший размер не помещается в поля размера заголовка
 
 // Статусы чтения BMP файла
 enum read_status {
@@ -40,7 +42,12 @@ enum read_status {
     /**
      * Ошибка выделения памяти при загрузке изображения
      */
-    READ_MEMORY_ERROR
+    READ_MEMORY_ERROR,
+
+    /**
+     * Запрошенная область выходит за пределы изображения
+     */
+    READ_INVALID_REGION
 };
 
 // Статусы записи BMP файла
@@ -85,6 +92,19 @@ enum write_status {
  */
 enum read_status bmp_from_file(FILE *in, struct image *img);
 
+/**
+ * @brief Вычисляет размер BMP файла с изображением заданного размера.
+ *
+ * Если размер больше `BMP_MAX_FILE_SIZE`, файл все равно записывается, но поля `bfileSize`
+ * и `biSizeImage` заголовка содержат 0: для несжатого BMP это допустимое значение, и читатели,
+ * включая этот, вычисляют размер данных по ширине и высоте. Для таких изображений лучше подходит TIFF.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Размер файла в байтах или `UINT64_MAX`, если он не помещается в 64 бита.
+ */
+uint64_t bmp_file_size(uint64_t width, uint64_t height);
+
 /**
  * @brief Записывает изображение из структуры `image` в BMP файл.
  *
@@ -94,6 +114,21 @@ enum read_status bmp_from_file(FILE *in, struct image *img);
  */
 enum write_status bmp_to_file(FILE *out, const struct image *img);
 
+/**
+ * @brief Записывает BMP файл, получая строки изображения по одной от источника.
+ *
+ * Строки запрашиваются в порядке их расположения в файле, то есть снизу вверх, поэтому изображение
+ * целиком в памяти не требуется, а запись идет строго последовательно и подходит для каналов.
+ *
+ * @param out Указатель на файл BMP для записи.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return Статус записи, указывающий на успешность операции или тип ошибки.
+ */
+enum write_status bmp_write_rows(FILE *out, uint64_t width, uint64_t height, image_row_source source, void *ctx);
+
 #pragma pack(push, 1)
 // Структура для заголовка BMP файла, соответствующая спецификации BMP
 struct bmp_header {
@@ -115,4 +150,60 @@ struct bmp_header {
 };
 #pragma pack(pop)
 
+/**
+ * @brief Читает и проверяет заголовок BMP файла.
+ *
+ * После успешного чтения размеры изображения известны, а растровые данные еще не прочитаны,
+ * что позволяет заранее выделить память под результат или выбрать нужную область. Размеры уже
+ * сверены с размером файла: заголовок, данные которого выходят за конец файла, отклоняется.
+ *
+ * @param in Указатель на файл BMP для чтения.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения, указывающий на успешность операции или тип ошибки.
+ */
+enum read_status bmp_read_header(FILE *in, struct bmp_header *header);
+
+/**
+ * @brief Дочитывает и проверяет заголовок BMP файла, первые байты которого уже прочитаны.
+ *
+ * Используется, когда формат файла определяется по первым байтам до выбора декодера.
+ *
+ * @param in Указатель на файл BMP, из которого уже прочитаны `prefix_size` байт.
+ * @param prefix Уже прочитанные первые байты файла.
+ * @param prefix_size Количество уже прочитанных байт.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения, указывающий на успешность операции или тип ошибки.
+ */
+enum read_status bmp_read_header_prefixed(FILE *in, const uint8_t *prefix, size_t prefix_size,
+                                          struct bmp_header *header);
+
+/**
+ * @brief Возвращает высоту изображения BMP в пикселях.
+ *
+ * Отрицательная высота в заголовке означает хранение строк сверху вниз, поэтому поле `biHeight`
+ * нельзя использовать как высоту напрямую.
+ *
+ * @param header Указатель на проверенный заголовок файла.
+ * @return Высота изображения в пикселях.
+ */
+uint64_t bmp_image_height(const struct bmp_header *header);
+
+/**
+ * @brief Читает из BMP файла только строки и байты, попадающие в заданную область.
+ *
+ * Строки читаются в порядке их расположения в файле (обычно снизу вверх) позиционным чтением,
+ * без загрузки остальных данных изображения. Каждая прочитанная строка области передается обработчику.
+ * Файлы без позиционного чтения (каналы, стандартный ввод) читаются последовательно от конца заголовка
+ * с пропуском ненужных данных, поэтому поток должен стоять сразу после заголовка.
+ *
+ * @param in Указатель на файл BMP, заголовок которого уже прочитан.
+ * @param header Указатель на прочитанный заголовок файла.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения, указывающий на успешность операции или тип ошибки.
+ */
+enum read_status bmp_read_region(FILE *in, const struct bmp_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx);
+
 #endif // BMP_H
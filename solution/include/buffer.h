@@ -0,0 +1,135 @@
+#ifndef BUFFER_H
+#define BUFFER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Использование больших страниц памяти для буферов изображений.
+ */
+enum buffer_huge_pages {
+    BUFFER_HUGE_PAGES_OFF = 0,       ///< Обычные страницы
+    BUFFER_HUGE_PAGES_TRANSPARENT,   ///< Прозрачные большие страницы (madvise MADV_HUGEPAGE)
+    BUFFER_HUGE_PAGES_EXPLICIT       ///< Явные большие страницы из пула hugetlbfs (MAP_HUGETLB)
+};
+
+/**
+ * @brief Размещение буферов изображений по узлам NUMA.
+ */
+enum buffer_numa {
+    BUFFER_NUMA_OFF = 0,             ///< Страницы получает узел потока, первым обратившегося к ним
+    BUFFER_NUMA_INTERLEAVE,          ///< Страницы чередуются между всеми узлами
+    BUFFER_NUMA_FIRST_TOUCH          ///< Страницы заранее затрагиваются потоками пула по частям буфера
+};
+
+/**
+ * @brief Параметры выделения буферов изображений.
+ */
+struct buffer_options {
+    enum buffer_huge_pages huge_pages; // Использование больших страниц
+    enum buffer_numa numa;           // Размещение по узлам NUMA
+    uint64_t threshold;              // Минимальный размер буфера в байтах, к которому применяются параметры
+    uint64_t memory_budget;          // Бюджет памяти буферов всех выполняемых загрузок в байтах (0 - без ограничения)
+};
+
+/**
+ * @brief Заполняет параметры значениями по умолчанию: обычное выделение памяти.
+ *
+ * @param options Указатель на параметры.
+ */
+void buffer_options_init(struct buffer_options *options);
+
+/**
+ * @brief Задает параметры для последующих выделений буферов.
+ *
+ * Вызывается при запуске программы, до начала работы с изображениями.
+ *
+ * @param options Указатель на параметры.
+ */
+void buffer_configure(const struct buffer_options *options);
+
+/**
+ * @brief Определяет режим больших страниц по имени (`off`, `thp`, `explicit`).
+ *
+ * @param name Имя режима.
+ * @param mode Указатель на результат.
+ * @return 0, если имя известно, или 1 в противном случае.
+ */
+int buffer_huge_pages_from_name(const char *name, enum buffer_huge_pages *mode);
+
+/**
+ * @brief Определяет режим размещения по узлам NUMA по имени (`off`, `interleave`, `first-touch`).
+ *
+ * @param name Имя режима.
+ * @param mode Указатель на результат.
+ * @return 0, если имя известно, или 1 в противном случае.
+ */
+int buffer_numa_from_name(const char *name, enum buffer_numa *mode);
+
+/**
+ * @brief Сообщает учету памяти, сколько байт займут буферы следующей загрузки в текущем потоке.
+ *
+ * Учет памяти считает загрузкой первое выделение в потоке, у которого нет живых буферов. Такое выделение
+ * ждет, пока заявка загрузки - наибольшее из ожидаемого объема и размера буфера - не поместится
+ * в бюджет вместе с заявками уже выполняемых загрузок (или пока их не останется). Следующие выделения
+ * того же потока не ждут, а при необходимости увеличивают его заявку, чтобы начатая обработка
+ * всегда могла закончиться. Каждый буфер помнит заявку своей загрузки, и она снимается при
+ * освобождении последнего буфера загрузки, в каком бы потоке это ни произошло: изображение
+ * можно передать другому потоку.
+ *
+ * @param bytes Ожидаемый объем буферов загрузки (0 - только размер первого буфера).
+ */
+void buffer_expect(uint64_t bytes);
+
+/**
+ * @brief Возвращает бюджет памяти буферов.
+ *
+ * @return Бюджет в байтах (0 - без ограничения).
+ */
+uint64_t buffer_memory_budget(void);
+
+/**
+ * @brief Возвращает наибольший суммарный размер одновременно живых буферов изображений.
+ *
+ * @return Размер в байтах.
+ */
+uint64_t buffer_peak_usage(void);
+
+/**
+ * @brief Возвращает пиковый размер резидентной памяти процесса (peak RSS).
+ *
+ * @return Размер в байтах или 0, если система его не сообщает.
+ */
+uint64_t buffer_peak_rss(void);
+
+/**
+ * @brief Выделяет обнуленный буфер для пикселей изображения.
+ *
+ * Небольшие буферы выделяются из кучи. Буферы не меньше порога при включенных параметрах отображаются
+ * напрямую (mmap) с запрошенными большими страницами и политикой NUMA; если явные большие страницы
+ * недоступны, используются прозрачные. Перед данными хранится заголовок с размером и способом выделения.
+ * Если задан бюджет памяти, выделение учитывается и может ждать освобождения памяти (см. `buffer_expect`).
+ *
+ * @param size Размер буфера в байтах.
+ * @return Указатель на буфер (выровненный не хуже, чем у malloc) или NULL, если выделить память не удалось.
+ */
+void *buffer_alloc(uint64_t size);
+
+/**
+ * @brief Выделяет буфер для пикселей изображения без обнуления.
+ *
+ * Предназначен для результатов, все пиксели которых будут записаны: так не тратится лишний проход
+ * записи нулей по всему буферу. Параметры больших страниц и NUMA применяются так же, как в `buffer_alloc`.
+ *
+ * @param size Размер буфера в байтах.
+ * @return Указатель на буфер (выровненный не хуже, чем у malloc) или NULL, если выделить память не удалось.
+ */
+void *buffer_alloc_uninit(uint64_t size);
+
+/**
+ * @brief Освобождает буфер, выделенный `buffer_alloc` или `buffer_alloc_uninit`.
+ *
+ * @param data Указатель на буфер или NULL.
+ */
+void buffer_free(void *data);
+
+#endif // BUFFER_H
@@ -0,0 +1,75 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CACHE_KEY_LENGTH 32          // Длина ключа кэша в шестнадцатеричных цифрах
+
+/**
+ * @brief Ключ результата в кэше: 128-битный хеш в шестнадцатеричной записи.
+ */
+struct cache_key {
+    char hex[CACHE_KEY_LENGTH + 1];  // Строка ключа, завершенная нулем
+};
+
+/**
+ * @brief Вычисляет ключ кэша по описанию результата.
+ *
+ * Описание должно однозначно определять результат: хеш исходных пикселей, параметры всех операций
+ * и формат файла результата. Ключ состоит из двух хешей XXH64 описания с разными начальными значениями.
+ *
+ * @param key Указатель на заполняемый ключ.
+ * @param data Указатель на описание результата.
+ * @param size Размер описания в байтах.
+ */
+void cache_key_init(struct cache_key *key, const void *data, size_t size);
+
+/**
+ * @brief Ищет в кэше результат с заданным ключом и помещает его по пути назначения.
+ *
+ * Результат по возможности клонируется без копирования данных (reflink), иначе на него
+ * создается жесткая ссылка, иначе он копируется. Прежний файл назначения заменяется.
+ *
+ * @param dir Каталог кэша.
+ * @param key Указатель на ключ результата.
+ * @param dest_path Путь, по которому должен появиться результат.
+ * @return 0, если результат найден и помещен по пути назначения, или 1, если его нет в кэше.
+ */
+int cache_fetch(const char *dir, const struct cache_key *key, const char *dest_path);
+
+/**
+ * @brief Сохраняет записанный результат в кэш под заданным ключом.
+ *
+ * Файл результата клонируется или копируется во временный файл каталога кэша, который затем
+ * атомарно переименовывается, так что параллельные запуски не видят неполных записей.
+ *
+ * @param dir Каталог кэша (создается при необходимости).
+ * @param key Указатель на ключ результата.
+ * @param path Путь к записанному результату.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+int cache_store(const char *dir, const struct cache_key *key, const char *path);
+
+/**
+ * @brief Проверяет, можно ли использовать кэш для файла назначения.
+ *
+ * Кэш применим только к обычным файлам: устройства, каналы и сокеты нельзя ни заменить
+ * ссылкой на запись кэша, ни перечитать после записи.
+ *
+ * @param dest_path Путь к файлу назначения.
+ * @return 1, если файл назначения не существует или является обычным файлом, иначе 0.
+ */
+int cache_accepts(const char *dest_path);
+
+/**
+ * @brief Отделяет файл назначения от записи кэша перед его перезаписью.
+ *
+ * Если файл является жесткой ссылкой на другой файл (например, на запись кэша), он удаляется,
+ * чтобы запись результата не изменила содержимое, общее с кэшем.
+ *
+ * @param path Путь к файлу назначения.
+ */
+void cache_detach(const char *path);
+
+#endif // CACHE_H
@@ -0,0 +1,95 @@
+#ifndef COLOR_H
+#define COLOR_H
+
+#include "image.h"
+#include "transform.h"
+
+/**
+ * @brief Скомпилированная цепочка поэлементных цветовых операций.
+ *
+ * Любая последовательность операций сводится к не более чем трем шагам: таблица преобразования (LUT)
+ * на 256 значений для каждого канала, перевод в оттенки серого и вторая таблица после него.
+ * Таблицы хранятся в порядке каналов `struct pixel` (b, g, r).
+ */
+struct color_ops {
+    int active;                      // Признак того, что цепочка не тождественна
+    int grayscale;                   // Признак перевода в оттенки серого между таблицами
+    uint8_t before[3][256];          // Таблицы каналов до перевода в оттенки серого
+    uint8_t after[3][256];           // Таблицы каналов после перевода в оттенки серого
+    uint16_t weighted[3][256];       // Первые таблицы, умноженные на веса каналов яркости
+};
+
+/**
+ * @brief Инициализирует тождественную цепочку операций.
+ *
+ * @param ops Указатель на цепочку операций.
+ */
+void color_ops_init(struct color_ops *ops);
+
+/**
+ * @brief Добавляет в цепочку перевод в оттенки серого (веса BT.601).
+ *
+ * @param ops Указатель на цепочку операций.
+ * @return 0 при успехе или 1, если после предыдущего перевода каналы уже обрабатываются по-разному.
+ */
+int color_ops_grayscale(struct color_ops *ops);
+
+/**
+ * @brief Добавляет в цепочку инверсию цветов.
+ *
+ * @param ops Указатель на цепочку операций.
+ */
+void color_ops_invert(struct color_ops *ops);
+
+/**
+ * @brief Добавляет в цепочку изменение яркости и контраста: `(v - 128) * contrast + 128 + brightness`.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param brightness Сдвиг яркости (-255..255).
+ * @param contrast Коэффициент контраста (1.0 - без изменений).
+ */
+void color_ops_brightness_contrast(struct color_ops *ops, int brightness, double contrast);
+
+/**
+ * @brief Добавляет в цепочку гамма-коррекцию: `255 * (v / 255) ^ (1 / gamma)`.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param gamma Показатель гаммы (больше 0).
+ */
+void color_ops_gamma(struct color_ops *ops, double gamma);
+
+/**
+ * @brief Добавляет в цепочку произвольные таблицы преобразования каналов.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param lut Таблицы для каналов в порядке r, g, b.
+ */
+void color_ops_lut(struct color_ops *ops, const uint8_t lut[3][256]);
+
+/**
+ * @brief Применяет цепочку операций к подряд идущим пикселям на месте.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param pixels Указатель на первый пиксель.
+ * @param count Количество пикселей.
+ */
+void color_apply_pixels(const struct color_ops *ops, struct pixel *pixels, uint64_t count);
+
+/**
+ * @brief Применяет цепочку операций ко всему изображению на общем пуле потоков.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param img Указатель на изображение.
+ */
+void color_apply_image(const struct color_ops *ops, struct image *img);
+
+/**
+ * @brief Представляет цепочку операций в виде поэлементного шага для совмещения со сменой ориентации.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param stage Указатель на заполняемый шаг.
+ * @return `stage`, если цепочка не тождественна, иначе NULL.
+ */
+const struct pixel_stage *color_ops_stage(const struct color_ops *ops, struct pixel_stage *stage);
+
+#endif // COLOR_H
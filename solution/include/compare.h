@@ -0,0 +1,63 @@
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <stdint.h>
+#include "image.h"
+
+#define COMPARE_ROWS_PER_BAND 64     // Количество строк в полосе, сравниваемой одной порцией пула потоков
+
+/**
+ * @brief Статистика различий двух изображений одинакового размера.
+ *
+ * Сравниваются только пиксели: заголовки файлов и байты выравнивания строк на результат не влияют.
+ */
+struct image_diff {
+    uint64_t pixels;                 // Количество сравненных пикселей
+    uint64_t differing;              // Количество пикселей, отличающихся хотя бы одним каналом
+    uint64_t squared_error;          // Сумма квадратов разностей каналов
+    uint8_t max_diff;                // Наибольшая абсолютная разность канала
+};
+
+/**
+ * @brief Проверяет, совпадают ли изображения попиксельно.
+ *
+ * Полосы строк сравниваются параллельно; как только одна из них находит различие,
+ * остальные прекращают работу, поэтому различающиеся изображения обычно отбрасываются
+ * после сравнения малой их части.
+ *
+ * @param a Указатель на первое изображение.
+ * @param b Указатель на второе изображение.
+ * @return 1, если размеры и все пиксели совпадают, иначе 0.
+ */
+int image_equal(const struct image *a, const struct image *b);
+
+/**
+ * @brief Вычисляет полную статистику различий двух изображений одинакового размера.
+ *
+ * Полосы строк обрабатываются параллельно; совпадающие участки по 16 пикселей отбрасываются
+ * одним сравнением SSE2, а разности накапливаются векторно.
+ *
+ * @param a Указатель на первое изображение.
+ * @param b Указатель на второе изображение.
+ * @param diff Указатель на заполняемую статистику.
+ * @return 0 при успехе или 1, если размеры изображений различаются или не удалось выделить память.
+ */
+int image_compare(const struct image *a, const struct image *b, struct image_diff *diff);
+
+/**
+ * @brief Вычисляет среднеквадратичную ошибку на канал.
+ *
+ * @param diff Указатель на статистику различий.
+ * @return Среднее значение квадрата разности канала.
+ */
+double image_diff_mse(const struct image_diff *diff);
+
+/**
+ * @brief Вычисляет пиковое отношение сигнала к шуму в децибелах.
+ *
+ * @param diff Указатель на статистику различий.
+ * @return PSNR или `INFINITY` для совпадающих изображений.
+ */
+double image_diff_psnr(const struct image_diff *diff);
+
+#endif // COMPARE_H
@@ -0,0 +1,88 @@
+#ifndef DECODER_H
+#define DECODER_H
+
+#include <stdio.h>
+#include "bmp.h"
+#include "image.h"
+#include "pnm.h"
+#include "qoi.h"
+
+#define DECODER_MAGIC_SIZE 4         // Количество первых байт файла, по которым определяется формат
+
+struct image_decoder;
+
+/**
+ * @brief Заголовок исходного изображения любого поддерживаемого формата.
+ */
+struct image_header {
+    const struct image_decoder *decoder; // Декодер, распознавший файл
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    union {
+        struct bmp_header bmp;       // Заголовок BMP
+        struct pnm_header pnm;       // Заголовок PGM, PPM или PAM
+        struct qoi_header qoi;       // Заголовок QOI
+    } format;                        // Заголовок в формате файла
+};
+
+/**
+ * @brief Декодер формата исходных изображений.
+ *
+ * Все декодеры выдают строки по одному контракту `image_row_handler`, поэтому вырезание области,
+ * уменьшение, смена ориентации и хеширование при чтении работают с любым форматом.
+ */
+struct image_decoder {
+    const char *name;                // Имя формата
+    /**
+     * Проверяет сигнатуру по первым `DECODER_MAGIC_SIZE` байтам файла.
+     * Возвращает 1, если файл относится к формату.
+     */
+    int (*sniff)(const uint8_t *magic, size_t size);
+    /**
+     * Дочитывает заголовок после первых `DECODER_MAGIC_SIZE` байт и заполняет размеры изображения.
+     */
+    enum read_status (*read_header)(FILE *in, const uint8_t *magic, size_t size, struct image_header *header);
+    /**
+     * Читает строки области и передает их обработчику (см. `bmp_read_region`).
+     */
+    enum read_status (*read_region)(FILE *in, const struct image_header *header, const struct image_rect *region,
+                                    image_row_handler handler, void *ctx);
+};
+
+/**
+ * @brief Определяет формат файла по первым байтам и читает его заголовок.
+ *
+ * Формат определяется по сигнатуре, а не по расширению, поэтому работает и для стандартного ввода.
+ * Читается только заголовок: размеры известны до чтения пикселей, и результат можно выделить заранее.
+ *
+ * @param in Указатель на файл, стоящий в начале.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения; `READ_INVALID_SIGNATURE`, если формат не распознан.
+ */
+enum read_status decoder_read_header(FILE *in, struct image_header *header);
+
+/**
+ * @brief Читает строки заданной области декодером, распознавшим файл.
+ *
+ * @param in Указатель на файл, заголовок которого прочитан `decoder_read_header`.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status decoder_read_region(FILE *in, const struct image_header *header, const struct image_rect *region,
+                                     image_row_handler handler, void *ctx);
+
+/**
+ * @brief Читает изображение любого поддерживаемого формата целиком.
+ *
+ * Строки записываются прямо в буфер результата, без промежуточной копии всего изображения.
+ *
+ * @param in Указатель на файл, стоящий в начале.
+ * @param img Указатель на структуру `image`, в которую будет загружено изображение.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status decoder_read_image(FILE *in, struct image *img);
+
+#endif // DECODER_H
@@ -0,0 +1,44 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "image.h"
+
+#define FILTER_MAX_RADIUS 1000       // Наибольший радиус ядра; больший радиус переполняет 32-битные суммы окна
+#define FILTER_MAX_AMOUNT 100.0      // Наибольшая сила повышения резкости; при большей насыщается любая разница
+
+/**
+ * @brief Вид фильтра свертки.
+ */
+enum filter_kind {
+    FILTER_BOX_BLUR = 0,     ///< Размытие средним по квадрату (2 * radius + 1)^2
+    FILTER_GAUSSIAN_BLUR,    ///< Размытие по Гауссу с параметром sigma
+    FILTER_UNSHARP_MASK      ///< Повышение резкости нерезким маскированием
+};
+
+/**
+ * @brief Параметры фильтра свертки.
+ */
+struct filter_op {
+    enum filter_kind kind;   // Вид фильтра
+    uint64_t radius;         // Радиус окна для размытия средним (не больше FILTER_MAX_RADIUS)
+    double sigma;            // Параметр Гаусса для размытия и маскирования (ceil(3 * sigma) не больше FILTER_MAX_RADIUS)
+    double amount;           // Сила повышения резкости (1.0 - разница добавляется целиком; от 0 до FILTER_MAX_AMOUNT)
+    uint8_t threshold;       // Минимальная разница с размытым пикселем, при которой резкость повышается
+};
+
+/**
+ * @brief Применяет к изображению фильтр свертки.
+ *
+ * Ядро раскладывается на горизонтальный и вертикальный проходы в целочисленной арифметике.
+ * Изображение обрабатывается тайлами с перекрытием на радиус ядра, которые распределяются
+ * по общему пулу потоков; за границами изображения повторяются крайние пиксели.
+ * Размытие средним использует скользящую сумму, поэтому его стоимость не зависит от радиуса.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param op Указатель на параметры фильтра.
+ * @return Новая структура `image` того же размера. Если радиус ядра больше `FILTER_MAX_RADIUS`,
+ *         сила резкости вне `[0, FILTER_MAX_AMOUNT]` или произошла ошибка, поле `data` равно NULL.
+ */
+struct image filter_image(const struct image *source, const struct filter_op *op);
+
+#endif // FILTER_H
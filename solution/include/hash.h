@@ -0,0 +1,48 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Состояние потокового вычисления хеша XXH64.
+ *
+ * Данные можно передавать порциями произвольной длины; результат совпадает
+ * с хешем всей последовательности, переданной за один раз.
+ */
+struct hash_state {
+    uint64_t total;                  // Общее количество переданных байт
+    uint64_t lanes[4];               // Накопители четырех независимых полос
+    uint8_t buffer[32];              // Неполный блок, ожидающий следующей порции
+    size_t buffered;                 // Количество байт в неполном блоке
+    uint64_t seed;                   // Начальное значение хеша
+};
+
+/**
+ * @brief Начинает вычисление хеша.
+ *
+ * @param state Указатель на состояние хеша.
+ * @param seed Начальное значение хеша.
+ */
+void hash_init(struct hash_state *state, uint64_t seed);
+
+/**
+ * @brief Добавляет к хешируемой последовательности очередную порцию данных.
+ *
+ * @param state Указатель на состояние хеша.
+ * @param data Указатель на данные.
+ * @param size Размер данных в байтах.
+ */
+void hash_update(struct hash_state *state, const void *data, size_t size);
+
+/**
+ * @brief Завершает вычисление и возвращает хеш всех переданных данных.
+ *
+ * Состояние не изменяется, поэтому после вызова можно продолжать добавлять данные.
+ *
+ * @param state Указатель на состояние хеша.
+ * @return 64-битный хеш XXH64.
+ */
+uint64_t hash_digest(const struct hash_state *state);
+
+#endif // HASH_H
@@ -17,6 +17,43 @@ struct image {
     struct pixel *data;      // Указатель на массив данных пикселей изображения
 };
 
+/**
+ * @brief Прямоугольная область изображения.
+ *
+ * Координаты задаются в пикселях относительно левого верхнего угла изображения.
+ */
+struct image_rect {
+    uint64_t x;              // Координата X левого верхнего угла области
+    uint64_t y;              // Координата Y левого верхнего угла области
+    uint64_t width;          // Ширина области в пикселях
+    uint64_t height;         // Высота области в пикселях
+};
+
+/**
+ * @brief Обработчик строки изображения при потоковом чтении.
+ *
+ * Вызывается для каждой прочитанной строки. Строки могут поступать в произвольном порядке
+ * (например, в порядке их расположения в файле), поэтому вместе со строкой передается ее номер.
+ *
+ * @param ctx Пользовательский контекст обработчика.
+ * @param y Номер строки (сверху вниз) в читаемой области.
+ * @param row Указатель на пиксели строки; количество пикселей равно ширине области.
+ * @return 0 при успехе или ненулевое значение, чтобы прервать чтение.
+ */
+typedef int (*image_row_handler)(void *ctx, uint64_t y, const struct pixel *row);
+
+/**
+ * @brief Источник строк изображения при потоковой записи.
+ *
+ * Вызывается для каждой записываемой строки в порядке, который нужен формату файла.
+ *
+ * @param ctx Пользовательский контекст источника.
+ * @param y Номер строки (сверху вниз).
+ * @param row Указатель на буфер, который нужно заполнить пикселями строки.
+ * @return 0 при успехе или ненулевое значение, чтобы прервать запись.
+ */
+typedef int (*image_row_source)(void *ctx, uint64_t y, struct pixel *row);
+
 /**
  * @brief Создает изображение с указанной шириной и высотой.
  *
@@ -28,6 +65,19 @@ struct image {
  */
 struct image create_image(uint64_t width, uint64_t height);
 
+/**
+ * @brief Создает изображение, не инициализируя пиксели.
+ *
+ * Предназначена для операций, которые записывают каждый пиксель результата (чтение файла, смена
+ * ориентации, изменение размера, фильтры): так не тратится отдельный проход записи нулей.
+ * Читать пиксели до их записи нельзя.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Структура `image`, содержащая информацию о новом изображении.
+ */
+struct image create_image_uninit(uint64_t width, uint64_t height);
+
 /**
  * @brief Уничтожает изображение и освобождает память.
  *
@@ -50,4 +100,14 @@ void destroy_image(struct image *img);
  */
 struct pixel *image_pixel(const struct image *img, uint64_t x, uint64_t y);
 
+/**
+ * @brief Проверяет, что прямоугольная область целиком лежит внутри изображения заданного размера.
+ *
+ * @param region Указатель на проверяемую область.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return 1, если область непустая и не выходит за границы изображения, иначе 0.
+ */
+int image_rect_fits(const struct image_rect *region, uint64_t width, uint64_t height);
+
 #endif // IMAGE_H
@@ -2,11 +2,52 @@
 #define IMAGE_IO_H
 
 #include "image.h"
+#include "stats.h"
+#include "transform.h"
+#include "uniform.h"
+
+/**
+ * @brief Формат записываемого изображения.
+ */
+enum image_format {
+    IMAGE_FORMAT_AUTO = 0,         ///< По расширению пути: `.qoi` - QOI, `.tif`/`.tiff` - TIFF, иначе BMP
+    IMAGE_FORMAT_BMP,              ///< BMP без сжатия, 24 бита на пиксель
+    IMAGE_FORMAT_QOI,              ///< QOI: сжатие без потерь, параллельное кодирование
+    IMAGE_FORMAT_TIFF,             ///< TIFF без сжатия; BigTIFF для файлов больше 4 ГиБ
+    IMAGE_FORMAT_COUNT
+};
+
+/**
+ * @brief Способ обработки строк при чтении области изображения.
+ */
+struct region_consumer {
+    /**
+     * Подготавливает результат, когда размер читаемой области уже известен.
+     * Возвращает 0 при успехе или 1, если не удалось выделить память.
+     */
+    int (*prepare)(void *ctx, const struct image_rect *region);
+    image_row_handler handler;       // Обработчик строк области
+    void (*finish)(void *ctx);       // Освобождает служебные данные (может быть NULL)
+    void *ctx;                       // Контекст обработчика
+};
+
+/**
+ * @brief Проверяет, обозначает ли путь стандартный поток ввода или вывода.
+ *
+ * Путь "-" в функциях чтения означает стандартный ввод, в функциях записи - стандартный вывод.
+ * Стандартный ввод читается последовательно, без перемещения по файлу, поэтому изображение можно
+ * передавать через канал.
+ *
+ * @param path Путь к файлу.
+ * @return 1, если путь равен "-", иначе 0.
+ */
+int image_path_is_stream(const char *path);
 
 /**
  * @brief Читает изображение из указанного файла.
  *
  * Открывает файл по указанному пути и загружает данные изображения в предоставленную структуру `image`.
+ * Формат файла (BMP, PGM/PPM/PAM или QOI) определяется по сигнатуре (см. decoder.h).
  * Если операция успешна, функция возвращает 0. При ошибке возвращается ненулевое значение.
  *
  * @param source_path Путь к файлу, из которого необходимо прочитать изображение.
@@ -15,6 +56,19 @@
  */
 int read_image(const char *source_path, struct image *img);
 
+/**
+ * @brief Читает только заголовок изображения и возвращает его размеры.
+ *
+ * Позволяет оценить память, нужную для обработки, до чтения пикселей. Сообщение об ошибке не выводится:
+ * ее сообщит последующее чтение изображения.
+ *
+ * @param source_path Путь к файлу изображения (не стандартный ввод).
+ * @param width Указатель, по которому будет записана ширина.
+ * @param height Указатель, по которому будет записана высота.
+ * @return 0, если заголовок прочитан, или 1 в случае ошибки.
+ */
+int read_image_size(const char *source_path, uint64_t *width, uint64_t *height);
+
 /**
  * @brief Записывает изображение в указанный файл.
  *
@@ -27,4 +81,149 @@ int read_image(const char *source_path, struct image *img);
  */
 int write_image(const char *dest_path, const struct image *img);
 
+/**
+ * @brief Записывает изображение в указанный файл в заданном формате.
+ *
+ * @param dest_path Путь к файлу, в который необходимо записать изображение.
+ * @param img Указатель на структуру `image`, данные которой необходимо записать в файл.
+ * @param format Формат файла; `IMAGE_FORMAT_AUTO` - по расширению пути.
+ * @return 0, если запись прошла успешно, или ненулевое значение в случае ошибки.
+ */
+int write_image_format(const char *dest_path, const struct image *img, enum image_format format);
+
+/**
+ * @brief Определяет формат, в котором будет записан файл.
+ *
+ * @param dest_path Путь к файлу.
+ * @param format Запрошенный формат; `IMAGE_FORMAT_AUTO` заменяется форматом по расширению пути.
+ * @return Формат файла (не `IMAGE_FORMAT_AUTO`).
+ */
+enum image_format image_format_resolve(const char *dest_path, enum image_format format);
+
+/**
+ * @brief Находит формат изображения по его имени.
+ *
+ * Допустимые имена: `auto`, `bmp`, `qoi`, `tiff`.
+ *
+ * @param name Имя формата.
+ * @param format Указатель, по которому будет записан найденный формат.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int image_format_from_name(const char *name, enum image_format *format);
+
+/**
+ * @brief Возвращает имя формата изображения.
+ *
+ * @param format Формат изображения.
+ * @return Имя формата или "unknown" для некорректного значения.
+ */
+const char *image_format_name(enum image_format format);
+
+/**
+ * @brief Сведения о пикселях, собираемые в том же проходе, что и чтение области.
+ *
+ * Каждое поле может быть NULL, если соответствующие сведения не нужны.
+ */
+struct read_observers {
+    uint64_t *digest;                // Хеш XXH64 размеров и пикселей области
+    struct image_stats *stats;       // Статистика пикселей области
+    struct uniform_tiles *tiles;     // Карта однотонных тайлов области; освобождается при ошибке чтения
+    uint64_t tile;                   // Сторона тайлов карты в пикселях
+};
+
+/**
+ * @brief Читает из указанного файла только заданную область изображения.
+ *
+ * С диска читаются лишь строки и байты, попадающие в область, поэтому объем ввода-вывода
+ * пропорционален площади области, а не всего изображения.
+ *
+ * @param source_path Путь к файлу, из которого необходимо прочитать область.
+ * @param region Указатель на читаемую область изображения.
+ * @param img Указатель на структуру `image`, в которую будет загружена область.
+ * @return 0, если чтение прошло успешно, или ненулевое значение в случае ошибки.
+ */
+int read_image_region(const char *source_path, const struct image_rect *region, struct image *img);
+
+/**
+ * @brief Читает область изображения из файла и сразу приводит ее к заданной ориентации.
+ *
+ * Строки области по мере чтения помещаются в результат в нужной ориентации, так что ни исходное изображение,
+ * ни вырезанная область целиком в памяти не хранятся. По запросу в том же проходе вычисляются
+ * хеш XXH64 размеров и пикселей области, пригодный для поиска результата в кэше, статистика пикселей
+ * и карта однотонных тайлов.
+ *
+ * @param source_path Путь к файлу, из которого необходимо прочитать область.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param orientation Ориентация результата.
+ * @param img Указатель на структуру `image`, в которую будет записан результат.
+ * @param observers Указатель на сведения о прочитанных пикселях или NULL, если они не нужны.
+ * @return 0, если чтение прошло успешно, или ненулевое значение в случае ошибки.
+ */
+int read_image_region_oriented(const char *source_path, const struct image_rect *region,
+                               enum orientation orientation, struct image *img,
+                               const struct read_observers *observers);
+
+/**
+ * @brief Читает изображение из файла, уменьшая его в целое число раз прямо во время чтения.
+ *
+ * Каждый блок `factor` x `factor` пикселей усредняется по мере поступления строк,
+ * поэтому в памяти хранится только уменьшенный результат.
+ *
+ * @param source_path Путь к файлу, из которого необходимо прочитать изображение.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param factor Коэффициент уменьшения (не меньше 1).
+ * @param orientation Ориентация результата.
+ * @param img Указатель на структуру `image`, в которую будет записан результат.
+ * @param observers Указатель на сведения о прочитанных (еще не уменьшенных) пикселях или NULL.
+ * @return 0, если чтение прошло успешно, или ненулевое значение в случае ошибки.
+ */
+int read_image_shrunk(const char *source_path, const struct image_rect *region, uint64_t factor,
+                      enum orientation orientation, struct image *img, const struct read_observers *observers);
+
+/**
+ * @brief Читает строки области изображения и передает их заданному обработчику.
+ *
+ * Изображение целиком в памяти не создается: после чтения заголовка вызывается `prepare`, затем
+ * каждая строка области передается обработчику в порядке ее расположения в файле.
+ *
+ * @param source_path Путь к файлу, из которого необходимо прочитать область.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param consumer Способ обработки строк области.
+ * @return 0, если чтение прошло успешно, или ненулевое значение в случае ошибки.
+ */
+int read_image_rows(const char *source_path, const struct image_rect *region, const struct region_consumer *consumer);
+
+/**
+ * @brief Проверяет, можно ли записать изображение в формате построчно (см. `write_image_rows`).
+ *
+ * @param format Формат файла (не `IMAGE_FORMAT_AUTO`).
+ * @return 1 для BMP и TIFF, иначе 0.
+ */
+int image_format_streams_rows(enum image_format format);
+
+/**
+ * @brief Проверяет, расположены ли строки в файле формата снизу вверх.
+ *
+ * @param format Формат файла (не `IMAGE_FORMAT_AUTO`).
+ * @return 1 для BMP, иначе 0.
+ */
+int image_format_bottom_up(enum image_format format);
+
+/**
+ * @brief Записывает изображение в BMP или TIFF файл, получая его строки по одной от источника.
+ *
+ * Строки запрашиваются в порядке их расположения в файле (для BMP - снизу вверх, для TIFF - сверху вниз),
+ * поэтому изображение целиком в памяти не требуется.
+ *
+ * @param dest_path Путь к файлу, в который необходимо записать изображение.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param format Формат файла; `IMAGE_FORMAT_AUTO` - по расширению пути.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return 0, если запись прошла успешно, или ненулевое значение в случае ошибки.
+ */
+int write_image_rows(const char *dest_path, uint64_t width, uint64_t height, enum image_format format,
+                     image_row_source source, void *ctx);
+
 #endif // IMAGE_IO_H
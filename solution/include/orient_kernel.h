@@ -0,0 +1,93 @@
+#ifndef ORIENT_KERNEL_H
+#define ORIENT_KERNEL_H
+
+#include "transform.h"
+
+#define TRANSFORM_TILE_SIZE 64   // Сторона тайла по умолчанию: тайл источника и результата помещаются в L1
+
+/**
+ * @brief Список ориентаций с параметрами их ядер.
+ *
+ * Для каждой ориентации задаются имя ядра, значение перечисления, признак обхода тайла по столбцам
+ * (ориентация меняет оси местами) и признак обратного направления записи: для построчного обхода -
+ * справа налево (`step_x < 0`), для обхода по столбцам - снизу вверх (`step_y < 0`).
+ * Из списка генерируются специализированные ядра и таблица выбора (см. orient_kernel.inc).
+ */
+#define ORIENT_KERNEL_LIST(X) \
+    X(none,       ORIENTATION_NONE,            0, 0) \
+    X(ccw90,      ORIENTATION_ROTATE_90_CCW,   1, 0) \
+    X(rotate180,  ORIENTATION_ROTATE_180,      0, 1) \
+    X(cw90,       ORIENTATION_ROTATE_90_CW,    1, 1) \
+    X(flip_h,     ORIENTATION_FLIP_HORIZONTAL, 0, 1) \
+    X(flip_v,     ORIENTATION_FLIP_VERTICAL,   0, 0) \
+    X(transpose,  ORIENTATION_TRANSPOSE,       1, 0) \
+    X(transverse, ORIENTATION_TRANSVERSE,      1, 1)
+
+struct orient_job;
+struct uniform_tiles;
+
+/**
+ * @brief Ядро, переносящее один тайл источника `[x0, x1) x [y0, y1)` в результат.
+ */
+typedef void (*orient_kernel)(const struct orient_job *job, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1);
+
+/**
+ * @brief Параметры переноса области изображения в результат, общие для всех тайлов.
+ */
+struct orient_job {
+    const struct pixel *source;      // Левый верхний пиксель области источника
+    uint64_t source_stride;          // Расстояние между строками источника в пикселях
+    uint64_t width;                  // Ширина области в пикселях
+    uint64_t height;                 // Высота области в пикселях
+    struct pixel *dest;              // Пиксели результата
+    struct orientation_map map;      // Отображение координат области в результат
+    const struct pixel_stage *stage; // Поэлементная операция над результатом (может быть NULL)
+    int stream;                      // Признак записи результата в обход кэша
+    uint64_t prefetch;               // Дальность программной предвыборки (0 - без предвыборки)
+    uint64_t tile;                   // Сторона тайла в пикселях
+    orient_kernel kernel;            // Специализированное ядро для ориентации и способа записи
+    const struct uniform_tiles *uniform; // Карта однотонных тайлов области с той же стороной тайла (может быть NULL)
+};
+
+/**
+ * @brief Проверяет, может ли текущий процессор выполнять ядра заданного набора.
+ *
+ * @param kernels Набор ядер (не `ORIENT_KERNELS_AUTO`).
+ * @return 1, если набор собран и поддерживается процессором, иначе 0.
+ */
+int orient_kernels_supported(enum orient_kernels kernels);
+
+/**
+ * @brief Находит специализированное ядро для набора, ориентации и способа записи.
+ *
+ * @param kernels Поддерживаемый набор ядер (не `ORIENT_KERNELS_AUTO`).
+ * @param orientation Ориентация результата.
+ * @param stream Признак записи результата в обход кэша.
+ * @return Указатель на ядро.
+ */
+orient_kernel orient_kernel_find(enum orient_kernels kernels, enum orientation orientation, int stream);
+
+/**
+ * @brief Заполняет место тайла источника `[x0, x1) x [y0, y1)` в результате одним цветом.
+ *
+ * Заменяет перенос однотонного тайла: пиксели источника не читаются, а результат записывается
+ * непрерывными отрезками. Поэлементная операция задания применяется к цвету один раз.
+ *
+ * @param job Параметры переноса.
+ * @param x0 Первый столбец тайла.
+ * @param y0 Первая строка тайла.
+ * @param x1 Столбец, следующий за последним.
+ * @param y1 Строка, следующая за последней.
+ * @param color Цвет всех пикселей тайла.
+ */
+void orient_fill_tile(const struct orient_job *job, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1,
+                      struct pixel color);
+
+/**
+ * @brief Завершает потоковую запись, сделанную ядрами в текущем потоке.
+ *
+ * Невременные записи должны стать видимы до того, как пул потоков сообщит о завершении порции.
+ */
+void orient_kernel_fence(void);
+
+#endif // ORIENT_KERNEL_H
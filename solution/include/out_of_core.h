@@ -0,0 +1,37 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+
+#include <stdint.h>
+#include "color.h"
+#include "image.h"
+#include "image_io.h"
+#include "transform.h"
+
+#define OUT_OF_CORE_TILE_SIZE 256    // Сторона тайла во временном файле: 192 КиБ на тайл, крупные блоки ввода-вывода
+#define OUT_OF_CORE_MIN_CACHE_MB 1   // Минимальный размер кэша тайлов в мегабайтах
+
+/**
+ * @brief Вырезает область, меняет ориентацию и применяет цветовые операции, не храня изображение в памяти целиком.
+ *
+ * Предназначена для изображений больше оперативной памяти. Строки исходной области раскладываются
+ * по квадратным тайлам, которые хранятся в кэше LRU ограниченного размера и вытесняются во временный
+ * файл в каталоге `$TMPDIR`. Затем строки результата собираются из тайлов и сразу записываются в BMP или TIFF.
+ * Места тайлов во временном файле назначаются в том порядке, в котором их будет читать запись результата,
+ * поэтому и раскладка, и сборка обращаются к файлу почти последовательно.
+ *
+ * Кэш должен вмещать хотя бы одну полосу тайлов вдоль строки источника и вдоль строки результата;
+ * меньший размер увеличивается до этого минимума с предупреждением.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному файлу ("-" - стандартный вывод).
+ * @param format Формат результата, допускающий построчную запись (см. `image_format_streams_rows`).
+ * @param region Указатель на вырезаемую область или NULL для всего изображения.
+ * @param orientation Ориентация результата.
+ * @param color Цветовые операции над результатом.
+ * @param cache_bytes Размер кэша тайлов в байтах.
+ * @return 0, если преобразование выполнено успешно, или 1 в случае ошибки.
+ */
+int out_of_core_transform(const char *source_path, const char *dest_path, enum image_format format,
+                          const struct image_rect *region, enum orientation orientation, const struct color_ops *color, uint64_t cache_bytes);
+
+#endif // OUT_OF_CORE_H
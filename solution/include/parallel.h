@@ -0,0 +1,71 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+/**
+ * @brief Функция, обрабатывающая диапазон элементов параллельного цикла.
+ *
+ * @param ctx Пользовательский контекст цикла.
+ * @param begin Индекс первого элемента диапазона.
+ * @param end Индекс, следующий за последним элементом диапазона.
+ */
+typedef void (*parallel_range_fn)(void *ctx, uint64_t begin, uint64_t end);
+
+/**
+ * @brief Способ выполнения параллельного цикла, заменяющий общий пул в отдельном потоке.
+ *
+ * @param executor Контекст, заданный `parallel_set_executor`.
+ * @param count Количество элементов (больше `grain`).
+ * @param grain Размер порции элементов (не меньше 1).
+ * @param fn Функция, обрабатывающая диапазон элементов.
+ * @param ctx Контекст, передаваемый функции.
+ */
+typedef void (*parallel_executor)(void *executor, uint64_t count, uint64_t grain, parallel_range_fn fn, void *ctx);
+
+/**
+ * @brief Выполняет цикл по элементам `[0, count)` на общем пуле потоков.
+ *
+ * Элементы раздаются потокам порциями по `grain` штук; вызывающий поток также участвует в работе.
+ * Функция возвращает управление, когда обработаны все элементы. Вложенные вызовы из потоков пула
+ * выполняются последовательно в вызывающем потоке. Если для вызывающего потока задан свой способ
+ * выполнения (`parallel_set_executor`), цикл передается ему.
+ *
+ * @param count Количество элементов.
+ * @param grain Размер порции элементов (0 трактуется как 1).
+ * @param fn Функция, обрабатывающая диапазон элементов.
+ * @param ctx Контекст, передаваемый функции.
+ */
+void parallel_for(uint64_t count, uint64_t grain, parallel_range_fn fn, void *ctx);
+
+/**
+ * @brief Возвращает количество потоков, участвующих в параллельных циклах.
+ *
+ * По умолчанию равно количеству доступных процессоров; может быть переопределено переменной
+ * окружения `IMAGE_TRANSFORM_THREADS`.
+ *
+ * @return Количество потоков, включая вызывающий.
+ */
+unsigned parallel_thread_count(void);
+
+/**
+ * @brief Задает количество потоков для последующих параллельных циклов.
+ *
+ * Недостающие потоки пула создаются при следующем вызове `parallel_for`; лишние простаивают.
+ *
+ * @param count Количество потоков, включая вызывающий (0 означает значение по умолчанию).
+ */
+void parallel_set_thread_count(unsigned count);
+
+/**
+ * @brief Задает для текущего потока способ выполнения параллельных циклов вместо общего пула.
+ *
+ * Так планировщик пакетной обработки (см. scheduler.h) превращает циклы внутри задачи в порции,
+ * которые могут выполнить другие его потоки.
+ *
+ * @param executor Способ выполнения или NULL, чтобы вернуться к общему пулу.
+ * @param ctx Контекст, передаваемый способу выполнения.
+ */
+void parallel_set_executor(parallel_executor executor, void *ctx);
+
+#endif // PARALLEL_H
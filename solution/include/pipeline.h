@@ -0,0 +1,142 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <stdio.h>
+#include "color.h"
+#include "filter.h"
+#include "image.h"
+#include "image_io.h"
+#include "resize.h"
+#include "transform.h"
+
+#define PIPELINE_MAX_FILTERS 8   // Максимальное количество фильтров свертки в одной цепочке
+#define PIPELINE_MAX_OUTPUTS ORIENT_MAX_OUTPUTS // Максимальное количество результатов одного исходного изображения
+
+/**
+ * @brief Описание последовательности операций над изображением.
+ *
+ * Операции выполняются в фиксированном порядке: вырезание области, уменьшение при чтении,
+ * изменение размера, смена ориентации, цветовые операции и фильтры свертки. Соседние операции
+ * по возможности объединяются в один проход. Результат записывается в BMP, QOI или TIFF.
+ */
+struct pipeline {
+    struct image_rect region;        // Вырезаемая область исходного изображения
+    int has_region;                  // Признак того, что область задана
+    uint64_t shrink;                 // Коэффициент уменьшения при чтении (1 - без уменьшения)
+    uint64_t width;                  // Ширина результата (0 - по пропорциям высоты)
+    uint64_t height;                 // Высота результата (0 - по пропорциям ширины)
+    int has_resize;                  // Признак того, что задано изменение размера
+    enum resize_filter filter;       // Фильтр изменения размера
+    enum orientation orientation;    // Ориентация результата
+    struct color_ops color;          // Цветовые операции в порядке их указания
+    struct filter_op filters[PIPELINE_MAX_FILTERS]; // Фильтры свертки в порядке их указания
+    int filter_count;                // Количество фильтров свертки
+    enum image_format format;        // Формат результата
+    const char *cache_dir;           // Каталог кэша результатов или NULL, если кэш не используется
+    uint64_t out_of_core;            // Размер кэша тайлов в байтах при обработке без загрузки в память (0 - выключено)
+    int stats;                       // Признак вывода статистики исходных пикселей, собранной при чтении
+    int sparse;                      // Признак поиска однотонных тайлов при чтении и их заполнения цветом
+};
+
+/**
+ * @brief Результат, получаемый из общего исходного изображения: свои операции и путь назначения.
+ */
+struct pipeline_output {
+    struct pipeline pipeline;        // Операции результата
+    const char *dest_path;           // Путь к выходному изображению
+};
+
+/**
+ * @brief Заполняет описание операциями по умолчанию (поворот на 90 градусов против часовой стрелки).
+ *
+ * Каталог кэша результатов по умолчанию берется из переменной окружения `IMAGE_TRANSFORM_CACHE`.
+ *
+ * @param pipeline Указатель на описание операций.
+ */
+void pipeline_init(struct pipeline *pipeline);
+
+/**
+ * @brief Разбирает параметр командной строки, относящийся к операциям над изображением.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param argc Количество аргументов командной строки.
+ * @param argv Массив строк с аргументами командной строки.
+ * @param arg Указатель на индекс текущего аргумента; при успехе сдвигается за разобранный параметр.
+ * @return 0, если параметр разобран; 1, если значение параметра некорректно (сообщение уже выведено);
+ *         -1, если параметр не относится к операциям над изображением.
+ */
+int pipeline_parse_option(struct pipeline *pipeline, int argc, char *argv[], int *arg);
+
+/**
+ * @brief Выводит в поток описание параметров операций над изображением.
+ *
+ * @param out Поток для вывода.
+ */
+void pipeline_print_usage(FILE *out);
+
+/**
+ * @brief Оценивает память, которую займут буферы изображений при выполнении операций.
+ *
+ * Учитываются прочитанное изображение (после вырезания и уменьшения), результат изменения размера
+ * или смены ориентации и буфер фильтров; в режиме `--out-of-core` - размер кэша тайлов.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param width Ширина исходного изображения.
+ * @param height Высота исходного изображения.
+ * @return Оценка в байтах.
+ */
+uint64_t pipeline_memory_estimate(const struct pipeline *pipeline, uint64_t width, uint64_t height);
+
+/**
+ * @brief Читает исходное изображение, выполняет над ним операции и записывает результат.
+ *
+ * Если задан каталог кэша, при чтении вычисляется хеш исходных пикселей. Когда результат с тем же
+ * хешем и теми же операциями уже есть в кэше, он помещается по пути назначения без вычислений,
+ * иначе записанный результат добавляется в кэш.
+ *
+ * С параметром `--stats` гистограммы, минимум, максимум и среднее каналов исходных пикселей собираются
+ * в проходе чтения и выводятся в стандартный вывод (в стандартный поток ошибок, если результат пишется
+ * в стандартный вывод).
+ *
+ * С параметром `--sparse` при чтении всего изображения строится карта однотонных тайлов (см. uniform.h),
+ * и при смене ориентации такие тайлы заполняются цветом вместо переноса пикселей.
+ *
+ * Если задан режим `--out-of-core`, изображение не загружается в память целиком (см. out_of_core.h);
+ * в этом режиме доступны только вырезание, смена ориентации и цветовые операции с записью в BMP или TIFF,
+ * а кэш результатов не используется.
+ *
+ * Если задан бюджет памяти буферов (см. `buffer_expect`), загрузка ждет, пока оценка ее памяти
+ * не поместится в бюджет; изображение, которое одно больше бюджета, при допустимых операциях
+ * обрабатывается в режиме без загрузки в память с кэшем тайлов в половину бюджета.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному изображению.
+ * @return 0, если все операции выполнены успешно, или 1 в случае ошибки.
+ */
+int pipeline_run(const struct pipeline *pipeline, const char *source_path, const char *dest_path);
+
+/**
+ * @brief Строит несколько результатов из одного исходного изображения, прочитав и разобрав его один раз.
+ *
+ * Результаты с той же областью и тем же уменьшением при чтении, что и у первого результата, получаются
+ * из одного прочитанного изображения. Все такие результаты без изменения размера строятся одним обходом
+ * тайлов (`orient_region_fanout`): каждый тайл источника, пока он в кэше, переносится во все результаты
+ * со своей ориентацией и цветовыми операциями. Результаты с изменением размера строятся из того же
+ * изображения в памяти, фильтры и запись выполняются для каждого результата отдельно. Статистика
+ * с `--stats` выводится один раз, кэш результатов проверяется для каждого результата.
+ *
+ * Все результаты общего чтения находятся в памяти одновременно. Результаты с другой областью, другим
+ * уменьшением или с `--out-of-core` выполняются отдельно через `pipeline_run`, что недопустимо для
+ * стандартного ввода. Если задан бюджет памяти и общее чтение в него не помещается, из него
+ * исключаются результаты, которые можно обработать без загрузки в память: они тоже выполняются
+ * отдельно и при необходимости переходят в режим `--out-of-core`.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param outputs Результаты: операции и пути назначения.
+ * @param count Количество результатов (от 1 до `PIPELINE_MAX_OUTPUTS`).
+ * @return 0, если все результаты записаны, или 1, если хотя бы один не записан.
+ */
+int pipeline_run_outputs(const char *source_path, const struct pipeline_output *outputs, size_t count);
+
+#endif // PIPELINE_H
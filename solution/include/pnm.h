@@ -0,0 +1,61 @@
+#ifndef PNM_H
+#define PNM_H
+
+#include <stdio.h>
+#include "bmp.h"
+#include "image.h"
+
+#define PNM_MAX_DIMENSION UINT32_MAX // Максимальная ширина и высота изображения
+
+/**
+ * @brief Заголовок изображения PGM (P5), PPM (P6) или PAM (P7).
+ */
+struct pnm_header {
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    uint32_t depth;                  // Количество каналов: 1 - серый, 2 - серый с альфой, 3 - RGB, 4 - RGBA
+    uint32_t maxval;                 // Максимальное значение канала (1..65535; больше 255 - два байта на канал)
+    uint64_t data_offset;            // Смещение пиксельных данных от начала файла в байтах
+};
+
+/**
+ * @brief Проверяет, похожи ли первые байты файла на заголовок PGM, PPM или PAM в двоичной форме.
+ *
+ * @param magic Первые байты файла.
+ * @param size Количество байт (не меньше 3).
+ * @return 1, если сигнатура распознана, иначе 0.
+ */
+int pnm_sniff(const uint8_t *magic, size_t size);
+
+/**
+ * @brief Дочитывает и проверяет текстовый заголовок PGM, PPM или PAM, первые байты которого уже прочитаны.
+ *
+ * После успешного чтения поток стоит на первом байте пиксельных данных. Заголовок, данные которого
+ * не помещаются в файл, отклоняется до выделения памяти (см. `raster_check_size`).
+ *
+ * @param in Указатель на файл для чтения.
+ * @param prefix Уже прочитанные первые байты файла.
+ * @param prefix_size Количество уже прочитанных байт.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения (`READ_OK`, `READ_INVALID_HEADER`, `READ_INVALID_BITS`, и т.д.).
+ */
+enum read_status pnm_read_header(FILE *in, const uint8_t *prefix, size_t prefix_size, struct pnm_header *header);
+
+/**
+ * @brief Читает строки заданной области и передает их обработчику.
+ *
+ * Строки хранятся сверху вниз без выравнивания, поэтому читаются так же, как строки BMP: позиционно
+ * только байты области или последовательно из канала. Серые изображения разворачиваются в RGB,
+ * альфа-канал отбрасывается, значения с другим `maxval` приводятся к диапазону 0..255.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status pnm_read_region(FILE *in, const struct pnm_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx);
+
+#endif // PNM_H
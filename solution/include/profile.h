@@ -0,0 +1,72 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "transform.h"
+
+#define PROFILE_VERSION 1            // Версия формата файла профиля
+
+/**
+ * @brief Настройки механизма смены ориентации, подбираемые под конкретную машину.
+ */
+struct transform_profile {
+    uint64_t tile_size;              // Сторона тайла в пикселях
+    unsigned threads;                // Количество потоков (0 - по умолчанию)
+    uint64_t prefetch_distance;      // Дальность программной предвыборки (0 - без предвыборки)
+    uint64_t stream_threshold;       // Порог потоковой записи в байтах (0 - размер кэша, UINT64_MAX - выключена)
+    enum orient_kernels kernels;     // Набор специализированных ядер
+};
+
+/**
+ * @brief Заполняет профиль действующими настройками механизма смены ориентации.
+ *
+ * @param profile Указатель на профиль.
+ */
+void profile_capture(struct transform_profile *profile);
+
+/**
+ * @brief Применяет настройки профиля ко всему процессу.
+ *
+ * @param profile Указатель на профиль.
+ * @return 0 при успехе или 1, если набор ядер профиля не поддерживается (остальные настройки применяются).
+ */
+int profile_apply(const struct transform_profile *profile);
+
+/**
+ * @brief Определяет путь к файлу профиля.
+ *
+ * Путь берется из переменной окружения `IMAGE_TRANSFORM_PROFILE`, иначе это
+ * `$XDG_CONFIG_HOME/image_transform/profile` или `$HOME/.config/image_transform/profile`.
+ *
+ * @param path Буфер для пути.
+ * @param size Размер буфера в байтах.
+ * @return 0, если путь определен, или 1, если его не из чего построить или он не помещается в буфер.
+ */
+int profile_default_path(char *path, size_t size);
+
+/**
+ * @brief Читает профиль из файла.
+ *
+ * Файл состоит из строк `ключ=значение`; пустые строки и строки, начинающиеся с `#`, пропускаются.
+ * Неизвестные ключи игнорируются, отсутствующие оставляют прежние значения в `profile`.
+ *
+ * @param path Путь к файлу профиля.
+ * @param profile Указатель на профиль, дополняемый прочитанными значениями.
+ * @return 0 при успехе; 1, если файла нет; -1, если файл поврежден (сообщение уже выведено).
+ */
+int profile_load(const char *path, struct transform_profile *profile);
+
+/**
+ * @brief Записывает профиль в файл, создавая недостающие каталоги.
+ *
+ * Файл сначала записывается во временный и затем переименовывается, так что одновременно
+ * запущенные процессы читают либо прежний, либо новый профиль целиком.
+ *
+ * @param path Путь к файлу профиля.
+ * @param profile Указатель на профиль.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+int profile_save(const char *path, const struct transform_profile *profile);
+
+#endif // PROFILE_H
@@ -0,0 +1,71 @@
+#ifndef QOI_H
+#define QOI_H
+
+#include <stdio.h>
+#include "bmp.h"
+#include "image.h"
+
+#define QOI_HEADER_SIZE 14           // Размер заголовка QOI в байтах
+#define QOI_END_MARKER_SIZE 8        // Размер маркера конца потока QOI в байтах
+
+/**
+ * @brief Заголовок изображения QOI.
+ */
+struct qoi_header {
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    uint8_t channels;                // Количество каналов: 3 - RGB, 4 - RGBA
+    uint8_t colorspace;              // Цветовое пространство: 0 - sRGB, 1 - линейное
+};
+
+/**
+ * @brief Проверяет, начинается ли файл с сигнатуры QOI.
+ *
+ * @param magic Первые байты файла.
+ * @param size Количество байт (не меньше 4).
+ * @return 1, если сигнатура распознана, иначе 0.
+ */
+int qoi_sniff(const uint8_t *magic, size_t size);
+
+/**
+ * @brief Дочитывает и проверяет заголовок QOI, первые байты которого уже прочитаны.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param prefix Уже прочитанные первые байты файла.
+ * @param prefix_size Количество уже прочитанных байт (не больше `QOI_HEADER_SIZE`).
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status qoi_read_header(FILE *in, const uint8_t *prefix, size_t prefix_size, struct qoi_header *header);
+
+/**
+ * @brief Декодирует изображение QOI и передает обработчику строки заданной области.
+ *
+ * Поток QOI декодируется только последовательно, поэтому строки выше области декодируются и отбрасываются,
+ * а после последней строки области чтение прекращается. Строки поступают сверху вниз, альфа-канал отбрасывается.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status qoi_read_region(FILE *in, const struct qoi_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx);
+
+/**
+ * @brief Записывает изображение в формате QOI (Quite OK Image) без потерь.
+ *
+ * Изображение делится на полосы строк, которые кодируются параллельно: каждая полоса начинает
+ * с предыдущим пикселем, известным из изображения, и использует только те элементы таблицы цветов,
+ * которые сама заполнила, поэтому результат остается корректным потоком QOI для любого декодера.
+ * Закодированные полосы записываются строго последовательно, так что вывод подходит для каналов.
+ *
+ * @param out Указатель на файл для записи.
+ * @param img Указатель на структуру `image` для записи.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status qoi_to_file(FILE *out, const struct image *img);
+
+#endif // QOI_H
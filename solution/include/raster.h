@@ -0,0 +1,75 @@
+#ifndef RASTER_H
+#define RASTER_H
+
+#include <stdio.h>
+#include "bmp.h"
+#include "image.h"
+
+/**
+ * @brief Преобразует пиксели в формате файла в пиксели `struct pixel`.
+ *
+ * @param ctx Параметры формата (например, заголовок файла).
+ * @param out Указатель на результат, `count` пикселей.
+ * @param in Указатель на пиксели в формате файла.
+ * @param count Количество пикселей.
+ */
+typedef void (*raster_convert)(const void *ctx, struct pixel *out, const uint8_t *in, uint64_t count);
+
+/**
+ * @brief Расположение несжатых строк изображения в файле.
+ *
+ * Описывает любой формат, в котором строки одинаковой длины лежат в файле подряд с постоянным шагом:
+ * BMP (снизу вверх или сверху вниз, с выравниванием), PPM/PGM/PAM и подобные.
+ */
+struct raster_layout {
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    uint64_t data_offset;            // Смещение первой хранимой строки от начала файла в байтах
+    uint64_t position;               // Количество байт, уже прочитанных из потока (заголовок)
+    uint64_t row_stride;             // Расстояние между началами соседних хранимых строк в байтах
+    uint64_t pixel_size;             // Размер пикселя в файле в байтах
+    int bottom_up;                   // Признак хранения строк снизу вверх
+    raster_convert convert;          // Преобразование пикселей или NULL, если они хранятся как `struct pixel`
+    const void *convert_ctx;         // Параметры преобразования
+};
+
+/**
+ * @brief Возвращает размер обычного файла, не читая его.
+ *
+ * @param in Указатель на файл.
+ * @return Размер файла в байтах или `UINT64_MAX`, если файл не обычный (канал, сокет, терминал)
+ *         и размер заранее неизвестен.
+ */
+uint64_t raster_file_size(FILE *in);
+
+/**
+ * @brief Проверяет, что все строки изображения помещаются в файл, до выделения памяти под изображение.
+ *
+ * Размеры в заголовке ничем не ограничены, поэтому файл в сотню байт может потребовать гигабайты памяти.
+ * Проверка сравнивает конец последней хранимой строки с размером файла (`fstat`) без чтения данных и
+ * стоит один системный вызов. Для каналов размер неизвестен, и проверка пропускается.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param layout Указатель на расположение строк в файле (ширина и высота больше 0).
+ * @return `READ_OK` или `READ_INVALID_HEADER`, если данные изображения выходят за конец файла.
+ */
+enum read_status raster_check_size(FILE *in, const struct raster_layout *layout);
+
+/**
+ * @brief Читает строки заданной области и передает их обработчику.
+ *
+ * Для каждой строки области читаются только байты ее пикселей; строки обходятся в порядке их расположения
+ * в файле. Файлы без позиционного чтения (каналы, стандартный ввод) читаются последовательно с позиции
+ * `position` с пропуском ненужных данных; строки после области не читаются вовсе.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param layout Указатель на расположение строк в файле.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status raster_read_region(FILE *in, const struct raster_layout *layout, const struct image_rect *region,
+                                    image_row_handler handler, void *ctx);
+
+#endif // RASTER_H
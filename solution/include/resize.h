@@ -0,0 +1,123 @@
+#ifndef RESIZE_H
+#define RESIZE_H
+
+#include "image.h"
+#include "transform.h"
+
+/**
+ * @brief Фильтр, используемый при изменении размера изображения.
+ */
+enum resize_filter {
+    RESIZE_FILTER_BOX = 0,     ///< Усреднение по площади (для целых коэффициентов - среднее по блоку)
+    RESIZE_FILTER_BILINEAR,    ///< Билинейная (треугольная) интерполяция
+    RESIZE_FILTER_LANCZOS3,    ///< Фильтр Ланцоша с радиусом 3
+    RESIZE_FILTER_COUNT
+};
+
+/**
+ * @brief Находит фильтр по его имени (`box`, `bilinear`, `lanczos`).
+ *
+ * @param name Имя фильтра.
+ * @param filter Указатель, по которому будет записан найденный фильтр.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int resize_filter_from_name(const char *name, enum resize_filter *filter);
+
+/**
+ * @brief Возвращает имя фильтра.
+ *
+ * @param filter Фильтр.
+ * @return Имя фильтра или "unknown" для некорректного значения.
+ */
+const char *resize_filter_name(enum resize_filter filter);
+
+/**
+ * @brief Изменяет размер изображения.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param width Ширина результата в пикселях.
+ * @param height Высота результата в пикселях.
+ * @param filter Фильтр пересчета.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image resize_image(const struct image *source, uint64_t width, uint64_t height, enum resize_filter filter);
+
+/**
+ * @brief Изменяет размер изображения и одновременно приводит его к заданной ориентации.
+ *
+ * Пересчет выполняется двумя раздельными проходами (по строкам, затем по столбцам) на общем пуле потоков;
+ * каждый пиксель источника читается один раз, а строки результата сразу записываются в нужной ориентации.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param width Ширина результата (после смены ориентации) в пикселях.
+ * @param height Высота результата (после смены ориентации) в пикселях.
+ * @param filter Фильтр пересчета.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image resize_oriented_image(const struct image *source, uint64_t width, uint64_t height,
+                                   enum resize_filter filter, enum orientation orientation);
+
+/**
+ * @brief Состояние уменьшения изображения в целое число раз во время чтения.
+ *
+ * Строки источника суммируются в блоки `factor` x `factor` по мере поступления; как только полоса блоков
+ * заполнена, она усредняется и записывается в результат. Полноразмерное изображение в памяти не хранится.
+ */
+struct shrink_reader {
+    struct image *dest;              // Изображение-результат
+    struct orientation_map map;      // Отображение строк уменьшенного изображения в результат
+    uint64_t source_width;           // Ширина источника в пикселях
+    uint64_t source_height;          // Высота источника в пикселях
+    uint64_t factor;                 // Коэффициент уменьшения
+    uint64_t band;                   // Номер текущей полосы блоков
+    uint64_t band_rows;              // Количество строк, накопленных в текущей полосе
+    uint32_t *sums;                  // Суммы каналов по блокам текущей полосы
+    struct pixel *row;               // Буфер строки уменьшенного изображения
+};
+
+/**
+ * @brief Вычисляет размер изображения после уменьшения в целое число раз.
+ *
+ * Неполные блоки у правого и нижнего края дают отдельные пиксели результата.
+ *
+ * @param size Размер источника в пикселях.
+ * @param factor Коэффициент уменьшения.
+ * @return Размер результата в пикселях.
+ */
+uint64_t shrink_size(uint64_t size, uint64_t factor);
+
+/**
+ * @brief Подготавливает уменьшение изображения во время чтения и выделяет память под результат.
+ *
+ * @param reader Указатель на состояние уменьшения.
+ * @param width Ширина источника в пикселях.
+ * @param height Высота источника в пикселях.
+ * @param factor Коэффициент уменьшения (не меньше 1).
+ * @param orientation Ориентация результата.
+ * @param dest Указатель на структуру `image`, в которую будет записан результат.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int shrink_reader_init(struct shrink_reader *reader, uint64_t width, uint64_t height, uint64_t factor,
+                       enum orientation orientation, struct image *dest);
+
+/**
+ * @brief Обработчик строки источника для `image_row_handler`.
+ *
+ * Строки одной полосы блоков должны поступать подряд (порядок внутри полосы и порядок полос произвольный).
+ *
+ * @param ctx Указатель на `struct shrink_reader`.
+ * @param y Номер строки источника.
+ * @param row Пиксели строки источника.
+ * @return 0 при успехе или 1, если строки полосы поступили не подряд.
+ */
+int shrink_reader_row(void *ctx, uint64_t y, const struct pixel *row);
+
+/**
+ * @brief Освобождает служебную память уменьшения (результат не затрагивается).
+ *
+ * @param reader Указатель на состояние уменьшения.
+ */
+void shrink_reader_destroy(struct shrink_reader *reader);
+
+#endif // RESIZE_H
@@ -0,0 +1,78 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define SCHEDULER_PRIORITIES 4       // Количество уровней приоритета задач (0 - низший)
+#define SCHEDULER_MAX_WORKERS 256    // Верхняя граница количества потоков планировщика
+
+struct scheduler_worker;
+
+/**
+ * @brief Задача планировщика: обработка одного изображения.
+ *
+ * Память под задачу принадлежит вызывающему; она должна оставаться доступной до `scheduler_finish`.
+ */
+struct scheduler_job {
+    void (*run)(void *ctx);          // Выполняет задачу в потоке планировщика
+    void *ctx;                       // Контекст задачи
+    unsigned priority;               // Приоритет (0..SCHEDULER_PRIORITIES-1; больший выполняется раньше)
+    uint64_t memory;                 // Оценка памяти, занимаемой задачей, в байтах
+    struct scheduler_job *next;      // Следующая задача в очереди (заполняется планировщиком)
+};
+
+/**
+ * @brief Планировщик задач с перехватом работы, приоритетами и допуском по памяти.
+ *
+ * Задачи ждут в очередях по приоритетам и допускаются к выполнению, пока их суммарная оценка памяти
+ * не превышает бюджет; задача, которая не помещается, не задерживает следующие за ней, если те
+ * помещаются вместе с ее резервом. Задача, одна превышающая бюджет, выполняется, когда других нет.
+ *
+ * Параллельные циклы внутри задачи (`parallel_for`) не уходят в общий пул, а делятся на порции:
+ * поток задачи выполняет их сам, а в свою очередь кладет билеты, которые свободные потоки
+ * перехватывают с другого конца очереди. Билет выполняет одну порцию и возвращается в очередь
+ * выполнившего его потока, так что между порциями поток снова выбирает самую приоритетную работу.
+ * Поэтому крупное изображение не занимает поток надолго: небольшие задачи ждут не дольше одной порции.
+ */
+struct scheduler {
+    pthread_mutex_t lock;            // Защищает очереди задач, учет памяти и счетчики
+    pthread_cond_t wake;             // Сигнал о появлении работы или завершении задачи
+    uint64_t version;                // Номер изменения; увеличивается при каждом появлении работы
+    struct scheduler_job *head[SCHEDULER_PRIORITIES]; // Начала очередей задач по приоритетам
+    struct scheduler_job *tail[SCHEDULER_PRIORITIES]; // Концы очередей задач по приоритетам
+    uint64_t memory_budget;          // Бюджет памяти задач в байтах (0 - без ограничения)
+    uint64_t memory_used;            // Суммарная оценка памяти выполняемых задач
+    uint64_t submitted;              // Количество поставленных задач
+    uint64_t finished;               // Количество завершенных задач
+    int closed;                      // Признак того, что новых задач не будет
+    unsigned worker_count;           // Количество потоков
+    struct scheduler_worker *workers; // Потоки планировщика
+};
+
+/**
+ * @brief Запускает потоки планировщика.
+ *
+ * @param scheduler Указатель на планировщик.
+ * @param workers Количество потоков (0 - по `parallel_thread_count`).
+ * @param memory_budget Бюджет памяти задач в байтах (0 - без ограничения).
+ * @return 0 при успехе или 1, если не удалось выделить память или создать ни одного потока.
+ */
+int scheduler_start(struct scheduler *scheduler, unsigned workers, uint64_t memory_budget);
+
+/**
+ * @brief Ставит задачу в очередь ее приоритета.
+ *
+ * @param scheduler Указатель на запущенный планировщик.
+ * @param job Указатель на задачу.
+ */
+void scheduler_submit(struct scheduler *scheduler, struct scheduler_job *job);
+
+/**
+ * @brief Дожидается выполнения всех поставленных задач, останавливает потоки и освобождает память.
+ *
+ * @param scheduler Указатель на запущенный планировщик.
+ */
+void scheduler_finish(struct scheduler *scheduler);
+
+#endif // SCHEDULER_H
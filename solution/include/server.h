@@ -0,0 +1,33 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+/**
+ * @brief Параметры режима сервера.
+ */
+struct server_options {
+    const char *socket_path;         // Путь к Unix-сокету, на котором принимаются запросы
+    unsigned workers;                // Количество потоков, обслуживающих соединения (0 - по числу процессоров)
+};
+
+/**
+ * @brief Запускает долгоживущий сервер, выполняющий операции над изображениями по запросам.
+ *
+ * Сервер принимает соединения на Unix-сокете типа `SOCK_SEQPACKET`. Каждое сообщение клиента -
+ * один запрос: аргументы командной строки программы (параметры операций, исходный и выходной путь),
+ * разделенные нулевыми байтами. Вместе с сообщением можно передать до 8 файловых дескрипторов
+ * (`SCM_RIGHTS`), например memfd; путь вида `fd:N` обозначает N-й из них (с нуля). Результат,
+ * записанный в переданный memfd, клиент читает через разделяемую память без копирования через сокет.
+ * Путь "-" (стандартные потоки) в запросах недоступен.
+ * На каждый запрос сервер отвечает сообщением `OK` или `ERROR`; по одному соединению можно
+ * отправлять запросы последовательно.
+ *
+ * Соединения обслуживаются постоянным набором потоков, так что при каждом запросе не тратится
+ * время на запуск процесса и прогрев распределителя памяти.
+ *
+ * @param options Указатель на параметры сервера.
+ * @return 1, если сервер не удалось запустить или слушающий сокет стал непригоден; при нормальной работе
+ *         функция не возвращает управление.
+ */
+int server_run(const struct server_options *options);
+
+#endif // SERVER_H
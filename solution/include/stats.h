@@ -0,0 +1,70 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "image.h"
+
+#define STATS_SUBHISTOGRAMS 4        // Количество частичных гистограмм, заполняемых по очереди
+
+/**
+ * @brief Статистика пикселей: гистограммы, минимум, максимум и среднее каждого канала.
+ *
+ * Строки добавляются по одной (обычно прямо при чтении файла, пока они в кэше). Соседние пиксели
+ * попадают в разные частичные гистограммы: подряд идущие увеличения одного и того же счетчика
+ * иначе ждали бы друг друга через память. Частичные гистограммы сводятся в `image_stats_finish`,
+ * а минимум, максимум и среднее вычисляются по итоговой гистограмме.
+ * Каналы нумеруются в порядке хранения пикселя: 0 - b, 1 - g, 2 - r.
+ */
+struct image_stats {
+    uint64_t pixels;                 // Количество учтенных пикселей
+    uint64_t histogram[3][256];      // Итоговые гистограммы каналов (после image_stats_finish)
+    uint8_t min[3];                  // Наименьшее значение канала (после image_stats_finish)
+    uint8_t max[3];                  // Наибольшее значение канала (после image_stats_finish)
+    double mean[3];                  // Среднее значение канала (после image_stats_finish)
+    uint32_t partial[STATS_SUBHISTOGRAMS][3][256]; // Частичные гистограммы
+    uint64_t pending;                // Пикселей в частичных гистограммах с последнего сведения
+};
+
+/**
+ * @brief Подготавливает пустую статистику.
+ *
+ * @param stats Указатель на статистику.
+ */
+void image_stats_init(struct image_stats *stats);
+
+/**
+ * @brief Добавляет к статистике пиксели строки.
+ *
+ * @param stats Указатель на статистику.
+ * @param row Указатель на пиксели строки.
+ * @param count Количество пикселей.
+ */
+void image_stats_add(struct image_stats *stats, const struct pixel *row, uint64_t count);
+
+/**
+ * @brief Сводит частичные гистограммы и вычисляет минимум, максимум и среднее каналов.
+ *
+ * После вызова можно продолжать добавлять строки и вызвать функцию снова.
+ *
+ * @param stats Указатель на статистику.
+ */
+void image_stats_finish(struct image_stats *stats);
+
+/**
+ * @brief Вычисляет статистику изображения в памяти отдельным проходом.
+ *
+ * @param stats Указатель на заполняемую статистику.
+ * @param img Указатель на изображение.
+ */
+void image_stats_compute(struct image_stats *stats, const struct image *img);
+
+/**
+ * @brief Выводит статистику: строку с минимумом, максимумом и средним и гистограмму для каждого канала.
+ *
+ * @param out Поток для вывода.
+ * @param stats Указатель на сведенную статистику.
+ */
+void image_stats_print(FILE *out, const struct image_stats *stats);
+
+#endif // STATS_H
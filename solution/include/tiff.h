@@ -0,0 +1,38 @@
+#ifndef TIFF_H
+#define TIFF_H
+
+#include <stdio.h>
+#include "bmp.h"
+#include "image.h"
+
+#define TIFF_STRIP_BYTES (1u << 20)  // Желаемый размер полосы строк TIFF в байтах
+
+/**
+ * @brief Записывает изображение в формате TIFF без сжатия, 8 бит на канал RGB.
+ *
+ * Пиксели записываются полосами строк сверху вниз, а каталог тегов со смещениями полос - после них,
+ * поэтому запись идет строго последовательно и подходит для каналов. Если файл не помещается
+ * в 32-битные смещения классического TIFF, записывается BigTIFF с 64-битными смещениями.
+ *
+ * @param out Указатель на файл для записи.
+ * @param img Указатель на структуру `image` для записи.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status tiff_to_file(FILE *out, const struct image *img);
+
+/**
+ * @brief Записывает TIFF файл, получая строки изображения по одной от источника.
+ *
+ * Строки запрашиваются сверху вниз, в порядке их расположения в файле; в памяти хранится
+ * только одна полоса строк.
+ *
+ * @param out Указатель на файл для записи.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status tiff_write_rows(FILE *out, uint64_t width, uint64_t height, image_row_source source, void *ctx);
+
+#endif // TIFF_H
@@ -0,0 +1,83 @@
+#ifndef TILE_CACHE_H
+#define TILE_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define TILE_CACHE_NONE UINT64_MAX   // Отсутствующий тайл, место или элемент кэша
+
+/**
+ * @brief Элемент кэша: тайл в памяти и его место в списке LRU.
+ */
+struct tile_cache_entry {
+    uint64_t tile;                   // Номер тайла или `TILE_CACHE_NONE`
+    uint64_t prev;                   // Предыдущий (более свежий) элемент списка LRU
+    uint64_t next;                   // Следующий (более старый) элемент списка LRU
+    int dirty;                       // Признак изменения тайла после чтения из временного файла
+    uint8_t *data;                   // Данные тайла
+};
+
+/**
+ * @brief Кэш тайлов ограниченного размера над временным файлом.
+ *
+ * В памяти хранятся не более `capacity` тайлов; при нехватке места вытесняется давно не использованный,
+ * а измененный тайл перед этим записывается во временный файл. Место тайла в файле можно назначить заранее
+ * (`tile_cache_place`) в порядке, в котором тайлы будут читаться, чтобы чтение шло последовательно.
+ * Временный файл создается только при первом вытеснении и удаляется при закрытии.
+ */
+struct tile_cache {
+    FILE *scratch;                   // Временный файл или NULL, если он еще не понадобился
+    uint64_t tile_bytes;             // Размер тайла в байтах
+    uint64_t tile_count;             // Количество тайлов
+    uint64_t capacity;               // Максимальное количество тайлов в памяти
+    uint64_t used;                   // Количество занятых элементов
+    uint64_t next_slot;              // Первое свободное место во временном файле
+    uint64_t *slots;                 // Место каждого тайла во временном файле
+    uint64_t *resident;              // Элемент кэша, хранящий тайл
+    uint8_t *stored;                 // Признак наличия тайла во временном файле
+    struct tile_cache_entry *entries; // Элементы кэша
+    uint64_t head;                   // Последний использованный элемент
+    uint64_t tail;                   // Давно не использованный элемент
+};
+
+/**
+ * @brief Создает пустой кэш тайлов.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile_count Количество тайлов.
+ * @param tile_bytes Размер тайла в байтах.
+ * @param capacity Максимальное количество тайлов в памяти (больше 0).
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int tile_cache_init(struct tile_cache *cache, uint64_t tile_count, uint64_t tile_bytes, uint64_t capacity);
+
+/**
+ * @brief Назначает тайлу следующее свободное место во временном файле, если место еще не назначено.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile Номер тайла.
+ */
+void tile_cache_place(struct tile_cache *cache, uint64_t tile);
+
+/**
+ * @brief Возвращает данные тайла, при необходимости читая его из временного файла.
+ *
+ * Тайл, который еще ни разу не записывался, не читается: его содержимое не определено,
+ * и вызывающий должен заполнить его целиком перед чтением.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile Номер тайла.
+ * @param write Признак изменения тайла вызывающим.
+ * @return Указатель на данные тайла, действительный до следующего вызова, или NULL при ошибке ввода-вывода
+ *         (после ошибки кэш можно только освободить).
+ */
+uint8_t *tile_cache_get(struct tile_cache *cache, uint64_t tile, int write);
+
+/**
+ * @brief Освобождает память кэша и удаляет временный файл.
+ *
+ * @param cache Указатель на кэш.
+ */
+void tile_cache_destroy(struct tile_cache *cache);
+
+#endif // TILE_CACHE_H
@@ -3,6 +3,280 @@
 
 #include "image.h"
 
+/**
+ * @brief Ориентация результата: повороты на углы, кратные 90 градусам, и отражения.
+ */
+enum orientation {
+    ORIENTATION_NONE = 0,          ///< Без изменений
+    ORIENTATION_ROTATE_90_CCW,     ///< Поворот на 90 градусов против часовой стрелки
+    ORIENTATION_ROTATE_180,        ///< Поворот на 180 градусов
+    ORIENTATION_ROTATE_90_CW,      ///< Поворот на 90 градусов по часовой стрелке
+    ORIENTATION_FLIP_HORIZONTAL,   ///< Отражение слева направо
+    ORIENTATION_FLIP_VERTICAL,     ///< Отражение сверху вниз
+    ORIENTATION_TRANSPOSE,         ///< Отражение относительно главной диагонали
+    ORIENTATION_TRANSVERSE,        ///< Отражение относительно побочной диагонали
+    ORIENTATION_COUNT
+};
+
+#define TRANSFORM_MIN_TILE_SIZE 8     // Минимальная сторона тайла смены ориентации в пикселях
+#define TRANSFORM_MAX_TILE_SIZE 256   // Максимальная сторона тайла смены ориентации в пикселях
+#define ORIENT_MAX_OUTPUTS 16         // Максимальное количество результатов одного прохода `orient_region_fanout`
+
+/**
+ * @brief Набор специализированных ядер смены ориентации.
+ */
+enum orient_kernels {
+    ORIENT_KERNELS_AUTO = 0,       ///< Лучший набор, поддерживаемый процессором
+    ORIENT_KERNELS_GENERIC,        ///< Ядра без расширений набора инструкций
+    ORIENT_KERNELS_AVX2,           ///< Ядра, собранные с AVX2
+    ORIENT_KERNELS_COUNT
+};
+
+/**
+ * @brief Отображение координат исходного изображения в индексы пикселей результата.
+ *
+ * Пиксель исходного изображения с координатами (x, y) попадает в элемент
+ * `origin + x * step_x + y * step_y` массива пикселей результата.
+ */
+struct orientation_map {
+    uint64_t width;          // Ширина результата в пикселях
+    uint64_t height;         // Высота результата в пикселях
+    int64_t origin;          // Индекс пикселя результата, в который попадает пиксель (0, 0)
+    int64_t step_x;          // Сдвиг индекса результата при увеличении x на единицу
+    int64_t step_y;          // Сдвиг индекса результата при увеличении y на единицу
+};
+
+/**
+ * @brief Поэлементная операция над пикселями, выполняемая в том же проходе, что и смена ориентации.
+ *
+ * Вызывается для непрерывных отрезков результата сразу после того, как тайл перенесен,
+ * пока его данные еще находятся в кэше.
+ */
+struct pixel_stage {
+    /**
+     * Обрабатывает `count` подряд идущих пикселей на месте.
+     */
+    void (*apply)(const void *ctx, struct pixel *pixels, uint64_t count);
+    const void *ctx;                 // Контекст операции
+};
+
+/**
+ * @brief Строит отображение координат для заданной ориентации и размеров исходного изображения.
+ *
+ * @param map Указатель на структуру, в которую будет записано отображение.
+ * @param orientation Ориентация результата.
+ * @param width Ширина исходного изображения в пикселях.
+ * @param height Высота исходного изображения в пикселях.
+ */
+void orientation_map_init(struct orientation_map *map, enum orientation orientation, uint64_t width, uint64_t height);
+
+/**
+ * @brief Проверяет, меняет ли ориентация местами ширину и высоту изображения.
+ *
+ * @param orientation Ориентация результата.
+ * @return 1, если ширина и высота меняются местами, иначе 0.
+ */
+int orientation_swaps_axes(enum orientation orientation);
+
+/**
+ * @brief Находит ориентацию по ее имени.
+ *
+ * Допустимые имена: `none`, `ccw90`, `180`, `cw90`, `flip-h`, `flip-v`, `transpose`, `transverse`.
+ *
+ * @param name Имя ориентации.
+ * @param orientation Указатель, по которому будет записана найденная ориентация.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int orientation_from_name(const char *name, enum orientation *orientation);
+
+/**
+ * @brief Возвращает имя ориентации.
+ *
+ * @param orientation Ориентация.
+ * @return Имя ориентации или "unknown" для некорректного значения.
+ */
+const char *orientation_name(enum orientation orientation);
+
+/**
+ * @brief Задает минимальный размер результата смены ориентации, начиная с которого он записывается в обход кэша.
+ *
+ * Когда результат больше кэша последнего уровня, обычная запись сначала читает каждую строку кэша
+ * результата (read-for-ownership) и вытесняет из кэша еще нужный источник. Невременная (потоковая)
+ * запись избегает и того и другого.
+ *
+ * @param bytes Порог в байтах; 0 - размер кэша последнего уровня (по умолчанию),
+ *              `UINT64_MAX` - не использовать потоковую запись.
+ */
+void orient_set_stream_threshold(uint64_t bytes);
+
+/**
+ * @brief Возвращает действующий порог потоковой записи результата смены ориентации.
+ *
+ * @return Порог в байтах.
+ */
+uint64_t orient_stream_threshold(void);
+
+/**
+ * @brief Задает дальность программной предвыборки при смене ориентации.
+ *
+ * При обходе тайла заранее запрашиваются строки источника и строки результата, до которых обход дойдет
+ * через заданное количество шагов. Для ориентаций, меняющих оси, шаги записи в результат отстоят друг
+ * от друга на целую строку результата, и аппаратная предвыборка их не отслеживает.
+ *
+ * @param lines Дальность в строках (для ориентаций, меняющих оси, - в столбцах источника); 0 отключает предвыборку.
+ */
+void orient_set_prefetch_distance(uint64_t lines);
+
+/**
+ * @brief Возвращает действующую дальность программной предвыборки при смене ориентации.
+ *
+ * @return Дальность в строках.
+ */
+uint64_t orient_prefetch_distance(void);
+
+/**
+ * @brief Задает сторону квадратных тайлов, которыми обрабатывается изображение при смене ориентации.
+ *
+ * Тайл источника и тайл результата должны вместе помещаться в кэш L1 или L2; лучший размер зависит
+ * от машины и подбирается режимом `--tune`.
+ *
+ * @param size Сторона тайла в пикселях (по умолчанию 64).
+ * @return 0, если размер допустим, или 1, если он вне `[TRANSFORM_MIN_TILE_SIZE, TRANSFORM_MAX_TILE_SIZE]`.
+ */
+int orient_set_tile_size(uint64_t size);
+
+/**
+ * @brief Возвращает действующую сторону тайла при смене ориентации.
+ *
+ * @return Сторона тайла в пикселях.
+ */
+uint64_t orient_tile_size(void);
+
+/**
+ * @brief Находит набор ядер смены ориентации по его имени.
+ *
+ * Допустимые имена: `auto`, `generic`, `avx2`.
+ *
+ * @param name Имя набора.
+ * @param kernels Указатель, по которому будет записан найденный набор.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int orient_kernels_from_name(const char *name, enum orient_kernels *kernels);
+
+/**
+ * @brief Возвращает имя набора ядер смены ориентации.
+ *
+ * @param kernels Набор ядер.
+ * @return Имя набора или "unknown" для некорректного значения.
+ */
+const char *orient_kernels_name(enum orient_kernels kernels);
+
+/**
+ * @brief Выбирает набор специализированных ядер смены ориентации.
+ *
+ * Для каждой пары (ориентация, набор инструкций) собирается отдельное ядро с постоянными направлениями
+ * обхода и записи, выбор ядра выполняется по таблице один раз на изображение.
+ *
+ * @param kernels Набор ядер; `ORIENT_KERNELS_AUTO` - лучший из поддерживаемых процессором (по умолчанию).
+ * @return 0, если набор выбран, или 1, если процессор или сборка его не поддерживает.
+ */
+int orient_set_kernels(enum orient_kernels kernels);
+
+/**
+ * @brief Возвращает действующий набор ядер смены ориентации.
+ *
+ * @return Набор ядер (не `ORIENT_KERNELS_AUTO`).
+ */
+enum orient_kernels orient_active_kernels(void);
+
+/**
+ * @brief Создает изображение в заданной ориентации.
+ *
+ * Изображение обрабатывается квадратными блоками (тайлами), которые распределяются между потоками,
+ * так что и чтение, и запись каждого блока остаются в кэше процессора.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image orient_image(const struct image *source, enum orientation orientation);
+
+/**
+ * @brief Вырезает область изображения и приводит ее к заданной ориентации за один проход.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image orient_region(const struct image *source, const struct image_rect *region, enum orientation orientation);
+
+/**
+ * @brief Вырезает область, приводит ее к заданной ориентации и применяет к пикселям поэлементную операцию за один проход.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @param orientation Ориентация результата.
+ * @param stage Указатель на поэлементную операцию или NULL.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image orient_region_staged(const struct image *source, const struct image_rect *region,
+                                  enum orientation orientation, const struct pixel_stage *stage);
+
+struct uniform_tiles;
+
+/**
+ * @brief То же, что `orient_region_staged`, но однотонные тайлы заполняются цветом без переноса пикселей.
+ *
+ * Карта однотонных тайлов (см. uniform.h) строится при чтении изображения; она используется, только если
+ * построена для той же области (размер области совпадает с размером карты) и с текущей стороной тайла
+ * (`orient_tile_size`), иначе все тайлы переносятся обычными ядрами. Объем работы над однотонными
+ * тайлами сводится к записи результата, поэтому время почти пропорционально доле неоднотонной площади.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @param orientation Ориентация результата.
+ * @param stage Указатель на поэлементную операцию или NULL.
+ * @param tiles Указатель на карту однотонных тайлов области или NULL.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image orient_region_sparse(const struct image *source, const struct image_rect *region,
+                                  enum orientation orientation, const struct pixel_stage *stage,
+                                  const struct uniform_tiles *tiles);
+
+/**
+ * @brief Строит несколько результатов смены ориентации одной области за один обход тайлов источника.
+ *
+ * Каждый тайл источника, пока он в кэше, переносится во все результаты по очереди, поэтому источник
+ * читается из памяти один раз, а не по разу на результат. Для каждого результата задаются своя ориентация
+ * и своя поэлементная операция; карта однотонных тайлов общая (см. `orient_region_sparse`).
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @param count Количество результатов (от 1 до `ORIENT_MAX_OUTPUTS`).
+ * @param orientations Ориентации результатов.
+ * @param stages Поэлементные операции результатов (элементы могут быть NULL) или NULL.
+ * @param tiles Указатель на карту однотонных тайлов области или NULL.
+ * @param results Массив, в который будут записаны `count` результатов; при ошибке они не создаются.
+ * @return 0 при успехе или 1, если параметры некорректны или выделение памяти не удалось.
+ */
+int orient_region_fanout(const struct image *source, const struct image_rect *region, size_t count,
+                         const enum orientation *orientations, const struct pixel_stage *const *stages,
+                         const struct uniform_tiles *tiles, struct image *results);
+
+/**
+ * @brief Помещает строку исходного изображения в результат согласно отображению ориентации.
+ *
+ * Позволяет строить результат построчно, по мере чтения строк исходного изображения.
+ *
+ * @param dest Указатель на изображение-результат размером `map->width` x `map->height`.
+ * @param map Указатель на отображение, построенное для размеров исходного изображения.
+ * @param y Номер строки в исходном изображении.
+ * @param row Пиксели исходной строки.
+ * @param width Количество пикселей в строке (ширина исходного изображения).
+ */
+void orient_row(struct image *dest, const struct orientation_map *map, uint64_t y, const struct pixel *row, uint64_t width);
+
 /**
  * @brief Поворачивает изображение на 90 градусов против часовой стрелки.
  *
@@ -14,4 +288,37 @@
  */
 struct image rotate_image_90_counterclockwise(const struct image *source);
 
+/**
+ * @brief Вырезает прямоугольную область изображения.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @return Новая структура `image` с копией области. При ошибке поле `data` равно NULL.
+ */
+struct image crop_image(const struct image *source, const struct image_rect *region);
+
+/**
+ * @brief Вырезает область изображения и поворачивает ее на 90 градусов против часовой стрелки за один проход.
+ *
+ * Результат совпадает с последовательным вызовом `crop_image` и `rotate_image_90_counterclockwise`,
+ * но промежуточное изображение не создается.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область; должна целиком лежать внутри изображения.
+ * @return Новая структура `image` с повернутой областью. При ошибке поле `data` равно NULL.
+ */
+struct image rotate_region_90_counterclockwise(const struct image *source, const struct image_rect *region);
+
+/**
+ * @brief Помещает строку исходного изображения в соответствующий столбец повернутого изображения.
+ *
+ * Позволяет строить повернутое изображение построчно, по мере чтения строк исходного
+ * (например, прямо из файла), не храня исходное изображение целиком.
+ *
+ * @param rotated Указатель на повернутое изображение; его высота равна ширине исходной строки.
+ * @param y Номер строки в исходном изображении.
+ * @param row Пиксели исходной строки.
+ */
+void rotate_row_90_counterclockwise(struct image *rotated, uint64_t y, const struct pixel *row);
+
 #endif // TRANSFORM_H
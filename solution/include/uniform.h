@@ -0,0 +1,63 @@
+#ifndef UNIFORM_H
+#define UNIFORM_H
+
+#include <stdint.h>
+#include "image.h"
+
+/**
+ * @brief Карта однотонных тайлов изображения.
+ *
+ * Строится по мере чтения строк: для каждого тайла запоминается цвет первого пикселя первой
+ * поступившей строки тайла, и каждая строка тайла сравнивается с этим цветом векторно. Тайл, в котором нашлось отличие,
+ * больше не проверяется, поэтому на изображениях без однотонных участков карта почти ничего не стоит.
+ * Смена ориентации (см. `orient_region_sparse`) заполняет однотонные тайлы цветом вместо переноса пикселей.
+ */
+struct uniform_tiles {
+    uint64_t tile;                   // Сторона тайла в пикселях
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    uint64_t tiles_x;                // Количество тайлов по горизонтали
+    uint64_t tiles_y;                // Количество тайлов по вертикали
+    struct pixel *colors;            // Цвет каждого тайла
+    uint8_t *uniform;                // Признак однотонности каждого тайла
+    uint8_t *seen;                   // Признак поступления хотя бы одной строки каждой полосы тайлов
+};
+
+/**
+ * @brief Подготавливает карту, в которой все тайлы считаются однотонными до проверки.
+ *
+ * @param tiles Указатель на карту.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param tile Сторона тайла в пикселях.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int uniform_tiles_init(struct uniform_tiles *tiles, uint64_t width, uint64_t height, uint64_t tile);
+
+/**
+ * @brief Учитывает строку изображения.
+ *
+ * Строки могут поступать в любом порядке (например, снизу вверх, как в BMP).
+ *
+ * @param tiles Указатель на карту.
+ * @param y Номер строки.
+ * @param row Указатель на пиксели строки (`tiles->width` пикселей).
+ */
+void uniform_tiles_row(struct uniform_tiles *tiles, uint64_t y, const struct pixel *row);
+
+/**
+ * @brief Возвращает количество однотонных тайлов.
+ *
+ * @param tiles Указатель на заполненную карту.
+ * @return Количество тайлов с признаком однотонности.
+ */
+uint64_t uniform_tiles_count(const struct uniform_tiles *tiles);
+
+/**
+ * @brief Освобождает память карты; повторный вызов и вызов для обнуленной карты допустимы.
+ *
+ * @param tiles Указатель на карту.
+ */
+void uniform_tiles_destroy(struct uniform_tiles *tiles);
+
+#endif // UNIFORM_H
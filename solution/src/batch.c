@@ -0,0 +1,259 @@
+#include "batch.h"
+#include "image_io.h"
+#include "scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BATCH_MAX_LINE 8192          // Максимальная длина строки файла заданий
+#define BATCH_MAX_ARGS 64            // Максимальное количество аргументов задания
+
+/**
+ * @brief Задание пакетной обработки.
+ */
+struct batch_job {
+    struct scheduler_job task;       // Задача планировщика
+    struct pipeline pipeline;        // Операции задания
+    char *line;                      // Копия строки задания; аргументы указывают в нее
+    const char *source_path;         // Путь к исходному изображению
+    const char *dest_path;           // Путь к выходному изображению
+    double submitted;                // Время постановки в очередь в секундах
+    double latency;                  // Время от постановки в очередь до завершения в секундах
+    int status;                      // Результат `pipeline_run`
+};
+
+/**
+ * @brief Возвращает текущее значение монотонных часов в секундах.
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Выполняет задание в потоке планировщика.
+ *
+ * @param ctx Указатель на `struct batch_job`.
+ */
+static void batch_job_run(void *ctx) {
+    struct batch_job *job = ctx;
+    job->status = pipeline_run(&job->pipeline, job->source_path, job->dest_path);
+    job->latency = now_seconds() - job->submitted;
+}
+
+/**
+ * @brief Освобождает задание.
+ */
+static void batch_job_destroy(struct batch_job *job) {
+    free(job->line);
+    free(job);
+}
+
+/**
+ * @brief Разбирает строку файла заданий.
+ *
+ * @param line Строка без перевода строки.
+ * @param number Номер строки для сообщений об ошибках.
+ * @param defaults Операции, заданные в командной строке.
+ * @param job Указатель, по которому будет записано задание, или NULL для пустой строки и комментария.
+ * @return 0 при успехе или 1, если строка некорректна (сообщение уже выведено).
+ */
+static int parse_job(const char *line, unsigned number, const struct pipeline *defaults, struct batch_job **job) {
+    *job = NULL;
+    size_t skip = strspn(line, " \t");
+    if (line[skip] == '\0' || line[skip] == '#') {
+        return 0;
+    }
+
+    struct batch_job *parsed = malloc(sizeof(*parsed));
+    char *copy = parsed ? malloc(strlen(line) + 1) : NULL;
+    if (!copy) {
+        free(parsed);
+        fprintf(stderr, "Ошибка: строка %u файла заданий: не удалось выделить память\n", number);
+        return 1;
+    }
+    strcpy(copy, line);
+    parsed->line = copy;
+    parsed->pipeline = *defaults;
+    parsed->task.run = batch_job_run;
+    parsed->task.ctx = parsed;
+    parsed->task.priority = 0;
+    parsed->status = 1;
+    parsed->latency = 0.0;
+
+    char *argv[BATCH_MAX_ARGS];
+    int argc = 0;
+    for (char *token = strtok(copy, " \t"); token; token = strtok(NULL, " \t")) {
+        if (argc == BATCH_MAX_ARGS) {
+            fprintf(stderr, "Ошибка: строка %u файла заданий: больше %d аргументов\n", number, BATCH_MAX_ARGS);
+            batch_job_destroy(parsed);
+            return 1;
+        }
+        argv[argc++] = token;
+    }
+
+    int arg = 0;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        int status;
+        if (strcmp(argv[arg], "--priority") == 0) {
+            int consumed = 0;
+            status = arg + 1 < argc && sscanf(argv[arg + 1], "%u%n", &parsed->task.priority, &consumed) == 1
+                     && argv[arg + 1][consumed] == '\0' && parsed->task.priority < SCHEDULER_PRIORITIES ? 0 : 1;
+            if (status != 0) {
+                fprintf(stderr, "Ошибка: приоритет должен быть от 0 до %d\n", SCHEDULER_PRIORITIES - 1);
+            }
+            arg += 2;
+        } else {
+            status = pipeline_parse_option(&parsed->pipeline, argc, argv, &arg);
+            if (status < 0) {
+                fprintf(stderr, "Ошибка: неизвестный параметр '%s'\n", argv[arg]);
+            }
+        }
+        if (status != 0) {
+            fprintf(stderr, "Ошибка: строка %u файла заданий не разобрана\n", number);
+            batch_job_destroy(parsed);
+            return 1;
+        }
+    }
+    if (argc - arg != 2 || image_path_is_stream(argv[arg]) || image_path_is_stream(argv[arg + 1])) {
+        fprintf(stderr, "Ошибка: строка %u файла заданий должна заканчиваться исходным и выходным путем к файлам\n",
+                number);
+        batch_job_destroy(parsed);
+        return 1;
+    }
+    parsed->source_path = argv[arg];
+    parsed->dest_path = argv[arg + 1];
+
+    uint64_t width, height;
+    parsed->task.memory = read_image_size(parsed->source_path, &width, &height) == 0
+                          ? pipeline_memory_estimate(&parsed->pipeline, width, height) : 0;
+    *job = parsed;
+    return 0;
+}
+
+/**
+ * @brief Сравнивает задержки для сортировки по возрастанию.
+ */
+static int compare_latency(const void *a, const void *b) {
+    double x = *(const double *) a;
+    double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Выводит количество заданий, ошибок и задержки по приоритетам.
+ *
+ * @param jobs Выполненные задания.
+ * @param count Количество заданий.
+ * @param rejected Количество неразобранных строк.
+ * @param elapsed Общее время обработки в секундах.
+ */
+static void report(struct batch_job **jobs, size_t count, unsigned rejected, double elapsed) {
+    unsigned failed = rejected;
+    for (size_t i = 0; i < count; i++) {
+        failed += jobs[i]->status != 0;
+    }
+    printf("# заданий %zu, ошибок %u, время %.3f с\n", count + rejected, failed, elapsed);
+
+    double *latencies = malloc((count ? count : 1) * sizeof(*latencies));
+    if (!latencies) {
+        return;
+    }
+    for (int level = SCHEDULER_PRIORITIES - 1; level >= 0; level--) {
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (jobs[i]->task.priority == (unsigned) level) {
+                latencies[n++] = jobs[i]->latency;
+            }
+        }
+        if (n == 0) {
+            continue;
+        }
+        qsort(latencies, n, sizeof(*latencies), compare_latency);
+        printf("# приоритет %d: заданий %zu, задержка p50 %.1f мс, p99 %.1f мс, макс %.1f мс\n", level, n,
+               latencies[(n - 1) / 2] * 1e3, latencies[(n - 1) * 99 / 100] * 1e3, latencies[n - 1] * 1e3);
+    }
+    free(latencies);
+}
+
+/**
+ * @brief Выполняет задания из файла на планировщике с перехватом работы.
+ *
+ * @param options Указатель на параметры пакетной обработки.
+ * @param defaults Указатель на операции, заданные в командной строке.
+ * @return 0, если все задания выполнены успешно, или 1, если хотя бы одно не выполнено.
+ */
+int batch_run(const struct batch_options *options, const struct pipeline *defaults) {
+    FILE *input = image_path_is_stream(options->path) ? stdin : fopen(options->path, "r");
+    if (!input) {
+        perror("Не удалось открыть файл заданий");
+        return 1;
+    }
+    struct scheduler scheduler;
+    if (scheduler_start(&scheduler, options->workers, options->memory_budget) != 0) {
+        fprintf(stderr, "Ошибка: не удалось запустить потоки обработки\n");
+        if (input != stdin) {
+            fclose(input);
+        }
+        return 1;
+    }
+
+    struct batch_job **jobs = NULL;
+    size_t count = 0, capacity = 0;
+    unsigned rejected = 0;
+    unsigned number = 0;
+    char line[BATCH_MAX_LINE];
+    double start = now_seconds();
+    while (fgets(line, sizeof(line), input)) {
+        number++;
+        size_t length = strcspn(line, "\r\n");
+        if (line[length] == '\0' && !feof(input)) {
+            fprintf(stderr, "Ошибка: строка %u файла заданий длиннее %d байт\n", number, BATCH_MAX_LINE - 2);
+            int c;
+            while ((c = fgetc(input)) != EOF && c != '\n') {
+            }
+            rejected++;
+            continue;
+        }
+        line[length] = '\0';
+
+        struct batch_job *job;
+        if (parse_job(line, number, defaults, &job) != 0) {
+            rejected++;
+            continue;
+        }
+        if (!job) {
+            continue;
+        }
+        if (count == capacity) {
+            size_t grown = capacity ? capacity * 2 : 64;
+            struct batch_job **list = realloc(jobs, grown * sizeof(*list));
+            if (!list) {
+                fprintf(stderr, "Ошибка: строка %u файла заданий: не удалось выделить память\n", number);
+                batch_job_destroy(job);
+                rejected++;
+                continue;
+            }
+            jobs = list;
+            capacity = grown;
+        }
+        jobs[count++] = job;
+        job->submitted = now_seconds();
+        scheduler_submit(&scheduler, &job->task);
+    }
+    if (input != stdin) {
+        fclose(input);
+    }
+    scheduler_finish(&scheduler);
+
+    report(jobs, count, rejected, now_seconds() - start);
+    int status = rejected > 0;
+    for (size_t i = 0; i < count; i++) {
+        status |= jobs[i]->status != 0;
+        batch_job_destroy(jobs[i]);
+    }
+    free(jobs);
+    return status;
+}
@@ -0,0 +1,686 @@
+#include "bench.h"
+#include "bmp.h"
+#include "compare.h"
+#include "decoder.h"
+#include "image.h"
+#include "parallel.h"
+#include "qoi.h"
+#include "stats.h"
+#include "tiff.h"
+#include "transform.h"
+#include "uniform.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_WIDTH 8192     // Ширина изображения по умолчанию: результат заведомо больше кэша
+#define BENCH_DEFAULT_HEIGHT 6144    // Высота изображения по умолчанию
+#define BENCH_DEFAULT_REPEATS 5      // Количество повторов по умолчанию
+#define BENCH_TUNE_WIDTH 4096        // Ширина изображения для подбора профиля по умолчанию
+#define BENCH_TUNE_HEIGHT 4096       // Высота изображения для подбора профиля по умолчанию
+#define BENCH_TUNE_REPEATS 3         // Количество повторов при подборе профиля по умолчанию
+#define BENCH_REJECT_CALLS 10000     // Количество отклонений поддельного файла в одном замере
+#define BENCH_REJECT_DIMENSION 30000 // Заявленная сторона поддельного изображения (2,7 ГБ пикселей)
+
+/**
+ * @brief Заполняет параметры измерения значениями по умолчанию.
+ *
+ * @param options Указатель на параметры.
+ */
+void bench_options_init(struct bench_options *options) {
+    options->width = BENCH_DEFAULT_WIDTH;
+    options->height = BENCH_DEFAULT_HEIGHT;
+    options->repeats = BENCH_DEFAULT_REPEATS;
+}
+
+/**
+ * @brief Заполняет параметры подбора профиля значениями по умолчанию.
+ *
+ * @param options Указатель на параметры.
+ */
+void bench_tune_options_init(struct bench_options *options) {
+    options->width = BENCH_TUNE_WIDTH;
+    options->height = BENCH_TUNE_HEIGHT;
+    options->repeats = BENCH_TUNE_REPEATS;
+}
+
+/**
+ * @brief Возвращает текущее значение монотонных часов в секундах.
+ */
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Заполняет изображение детерминированным узором.
+ */
+static void fill_pattern(struct image *img) {
+    uint8_t *bytes = (uint8_t *) img->data;
+    uint64_t size = img->width * img->height * sizeof(struct pixel);
+    uint32_t state = 12345;
+    for (uint64_t i = 0; i < size; i++) {
+        state = state * 1103515245u + 12345u;
+        bytes[i] = (uint8_t) (state >> 24);
+    }
+}
+
+/**
+ * @brief Заполняет изображение плавным градиентом с небольшим шумом, похожим на фотографию.
+ *
+ * Случайный узор не сжимается, поэтому форматы со сжатием измеряются на таком изображении.
+ */
+static void fill_gradient(struct image *img) {
+    uint32_t state = 12345;
+    for (uint64_t y = 0; y < img->height; y++) {
+        struct pixel *row = image_pixel(img, 0, y);
+        for (uint64_t x = 0; x < img->width; x++) {
+            state = state * 1103515245u + 12345u;
+            uint32_t noise = (state >> 24) & 3;
+            row[x].r = (uint8_t) (x * 255 / img->width + noise);
+            row[x].g = (uint8_t) (y * 255 / img->height + noise);
+            row[x].b = (uint8_t) ((x + y) / 16 + noise);
+        }
+    }
+}
+
+/**
+ * @brief Выводит строку таблицы результатов.
+ *
+ * @param name Название замера.
+ * @param variant Вариант реализации.
+ * @param seconds Лучшее время в секундах.
+ * @param bytes Объем прочитанных и записанных данных в байтах.
+ */
+static void report(const char *name, const char *variant, double seconds, uint64_t bytes) {
+    printf("%-14s %-12s %10.2f ms %8.2f GB/s\n", name, variant, seconds * 1e3, (double) bytes / seconds * 1e-9);
+}
+
+/**
+ * @brief Измеряет лучшее время смены ориентации из нескольких повторов.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param orientation Ориентация результата.
+ * @param repeats Количество повторов.
+ * @param best Указатель, куда записывается лучшее время в секундах.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int measure_orientation(const struct image *source, enum orientation orientation, unsigned repeats,
+                               double *best) {
+    for (unsigned r = 0; r < repeats; r++) {
+        double start = now_seconds();
+        struct image result = orient_image(source, orientation);
+        double elapsed = now_seconds() - start;
+        if (!result.data) {
+            return 1;
+        }
+        destroy_image(&result);
+        if (r == 0 || elapsed < *best) {
+            *best = elapsed;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Измеряет смену ориентации с обычной и потоковой записью результата.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int bench_orientation(const struct image *source, unsigned repeats) {
+    static const enum orientation cases[] = {
+        ORIENTATION_NONE, ORIENTATION_FLIP_HORIZONTAL, ORIENTATION_ROTATE_180,
+        ORIENTATION_ROTATE_90_CCW, ORIENTATION_TRANSPOSE
+    };
+    static const char *const variants[] = {"cached", "streaming"};
+    uint64_t saved = orient_stream_threshold();
+    uint64_t bytes = 2 * source->width * source->height * sizeof(struct pixel);
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int v = 0; v < 2; v++) {
+            orient_set_stream_threshold(v ? 1 : UINT64_MAX);
+            double best = 0.0;
+            if (measure_orientation(source, cases[c], repeats, &best) != 0) {
+                orient_set_stream_threshold(saved);
+                return 1;
+            }
+            report(orientation_name(cases[c]), variants[v], best, bytes);
+        }
+    }
+    orient_set_stream_threshold(saved);
+    return 0;
+}
+
+/**
+ * @brief Измеряет запись изображения в BMP, QOI и TIFF во временный файл и сравнивает размеры файлов.
+ *
+ * @param source Указатель на изображение со сжимаемым содержимым.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1 в случае ошибки записи.
+ */
+static int bench_formats(const struct image *source, unsigned repeats) {
+    static const char *const names[] = {"bmp", "qoi", "tiff"};
+    static enum write_status (*const writers[])(FILE *, const struct image *) = {bmp_to_file, qoi_to_file,
+                                                                                 tiff_to_file};
+    uint64_t bytes = source->width * source->height * sizeof(struct pixel);
+    long sizes[3] = {0, 0, 0};
+
+    for (int f = 0; f < 3; f++) {
+        double best = 0.0;
+        for (unsigned r = 0; r < repeats; r++) {
+            FILE *out = tmpfile();
+            if (!out) {
+                return 1;
+            }
+            double start = now_seconds();
+            enum write_status status = writers[f](out, source);
+            int flushed = fflush(out) == 0;
+            double elapsed = now_seconds() - start;
+            sizes[f] = ftell(out);
+            fclose(out);
+            if (status != WRITE_OK || !flushed) {
+                return 1;
+            }
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        report("write", names[f], best, bytes);
+    }
+    printf("# размер файла: bmp %ld байт, qoi %ld байт (%.1f%%), tiff %ld байт\n", sizes[0], sizes[1],
+           sizes[0] > 0 ? 100.0 * (double) sizes[1] / (double) sizes[0] : 0.0, sizes[2]);
+    return 0;
+}
+
+/**
+ * @brief Измеряет сравнение изображений: равных, различающихся в первой строке и со статистикой различий.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int bench_compare(const struct image *source, unsigned repeats) {
+    static const char *const variants[] = {"equal", "early-exit", "stats"};
+    struct image copy = create_image_uninit(source->width, source->height);
+    if (!copy.data) {
+        return 1;
+    }
+    memcpy(copy.data, source->data, source->width * source->height * sizeof(struct pixel));
+    uint64_t bytes = 2 * source->width * source->height * sizeof(struct pixel);
+
+    for (int v = 0; v < 3; v++) {
+        // Для раннего выхода различие ставится в первую строку, для статистики - в каждую сотую строку
+        if (v == 1) {
+            copy.data[0].g ^= 1;
+        } else if (v == 2) {
+            copy.data[0].g ^= 1;
+            for (uint64_t y = 0; y < copy.height; y += 100) {
+                image_pixel(&copy, y % copy.width, y)->r ^= 0x10;
+            }
+        }
+        double best = 0.0;
+        for (unsigned r = 0; r < repeats; r++) {
+            struct image_diff diff;
+            double start = now_seconds();
+            if (v < 2) {
+                image_equal(source, &copy);
+            } else {
+                image_compare(source, &copy, &diff);
+            }
+            double elapsed = now_seconds() - start;
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        report("compare", variants[v], best, bytes);
+    }
+    destroy_image(&copy);
+    return 0;
+}
+
+/**
+ * @brief Измеряет сбор статистики пикселей (гистограммы, минимум, максимум, среднее).
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int bench_stats(const struct image *source, unsigned repeats) {
+    struct image_stats *stats = malloc(sizeof(*stats));
+    if (!stats) {
+        return 1;
+    }
+    double best = 0.0;
+    for (unsigned r = 0; r < repeats; r++) {
+        double start = now_seconds();
+        image_stats_compute(stats, source);
+        double elapsed = now_seconds() - start;
+        if (r == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    report("stats", "histogram", best, source->width * source->height * sizeof(struct pixel));
+    free(stats);
+    return 0;
+}
+
+/**
+ * @brief Возвращает наименьшее время смены ориентации с заданной картой однотонных тайлов.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param tiles Указатель на карту тайлов или NULL.
+ * @param repeats Количество повторов.
+ * @param best Указатель, по которому будет записано время в секундах.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int measure_sparse(const struct image *source, const struct uniform_tiles *tiles, unsigned repeats,
+                          double *best) {
+    struct image_rect full = {0, 0, source->width, source->height};
+    for (unsigned r = 0; r < repeats; r++) {
+        double start = now_seconds();
+        struct image result = orient_region_sparse(source, &full, ORIENTATION_ROTATE_90_CCW, NULL, tiles);
+        double elapsed = now_seconds() - start;
+        if (!result.data) {
+            return 1;
+        }
+        destroy_image(&result);
+        if (r == 0 || elapsed < *best) {
+            *best = elapsed;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Измеряет поиск однотонных тайлов и смену ориентации с их заполнением цветом.
+ *
+ * Четыре из каждых пяти полос тайлов изображения закрашиваются белым, как на скане с большим фоном.
+ * Изображение после измерения остается измененным.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int bench_sparse(struct image *source, unsigned repeats) {
+    uint64_t tile = orient_tile_size();
+    for (uint64_t y = 0; y < source->height; y++) {
+        if (y / tile % 5 != 0) {
+            memset(image_pixel(source, 0, y), 0xff, source->width * sizeof(struct pixel));
+        }
+    }
+    uint64_t bytes = source->width * source->height * sizeof(struct pixel);
+
+    struct uniform_tiles tiles;
+    double detect = 0.0;
+    for (unsigned r = 0; r < repeats; r++) {
+        double start = now_seconds();
+        if (uniform_tiles_init(&tiles, source->width, source->height, tile) != 0) {
+            return 1;
+        }
+        for (uint64_t y = 0; y < source->height; y++) {
+            uniform_tiles_row(&tiles, y, image_pixel(source, 0, y));
+        }
+        double elapsed = now_seconds() - start;
+        if (r + 1 < repeats) {
+            uniform_tiles_destroy(&tiles);
+        }
+        if (r == 0 || elapsed < detect) {
+            detect = elapsed;
+        }
+    }
+    report("sparse", "detect", detect, bytes);
+
+    double dense = 0.0, sparse = 0.0;
+    int status = measure_sparse(source, NULL, repeats, &dense);
+    if (status == 0) {
+        status = measure_sparse(source, &tiles, repeats, &sparse);
+    }
+    if (status == 0) {
+        report("sparse", "ccw90-dense", dense, bytes);
+        report("sparse", "ccw90-sparse", sparse, bytes);
+    }
+    uniform_tiles_destroy(&tiles);
+    return status;
+}
+
+/**
+ * @brief Записывает во временный файл заголовок, заявляющий изображение гораздо больше самого файла.
+ *
+ * @param format Номер формата: 0 - BMP, 1 - PPM, 2 - QOI.
+ * @return Указатель на файл или NULL в случае ошибки.
+ */
+static FILE *forged_file(int format) {
+    FILE *file = tmpfile();
+    if (!file) {
+        return NULL;
+    }
+    uint8_t bytes[100] = {0};
+    size_t size = sizeof(bytes);
+    if (format == 0) {
+        struct bmp_header header = {0};
+        header.bfType = BMP_SIGNATURE;
+        header.bOffBits = sizeof(header);
+        header.biSize = BITMAPINFOHEADER_SIZE;
+        header.biWidth = BENCH_REJECT_DIMENSION;
+        header.biHeight = BENCH_REJECT_DIMENSION;
+        header.biPlanes = 1;
+        header.biBitCount = BMP_BPP;
+        memcpy(bytes, &header, sizeof(header));
+    } else if (format == 1) {
+        snprintf((char *) bytes, sizeof(bytes), "P6\n%d %d\n255\n", BENCH_REJECT_DIMENSION, BENCH_REJECT_DIMENSION);
+    } else {
+        static const uint8_t qoi[QOI_HEADER_SIZE] = {'q', 'o', 'i', 'f', 0, 0, 0x75, 0x30, 0, 0, 0x75, 0x30, 3, 0};
+        memcpy(bytes, qoi, sizeof(qoi));
+    }
+    if (fwrite(bytes, 1, size, file) != size || fflush(file) != 0) {
+        fclose(file);
+        return NULL;
+    }
+    return file;
+}
+
+/**
+ * @brief Измеряет отклонение файлов в сотню байт, заголовок которых заявляет изображение в гигабайты.
+ *
+ * Такой файл должен отклоняться по размеру файла до выделения памяти, поэтому время одного отклонения -
+ * единицы микросекунд, а не время выделения и обнуления гигабайтов.
+ *
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если файл не создан или не был отклонен.
+ */
+static int bench_reject(unsigned repeats) {
+    static const char *const names[] = {"bmp", "ppm", "qoi"};
+    for (int f = 0; f < 3; f++) {
+        FILE *file = forged_file(f);
+        if (!file) {
+            return 1;
+        }
+        double best = 0.0;
+        int rejected = 1;
+        for (unsigned r = 0; r < repeats && rejected; r++) {
+            double start = now_seconds();
+            for (unsigned i = 0; i < BENCH_REJECT_CALLS && rejected; i++) {
+                struct image img;
+                rewind(file);
+                rejected = decoder_read_image(file, &img) == READ_INVALID_HEADER;
+            }
+            double elapsed = (now_seconds() - start) / BENCH_REJECT_CALLS;
+            if (r == 0 || elapsed < best) {
+                best = elapsed;
+            }
+        }
+        fclose(file);
+        if (!rejected) {
+            fprintf(stderr, "Ошибка: поддельный файл %s не отклонен\n", names[f]);
+            return 1;
+        }
+        printf("%-14s %-12s %10.2f us\n", "reject", names[f], best * 1e6);
+    }
+    return 0;
+}
+
+/**
+ * @brief Измеряет смену ориентации каждым набором специализированных ядер, поддерживаемым процессором.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int bench_kernels(const struct image *source, unsigned repeats) {
+    uint64_t bytes = 2 * source->width * source->height * sizeof(struct pixel);
+    enum orient_kernels saved = orient_active_kernels();
+
+    for (int o = 0; o < ORIENTATION_COUNT; o++) {
+        for (int k = ORIENT_KERNELS_GENERIC; k < ORIENT_KERNELS_COUNT; k++) {
+            if (orient_set_kernels((enum orient_kernels) k) != 0) {
+                continue;
+            }
+            double best = 0.0;
+            if (measure_orientation(source, (enum orientation) o, repeats, &best) != 0) {
+                orient_set_kernels(saved);
+                return 1;
+            }
+            report(orientation_name((enum orientation) o), orient_kernels_name((enum orient_kernels) k), best, bytes);
+        }
+    }
+    orient_set_kernels(saved);
+    return 0;
+}
+
+/**
+ * @brief Настройка профиля, перебираемая при подборе.
+ */
+struct tune_axis {
+    const char *name;                // Имя настройки в таблице результатов
+    const uint64_t *values;          // Значения-кандидаты
+    size_t count;                    // Количество кандидатов
+    /**
+     * Записывает значение настройки в профиль.
+     */
+    void (*set)(struct transform_profile *profile, uint64_t value);
+    /**
+     * Формирует подпись значения для таблицы результатов.
+     */
+    void (*label)(char *buffer, size_t size, uint64_t value);
+};
+
+static const uint64_t tile_values[] = {16, 32, 64, 128, 256};
+static const uint64_t prefetch_values[] = {0, 1, 2, 4, 8, 16, 32};
+
+// Запись перебираемых значений в профиль и их подписи для таблицы результатов
+
+static void set_kernels(struct transform_profile *profile, uint64_t value) {
+    profile->kernels = (enum orient_kernels) value;
+}
+
+static void set_tile(struct transform_profile *profile, uint64_t value) {
+    profile->tile_size = value;
+}
+
+static void set_prefetch(struct transform_profile *profile, uint64_t value) {
+    profile->prefetch_distance = value;
+}
+
+static void set_threads(struct transform_profile *profile, uint64_t value) {
+    profile->threads = (unsigned) value;
+}
+
+static void set_stream(struct transform_profile *profile, uint64_t value) {
+    profile->stream_threshold = value;
+}
+
+static void label_number(char *buffer, size_t size, uint64_t value) {
+    snprintf(buffer, size, "%llu", (unsigned long long) value);
+}
+
+static void label_kernels(char *buffer, size_t size, uint64_t value) {
+    snprintf(buffer, size, "%s", orient_kernels_name((enum orient_kernels) value));
+}
+
+static void label_stream(char *buffer, size_t size, uint64_t value) {
+    if (value == UINT64_MAX) {
+        snprintf(buffer, size, "off");
+    } else {
+        snprintf(buffer, size, "%llu", (unsigned long long) value);
+    }
+}
+
+/**
+ * @brief Подбирает значение одной настройки профиля, при котором смена ориентации выполняется быстрее всего.
+ *
+ * Для каждого кандидата профиль применяется ко всему процессу и измеряется суммарное время ориентаций
+ * с построчным и постолбцовым обходом в обоих направлениях. Лучший вариант записывается в профиль
+ * и остается примененным.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param repeats Количество повторов.
+ * @param axis Указатель на перебираемую настройку.
+ * @param profile Указатель на профиль: исходные значения остальных настроек и результат подбора.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int tune_axis(const struct image *source, unsigned repeats, const struct tune_axis *axis,
+                     struct transform_profile *profile) {
+    static const enum orientation cases[] = {
+        ORIENTATION_NONE, ORIENTATION_FLIP_HORIZONTAL, ORIENTATION_ROTATE_90_CCW, ORIENTATION_ROTATE_90_CW
+    };
+    size_t case_count = sizeof(cases) / sizeof(cases[0]);
+    uint64_t bytes = 2 * source->width * source->height * sizeof(struct pixel) * case_count;
+    struct transform_profile best = *profile;
+    double best_time = 0.0;
+
+    for (size_t i = 0; i < axis->count; i++) {
+        struct transform_profile candidate = *profile;
+        axis->set(&candidate, axis->values[i]);
+        profile_apply(&candidate);
+
+        double total = 0.0;
+        for (size_t c = 0; c < case_count; c++) {
+            double fastest = 0.0;
+            if (measure_orientation(source, cases[c], repeats, &fastest) != 0) {
+                profile_apply(profile);
+                return 1;
+            }
+            total += fastest;
+        }
+
+        char label[32];
+        axis->label(label, sizeof(label), axis->values[i]);
+        report(axis->name, label, total, bytes);
+        if (i == 0 || total < best_time) {
+            best_time = total;
+            best = candidate;
+        }
+    }
+    *profile = best;
+    profile_apply(profile);
+    return 0;
+}
+
+/**
+ * @brief Измеряет скорость основных ядер на синтетическом изображении и выводит таблицу в стандартный вывод.
+ *
+ * @param options Указатель на параметры измерения.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int bench_run(const struct bench_options *options) {
+    struct image source = create_image_uninit(options->width, options->height);
+    if (!source.data) {
+        fprintf(stderr, "Ошибка: не удалось выделить память для изображения %llux%llu\n",
+                (unsigned long long) options->width, (unsigned long long) options->height);
+        return 1;
+    }
+    fill_pattern(&source);
+
+    printf("# изображение %llux%llu, порог потоковой записи %llu байт, дальность предвыборки %llu\n",
+           (unsigned long long) source.width, (unsigned long long) source.height,
+           (unsigned long long) orient_stream_threshold(), (unsigned long long) orient_prefetch_distance());
+    struct transform_profile saved, profile;
+    profile_capture(&saved);
+    profile = saved;
+    int status = bench_orientation(&source, options->repeats);
+    if (status == 0) {
+        status = bench_kernels(&source, options->repeats);
+    }
+    if (status == 0) {
+        fill_gradient(&source);
+        status = bench_formats(&source, options->repeats);
+        fill_pattern(&source);
+    }
+    if (status == 0) {
+        status = bench_compare(&source, options->repeats);
+    }
+    if (status == 0) {
+        status = bench_stats(&source, options->repeats);
+    }
+    if (status == 0) {
+        status = bench_sparse(&source, options->repeats);
+        fill_pattern(&source);
+    }
+    if (status == 0) {
+        status = bench_reject(options->repeats);
+    }
+    if (status == 0) {
+        struct tune_axis axis = {"prefetch", prefetch_values, sizeof(prefetch_values) / sizeof(prefetch_values[0]),
+                                 set_prefetch, label_number};
+        status = tune_axis(&source, options->repeats, &axis, &profile);
+    }
+    if (status == 0) {
+        printf("# лучшая дальность предвыборки: %llu (--prefetch %llu)\n",
+               (unsigned long long) profile.prefetch_distance, (unsigned long long) profile.prefetch_distance);
+    }
+    profile_apply(&saved);
+
+    destroy_image(&source);
+    if (status != 0) {
+        fprintf(stderr, "Ошибка: не удалось выделить память для результата\n");
+    }
+    return status;
+}
+
+/**
+ * @brief Подбирает настройки механизма смены ориентации для текущей машины.
+ *
+ * @param options Указатель на параметры измерения.
+ * @param profile Указатель на профиль: начальные настройки и результат подбора.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int bench_tune(const struct bench_options *options, struct transform_profile *profile) {
+    struct image source = create_image_uninit(options->width, options->height);
+    if (!source.data) {
+        fprintf(stderr, "Ошибка: не удалось выделить память для изображения %llux%llu\n",
+                (unsigned long long) options->width, (unsigned long long) options->height);
+        return 1;
+    }
+    fill_pattern(&source);
+
+    // Наборы ядер и количества потоков зависят от машины
+    uint64_t kernel_values[ORIENT_KERNELS_COUNT];
+    size_t kernel_count = 0;
+    enum orient_kernels saved_kernels = orient_active_kernels();
+    for (int k = ORIENT_KERNELS_GENERIC; k < ORIENT_KERNELS_COUNT; k++) {
+        if (orient_set_kernels((enum orient_kernels) k) == 0) {
+            kernel_values[kernel_count++] = (uint64_t) k;
+        }
+    }
+    orient_set_kernels(saved_kernels);
+
+    uint64_t thread_values[32];
+    size_t thread_count = 0;
+    unsigned saved_threads = parallel_thread_count();
+    parallel_set_thread_count(0);
+    unsigned max_threads = parallel_thread_count();
+    parallel_set_thread_count(saved_threads);
+    for (unsigned t = 1; t < max_threads; t *= 2) {
+        thread_values[thread_count++] = t;
+    }
+    thread_values[thread_count++] = max_threads;
+
+    // Потоковая запись либо выключена, либо включается для результатов не меньше измеряемого
+    uint64_t image_bytes = source.width * source.height * sizeof(struct pixel);
+    uint64_t stream_values[] = {UINT64_MAX, image_bytes};
+
+    const struct tune_axis axes[] = {
+        {"kernels", kernel_values, kernel_count, set_kernels, label_kernels},
+        {"tile", tile_values, sizeof(tile_values) / sizeof(tile_values[0]), set_tile, label_number},
+        {"prefetch", prefetch_values, sizeof(prefetch_values) / sizeof(prefetch_values[0]), set_prefetch, label_number},
+        {"threads", thread_values, thread_count, set_threads, label_number},
+        {"stream", stream_values, sizeof(stream_values) / sizeof(stream_values[0]), set_stream, label_stream},
+    };
+
+    printf("# подбор профиля на изображении %llux%llu, повторов %u\n", (unsigned long long) source.width,
+           (unsigned long long) source.height, options->repeats);
+    int status = 0;
+    for (size_t a = 0; status == 0 && a < sizeof(axes) / sizeof(axes[0]); a++) {
+        status = tune_axis(&source, options->repeats, &axes[a], profile);
+    }
+
+    destroy_image(&source);
+    if (status != 0) {
+        fprintf(stderr, "Ошибка: не удалось выделить память для результата\n");
+    }
+    return status;
+}
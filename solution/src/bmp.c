@@ -1,21 +1,72 @@
 #include "bmp.h"
+#include "raster.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#define BMP_BPP_32 32                // Количество бит на пиксель в 32-битном BMP (BGRX или BGRA)
+#define BMP_BI_RGB 0                 // Сжатие отсутствует
+#define BMP_BI_BITFIELDS 3           // Каналы заданы масками, записанными после BITMAPINFOHEADER
+#define BMP_MASKS_SIZE 12            // Размер масок красного, зеленого и синего каналов в байтах
+#define BMP_FILE_HEADER_SIZE 14      // Размер BITMAPFILEHEADER, после которого начинается BITMAPINFOHEADER
+
 /**
- * @brief Читает строку данных изображения BMP из файла.
+ * @brief Вычисляет размер строки BMP в байтах с учетом выравнивания.
  *
- * @param in Указатель на файл для чтения.
- * @param row_data Буфер для хранения прочитанной строки.
- * @param bmp_row_size Размер строки BMP в байтах.
- * @return 0, если чтение прошло успешно, или -1 в случае ошибки.
+ * @param width Ширина изображения в пикселях.
+ * @param pixel_size Размер пикселя в файле в байтах.
+ * @return Размер строки в файле, кратный `BMP_PADDING`.
  */
-static int read_bmp_row(FILE *in, uint8_t *row_data, uint64_t bmp_row_size) {
-    if (fread(row_data, 1, bmp_row_size, in) != bmp_row_size) {
-        return -1;
+static uint64_t bmp_row_size(uint64_t width, uint64_t pixel_size) {
+    return (width * pixel_size + BMP_PADDING - 1) & ~(uint64_t) (BMP_PADDING - 1);
+}
+
+/**
+ * @brief Возвращает количество байт от начала файла до конца заголовка и масок каналов.
+ */
+static uint64_t bmp_header_end(const struct bmp_header *header) {
+    return sizeof(struct bmp_header) + (header->biCompression == BMP_BI_BITFIELDS ? BMP_MASKS_SIZE : 0);
+}
+
+/**
+ * @brief Возвращает высоту изображения в пикселях.
+ *
+ * Отрицательная высота в заголовке означает, что строки хранятся сверху вниз.
+ *
+ * @param header Указатель на проверенный заголовок файла.
+ * @return Высота изображения в пикселях.
+ */
+uint64_t bmp_image_height(const struct bmp_header *header) {
+    int32_t height = (int32_t) header->biHeight;
+    return height < 0 ? (uint64_t) -(int64_t) height : (uint64_t) height;
+}
+
+/**
+ * @brief Упаковывает 32-битные пиксели BGRX в 24-битные, отбрасывая четвертый байт.
+ */
+static void bmp_convert_32(const void *ctx, struct pixel *out, const uint8_t *in, uint64_t count) {
+    (void) ctx;
+    for (uint64_t i = 0; i < count; i++, in += 4) {
+        out[i].b = in[0];
+        out[i].g = in[1];
+        out[i].r = in[2];
     }
-    return 0;
+}
+
+/**
+ * @brief Описывает расположение строк BMP файла по его заголовку.
+ *
+ * @param header Указатель на проверенный заголовок файла.
+ * @return Расположение строк для `raster_read_region`.
+ */
+static struct raster_layout bmp_layout(const struct bmp_header *header) {
+    uint64_t pixel_size = header->biBitCount / 8;
+    struct raster_layout layout = {
+        header->biWidth, bmp_image_height(header), header->bOffBits, bmp_header_end(header),
+        bmp_row_size(header->biWidth, pixel_size), pixel_size, (int32_t) header->biHeight > 0,
+        header->biBitCount == BMP_BPP_32 ? bmp_convert_32 : NULL, NULL
+    };
+    return layout;
 }
 
 /**
@@ -39,113 +90,215 @@ static int write_bmp_row(FILE *out, const uint8_t *row_data, uint64_t row_size,
 }
 
 /**
- * @brief Читает изображение BMP из файла и загружает его в структуру `image`.
+ * @brief Читает и проверяет заголовок BMP файла.
  *
  * @param in Указатель на файл для чтения.
- * @param img Указатель на структуру `image`, в которую будут загружены данные изображения.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
  * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
  */
-enum read_status bmp_from_file(FILE *in, struct image *img) {
-    if (!in || !img) return READ_INVALID_HEADER;
+enum read_status bmp_read_header(FILE *in, struct bmp_header *header) {
+    return bmp_read_header_prefixed(in, NULL, 0, header);
+}
 
-    struct bmp_header header;
-    if (fread(&header, sizeof(struct bmp_header), 1, in) != 1)
+/**
+ * @brief Дочитывает и проверяет заголовок BMP файла, первые байты которого уже прочитаны.
+ *
+ * Поддерживаются 24-битные и 32-битные изображения без сжатия, 32-битные с масками каналов BGRX,
+ * заголовки BITMAPINFOHEADER и более новые версии, а также строки, хранящиеся сверху вниз.
+ * Заголовок, который не помещается перед данными изображения, и данные, выходящие за конец файла,
+ * отклоняются сразу, без чтения данных и выделения памяти.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param prefix Уже прочитанные первые байты файла (может быть NULL при `prefix_size` 0).
+ * @param prefix_size Количество уже прочитанных байт (не больше размера заголовка).
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status bmp_read_header_prefixed(FILE *in, const uint8_t *prefix, size_t prefix_size,
+                                          struct bmp_header *header) {
+    if (!in || !header || prefix_size > sizeof(struct bmp_header)) return READ_INVALID_HEADER;
+
+    uint8_t *bytes = (uint8_t *) header;
+    if (prefix_size > 0) {
+        memcpy(bytes, prefix, prefix_size);
+    }
+    if (fread(bytes + prefix_size, sizeof(struct bmp_header) - prefix_size, 1, in) != 1)
         return READ_IO_ERROR;
 
-    if (header.bfType != BMP_SIGNATURE)
+    if (header->bfType != BMP_SIGNATURE)
         return READ_INVALID_SIGNATURE;
 
-    if (header.biBitCount != BMP_BPP)
+    if (header->biBitCount != BMP_BPP && header->biBitCount != BMP_BPP_32)
         return READ_INVALID_BITS;
 
-    uint32_t width = header.biWidth;
-    uint32_t height = header.biHeight;
-    uint64_t abs_width = (uint64_t) width;
-    uint64_t abs_height = (uint64_t) height;
+    if (header->biCompression != BMP_BI_RGB
+        && !(header->biCompression == BMP_BI_BITFIELDS && header->biBitCount == BMP_BPP_32))
+        return READ_INVALID_BITS;
 
-    // Проверка на переполнение при выделении памяти
-    if (abs_width == 0 || abs_height == 0 || abs_height > UINT64_MAX / abs_width) {
-        return READ_INVALID_HEADER;
+    if (header->biCompression == BMP_BI_BITFIELDS) {
+        // Маски записаны сразу после BITMAPINFOHEADER (или входят в заголовок версий 4 и 5)
+        static const uint8_t bgrx_masks[BMP_MASKS_SIZE] = {0, 0, 0xff, 0, 0, 0xff, 0, 0, 0xff, 0, 0, 0};
+        uint8_t masks[BMP_MASKS_SIZE];
+        if (fread(masks, sizeof(masks), 1, in) != 1)
+            return READ_IO_ERROR;
+        if (memcmp(masks, bgrx_masks, sizeof(masks)) != 0)
+            return READ_INVALID_BITS;
     }
 
-    *img = create_image(abs_width, abs_height);
-    if (!img->data) {
-        return READ_MEMORY_ERROR;
-    }
+    if ((int32_t) header->biWidth <= 0 || header->biHeight == 0 || header->biHeight == (uint32_t) INT32_MIN
+        || header->biSize < BITMAPINFOHEADER_SIZE || header->bOffBits < bmp_header_end(header)
+        || header->biSize > header->bOffBits - BMP_FILE_HEADER_SIZE)
+        return READ_INVALID_HEADER;
 
-    // Вычисление размера строки с учетом выравнивания
-    uint64_t pixel_row_size = abs_width * sizeof(struct pixel);
-    uint64_t row_padding = (BMP_PADDING - (pixel_row_size % BMP_PADDING)) % BMP_PADDING;
-    uint64_t bmp_row_size = pixel_row_size + row_padding;
+    // Данные проверяются по размеру файла до того, как по заголовку будет выделена память
+    struct raster_layout layout = bmp_layout(header);
+    return raster_check_size(in, &layout);
+}
 
-    if (fseek(in, (long) header.bOffBits, SEEK_SET) != 0) {
-        destroy_image(img);
-        return READ_IO_ERROR;
-    }
+/**
+ * @brief Читает из BMP файла строки заданной области и передает их обработчику.
+ *
+ * Для каждой строки области читаются только байты ее пикселей, без выравнивания и соседних столбцов.
+ * Строки обходятся по возрастанию смещения в файле (обычно снизу вверх). Если файл не допускает
+ * позиционного чтения (канал), строки читаются последовательно. 32-битные пиксели упаковываются в 24-битные.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param header Указатель на прочитанный заголовок файла.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status bmp_read_region(FILE *in, const struct bmp_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx) {
+    if (!in || !header || !region || !handler) return READ_INVALID_HEADER;
 
-    uint8_t *row_data = malloc(bmp_row_size);
-    if (!row_data) {
-        destroy_image(img);
+    struct raster_layout layout = bmp_layout(header);
+    return raster_read_region(in, &layout, region, handler, ctx);
+}
+
+/**
+ * @brief Копирует прочитанную строку в соответствующую строку изображения.
+ *
+ * @param ctx Указатель на структуру `image`, в которую загружаются данные.
+ * @param y Номер строки изображения.
+ * @param row Пиксели строки.
+ * @return Всегда 0.
+ */
+static int store_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct image *img = ctx;
+    memcpy(image_pixel(img, 0, y), row, img->width * sizeof(struct pixel));
+    return 0;
+}
+
+/**
+ * @brief Читает изображение BMP из файла и загружает его в структуру `image`.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param img Указатель на структуру `image`, в которую будут загружены данные изображения.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status bmp_from_file(FILE *in, struct image *img) {
+    if (!in || !img) return READ_INVALID_HEADER;
+
+    struct bmp_header header;
+    enum read_status status = bmp_read_header(in, &header);
+    if (status != READ_OK)
+        return status;
+
+    *img = create_image_uninit(header.biWidth, bmp_image_height(&header));
+    if (!img->data) {
         return READ_MEMORY_ERROR;
     }
 
-    for (uint64_t y = 0; y < abs_height; y++) {
-        uint64_t row = (abs_height - 1 - y);
-        if (read_bmp_row(in, row_data, bmp_row_size) != 0) {
-            free(row_data);
-            destroy_image(img);
-            return READ_IO_ERROR;
-        }
-        struct pixel *row_ptr = image_pixel(img, 0, row);
-        memcpy(row_ptr, row_data, pixel_row_size);
+    struct image_rect full = {0, 0, img->width, img->height};
+    status = bmp_read_region(in, &header, &full, store_row, img);
+    if (status != READ_OK) {
+        destroy_image(img);
     }
 
-    free(row_data);
-
-    return READ_OK;
+    return status;
 }
 
 
 /**
- * @brief Записывает изображение BMP в файл.
+ * @brief Записывает заголовок 24-битного BMP файла для изображения заданного размера.
  *
  * @param out Указатель на файл для записи.
- * @param img Указатель на структуру `image` с данными для записи.
- * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Статус записи (`WRITE_OK`, `WRITE_IMAGE_TOO_LARGE` или `WRITE_HEADER_ERROR`).
  */
-enum write_status bmp_to_file(FILE *out, const struct image *img) {
-    if (!out) {
-        return WRITE_FILE_POINTER_NULL;
-    }
-
-    if (!img) {
-        return WRITE_IMAGE_POINTER_NULL;
-    }
-
+static enum write_status write_bmp_header(FILE *out, uint64_t width, uint64_t height) {
     struct bmp_header header = {0};
     header.bfType = BMP_SIGNATURE;
     header.bOffBits = sizeof(struct bmp_header);
     header.biSize = BITMAPINFOHEADER_SIZE;
 
-    if (img->width > UINT32_MAX || img->height > UINT32_MAX) {
+    // Отрицательная высота означает строки сверху вниз, поэтому старший бит занимать нельзя
+    uint64_t file_size = bmp_file_size(width, height);
+    if (width > BMP_MAX_DIMENSION || height > BMP_MAX_DIMENSION || file_size == UINT64_MAX) {
         return WRITE_IMAGE_TOO_LARGE;
     }
 
-    header.biWidth = (uint32_t) img->width;
-    header.biHeight = (uint32_t) img->height;
+    header.biWidth = (uint32_t) width;
+    header.biHeight = (uint32_t) height;
     header.biPlanes = 1;
     header.biBitCount = BMP_BPP;
     header.biCompression = 0;
 
-    uint64_t row_size = (img->width * sizeof(struct pixel) + BMP_PADDING - 1) & ~(BMP_PADDING - 1);
-    uint64_t padding = row_size - img->width * sizeof(struct pixel);
-    header.biSizeImage = row_size * img->height;
-    header.bfileSize = header.bOffBits + header.biSizeImage;
+    // Размеры больше 4 ГиБ не помещаются в заголовок и записываются нулями (см. bmp_file_size)
+    if (file_size <= BMP_MAX_FILE_SIZE) {
+        header.biSizeImage = (uint32_t) (file_size - header.bOffBits);
+        header.bfileSize = (uint32_t) file_size;
+    }
 
     if (fwrite(&header, sizeof(struct bmp_header), 1, out) != 1) {
         return WRITE_HEADER_ERROR;
     }
+    return WRITE_OK;
+}
+
+/**
+ * @brief Вычисляет размер BMP файла с изображением заданного размера.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Размер файла в байтах или `UINT64_MAX`, если он не помещается в 64 бита.
+ */
+uint64_t bmp_file_size(uint64_t width, uint64_t height) {
+    if (width > (UINT64_MAX - BMP_PADDING) / sizeof(struct pixel)) {
+        return UINT64_MAX;
+    }
+    uint64_t row_size = bmp_row_size(width, sizeof(struct pixel));
+    if (height != 0 && row_size > (UINT64_MAX - sizeof(struct bmp_header)) / height) {
+        return UINT64_MAX;
+    }
+    return sizeof(struct bmp_header) + row_size * height;
+}
 
+/**
+ * @brief Записывает изображение BMP в файл.
+ *
+ * @param out Указатель на файл для записи.
+ * @param img Указатель на структуру `image` с данными для записи.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status bmp_to_file(FILE *out, const struct image *img) {
+    if (!out) {
+        return WRITE_FILE_POINTER_NULL;
+    }
+
+    if (!img) {
+        return WRITE_IMAGE_POINTER_NULL;
+    }
+
+    enum write_status status = write_bmp_header(out, img->width, img->height);
+    if (status != WRITE_OK) {
+        return status;
+    }
+
+    uint64_t padding = bmp_row_size(img->width, sizeof(struct pixel)) - img->width * sizeof(struct pixel);
     for (uint64_t y = 0; y < img->height; y++) {
         uint64_t row = img->height - 1 - y;
         if (write_bmp_row(out, (const uint8_t *) image_pixel(img, 0, row), img->width * sizeof(struct pixel), padding) != 0) {
@@ -156,3 +309,38 @@ enum write_status bmp_to_file(FILE *out, const struct image *img) {
     return WRITE_OK;
 }
 
+/**
+ * @brief Записывает BMP файл, получая строки изображения по одной от источника.
+ *
+ * @param out Указатель на файл для записи.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status bmp_write_rows(FILE *out, uint64_t width, uint64_t height, image_row_source source, void *ctx) {
+    if (!out) {
+        return WRITE_FILE_POINTER_NULL;
+    }
+
+    enum write_status status = write_bmp_header(out, width, height);
+    if (status != WRITE_OK) {
+        return status;
+    }
+
+    struct pixel *row = malloc(width * sizeof(struct pixel));
+    if (!row) {
+        return WRITE_ROW_ERROR;
+    }
+    uint64_t padding = bmp_row_size(width, sizeof(struct pixel)) - width * sizeof(struct pixel);
+    for (uint64_t i = 0; i < height && status == WRITE_OK; i++) {
+        uint64_t y = height - 1 - i;
+        if (source(ctx, y, row) != 0
+            || write_bmp_row(out, (const uint8_t *) row, width * sizeof(struct pixel), padding) != 0) {
+            status = WRITE_ROW_ERROR;
+        }
+    }
+    free(row);
+    return status;
+}
@@ -0,0 +1,487 @@
+#include "buffer.h"
+#include "parallel.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#define BUFFER_HEADER_SIZE 64                    // Размер заголовка перед данными (кратен выравниванию malloc)
+#define BUFFER_DEFAULT_THRESHOLD (32ull << 20)   // Порог по умолчанию: меньшие буферы выделяются из кучи
+#define BUFFER_HUGE_PAGE_SIZE (2ull << 20)       // Размер большой страницы
+#define BUFFER_PAGE_SIZE 4096                    // Размер обычной страницы
+#define BUFFER_TOUCH_GRAIN 256                   // Количество страниц в порции первого обращения
+#define BUFFER_MPOL_INTERLEAVE 3                 // Политика MPOL_INTERLEAVE системного вызова mbind
+#define BUFFER_MAX_NODES 1024                    // Максимальное количество узлов NUMA в маске
+#define BUFFER_POISON_BYTE 0xA5                  // Заполнитель неинициализированных буферов в отладочной сборке
+
+/**
+ * @brief Способ выделения буфера.
+ */
+enum buffer_kind {
+    BUFFER_KIND_HEAP = 0,            // Выделен из кучи
+    BUFFER_KIND_MAPPED               // Отображен напрямую (mmap)
+};
+
+/**
+ * @brief Заявка одной загрузки в бюджете памяти.
+ *
+ * Буферы загрузки ссылаются на заявку из заголовка, поэтому ее можно снять при освобождении
+ * последнего буфера в любом потоке. Структура живет, пока на нее ссылаются буферы или поток,
+ * для которого загрузка текущая.
+ */
+struct buffer_claim {
+    uint64_t amount;                 // Учтенный в бюджете объем (0 после снятия заявки)
+    uint64_t held;                   // Суммарный размер живых буферов загрузки
+    unsigned buffers;                // Количество живых буферов загрузки
+    unsigned refs;                   // Количество ссылок: живые буферы и поток загрузки
+};
+
+/**
+ * @brief Заголовок, хранящийся непосредственно перед данными буфера.
+ */
+struct buffer_header {
+    void *base;                      // Начало выделенной области
+    uint64_t size;                   // Размер выделенной области в байтах
+    uint64_t accounted;              // Размер данных, учтенный в бюджете памяти
+    struct buffer_claim *claim;      // Заявка загрузки, которой принадлежит буфер
+    enum buffer_kind kind;           // Способ выделения
+};
+
+// Параметры выделения; задаются один раз при запуске программы
+static struct buffer_options current = {BUFFER_HUGE_PAGES_OFF, BUFFER_NUMA_OFF, BUFFER_DEFAULT_THRESHOLD, 0};
+
+static pthread_mutex_t budget_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t budget_freed = PTHREAD_COND_INITIALIZER;
+static uint64_t committed = 0;        // Сумма заявок выполняемых загрузок
+static uint64_t used = 0;             // Суммарный размер живых буферов
+static uint64_t peak = 0;             // Наибольшее значение `used`
+
+static pthread_once_t claim_key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t claim_key;               // Снимает ссылку потока на его заявку при завершении потока
+
+static __thread struct buffer_claim *thread_claim = NULL; // Заявка текущей загрузки потока
+static __thread uint64_t thread_expected = 0; // Ожидаемый объем следующей загрузки потока
+
+/**
+ * @brief Заполняет параметры значениями по умолчанию: обычное выделение памяти.
+ *
+ * @param options Указатель на параметры.
+ */
+void buffer_options_init(struct buffer_options *options) {
+    options->huge_pages = BUFFER_HUGE_PAGES_OFF;
+    options->numa = BUFFER_NUMA_OFF;
+    options->threshold = BUFFER_DEFAULT_THRESHOLD;
+    options->memory_budget = 0;
+}
+
+/**
+ * @brief Задает параметры для последующих выделений буферов.
+ *
+ * @param options Указатель на параметры.
+ */
+void buffer_configure(const struct buffer_options *options) {
+    current = *options;
+}
+
+/**
+ * @brief Определяет режим больших страниц по имени.
+ *
+ * @param name Имя режима.
+ * @param mode Указатель на результат.
+ * @return 0, если имя известно, или 1 в противном случае.
+ */
+int buffer_huge_pages_from_name(const char *name, enum buffer_huge_pages *mode) {
+    static const char *const names[] = {"off", "thp", "explicit"};
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *mode = (enum buffer_huge_pages) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Определяет режим размещения по узлам NUMA по имени.
+ *
+ * @param name Имя режима.
+ * @param mode Указатель на результат.
+ * @return 0, если имя известно, или 1 в противном случае.
+ */
+int buffer_numa_from_name(const char *name, enum buffer_numa *mode) {
+    static const char *const names[] = {"off", "interleave", "first-touch"};
+    for (int i = 0; i < 3; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *mode = (enum buffer_numa) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Сообщает учету памяти, сколько байт займут буферы следующей загрузки в текущем потоке.
+ *
+ * @param bytes Ожидаемый объем буферов загрузки (0 - только размер первого буфера).
+ */
+void buffer_expect(uint64_t bytes) {
+    thread_expected = bytes;
+}
+
+/**
+ * @brief Возвращает бюджет памяти буферов.
+ *
+ * @return Бюджет в байтах (0 - без ограничения).
+ */
+uint64_t buffer_memory_budget(void) {
+    return current.memory_budget;
+}
+
+/**
+ * @brief Возвращает наибольший суммарный размер одновременно живых буферов изображений.
+ *
+ * @return Размер в байтах.
+ */
+uint64_t buffer_peak_usage(void) {
+    pthread_mutex_lock(&budget_lock);
+    uint64_t result = peak;
+    pthread_mutex_unlock(&budget_lock);
+    return result;
+}
+
+/**
+ * @brief Возвращает пиковый размер резидентной памяти процесса (peak RSS).
+ *
+ * @return Размер в байтах или 0, если система его не сообщает.
+ */
+uint64_t buffer_peak_rss(void) {
+#ifdef __linux__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        return (uint64_t) usage.ru_maxrss << 10; // В Linux значение в килобайтах
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief Снимает ссылку на заявку и освобождает ее после последней ссылки. Вызывается под `budget_lock`.
+ */
+static void claim_unref(struct buffer_claim *claim) {
+    if (--claim->refs == 0) {
+        free(claim);
+    }
+}
+
+/**
+ * @brief Снимает ссылку завершающегося потока на его заявку.
+ */
+static void claim_thread_exit(void *claim) {
+    pthread_mutex_lock(&budget_lock);
+    claim_unref(claim);
+    pthread_mutex_unlock(&budget_lock);
+}
+
+/**
+ * @brief Создает ключ, по которому снимается ссылка потока на заявку при его завершении.
+ */
+static void claim_key_create(void) {
+    pthread_key_create(&claim_key, claim_thread_exit);
+}
+
+/**
+ * @brief Учитывает новый буфер; первое выделение загрузки ждет, пока ее заявка не поместится в бюджет.
+ *
+ * Загрузка потока начинается, когда у его текущей заявки не осталось живых буферов, в том числе
+ * если последний из них освободил другой поток.
+ *
+ * @param size Размер буфера в байтах.
+ * @return Заявка, которой принадлежит буфер, или NULL, если не удалось выделить память для заявки.
+ */
+static struct buffer_claim *account_alloc(uint64_t size) {
+    pthread_once(&claim_key_once, claim_key_create);
+    pthread_mutex_lock(&budget_lock);
+    struct buffer_claim *claim = thread_claim;
+    if (!claim || claim->buffers == 0) {
+        uint64_t amount = thread_expected > size ? thread_expected : size;
+        while (current.memory_budget && committed > 0 && committed + amount > current.memory_budget) {
+            pthread_cond_wait(&budget_freed, &budget_lock);
+        }
+        struct buffer_claim *fresh = malloc(sizeof(*fresh));
+        if (!fresh) {
+            pthread_mutex_unlock(&budget_lock);
+            return NULL;
+        }
+        if (claim) {
+            claim_unref(claim);
+        }
+        fresh->amount = amount;
+        fresh->held = 0;
+        fresh->buffers = 0;
+        fresh->refs = 1;
+        committed += amount;
+        claim = fresh;
+        thread_claim = fresh;
+        thread_expected = 0;
+        pthread_setspecific(claim_key, fresh);
+    } else if (claim->held + size > claim->amount) {
+        committed += claim->held + size - claim->amount;
+        claim->amount = claim->held + size;
+    }
+    claim->held += size;
+    claim->buffers++;
+    claim->refs++;
+    used += size;
+    if (used > peak) {
+        peak = used;
+    }
+    pthread_mutex_unlock(&budget_lock);
+    return claim;
+}
+
+/**
+ * @brief Снимает буфер с учета; после последнего буфера загрузки снимается и ее заявка.
+ *
+ * Может вызываться в любом потоке, а не только в выделившем буфер.
+ *
+ * @param claim Заявка, которой принадлежит буфер.
+ * @param size Размер буфера в байтах.
+ */
+static void account_free(struct buffer_claim *claim, uint64_t size) {
+    pthread_mutex_lock(&budget_lock);
+    used -= size;
+    claim->held -= size;
+    if (--claim->buffers == 0) {
+        committed -= claim->amount;
+        claim->amount = 0;
+        pthread_cond_broadcast(&budget_freed);
+    }
+    claim_unref(claim);
+    pthread_mutex_unlock(&budget_lock);
+}
+
+/**
+ * @brief Размещает заголовок в начале области и возвращает указатель на данные.
+ */
+static void *attach_header(void *base, uint64_t size, enum buffer_kind kind) {
+    struct buffer_header *header = base;
+    header->base = base;
+    header->size = size;
+    header->accounted = 0;
+    header->claim = NULL;
+    header->kind = kind;
+    return (uint8_t *) base + BUFFER_HEADER_SIZE;
+}
+
+#ifdef __linux__
+
+/**
+ * @brief Отображает анонимную область, выровненную по размеру большой страницы.
+ *
+ * Явные большие страницы запрашиваются флагом MAP_HUGETLB; если пул hugetlbfs пуст, используется
+ * обычное отображение с советом MADV_HUGEPAGE, по которому ядро собирает прозрачные большие страницы.
+ *
+ * @param size Размер области, кратный размеру большой страницы.
+ * @return Начало области или NULL в случае ошибки.
+ */
+static void *map_region(uint64_t size) {
+    if (current.huge_pages == BUFFER_HUGE_PAGES_EXPLICIT) {
+        void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            return base;
+        }
+    }
+
+    // Лишняя большая страница позволяет выровнять начало, чтобы ядро могло использовать большие страницы целиком
+    uint64_t padded = size + BUFFER_HUGE_PAGE_SIZE;
+    uint8_t *raw = mmap(NULL, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return NULL;
+    }
+    uint8_t *base = (uint8_t *) (((uintptr_t) raw + BUFFER_HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (BUFFER_HUGE_PAGE_SIZE - 1));
+    if (base > raw) {
+        munmap(raw, (size_t) (base - raw));
+    }
+    if (raw + padded > base + size) {
+        munmap(base + size, (size_t) (raw + padded - (base + size)));
+    }
+    if (current.huge_pages != BUFFER_HUGE_PAGES_OFF) {
+        madvise(base, size, MADV_HUGEPAGE);
+    }
+    return base;
+}
+
+/**
+ * @brief Читает маску узлов NUMA, в которых есть память.
+ *
+ * @param mask Маска узлов (по биту на узел).
+ * @return Количество узлов в маске.
+ */
+static unsigned read_memory_nodes(unsigned long mask[BUFFER_MAX_NODES / (8 * sizeof(unsigned long))]) {
+    FILE *input = fopen("/sys/devices/system/node/has_memory", "r");
+    if (!input) {
+        return 0;
+    }
+    unsigned count = 0;
+    unsigned first, last;
+    int separator;
+    while (fscanf(input, "%u", &first) == 1) {
+        last = first;
+        separator = fgetc(input);
+        if (separator == '-' && fscanf(input, "%u", &last) == 1) {
+            separator = fgetc(input);
+        }
+        for (unsigned node = first; node <= last && node < BUFFER_MAX_NODES; node++) {
+            mask[node / (8 * sizeof(unsigned long))] |= 1ul << (node % (8 * sizeof(unsigned long)));
+            count++;
+        }
+        if (separator != ',') {
+            break;
+        }
+    }
+    fclose(input);
+    return count;
+}
+
+/**
+ * @brief Чередует страницы области между всеми узлами NUMA с памятью.
+ *
+ * Используется системный вызов mbind напрямую, чтобы не зависеть от libnuma. На машине с одним узлом
+ * ничего не делает.
+ */
+static void interleave_region(void *base, uint64_t size) {
+    unsigned long mask[BUFFER_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    if (read_memory_nodes(mask) > 1) {
+        syscall(SYS_mbind, base, (unsigned long) size, BUFFER_MPOL_INTERLEAVE, mask,
+                (unsigned long) BUFFER_MAX_NODES + 1, 0u);
+    }
+}
+
+/**
+ * @brief Затрагивает страницы `[begin, end)` области, чтобы ядро выделило их на узле текущего потока.
+ */
+static void touch_pages(void *ctx, uint64_t begin, uint64_t end) {
+    volatile uint8_t *base = ctx;
+    for (uint64_t page = begin; page < end; page++) {
+        base[page * BUFFER_PAGE_SIZE] = 0;
+    }
+}
+
+/**
+ * @brief Отображает область для буфера и применяет к ней политику NUMA.
+ *
+ * При первом обращении по частям страницы распределяются между потоками пула так же, как строки
+ * изображения в параллельных проходах: непрерывными порциями, так что каждая часть буфера оказывается
+ * на узле одного из обрабатывающих ее потоков.
+ *
+ * @param size Размер данных буфера в байтах.
+ * @return Указатель на данные или NULL в случае ошибки.
+ */
+static void *map_buffer(uint64_t size) {
+    uint64_t total = (size + BUFFER_HEADER_SIZE + BUFFER_HUGE_PAGE_SIZE - 1) & ~(BUFFER_HUGE_PAGE_SIZE - 1);
+    void *base = map_region(total);
+    if (!base) {
+        return NULL;
+    }
+    if (current.numa == BUFFER_NUMA_INTERLEAVE) {
+        interleave_region(base, total);
+    } else if (current.numa == BUFFER_NUMA_FIRST_TOUCH) {
+        parallel_for(total / BUFFER_PAGE_SIZE, BUFFER_TOUCH_GRAIN, touch_pages, base);
+    }
+    return attach_header(base, total, BUFFER_KIND_MAPPED);
+}
+
+#endif
+
+/**
+ * @brief Выделяет буфер для пикселей изображения.
+ *
+ * Отображенные напрямую буферы ядро всегда выдает обнуленными, поэтому различие между обнуленными
+ * и неинициализированными буферами касается только кучи: для последних используется malloc без записи
+ * нулей. Если программа собрана с `-DBUFFER_POISON`, неинициализированные буферы заполняются
+ * байтом `BUFFER_POISON_BYTE`, чтобы чтение незаписанных пикселей проявлялось в результате.
+ *
+ * @param size Размер буфера в байтах.
+ * @param zeroed Нужно ли обнулить буфер.
+ * @return Указатель на буфер или NULL, если выделить память не удалось.
+ */
+static void *allocate(uint64_t size, int zeroed) {
+    if (size > UINT64_MAX - BUFFER_HUGE_PAGE_SIZE - BUFFER_HEADER_SIZE || size + BUFFER_HEADER_SIZE > SIZE_MAX) {
+        return NULL;
+    }
+    // Учет идет до выделения, чтобы ожидание бюджета не удерживало память
+    struct buffer_claim *claim = account_alloc(size);
+    if (!claim) {
+        return NULL;
+    }
+    void *data = NULL;
+#ifdef __linux__
+    if ((current.huge_pages != BUFFER_HUGE_PAGES_OFF || current.numa != BUFFER_NUMA_OFF) && size >= current.threshold) {
+        data = map_buffer(size);
+    }
+#endif
+    if (!data) {
+        // calloc получает большие блоки уже обнуленными от ядра, не затрагивая страницы
+        void *base = zeroed ? calloc(1, (size_t) (size + BUFFER_HEADER_SIZE)) : malloc((size_t) (size + BUFFER_HEADER_SIZE));
+        if (!base) {
+            account_free(claim, size);
+            return NULL;
+        }
+        data = attach_header(base, size + BUFFER_HEADER_SIZE, BUFFER_KIND_HEAP);
+    }
+    struct buffer_header *header = (struct buffer_header *) ((uint8_t *) data - BUFFER_HEADER_SIZE);
+    header->accounted = size;
+    header->claim = claim;
+#ifdef BUFFER_POISON
+    if (!zeroed) {
+        memset(data, BUFFER_POISON_BYTE, (size_t) size);
+    }
+#endif
+    return data;
+}
+
+/**
+ * @brief Выделяет обнуленный буфер для пикселей изображения.
+ *
+ * @param size Размер буфера в байтах.
+ * @return Указатель на буфер или NULL, если выделить память не удалось.
+ */
+void *buffer_alloc(uint64_t size) {
+    return allocate(size, 1);
+}
+
+/**
+ * @brief Выделяет буфер для пикселей изображения без инициализации.
+ *
+ * @param size Размер буфера в байтах.
+ * @return Указатель на буфер или NULL, если выделить память не удалось.
+ */
+void *buffer_alloc_uninit(uint64_t size) {
+    return allocate(size, 0);
+}
+
+/**
+ * @brief Освобождает буфер, выделенный `buffer_alloc` или `buffer_alloc_uninit`.
+ *
+ * @param data Указатель на буфер или NULL.
+ */
+void buffer_free(void *data) {
+    if (!data) {
+        return;
+    }
+    struct buffer_header *header = (struct buffer_header *) ((uint8_t *) data - BUFFER_HEADER_SIZE);
+    account_free(header->claim, header->accounted);
+#ifdef __linux__
+    if (header->kind == BUFFER_KIND_MAPPED) {
+        munmap(header->base, (size_t) header->size);
+        return;
+    }
+#endif
+    free(header->base);
+}
@@ -0,0 +1,218 @@
+#include "cache.h"
+#include "hash.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+#define CACHE_PATH_MAX 4096          // Максимальная длина пути к записи кэша
+#define CACHE_COPY_CHUNK (1 << 20)   // Размер порции копирования файла в байтах
+
+/**
+ * @brief Вычисляет ключ кэша по описанию результата.
+ *
+ * @param key Указатель на заполняемый ключ.
+ * @param data Указатель на описание результата.
+ * @param size Размер описания в байтах.
+ */
+void cache_key_init(struct cache_key *key, const void *data, size_t size) {
+    struct hash_state state;
+    uint64_t halves[2];
+    for (int i = 0; i < 2; i++) {
+        hash_init(&state, (uint64_t) i);
+        hash_update(&state, data, size);
+        halves[i] = hash_digest(&state);
+    }
+    snprintf(key->hex, sizeof(key->hex), "%016llx%016llx",
+             (unsigned long long) halves[0], (unsigned long long) halves[1]);
+}
+
+/**
+ * @brief Формирует путь к записи кэша.
+ *
+ * @return 0 при успехе или 1, если путь слишком длинный.
+ */
+static int entry_path(char *path, const char *dir, const struct cache_key *key) {
+    int length = snprintf(path, CACHE_PATH_MAX, "%s/%s", dir, key->hex);
+    return length > 0 && length < CACHE_PATH_MAX ? 0 : 1;
+}
+
+/**
+ * @brief Формирует уникальное для процесса имя временного файла рядом с `path`.
+ *
+ * @return 0 при успехе или 1, если путь слишком длинный.
+ */
+static int temp_path(char *temp, const char *path) {
+    int length = snprintf(temp, CACHE_PATH_MAX, "%s.%ld.tmp", path, (long) getpid());
+    return length > 0 && length < CACHE_PATH_MAX ? 0 : 1;
+}
+
+/**
+ * @brief Копирует содержимое одного открытого файла в другой.
+ *
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+static int copy_contents(int input, int output) {
+    char *buffer = malloc(CACHE_COPY_CHUNK);
+    if (!buffer) {
+        return 1;
+    }
+    int status = 0;
+    for (;;) {
+        ssize_t got = read(input, buffer, CACHE_COPY_CHUNK);
+        if (got == 0) {
+            break;
+        }
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = 1;
+            break;
+        }
+        for (ssize_t done = 0; done < got;) {
+            ssize_t put = write(output, buffer + done, (size_t) (got - done));
+            if (put < 0 && errno != EINTR) {
+                status = 1;
+                break;
+            }
+            done += put > 0 ? put : 0;
+        }
+        if (status) {
+            break;
+        }
+    }
+    free(buffer);
+    return status;
+}
+
+/**
+ * @brief Создает файл `to` с содержимым файла `from`.
+ *
+ * Сначала пробует клонировать файл средствами файловой системы (reflink), при котором данные
+ * не копируются, а блоки разделяются до первого изменения.
+ *
+ * @param from Путь к исходному файлу.
+ * @param to Путь к создаваемому файлу (не должен существовать).
+ * @param allow_copy Разрешено ли побайтовое копирование, если клонирование не поддерживается.
+ * @return 0 при успехе или 1 в случае ошибки (созданный файл удаляется).
+ */
+static int clone_file(const char *from, const char *to, int allow_copy) {
+    int input = open(from, O_RDONLY);
+    if (input < 0) {
+        return 1;
+    }
+    int output = open(to, O_WRONLY | O_CREAT | O_EXCL, 0644);
+    if (output < 0) {
+        close(input);
+        return 1;
+    }
+
+    int status = 1;
+#ifdef FICLONE
+    status = ioctl(output, FICLONE, input) == 0 ? 0 : 1;
+#endif
+    if (status != 0 && allow_copy) {
+        status = copy_contents(input, output);
+    }
+    if (close(output) != 0) {
+        status = 1;
+    }
+    close(input);
+    if (status != 0) {
+        unlink(to);
+    }
+    return status;
+}
+
+/**
+ * @brief Ищет в кэше результат с заданным ключом и помещает его по пути назначения.
+ *
+ * Результат сначала появляется во временном файле рядом с назначением и затем переименовывается,
+ * поэтому файл назначения никогда не бывает записан частично.
+ *
+ * @param dir Каталог кэша.
+ * @param key Указатель на ключ результата.
+ * @param dest_path Путь, по которому должен появиться результат.
+ * @return 0, если результат найден и помещен по пути назначения, или 1, если его нет в кэше.
+ */
+int cache_fetch(const char *dir, const struct cache_key *key, const char *dest_path) {
+    char entry[CACHE_PATH_MAX];
+    char temp[CACHE_PATH_MAX];
+    if (entry_path(entry, dir, key) != 0 || temp_path(temp, dest_path) != 0 || access(entry, R_OK) != 0) {
+        return 1;
+    }
+
+    unlink(temp);
+    if (clone_file(entry, temp, 0) != 0 && link(entry, temp) != 0 && clone_file(entry, temp, 1) != 0) {
+        return 1;
+    }
+    if (rename(temp, dest_path) != 0) {
+        unlink(temp);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Сохраняет записанный результат в кэш под заданным ключом.
+ *
+ * @param dir Каталог кэша (создается при необходимости).
+ * @param key Указатель на ключ результата.
+ * @param path Путь к записанному результату.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+int cache_store(const char *dir, const struct cache_key *key, const char *path) {
+    char entry[CACHE_PATH_MAX];
+    char temp[CACHE_PATH_MAX];
+    if (entry_path(entry, dir, key) != 0 || temp_path(temp, entry) != 0) {
+        return 1;
+    }
+    if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+        return 1;
+    }
+
+    // Запись кэша копируется, а не связывается жесткой ссылкой, чтобы последующие изменения
+    // файла результата не портили кэш
+    unlink(temp);
+    if (clone_file(path, temp, 1) != 0) {
+        return 1;
+    }
+    if (rename(temp, entry) != 0) {
+        unlink(temp);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Проверяет, можно ли использовать кэш для файла назначения.
+ *
+ * @param dest_path Путь к файлу назначения.
+ * @return 1, если файл назначения не существует или является обычным файлом, иначе 0.
+ */
+int cache_accepts(const char *dest_path) {
+    struct stat info;
+    if (stat(dest_path, &info) != 0) {
+        return errno == ENOENT;
+    }
+    return S_ISREG(info.st_mode);
+}
+
+/**
+ * @brief Отделяет файл назначения от записи кэша перед его перезаписью.
+ *
+ * @param path Путь к файлу назначения.
+ */
+void cache_detach(const char *path) {
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISREG(info.st_mode) && info.st_nlink > 1) {
+        unlink(path);
+    }
+}
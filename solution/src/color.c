@@ -0,0 +1,236 @@
+#include "color.h"
+#include "parallel.h"
+#include <math.h>
+#include <string.h>
+
+#define COLOR_ROWS_PER_TASK 64   // Количество строк, обрабатываемых одной порцией пула потоков
+
+// Веса каналов BT.601 в фиксированной точке с 8 дробными битами (сумма равна 256)
+static const uint16_t GRAY_WEIGHTS[3] = {29, 150, 77};   // b, g, r
+
+/**
+ * @brief Инициализирует тождественную цепочку операций.
+ *
+ * @param ops Указатель на цепочку операций.
+ */
+void color_ops_init(struct color_ops *ops) {
+    ops->active = 0;
+    ops->grayscale = 0;
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < 256; i++) {
+            ops->before[c][i] = (uint8_t) i;
+            ops->after[c][i] = (uint8_t) i;
+        }
+    }
+}
+
+/**
+ * @brief Дописывает к цепочке таблицы преобразования каналов.
+ *
+ * До перевода в оттенки серого таблицы объединяются с первой таблицей цепочки, после - со второй.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param tables Таблицы для каналов в порядке b, g, r.
+ */
+static void compose(struct color_ops *ops, const uint8_t tables[3][256]) {
+    uint8_t (*target)[256] = ops->grayscale ? ops->after : ops->before;
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < 256; i++) {
+            target[c][i] = tables[c][target[c][i]];
+        }
+    }
+    ops->active = 1;
+}
+
+/**
+ * @brief Дописывает к цепочке одну и ту же таблицу для всех каналов.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param table Таблица преобразования значения канала.
+ */
+static void compose_uniform(struct color_ops *ops, const uint8_t table[256]) {
+    uint8_t tables[3][256];
+    for (int c = 0; c < 3; c++) {
+        memcpy(tables[c], table, 256);
+    }
+    compose(ops, (const uint8_t (*)[256]) tables);
+}
+
+/**
+ * @brief Переводит вещественное значение канала в диапазон 0..255 с округлением.
+ */
+static uint8_t clamp_channel(double value) {
+    if (value <= 0.0) {
+        return 0;
+    }
+    return value >= 255.0 ? 255 : (uint8_t) lround(value);
+}
+
+/**
+ * @brief Добавляет в цепочку перевод в оттенки серого.
+ *
+ * Повторный перевод допустим, только если после предыдущего все каналы обрабатываются одинаково:
+ * тогда серый пиксель остается серым и повтор ничего не меняет.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @return 0 при успехе или 1, если повторный перевод нельзя выразить таблицами.
+ */
+int color_ops_grayscale(struct color_ops *ops) {
+    if (ops->grayscale) {
+        return memcmp(ops->after[0], ops->after[1], 256) == 0 && memcmp(ops->after[0], ops->after[2], 256) == 0 ? 0 : 1;
+    }
+    // Первая таблица больше не меняется, поэтому веса каналов умножаются на нее один раз
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < 256; i++) {
+            ops->weighted[c][i] = (uint16_t) (GRAY_WEIGHTS[c] * ops->before[c][i]);
+        }
+    }
+    ops->grayscale = 1;
+    ops->active = 1;
+    return 0;
+}
+
+/**
+ * @brief Добавляет в цепочку инверсию цветов.
+ *
+ * @param ops Указатель на цепочку операций.
+ */
+void color_ops_invert(struct color_ops *ops) {
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++) {
+        table[i] = (uint8_t) (255 - i);
+    }
+    compose_uniform(ops, table);
+}
+
+/**
+ * @brief Добавляет в цепочку изменение яркости и контраста.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param brightness Сдвиг яркости.
+ * @param contrast Коэффициент контраста.
+ */
+void color_ops_brightness_contrast(struct color_ops *ops, int brightness, double contrast) {
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++) {
+        table[i] = clamp_channel((i - 128) * contrast + 128 + brightness);
+    }
+    compose_uniform(ops, table);
+}
+
+/**
+ * @brief Добавляет в цепочку гамма-коррекцию.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param gamma Показатель гаммы.
+ */
+void color_ops_gamma(struct color_ops *ops, double gamma) {
+    uint8_t table[256];
+    for (int i = 0; i < 256; i++) {
+        table[i] = clamp_channel(255.0 * pow(i / 255.0, 1.0 / gamma));
+    }
+    compose_uniform(ops, table);
+}
+
+/**
+ * @brief Добавляет в цепочку произвольные таблицы преобразования каналов.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param lut Таблицы для каналов в порядке r, g, b.
+ */
+void color_ops_lut(struct color_ops *ops, const uint8_t lut[3][256]) {
+    uint8_t tables[3][256];
+    memcpy(tables[0], lut[2], 256);
+    memcpy(tables[1], lut[1], 256);
+    memcpy(tables[2], lut[0], 256);
+    compose(ops, (const uint8_t (*)[256]) tables);
+}
+
+/**
+ * @brief Применяет цепочку операций к подряд идущим пикселям на месте.
+ *
+ * Без перевода в оттенки серого каждый канал проходит через одну таблицу. С переводом яркость пикселя
+ * вычисляется тремя чтениями заранее взвешенных таблиц и сложением.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param pixels Указатель на первый пиксель.
+ * @param count Количество пикселей.
+ */
+void color_apply_pixels(const struct color_ops *ops, struct pixel *pixels, uint64_t count) {
+    if (!ops->active) {
+        return;
+    }
+
+    if (!ops->grayscale) {
+        const uint8_t *lut_b = ops->before[0];
+        const uint8_t *lut_g = ops->before[1];
+        const uint8_t *lut_r = ops->before[2];
+        for (uint64_t i = 0; i < count; i++) {
+            pixels[i].b = lut_b[pixels[i].b];
+            pixels[i].g = lut_g[pixels[i].g];
+            pixels[i].r = lut_r[pixels[i].r];
+        }
+        return;
+    }
+
+    const uint16_t (*weighted)[256] = ops->weighted;
+    for (uint64_t i = 0; i < count; i++) {
+        unsigned luma = (weighted[0][pixels[i].b] + weighted[1][pixels[i].g] + weighted[2][pixels[i].r] + 128u) >> 8;
+        pixels[i].b = ops->after[0][luma];
+        pixels[i].g = ops->after[1][luma];
+        pixels[i].r = ops->after[2][luma];
+    }
+}
+
+/**
+ * @brief Параметры применения цепочки к изображению, общие для всех потоков.
+ */
+struct color_job {
+    const struct color_ops *ops;     // Цепочка операций
+    struct image *img;               // Обрабатываемое изображение
+};
+
+/**
+ * @brief Обрабатывает строки `[begin, end)`; вызывается из пула потоков.
+ */
+static void color_rows(void *ctx, uint64_t begin, uint64_t end) {
+    const struct color_job *job = ctx;
+    color_apply_pixels(job->ops, image_pixel(job->img, 0, begin), (end - begin) * job->img->width);
+}
+
+/**
+ * @brief Применяет цепочку операций ко всему изображению на общем пуле потоков.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param img Указатель на изображение.
+ */
+void color_apply_image(const struct color_ops *ops, struct image *img) {
+    if (!ops->active || !img || !img->data) {
+        return;
+    }
+    struct color_job job = {ops, img};
+    parallel_for(img->height, COLOR_ROWS_PER_TASK, color_rows, &job);
+}
+
+/**
+ * @brief Вызывает `color_apply_pixels` с контекстом поэлементного шага.
+ */
+static void color_stage_apply(const void *ctx, struct pixel *pixels, uint64_t count) {
+    color_apply_pixels(ctx, pixels, count);
+}
+
+/**
+ * @brief Представляет цепочку операций в виде поэлементного шага для совмещения со сменой ориентации.
+ *
+ * @param ops Указатель на цепочку операций.
+ * @param stage Указатель на заполняемый шаг.
+ * @return `stage`, если цепочка не тождественна, иначе NULL.
+ */
+const struct pixel_stage *color_ops_stage(const struct color_ops *ops, struct pixel_stage *stage) {
+    if (!ops->active) {
+        return NULL;
+    }
+    stage->apply = color_stage_apply;
+    stage->ctx = ops;
+    return stage;
+}
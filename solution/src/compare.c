@@ -0,0 +1,237 @@
+#include "compare.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define FLAG_LOAD(flag) __atomic_load_n(&(flag), __ATOMIC_RELAXED)
+#define FLAG_SET(flag) __atomic_store_n(&(flag), 1, __ATOMIC_RELAXED)
+#else
+#define FLAG_LOAD(flag) (*(volatile int *) &(flag))
+#define FLAG_SET(flag) (*(volatile int *) &(flag) = 1)
+#endif
+
+#define COMPARE_BLOCK 16             // Пикселей в блоке SSE2: три 16-байтных вектора
+#define COMPARE_FLUSH_BLOCKS 4096    // Блоков до переноса 32-битных сумм квадратов в 64-битную
+
+/**
+ * @brief Параметры параллельного сравнения изображений.
+ */
+struct compare_job {
+    const struct image *a;           // Первое изображение
+    const struct image *b;           // Второе изображение
+    struct image_diff *bands;        // Статистика каждой полосы (NULL при проверке равенства)
+    int differs;                     // Признак найденного различия при проверке равенства
+};
+
+/**
+ * @brief Проверяет равенство полос строк, прекращая работу после первого найденного различия.
+ */
+static void equal_bands(void *ctx, uint64_t begin, uint64_t end) {
+    struct compare_job *job = ctx;
+    uint64_t row_bytes = job->a->width * sizeof(struct pixel);
+    for (uint64_t band = begin; band < end; band++) {
+        uint64_t y0 = band * COMPARE_ROWS_PER_BAND;
+        uint64_t y1 = y0 + COMPARE_ROWS_PER_BAND < job->a->height ? y0 + COMPARE_ROWS_PER_BAND : job->a->height;
+        for (uint64_t y = y0; y < y1; y++) {
+            if (FLAG_LOAD(job->differs)) {
+                return;
+            }
+            // memcmp в стандартной библиотеке уже векторизован и сам останавливается на первом различии
+            if (memcmp(image_pixel(job->a, 0, y), image_pixel(job->b, 0, y), row_bytes) != 0) {
+                FLAG_SET(job->differs);
+                return;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Добавляет к статистике различия пикселей по одному, без векторных инструкций.
+ */
+static void diff_pixels(const uint8_t *a, const uint8_t *b, uint64_t count, struct image_diff *diff) {
+    for (uint64_t i = 0; i < count; i++, a += sizeof(struct pixel), b += sizeof(struct pixel)) {
+        int differs = 0;
+        for (size_t c = 0; c < sizeof(struct pixel); c++) {
+            uint8_t d = a[c] > b[c] ? a[c] - b[c] : b[c] - a[c];
+            diff->squared_error += (uint64_t) d * d;
+            if (d > diff->max_diff) {
+                diff->max_diff = d;
+            }
+            differs |= d != 0;
+        }
+        diff->differing += differs;
+    }
+}
+
+#ifdef __SSE2__
+/**
+ * @brief Суммирует четыре 32-битных элемента вектора.
+ */
+static uint64_t sum_epu32(__m128i v) {
+    uint32_t lanes[4];
+    _mm_storeu_si128((__m128i *) lanes, v);
+    return (uint64_t) lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+/**
+ * @brief Добавляет к сумме квадратов и максимуму разности одного вектора из 16 байт.
+ */
+static void diff_vector(__m128i a, __m128i b, __m128i *squares, __m128i *max) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i d = _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+    __m128i lo = _mm_unpacklo_epi8(d, zero);
+    __m128i hi = _mm_unpackhi_epi8(d, zero);
+    *squares = _mm_add_epi32(*squares, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+    *max = _mm_max_epu8(*max, d);
+}
+#endif
+
+/**
+ * @brief Добавляет к статистике различия строки.
+ *
+ * Совпадающие блоки по 16 пикселей отбрасываются одним сравнением; в отличающихся суммы квадратов
+ * и максимум считаются векторно, а количество отличающихся пикселей - по пикселям блока.
+ */
+static void diff_row(const uint8_t *a, const uint8_t *b, uint64_t width, struct image_diff *diff) {
+    uint64_t x = 0;
+#ifdef __SSE2__
+    __m128i squares = _mm_setzero_si128();
+    __m128i max = _mm_setzero_si128();
+    unsigned pending = 0;
+    for (; x + COMPARE_BLOCK <= width; x += COMPARE_BLOCK) {
+        const uint8_t *pa = a + x * sizeof(struct pixel);
+        const uint8_t *pb = b + x * sizeof(struct pixel);
+        __m128i a0 = _mm_loadu_si128((const __m128i *) pa);
+        __m128i a1 = _mm_loadu_si128((const __m128i *) (pa + 16));
+        __m128i a2 = _mm_loadu_si128((const __m128i *) (pa + 32));
+        __m128i b0 = _mm_loadu_si128((const __m128i *) pb);
+        __m128i b1 = _mm_loadu_si128((const __m128i *) (pb + 16));
+        __m128i b2 = _mm_loadu_si128((const __m128i *) (pb + 32));
+        __m128i equal = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(a0, b0), _mm_cmpeq_epi8(a1, b1)),
+                                      _mm_cmpeq_epi8(a2, b2));
+        if (_mm_movemask_epi8(equal) == 0xFFFF) {
+            continue;
+        }
+        diff_vector(a0, b0, &squares, &max);
+        diff_vector(a1, b1, &squares, &max);
+        diff_vector(a2, b2, &squares, &max);
+        for (int i = 0; i < COMPARE_BLOCK; i++) {
+            const uint8_t *qa = pa + i * sizeof(struct pixel);
+            const uint8_t *qb = pb + i * sizeof(struct pixel);
+            diff->differing += qa[0] != qb[0] || qa[1] != qb[1] || qa[2] != qb[2];
+        }
+        // За блок к элементу суммы добавляется не больше 12 * 255^2, поэтому 4096 блоков помещаются в 32 бита
+        if (++pending == COMPARE_FLUSH_BLOCKS) {
+            diff->squared_error += sum_epu32(squares);
+            squares = _mm_setzero_si128();
+            pending = 0;
+        }
+    }
+    diff->squared_error += sum_epu32(squares);
+    uint8_t lanes[16];
+    _mm_storeu_si128((__m128i *) lanes, max);
+    for (int i = 0; i < 16; i++) {
+        if (lanes[i] > diff->max_diff) {
+            diff->max_diff = lanes[i];
+        }
+    }
+#endif
+    diff_pixels(a + x * sizeof(struct pixel), b + x * sizeof(struct pixel), width - x, diff);
+}
+
+/**
+ * @brief Вычисляет статистику различий полос строк.
+ */
+static void diff_bands(void *ctx, uint64_t begin, uint64_t end) {
+    struct compare_job *job = ctx;
+    for (uint64_t band = begin; band < end; band++) {
+        struct image_diff *diff = &job->bands[band];
+        uint64_t y0 = band * COMPARE_ROWS_PER_BAND;
+        uint64_t y1 = y0 + COMPARE_ROWS_PER_BAND < job->a->height ? y0 + COMPARE_ROWS_PER_BAND : job->a->height;
+        memset(diff, 0, sizeof(*diff));
+        for (uint64_t y = y0; y < y1; y++) {
+            diff_row((const uint8_t *) image_pixel(job->a, 0, y), (const uint8_t *) image_pixel(job->b, 0, y),
+                     job->a->width, diff);
+        }
+    }
+}
+
+/**
+ * @brief Проверяет, совпадают ли изображения попиксельно.
+ *
+ * @param a Указатель на первое изображение.
+ * @param b Указатель на второе изображение.
+ * @return 1, если размеры и все пиксели совпадают, иначе 0.
+ */
+int image_equal(const struct image *a, const struct image *b) {
+    if (a->width != b->width || a->height != b->height) {
+        return 0;
+    }
+    struct compare_job job = {a, b, NULL, 0};
+    parallel_for((a->height + COMPARE_ROWS_PER_BAND - 1) / COMPARE_ROWS_PER_BAND, 1, equal_bands, &job);
+    return !job.differs;
+}
+
+/**
+ * @brief Вычисляет полную статистику различий двух изображений одинакового размера.
+ *
+ * @param a Указатель на первое изображение.
+ * @param b Указатель на второе изображение.
+ * @param diff Указатель на заполняемую статистику.
+ * @return 0 при успехе или 1, если размеры изображений различаются или не удалось выделить память.
+ */
+int image_compare(const struct image *a, const struct image *b, struct image_diff *diff) {
+    if (a->width != b->width || a->height != b->height) {
+        return 1;
+    }
+    uint64_t count = (a->height + COMPARE_ROWS_PER_BAND - 1) / COMPARE_ROWS_PER_BAND;
+    struct compare_job job = {a, b, malloc((count ? count : 1) * sizeof(struct image_diff)), 0};
+    if (!job.bands) {
+        return 1;
+    }
+    parallel_for(count, 1, diff_bands, &job);
+
+    memset(diff, 0, sizeof(*diff));
+    diff->pixels = a->width * a->height;
+    for (uint64_t i = 0; i < count; i++) {
+        diff->differing += job.bands[i].differing;
+        diff->squared_error += job.bands[i].squared_error;
+        if (job.bands[i].max_diff > diff->max_diff) {
+            diff->max_diff = job.bands[i].max_diff;
+        }
+    }
+    free(job.bands);
+    return 0;
+}
+
+/**
+ * @brief Вычисляет среднеквадратичную ошибку на канал.
+ *
+ * @param diff Указатель на статистику различий.
+ * @return Среднее значение квадрата разности канала.
+ */
+double image_diff_mse(const struct image_diff *diff) {
+    if (diff->pixels == 0) {
+        return 0.0;
+    }
+    return (double) diff->squared_error / ((double) diff->pixels * sizeof(struct pixel));
+}
+
+/**
+ * @brief Вычисляет пиковое отношение сигнала к шуму в децибелах.
+ *
+ * @param diff Указатель на статистику различий.
+ * @return PSNR или `INFINITY` для совпадающих изображений.
+ */
+double image_diff_psnr(const struct image_diff *diff) {
+    double mse = image_diff_mse(diff);
+    if (mse == 0.0) {
+        return INFINITY;
+    }
+    return 10.0 * log10(255.0 * 255.0 / mse);
+}
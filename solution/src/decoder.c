@@ -0,0 +1,151 @@
+#include "decoder.h"
+#include <string.h>
+
+/**
+ * @brief Дочитывает заголовок BMP.
+ */
+static enum read_status bmp_decoder_header(FILE *in, const uint8_t *magic, size_t size, struct image_header *header) {
+    enum read_status status = bmp_read_header_prefixed(in, magic, size, &header->format.bmp);
+    header->width = header->format.bmp.biWidth;
+    header->height = bmp_image_height(&header->format.bmp);
+    return status;
+}
+
+/**
+ * @brief Читает строки области BMP.
+ */
+static enum read_status bmp_decoder_region(FILE *in, const struct image_header *header,
+                                           const struct image_rect *region, image_row_handler handler, void *ctx) {
+    return bmp_read_region(in, &header->format.bmp, region, handler, ctx);
+}
+
+/**
+ * @brief Проверяет сигнатуру BMP.
+ */
+static int bmp_sniff(const uint8_t *magic, size_t size) {
+    return size >= 2 && magic[0] == 'B' && magic[1] == 'M';
+}
+
+/**
+ * @brief Дочитывает заголовок PGM, PPM или PAM.
+ */
+static enum read_status pnm_decoder_header(FILE *in, const uint8_t *magic, size_t size, struct image_header *header) {
+    enum read_status status = pnm_read_header(in, magic, size, &header->format.pnm);
+    header->width = header->format.pnm.width;
+    header->height = header->format.pnm.height;
+    return status;
+}
+
+/**
+ * @brief Читает строки области PGM, PPM или PAM.
+ */
+static enum read_status pnm_decoder_region(FILE *in, const struct image_header *header,
+                                           const struct image_rect *region, image_row_handler handler, void *ctx) {
+    return pnm_read_region(in, &header->format.pnm, region, handler, ctx);
+}
+
+/**
+ * @brief Дочитывает заголовок QOI.
+ */
+static enum read_status qoi_decoder_header(FILE *in, const uint8_t *magic, size_t size, struct image_header *header) {
+    enum read_status status = qoi_read_header(in, magic, size, &header->format.qoi);
+    header->width = header->format.qoi.width;
+    header->height = header->format.qoi.height;
+    return status;
+}
+
+/**
+ * @brief Декодирует строки области QOI.
+ */
+static enum read_status qoi_decoder_region(FILE *in, const struct image_header *header,
+                                           const struct image_rect *region, image_row_handler handler, void *ctx) {
+    return qoi_read_region(in, &header->format.qoi, region, handler, ctx);
+}
+
+// Зарегистрированные декодеры; новый формат подключается добавлением строки
+static const struct image_decoder decoders[] = {
+    {"bmp", bmp_sniff, bmp_decoder_header, bmp_decoder_region},
+    {"pnm", pnm_sniff, pnm_decoder_header, pnm_decoder_region},
+    {"qoi", qoi_sniff, qoi_decoder_header, qoi_decoder_region},
+};
+
+/**
+ * @brief Определяет формат файла по первым байтам и читает его заголовок.
+ *
+ * @param in Указатель на файл, стоящий в начале.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения; `READ_INVALID_SIGNATURE`, если формат не распознан.
+ */
+enum read_status decoder_read_header(FILE *in, struct image_header *header) {
+    if (!in || !header) return READ_INVALID_HEADER;
+
+    uint8_t magic[DECODER_MAGIC_SIZE];
+    if (fread(magic, sizeof(magic), 1, in) != 1)
+        return READ_IO_ERROR;
+
+    for (size_t i = 0; i < sizeof(decoders) / sizeof(decoders[0]); i++) {
+        if (decoders[i].sniff(magic, sizeof(magic))) {
+            header->decoder = &decoders[i];
+            return decoders[i].read_header(in, magic, sizeof(magic), header);
+        }
+    }
+    return READ_INVALID_SIGNATURE;
+}
+
+/**
+ * @brief Читает строки заданной области декодером, распознавшим файл.
+ *
+ * @param in Указатель на файл, заголовок которого прочитан `decoder_read_header`.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status decoder_read_region(FILE *in, const struct image_header *header, const struct image_rect *region,
+                                     image_row_handler handler, void *ctx) {
+    if (!header || !header->decoder) return READ_INVALID_HEADER;
+    return header->decoder->read_region(in, header, region, handler, ctx);
+}
+
+/**
+ * @brief Копирует прочитанную строку в соответствующую строку изображения.
+ *
+ * @param ctx Указатель на структуру `image`, в которую загружаются данные.
+ * @param y Номер строки изображения.
+ * @param row Пиксели строки.
+ * @return Всегда 0.
+ */
+static int store_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct image *img = ctx;
+    memcpy(image_pixel(img, 0, y), row, img->width * sizeof(struct pixel));
+    return 0;
+}
+
+/**
+ * @brief Читает изображение любого поддерживаемого формата целиком.
+ *
+ * @param in Указатель на файл, стоящий в начале.
+ * @param img Указатель на структуру `image`, в которую будет загружено изображение.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status decoder_read_image(FILE *in, struct image *img) {
+    if (!in || !img) return READ_INVALID_HEADER;
+
+    struct image_header header;
+    enum read_status status = decoder_read_header(in, &header);
+    if (status != READ_OK)
+        return status;
+
+    *img = create_image_uninit(header.width, header.height);
+    if (!img->data) {
+        return READ_MEMORY_ERROR;
+    }
+
+    struct image_rect full = {0, 0, header.width, header.height};
+    status = decoder_read_region(in, &header, &full, store_row, img);
+    if (status != READ_OK) {
+        destroy_image(img);
+    }
+    return status;
+}
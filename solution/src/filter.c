@@ -0,0 +1,317 @@
+#include "filter.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FILTER_TILE_WIDTH 256        // Ширина тайла в пикселях
+#define FILTER_MIN_TILE_HEIGHT 64    // Минимальная высота тайла; для больших радиусов тайл выше, чтобы перекрытие было мало
+#define FILTER_GAUSS_BITS 14         // Число дробных бит весов ядра Гаусса
+#define FILTER_CARRY_BITS 8          // Число дробных бит, сохраняемых между горизонтальным и вертикальным проходами
+
+/**
+ * @brief Параметры применения фильтра, общие для всех потоков.
+ */
+struct filter_job {
+    const struct image *source;      // Исходное изображение
+    struct image *dest;              // Изображение-результат
+    const struct filter_op *op;      // Параметры фильтра
+    uint64_t radius;                 // Радиус ядра в пикселях
+    uint32_t *kernel;                // Веса ядра Гаусса (2 * radius + 1 штук)
+    uint64_t box_inverse;            // Обратная площадь окна размытия средним в формате 0.32
+    int32_t amount;                  // Сила повышения резкости в формате 8.8
+    uint64_t tile_height;            // Высота тайла в пикселях
+    uint64_t tiles_x;                // Количество тайлов по горизонтали
+    int failed;                      // Признак того, что потоку не хватило памяти
+};
+
+/**
+ * @brief Ограничивает индекс пикселя границами изображения (крайние пиксели повторяются).
+ */
+static inline uint64_t clamp_index(int64_t index, uint64_t size) {
+    if (index < 0) {
+        return 0;
+    }
+    return (uint64_t) index >= size ? size - 1 : (uint64_t) index;
+}
+
+/**
+ * @brief Горизонтальный проход размытия средним: суммы окна для столбцов `[x0, x1)` одной строки.
+ *
+ * Сумма окна обновляется скользящим образом: на каждом шаге добавляется входящий пиксель
+ * и вычитается выходящий, так что стоимость не зависит от радиуса.
+ */
+static void box_horizontal(const struct filter_job *job, const struct pixel *row, uint64_t x0, uint64_t x1, uint32_t *out) {
+    int64_t radius = (int64_t) job->radius;
+    uint64_t width = job->source->width;
+    uint32_t b = 0, g = 0, r = 0;
+
+    for (int64_t k = -radius; k <= radius; k++) {
+        const struct pixel *p = &row[clamp_index((int64_t) x0 + k, width)];
+        b += p->b;
+        g += p->g;
+        r += p->r;
+    }
+    for (uint64_t x = x0; x < x1; x++) {
+        *out++ = b;
+        *out++ = g;
+        *out++ = r;
+        const struct pixel *in = &row[clamp_index((int64_t) x + radius + 1, width)];
+        const struct pixel *leaving = &row[clamp_index((int64_t) x - radius, width)];
+        b += (uint32_t) in->b - leaving->b;
+        g += (uint32_t) in->g - leaving->g;
+        r += (uint32_t) in->r - leaving->r;
+    }
+}
+
+/**
+ * @brief Горизонтальный проход Гаусса для столбцов `[x0, x1)` одной строки.
+ *
+ * Нужный отрезок строки вместе с перекрытием копируется в буфер `line` (с повторением крайних пикселей),
+ * после чего свертка идет по непрерывным массивам каналов: внешний цикл по весам, внутренний по каналам,
+ * который компилятор векторизует. Результат сохраняет `FILTER_CARRY_BITS` дробных бит,
+ * чтобы вертикальный проход не терял точность.
+ */
+static void gaussian_horizontal(const struct filter_job *job, const struct pixel *row, uint64_t x0, uint64_t x1,
+                                uint8_t *line, uint32_t *out) {
+    uint64_t radius = job->radius;
+    uint64_t width = job->source->width;
+    uint64_t channels = (x1 - x0) * sizeof(struct pixel);
+    const uint32_t round = 1u << (FILTER_GAUSS_BITS - FILTER_CARRY_BITS - 1);
+
+    if (x0 >= radius && x1 + radius <= width) {
+        memcpy(line, row + x0 - radius, (x1 - x0 + 2 * radius) * sizeof(struct pixel));
+    } else {
+        struct pixel *padded = (struct pixel *) line;
+        for (uint64_t i = 0; i < x1 - x0 + 2 * radius; i++) {
+            padded[i] = row[clamp_index((int64_t) (x0 + i) - (int64_t) radius, width)];
+        }
+    }
+
+    for (uint64_t c = 0; c < channels; c++) {
+        out[c] = round;
+    }
+    for (uint64_t k = 0; k <= 2 * radius; k++) {
+        const uint8_t *in = line + k * sizeof(struct pixel);
+        uint32_t weight = job->kernel[k];
+        for (uint64_t c = 0; c < channels; c++) {
+            out[c] += weight * in[c];
+        }
+    }
+    for (uint64_t c = 0; c < channels; c++) {
+        out[c] >>= FILTER_GAUSS_BITS - FILTER_CARRY_BITS;
+    }
+}
+
+/**
+ * @brief Повышает резкость значения канала по разнице с размытым значением.
+ */
+static inline uint8_t unsharp_channel(const struct filter_job *job, uint8_t original, uint32_t blurred) {
+    int32_t diff = (int32_t) original - (int32_t) blurred;
+    if ((diff < 0 ? -diff : diff) < job->op->threshold) {
+        return original;
+    }
+    int64_t value = original + ((int64_t) diff * job->amount + (diff >= 0 ? 128 : -128)) / 256;
+    if (value < 0) {
+        return 0;
+    }
+    return value > 255 ? 255 : (uint8_t) value;
+}
+
+/**
+ * @brief Обрабатывает один тайл результата `[x0, x1) x [y0, y1)`.
+ *
+ * Сначала горизонтальный проход считается для строк тайла и перекрытия сверху и снизу на радиус ядра,
+ * затем вертикальный проход по непрерывным массивам каналов, который компилятор векторизует.
+ *
+ * @param job Параметры фильтра.
+ * @param temp Буфер горизонтального прохода на `(y1 - y0 + 2 * radius) * (x1 - x0) * 3` значений.
+ * @param acc Буфер сумм вертикального прохода на `(x1 - x0) * 3` значений.
+ * @param line Буфер отрезка строки с перекрытием на `(x1 - x0 + 2 * radius) * 3` байт.
+ */
+static void filter_tile(const struct filter_job *job, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1,
+                        uint32_t *temp, uint32_t *acc, uint8_t *line) {
+    uint64_t radius = job->radius;
+    uint64_t channels = (x1 - x0) * sizeof(struct pixel);
+    uint64_t rows = y1 - y0 + 2 * radius;
+    const struct image *source = job->source;
+
+    for (uint64_t i = 0; i < rows; i++) {
+        const struct pixel *row = image_pixel(source, 0, clamp_index((int64_t) (y0 + i) - (int64_t) radius, source->height));
+        if (job->op->kind == FILTER_BOX_BLUR) {
+            box_horizontal(job, row, x0, x1, temp + i * channels);
+        } else {
+            gaussian_horizontal(job, row, x0, x1, line, temp + i * channels);
+        }
+    }
+
+    if (job->op->kind == FILTER_BOX_BLUR) {
+        for (uint64_t c = 0; c < channels; c++) {
+            acc[c] = 0;
+        }
+        for (uint64_t k = 0; k <= 2 * radius; k++) {
+            const uint32_t *in = temp + k * channels;
+            for (uint64_t c = 0; c < channels; c++) {
+                acc[c] += in[c];
+            }
+        }
+        for (uint64_t y = y0; y < y1; y++) {
+            uint8_t *out = (uint8_t *) image_pixel(job->dest, x0, y);
+            for (uint64_t c = 0; c < channels; c++) {
+                out[c] = (uint8_t) ((acc[c] * job->box_inverse + (1ull << 31)) >> 32);
+            }
+            if (y + 1 < y1) {
+                // Скользящая сумма по вертикали: добавляем следующую строку окна и вычитаем первую
+                const uint32_t *entering = temp + (y - y0 + 2 * radius + 1) * channels;
+                const uint32_t *leaving = temp + (y - y0) * channels;
+                for (uint64_t c = 0; c < channels; c++) {
+                    acc[c] += entering[c] - leaving[c];
+                }
+            }
+        }
+        return;
+    }
+
+    const uint32_t round = 1u << (FILTER_GAUSS_BITS + FILTER_CARRY_BITS - 1);
+    for (uint64_t y = y0; y < y1; y++) {
+        for (uint64_t c = 0; c < channels; c++) {
+            acc[c] = round;
+        }
+        for (uint64_t k = 0; k <= 2 * radius; k++) {
+            const uint32_t *in = temp + (y - y0 + k) * channels;
+            uint32_t weight = job->kernel[k];
+            for (uint64_t c = 0; c < channels; c++) {
+                acc[c] += weight * in[c];
+            }
+        }
+
+        uint8_t *out = (uint8_t *) image_pixel(job->dest, x0, y);
+        if (job->op->kind == FILTER_UNSHARP_MASK) {
+            const uint8_t *original = (const uint8_t *) image_pixel(source, x0, y);
+            for (uint64_t c = 0; c < channels; c++) {
+                uint32_t blurred = acc[c] >> (FILTER_GAUSS_BITS + FILTER_CARRY_BITS);
+                out[c] = unsharp_channel(job, original[c], blurred > 255 ? 255 : blurred);
+            }
+        } else {
+            for (uint64_t c = 0; c < channels; c++) {
+                uint32_t blurred = acc[c] >> (FILTER_GAUSS_BITS + FILTER_CARRY_BITS);
+                out[c] = (uint8_t) (blurred > 255 ? 255 : blurred);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Обрабатывает тайлы с номерами `[begin, end)`; вызывается из пула потоков.
+ */
+static void filter_tiles(void *ctx, uint64_t begin, uint64_t end) {
+    struct filter_job *job = ctx;
+    uint64_t channels = FILTER_TILE_WIDTH * sizeof(struct pixel);
+    uint32_t *temp = malloc((job->tile_height + 2 * job->radius) * channels * sizeof(uint32_t));
+    uint32_t *acc = malloc(channels * sizeof(uint32_t));
+    uint8_t *line = malloc((FILTER_TILE_WIDTH + 2 * job->radius) * sizeof(struct pixel));
+    if (!temp || !acc || !line) {
+        free(temp);
+        free(acc);
+        free(line);
+        job->failed = 1;
+        return;
+    }
+
+    for (uint64_t tile = begin; tile < end; tile++) {
+        uint64_t x0 = (tile % job->tiles_x) * FILTER_TILE_WIDTH;
+        uint64_t y0 = (tile / job->tiles_x) * job->tile_height;
+        uint64_t x1 = job->source->width - x0 > FILTER_TILE_WIDTH ? x0 + FILTER_TILE_WIDTH : job->source->width;
+        uint64_t y1 = job->source->height - y0 > job->tile_height ? y0 + job->tile_height : job->source->height;
+        filter_tile(job, x0, y0, x1, y1, temp, acc, line);
+    }
+
+    free(temp);
+    free(acc);
+    free(line);
+}
+
+/**
+ * @brief Вычисляет нормированные веса ядра Гаусса в фиксированной точке.
+ *
+ * Остаток от округления добавляется к центральному весу, чтобы сумма весов была точно равна единице.
+ *
+ * @param job Параметры фильтра; заполняются поля `radius` и `kernel`.
+ * @param sigma Параметр Гаусса.
+ * @return 0 при успехе или 1, если радиус ядра больше `FILTER_MAX_RADIUS` или не удалось выделить память.
+ */
+static int gaussian_kernel(struct filter_job *job, double sigma) {
+    if (!(ceil(3.0 * sigma) <= FILTER_MAX_RADIUS)) {
+        return 1;
+    }
+    uint64_t radius = (uint64_t) ceil(3.0 * sigma);
+    job->radius = radius;
+    job->kernel = malloc((2 * radius + 1) * sizeof(uint32_t));
+    if (!job->kernel) {
+        return 1;
+    }
+
+    double total = 0.0;
+    for (uint64_t k = 0; k <= 2 * radius; k++) {
+        double x = (double) k - (double) radius;
+        total += exp(-x * x / (2.0 * sigma * sigma));
+    }
+    uint32_t sum = 0;
+    for (uint64_t k = 0; k <= 2 * radius; k++) {
+        double x = (double) k - (double) radius;
+        job->kernel[k] = (uint32_t) lround(exp(-x * x / (2.0 * sigma * sigma)) / total * (1 << FILTER_GAUSS_BITS));
+        sum += job->kernel[k];
+    }
+    job->kernel[radius] += (1u << FILTER_GAUSS_BITS) - sum;
+    return 0;
+}
+
+/**
+ * @brief Применяет к изображению фильтр свертки.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param op Указатель на параметры фильтра.
+ * @return Новая структура `image` того же размера. Если параметры некорректны или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image filter_image(const struct image *source, const struct filter_op *op) {
+    struct image result = {0};
+    if (source == NULL || source->data == NULL || op == NULL) {
+        return result;
+    }
+
+    struct filter_job job = {0};
+    job.source = source;
+    job.op = op;
+
+    if (op->kind == FILTER_BOX_BLUR) {
+        if (op->radius > FILTER_MAX_RADIUS) {
+            return result;
+        }
+        job.radius = op->radius;
+        uint64_t area = (2 * job.radius + 1) * (2 * job.radius + 1);
+        job.box_inverse = ((1ull << 32) + area / 2) / area;
+    } else {
+        if (op->kind == FILTER_UNSHARP_MASK && !(op->amount >= 0.0 && op->amount <= FILTER_MAX_AMOUNT)) {
+            return result;
+        }
+        if (!(op->sigma > 0.0) || gaussian_kernel(&job, op->sigma) != 0) {
+            return result;
+        }
+        job.amount = (int32_t) lround(op->amount * 256.0);
+    }
+
+    result = create_image_uninit(source->width, source->height);
+    if (result.data) {
+        job.dest = &result;
+        job.tile_height = 4 * job.radius > FILTER_MIN_TILE_HEIGHT ? 4 * job.radius : FILTER_MIN_TILE_HEIGHT;
+        job.tiles_x = (source->width + FILTER_TILE_WIDTH - 1) / FILTER_TILE_WIDTH;
+        uint64_t tiles_y = (source->height + job.tile_height - 1) / job.tile_height;
+        parallel_for(job.tiles_x * tiles_y, 1, filter_tiles, &job);
+        if (job.failed) {
+            destroy_image(&result);
+        }
+    }
+
+    free(job.kernel);
+    return result;
+}
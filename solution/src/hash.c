@@ -0,0 +1,157 @@
+#include "hash.h"
+#include <string.h>
+
+// Простые множители XXH64
+#define PRIME1 0x9E3779B185EBCA87ULL
+#define PRIME2 0xC2B2AE3D27D4EB4FULL
+#define PRIME3 0x165667B19E3779F9ULL
+#define PRIME4 0x85EBCA77C2B2AE63ULL
+#define PRIME5 0x27D4EB2F165667C5ULL
+
+/**
+ * @brief Циклический сдвиг 64-битного значения влево.
+ */
+static inline uint64_t rotl(uint64_t value, unsigned bits) {
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+ * @brief Читает 64-битное значение в порядке little-endian с произвольного адреса.
+ */
+static inline uint64_t read64(const uint8_t *p) {
+    return (uint64_t) p[0] | (uint64_t) p[1] << 8 | (uint64_t) p[2] << 16 | (uint64_t) p[3] << 24
+           | (uint64_t) p[4] << 32 | (uint64_t) p[5] << 40 | (uint64_t) p[6] << 48 | (uint64_t) p[7] << 56;
+}
+
+/**
+ * @brief Читает 32-битное значение в порядке little-endian с произвольного адреса.
+ */
+static inline uint32_t read32(const uint8_t *p) {
+    return (uint32_t) p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 | (uint32_t) p[3] << 24;
+}
+
+/**
+ * @brief Обновляет накопитель полосы очередным 64-битным словом.
+ */
+static inline uint64_t round64(uint64_t acc, uint64_t input) {
+    acc += input * PRIME2;
+    acc = rotl(acc, 31);
+    return acc * PRIME1;
+}
+
+/**
+ * @brief Вливает накопитель полосы в итоговый хеш.
+ */
+static inline uint64_t merge_round(uint64_t hash, uint64_t lane) {
+    hash ^= round64(0, lane);
+    return hash * PRIME1 + PRIME4;
+}
+
+/**
+ * @brief Обрабатывает полные 32-байтные блоки и возвращает количество обработанных байт.
+ */
+static size_t consume_blocks(uint64_t lanes[4], const uint8_t *data, size_t size) {
+    uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+    size_t offset = 0;
+    for (; offset + 32 <= size; offset += 32) {
+        v1 = round64(v1, read64(data + offset));
+        v2 = round64(v2, read64(data + offset + 8));
+        v3 = round64(v3, read64(data + offset + 16));
+        v4 = round64(v4, read64(data + offset + 24));
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+    return offset;
+}
+
+/**
+ * @brief Начинает вычисление хеша.
+ *
+ * @param state Указатель на состояние хеша.
+ * @param seed Начальное значение хеша.
+ */
+void hash_init(struct hash_state *state, uint64_t seed) {
+    state->total = 0;
+    state->lanes[0] = seed + PRIME1 + PRIME2;
+    state->lanes[1] = seed + PRIME2;
+    state->lanes[2] = seed;
+    state->lanes[3] = seed - PRIME1;
+    state->buffered = 0;
+    state->seed = seed;
+}
+
+/**
+ * @brief Добавляет к хешируемой последовательности очередную порцию данных.
+ *
+ * @param state Указатель на состояние хеша.
+ * @param data Указатель на данные.
+ * @param size Размер данных в байтах.
+ */
+void hash_update(struct hash_state *state, const void *data, size_t size) {
+    const uint8_t *bytes = data;
+    state->total += size;
+
+    if (state->buffered + size < sizeof(state->buffer)) {
+        memcpy(state->buffer + state->buffered, bytes, size);
+        state->buffered += size;
+        return;
+    }
+    if (state->buffered > 0) {
+        size_t fill = sizeof(state->buffer) - state->buffered;
+        memcpy(state->buffer + state->buffered, bytes, fill);
+        consume_blocks(state->lanes, state->buffer, sizeof(state->buffer));
+        bytes += fill;
+        size -= fill;
+        state->buffered = 0;
+    }
+    size_t consumed = consume_blocks(state->lanes, bytes, size);
+    memcpy(state->buffer, bytes + consumed, size - consumed);
+    state->buffered = size - consumed;
+}
+
+/**
+ * @brief Завершает вычисление и возвращает хеш всех переданных данных.
+ *
+ * @param state Указатель на состояние хеша.
+ * @return 64-битный хеш XXH64.
+ */
+uint64_t hash_digest(const struct hash_state *state) {
+    uint64_t hash;
+    if (state->total >= 32) {
+        const uint64_t *v = state->lanes;
+        hash = rotl(v[0], 1) + rotl(v[1], 7) + rotl(v[2], 12) + rotl(v[3], 18);
+        for (int i = 0; i < 4; i++) {
+            hash = merge_round(hash, v[i]);
+        }
+    } else {
+        hash = state->seed + PRIME5;
+    }
+    hash += state->total;
+
+    // Хвост, не образующий полного блока
+    const uint8_t *p = state->buffer;
+    size_t left = state->buffered;
+    for (; left >= 8; p += 8, left -= 8) {
+        hash ^= round64(0, read64(p));
+        hash = rotl(hash, 27) * PRIME1 + PRIME4;
+    }
+    if (left >= 4) {
+        hash ^= (uint64_t) read32(p) * PRIME1;
+        hash = rotl(hash, 23) * PRIME2 + PRIME3;
+        p += 4;
+        left -= 4;
+    }
+    for (; left > 0; p++, left--) {
+        hash ^= *p * PRIME5;
+        hash = rotl(hash, 11) * PRIME1;
+    }
+
+    hash ^= hash >> 33;
+    hash *= PRIME2;
+    hash ^= hash >> 29;
+    hash *= PRIME3;
+    hash ^= hash >> 32;
+    return hash;
+}
@@ -1,31 +1,34 @@
 #include "image.h"
+#include "buffer.h"
 #include <stdlib.h>
 #include <limits.h>  // Для проверки переполнения
 
 /**
- * @brief Создает изображение с указанной шириной и высотой.
+ * @brief Выделяет память под изображение с указанной шириной и высотой.
  *
- * Выделяет память для массива пикселей и инициализирует их нулями. Если ширина или высота равны нулю
- * или происходит переполнение при вычислении размера памяти, возвращает пустую структуру.
+ * Если ширина или высота равны нулю или происходит переполнение при вычислении размера памяти,
+ * возвращает пустую структуру.
  *
  * @param width Ширина изображения в пикселях.
  * @param height Высота изображения в пикселях.
- * @return Структура `image`, содержащая данные нового изображения. Если выделение памяти не удалось, возвращается структура с `data` равной NULL.
+ * @param zeroed Нужно ли инициализировать пиксели нулями.
+ * @return Структура `image`; если выделение памяти не удалось, поле `data` равно NULL.
  */
-struct image create_image(uint64_t width, uint64_t height) {
+static struct image allocate_image(uint64_t width, uint64_t height, int zeroed) {
     struct image img;
 
     // Проверка на переполнение при умножении
-    if (width == 0 || height == 0 || width > UINT64_MAX / height) {
+    if (width == 0 || height == 0 || width > UINT64_MAX / height / sizeof(struct pixel)) {
         img.width = 0;
         img.height = 0;
         img.data = NULL;
         return img;
     }
 
+    uint64_t size = width * height * sizeof(struct pixel);
     img.width = width;
     img.height = height;
-    img.data = calloc(width * height, sizeof(struct pixel));  // Выделение памяти и инициализация нулями
+    img.data = zeroed ? buffer_alloc(size) : buffer_alloc_uninit(size);
 
     // Проверка успешного выделения памяти
     if (!img.data) {
@@ -36,6 +39,32 @@ struct image create_image(uint64_t width, uint64_t height) {
     return img;
 }
 
+/**
+ * @brief Создает изображение с указанной шириной и высотой.
+ *
+ * Выделяет память для массива пикселей через `buffer_alloc` (с учетом настроек больших страниц и NUMA)
+ * и инициализирует их нулями. Если ширина или высота равны нулю или происходит переполнение
+ * при вычислении размера памяти, возвращает пустую структуру.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Структура `image`, содержащая данные нового изображения. Если выделение памяти не удалось, возвращается структура с `data` равной NULL.
+ */
+struct image create_image(uint64_t width, uint64_t height) {
+    return allocate_image(width, height, 1);
+}
+
+/**
+ * @brief Создает изображение с неинициализированными пикселями.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return Структура `image`. Если выделение памяти не удалось, возвращается структура с `data` равной NULL.
+ */
+struct image create_image_uninit(uint64_t width, uint64_t height) {
+    return allocate_image(width, height, 0);
+}
+
 /**
  * @brief Освобождает память, выделенную под изображение.
  *
@@ -45,7 +74,7 @@ struct image create_image(uint64_t width, uint64_t height) {
  */
 void destroy_image(struct image *img) {
     if (img && img->data) {
-        free(img->data);
+        buffer_free(img->data);
         img->data = NULL;
         img->width = 0;
         img->height = 0;
@@ -69,3 +98,24 @@ struct pixel *image_pixel(const struct image *img, uint64_t x, uint64_t y) {
     }
     return &img->data[y * img->width + x];
 }
+
+/**
+ * @brief Проверяет, что прямоугольная область целиком лежит внутри изображения заданного размера.
+ *
+ * Проверка выполняется без переполнений: сравниваются размеры области с оставшимся местом
+ * от ее левого верхнего угла до границ изображения.
+ *
+ * @param region Указатель на проверяемую область.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return 1, если область непустая и не выходит за границы изображения, иначе 0.
+ */
+int image_rect_fits(const struct image_rect *region, uint64_t width, uint64_t height) {
+    if (!region || region->width == 0 || region->height == 0) {
+        return 0;
+    }
+    if (region->x >= width || region->y >= height) {
+        return 0;
+    }
+    return region->width <= width - region->x && region->height <= height - region->y;
+}
@@ -1,30 +1,344 @@
 #include "image_io.h"
 #include "bmp.h"
+#include "decoder.h"
+#include "hash.h"
+#include "qoi.h"
+#include "resize.h"
+#include "tiff.h"
 #include <stdio.h>
+#include <string.h>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
+static const char *const format_names[IMAGE_FORMAT_COUNT] = {"auto", "bmp", "qoi", "tiff"};
+static const char *const format_titles[IMAGE_FORMAT_COUNT] = {"", "BMP", "QOI", "TIFF"};
+
+/**
+ * @brief Проверяет, обозначает ли путь стандартный поток ввода или вывода.
+ *
+ * @param path Путь к файлу.
+ * @return 1, если путь равен "-", иначе 0.
+ */
+int image_path_is_stream(const char *path) {
+    return strcmp(path, "-") == 0;
+}
 
 /**
- * @brief Читает изображение из BMP файла.
+ * @brief Открывает файл для двоичного чтения; путь "-" обозначает стандартный ввод.
  *
- * Открывает файл по указанному пути в режиме "rb" (чтение в двоичном режиме).
- * Затем читает данные изображения в структуру `image` с использованием функции `bmp_from_file`.
+ * @param path Путь к файлу.
+ * @return Указатель на открытый файл или NULL в случае ошибки.
+ */
+static FILE *open_input(const char *path) {
+    if (!image_path_is_stream(path)) {
+        return fopen(path, "rb");
+    }
+#ifdef _WIN32
+    _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    return stdin;
+}
+
+/**
+ * @brief Открывает файл для двоичной записи; путь "-" обозначает стандартный вывод.
+ *
+ * @param path Путь к файлу.
+ * @return Указатель на открытый файл или NULL в случае ошибки.
+ */
+static FILE *open_output(const char *path) {
+    if (!image_path_is_stream(path)) {
+        return fopen(path, "wb");
+    }
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    return stdout;
+}
+
+/**
+ * @brief Закрывает файл, открытый `open_input` или `open_output`.
+ *
+ * Стандартные потоки не закрываются, а только сбрасываются, чтобы программа могла продолжить работу.
+ *
+ * @param file Указатель на файл.
+ * @return 0 при успехе или EOF, если не удалось дописать данные.
+ */
+static int close_file(FILE *file) {
+    if (file == stdin) {
+        return 0;
+    }
+    if (file == stdout) {
+        return fflush(file);
+    }
+    return fclose(file);
+}
+
+/**
+ * @brief Сообщает об ошибке чтения исходного изображения.
+ *
+ * @param status Статус чтения, отличный от `READ_OK`.
+ */
+static void report_read_error(enum read_status status) {
+    switch (status) {
+        case READ_INVALID_REGION:
+            fprintf(stderr, "Ошибка: область выходит за пределы изображения\n");
+            break;
+        case READ_INVALID_SIGNATURE:
+            fprintf(stderr, "Ошибка при чтении изображения: неизвестный формат файла\n");
+            break;
+        case READ_INVALID_BITS:
+            fprintf(stderr, "Ошибка при чтении изображения: неподдерживаемый формат пикселей\n");
+            break;
+        case READ_MEMORY_ERROR:
+            fprintf(stderr, "Ошибка при чтении изображения: недостаточно памяти\n");
+            break;
+        default:
+            fprintf(stderr, "Ошибка при чтении изображения\n");
+            break;
+    }
+}
+
+/**
+ * @brief Читает изображение из файла любого поддерживаемого формата.
+ *
+ * Открывает файл по указанному пути в режиме "rb" (чтение в двоичном режиме); путь "-" обозначает стандартный ввод.
+ * Формат (BMP, PGM/PPM/PAM или QOI) определяется по первым байтам функцией `decoder_read_image`.
  * В случае ошибки выводит сообщение об ошибке и возвращает ненулевой код.
  *
- * @param source_path Путь к BMP файлу для чтения изображения.
+ * @param source_path Путь к файлу для чтения изображения.
  * @param img Указатель на структуру `image`, в которую будут записаны данные изображения.
  * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
  */
 int read_image(const char *source_path, struct image *img) {
-    FILE *input = fopen(source_path, "rb");
+    FILE *input = open_input(source_path);
     if (!input) {
         perror("Не удалось открыть исходный файл");
         return 1;
     }
 
-    enum read_status r_status = bmp_from_file(input, img);
+    enum read_status r_status = decoder_read_image(input, img);
+    close_file(input);
+
+    if (r_status != READ_OK) {
+        report_read_error(r_status);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Читает только заголовок изображения и возвращает его размеры.
+ *
+ * @param source_path Путь к файлу изображения.
+ * @param width Указатель, по которому будет записана ширина.
+ * @param height Указатель, по которому будет записана высота.
+ * @return 0, если заголовок прочитан, или 1 в случае ошибки.
+ */
+int read_image_size(const char *source_path, uint64_t *width, uint64_t *height) {
+    if (image_path_is_stream(source_path)) {
+        return 1;
+    }
+    FILE *input = fopen(source_path, "rb");
+    if (!input) {
+        return 1;
+    }
+    struct image_header header;
+    enum read_status r_status = decoder_read_header(input, &header);
     fclose(input);
+    if (r_status != READ_OK) {
+        return 1;
+    }
+    *width = header.width;
+    *height = header.height;
+    return 0;
+}
+
+/**
+ * @brief Контекст чтения области с приведением к заданной ориентации.
+ */
+struct oriented_region {
+    struct image *img;               // Изображение-результат
+    enum orientation orientation;    // Ориентация результата
+    struct orientation_map map;      // Отображение строк области в результат
+    uint64_t width;                  // Ширина области в пикселях
+};
+
+/**
+ * @brief Выделяет память под результат в нужной ориентации.
+ */
+static int oriented_prepare(void *ctx, const struct image_rect *region) {
+    struct oriented_region *oriented = ctx;
+    orientation_map_init(&oriented->map, oriented->orientation, region->width, region->height);
+    oriented->width = region->width;
+    *oriented->img = create_image_uninit(oriented->map.width, oriented->map.height);
+    return oriented->img->data ? 0 : 1;
+}
+
+/**
+ * @brief Помещает строку области в результат согласно ориентации.
+ */
+static int oriented_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct oriented_region *oriented = ctx;
+    orient_row(oriented->img, &oriented->map, y, row, oriented->width);
+    return 0;
+}
+
+/**
+ * @brief Контекст чтения области с уменьшением в целое число раз.
+ */
+struct shrunk_region {
+    struct shrink_reader reader;     // Состояние уменьшения
+    struct image *img;               // Изображение-результат
+    uint64_t factor;                 // Коэффициент уменьшения
+    enum orientation orientation;    // Ориентация результата
+};
+
+/**
+ * @brief Подготавливает уменьшение и выделяет память под результат.
+ */
+static int shrunk_prepare(void *ctx, const struct image_rect *region) {
+    struct shrunk_region *shrunk = ctx;
+    return shrink_reader_init(&shrunk->reader, region->width, region->height, shrunk->factor,
+                              shrunk->orientation, shrunk->img);
+}
+
+/**
+ * @brief Добавляет строку области в накапливаемые блоки уменьшения.
+ */
+static int shrunk_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct shrunk_region *shrunk = ctx;
+    return shrink_reader_row(&shrunk->reader, y, row);
+}
+
+/**
+ * @brief Освобождает служебную память уменьшения.
+ */
+static void shrunk_finish(void *ctx) {
+    struct shrunk_region *shrunk = ctx;
+    shrink_reader_destroy(&shrunk->reader);
+}
+
+/**
+ * @brief Контекст сбора сведений о строках по пути к обработчику.
+ */
+struct observed_rows {
+    const struct region_consumer *consumer; // Исходный способ обработки строк
+    const struct read_observers *observers; // Собираемые сведения
+    struct hash_state state;         // Хеш прочитанных пикселей
+    uint64_t width;                  // Ширина области в пикселях
+};
+
+/**
+ * @brief Добавляет строку к хешу, статистике и карте тайлов и передает ее исходному обработчику.
+ */
+static int observed_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct observed_rows *observed = ctx;
+    if (observed->observers->digest) {
+        hash_update(&observed->state, row, observed->width * sizeof(struct pixel));
+    }
+    if (observed->observers->stats) {
+        image_stats_add(observed->observers->stats, row, observed->width);
+    }
+    if (observed->observers->tiles) {
+        uniform_tiles_row(observed->observers->tiles, y, row);
+    }
+    return observed->consumer->handler(observed->consumer->ctx, y, row);
+}
+
+/**
+ * @brief Читает строки области, собирая по пути запрошенные сведения о пикселях.
+ *
+ * @param input Открытый файл, спозиционированный после заголовка.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область.
+ * @param consumer Способ обработки строк области.
+ * @param observers Указатель на собираемые сведения.
+ * @return `READ_OK` при успехе или код ошибки.
+ */
+static enum read_status read_observed(FILE *input, const struct image_header *header,
+                                      const struct image_rect *region, const struct region_consumer *consumer,
+                                      const struct read_observers *observers) {
+    if (observers->tiles
+        && uniform_tiles_init(observers->tiles, region->width, region->height, observers->tile) != 0) {
+        return READ_MEMORY_ERROR;
+    }
+    struct observed_rows observed = {consumer, observers, {0}, region->width};
+    hash_init(&observed.state, 0);
+    hash_update(&observed.state, &region->width, sizeof(region->width));
+    hash_update(&observed.state, &region->height, sizeof(region->height));
+    if (observers->stats) {
+        image_stats_init(observers->stats);
+    }
+    enum read_status r_status = decoder_read_region(input, header, region, observed_row, &observed);
+    if (observers->digest) {
+        *observers->digest = hash_digest(&observed.state);
+    }
+    if (observers->stats) {
+        image_stats_finish(observers->stats);
+    }
+    if (observers->tiles && r_status != READ_OK) {
+        uniform_tiles_destroy(observers->tiles);
+    }
+    return r_status;
+}
+
+/**
+ * @brief Читает область изображения, передавая ее строки обработчику.
+ *
+ * Открывает файл, определяет формат и читает заголовок, подготавливает результат под размер области
+ * и читает только строки, попадающие в область. Если нужны хеш, статистика пикселей или карта
+ * однотонных тайлов, они вычисляются в том же проходе по мере поступления строк, пока строки еще в кэше.
+ *
+ * @param source_path Путь к файлу изображения.
+ * @param region Указатель на читаемую область или NULL для всего изображения.
+ * @param consumer Способ обработки строк области.
+ * @param img Указатель на структуру `image` с результатом; освобождается при ошибке (может быть NULL).
+ * @param observers Указатель на сведения о пикселях области или NULL, если они не нужны.
+ * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
+ */
+static int read_region(const char *source_path, const struct image_rect *region,
+                       const struct region_consumer *consumer, struct image *img,
+                       const struct read_observers *observers) {
+    FILE *input = open_input(source_path);
+    if (!input) {
+        perror("Не удалось открыть исходный файл");
+        return 1;
+    }
+
+    struct image_header header;
+    struct image_rect full = {0};
+    enum read_status r_status = decoder_read_header(input, &header);
+    if (r_status == READ_OK && !region) {
+        full.width = header.width;
+        full.height = header.height;
+        region = &full;
+    }
+    if (r_status == READ_OK && !image_rect_fits(region, header.width, header.height)) {
+        r_status = READ_INVALID_REGION;
+    }
+    if (r_status == READ_OK && consumer->prepare(consumer->ctx, region) != 0) {
+        r_status = READ_MEMORY_ERROR;
+    }
+    if (r_status == READ_OK) {
+        if (observers) {
+            r_status = read_observed(input, &header, region, consumer, observers);
+        } else {
+            r_status = decoder_read_region(input, &header, region, consumer->handler, consumer->ctx);
+        }
+        if (consumer->finish) {
+            consumer->finish(consumer->ctx);
+        }
+        if (r_status != READ_OK) {
+            destroy_image(img);
+        }
+    }
+    close_file(input);
 
     if (r_status != READ_OK) {
-        fprintf(stderr, "Ошибка при чтении BMP изображения\n");
+        report_read_error(r_status);
         return 1;
     }
 
@@ -32,49 +346,284 @@ int read_image(const char *source_path, struct image *img) {
 }
 
 /**
- * @brief Записывает изображение в BMP файл.
+ * @brief Читает строки области изображения и передает их заданному обработчику.
  *
- * Открывает файл по указанному пути в режиме "wb" (запись в двоичном режиме).
- * Затем записывает данные изображения из структуры `image` в файл с использованием функции `bmp_to_file`.
- * В случае ошибки выводит сообщение об ошибке и возвращает ненулевой код.
+ * @param source_path Путь к файлу изображения для чтения.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param consumer Способ обработки строк области.
+ * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
+ */
+int read_image_rows(const char *source_path, const struct image_rect *region, const struct region_consumer *consumer) {
+    return read_region(source_path, region, consumer, NULL, NULL);
+}
+
+/**
+ * @brief Читает из файла только заданную область изображения.
  *
- * @param dest_path Путь к BMP файлу для записи изображения.
+ * @param source_path Путь к файлу изображения для чтения.
+ * @param region Указатель на читаемую область изображения.
+ * @param img Указатель на структуру `image`, в которую будет загружена область.
+ * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
+ */
+int read_image_region(const char *source_path, const struct image_rect *region, struct image *img) {
+    return read_image_region_oriented(source_path, region, ORIENTATION_NONE, img, NULL);
+}
+
+/**
+ * @brief Читает область изображения и приводит ее к заданной ориентации.
+ *
+ * @param source_path Путь к файлу изображения для чтения.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param orientation Ориентация результата.
+ * @param img Указатель на структуру `image`, в которую будет записан результат.
+ * @param observers Указатель на сведения о прочитанных пикселях или NULL, если они не нужны.
+ * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
+ */
+int read_image_region_oriented(const char *source_path, const struct image_rect *region,
+                               enum orientation orientation, struct image *img,
+                               const struct read_observers *observers) {
+    struct oriented_region oriented = {img, orientation, {0}, 0};
+    struct region_consumer consumer = {oriented_prepare, oriented_row, NULL, &oriented};
+    return read_region(source_path, region, &consumer, img, observers);
+}
+
+/**
+ * @brief Читает изображение, уменьшая его в целое число раз во время чтения.
+ *
+ * @param source_path Путь к файлу изображения для чтения.
+ * @param region Указатель на читаемую область изображения или NULL для всего изображения.
+ * @param factor Коэффициент уменьшения.
+ * @param orientation Ориентация результата.
+ * @param img Указатель на структуру `image`, в которую будет записан результат.
+ * @param observers Указатель на сведения о прочитанных пикселях или NULL, если они не нужны.
+ * @return 0, если чтение прошло успешно, или 1 в случае ошибки.
+ */
+int read_image_shrunk(const char *source_path, const struct image_rect *region, uint64_t factor,
+                      enum orientation orientation, struct image *img, const struct read_observers *observers) {
+    if (factor == 0) {
+        fprintf(stderr, "Ошибка: коэффициент уменьшения должен быть положительным\n");
+        return 1;
+    }
+    struct shrunk_region shrunk = {{0}, img, factor, orientation};
+    struct region_consumer consumer = {shrunk_prepare, shrunk_row, shrunk_finish, &shrunk};
+    return read_region(source_path, region, &consumer, img, observers);
+}
+
+/**
+ * @brief Находит формат изображения по его имени.
+ *
+ * @param name Имя формата.
+ * @param format Указатель, по которому будет записан найденный формат.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int image_format_from_name(const char *name, enum image_format *format) {
+    for (int i = 0; i < IMAGE_FORMAT_COUNT; i++) {
+        if (strcmp(name, format_names[i]) == 0) {
+            *format = (enum image_format) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Возвращает имя формата изображения.
+ *
+ * @param format Формат изображения.
+ * @return Имя формата или "unknown" для некорректного значения.
+ */
+const char *image_format_name(enum image_format format) {
+    if ((unsigned) format >= IMAGE_FORMAT_COUNT) {
+        return "unknown";
+    }
+    return format_names[format];
+}
+
+/**
+ * @brief Определяет формат, в котором будет записан файл.
+ *
+ * Стандартный вывод без явно заданного формата записывается в BMP.
+ *
+ * @param dest_path Путь к файлу.
+ * @param format Запрошенный формат; `IMAGE_FORMAT_AUTO` заменяется форматом по расширению пути.
+ * @return Формат файла (не `IMAGE_FORMAT_AUTO`).
+ */
+enum image_format image_format_resolve(const char *dest_path, enum image_format format) {
+    if (format != IMAGE_FORMAT_AUTO) {
+        return format;
+    }
+    const char *extension = strrchr(dest_path, '.');
+    if (!extension || strchr(extension, '/')) {
+        return IMAGE_FORMAT_BMP;
+    }
+    if (strcmp(extension, ".qoi") == 0 || strcmp(extension, ".QOI") == 0) {
+        return IMAGE_FORMAT_QOI;
+    }
+    if (strcmp(extension, ".tif") == 0 || strcmp(extension, ".tiff") == 0 || strcmp(extension, ".TIF") == 0
+        || strcmp(extension, ".TIFF") == 0) {
+        return IMAGE_FORMAT_TIFF;
+    }
+    return IMAGE_FORMAT_BMP;
+}
+
+/**
+ * @brief Проверяет, можно ли записать изображение в формате построчно.
+ *
+ * @param format Формат файла (не `IMAGE_FORMAT_AUTO`).
+ * @return 1 для BMP и TIFF, иначе 0.
+ */
+int image_format_streams_rows(enum image_format format) {
+    return format == IMAGE_FORMAT_BMP || format == IMAGE_FORMAT_TIFF;
+}
+
+/**
+ * @brief Проверяет, расположены ли строки в файле формата снизу вверх.
+ *
+ * @param format Формат файла (не `IMAGE_FORMAT_AUTO`).
+ * @return 1 для BMP, иначе 0.
+ */
+int image_format_bottom_up(enum image_format format) {
+    return format == IMAGE_FORMAT_BMP;
+}
+
+/**
+ * @brief Предупреждает, что размер BMP файла не помещается в поля размера заголовка.
+ *
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ */
+static void warn_large_bmp(uint64_t width, uint64_t height) {
+    uint64_t size = bmp_file_size(width, height);
+    if (size > BMP_MAX_FILE_SIZE && size != UINT64_MAX && width <= BMP_MAX_DIMENSION && height <= BMP_MAX_DIMENSION) {
+        fprintf(stderr, "Предупреждение: BMP больше 4 ГиБ, поля размера в заголовке записываются нулями; "
+                        "для таких изображений лучше подходит TIFF (--format tiff)\n");
+    }
+}
+
+/**
+ * @brief Сообщает об ошибке записи изображения и удаляет недописанный файл.
+ *
+ * @param dest_path Путь к файлу.
+ * @param format Формат файла.
+ * @param status Статус записи, отличный от `WRITE_OK`.
+ */
+static void report_write_error(const char *dest_path, enum image_format format, enum write_status status) {
+    fprintf(stderr, "Ошибка при записи %s изображения: ", format_titles[format]);
+    switch (status) {
+        case WRITE_FILE_POINTER_NULL:
+            fprintf(stderr, "Указатель на файл NULL\n");
+            break;
+        case WRITE_IMAGE_POINTER_NULL:
+            fprintf(stderr, "Указатель на изображение NULL\n");
+            break;
+        case WRITE_IMAGE_TOO_LARGE:
+            fprintf(stderr, "Размеры изображения слишком большие\n");
+            break;
+        case WRITE_HEADER_ERROR:
+            fprintf(stderr, "Ошибка при записи заголовка\n");
+            break;
+        case WRITE_ROW_ERROR:
+            fprintf(stderr, "Ошибка при записи строки изображения\n");
+            break;
+        default:
+            fprintf(stderr, "Неизвестная ошибка\n");
+            break;
+    }
+    if (!image_path_is_stream(dest_path)) {
+        remove(dest_path); // Удаление файла в случае ошибки
+    }
+}
+
+/**
+ * @brief Записывает изображение в файл в формате, определяемом по расширению пути.
+ *
+ * @param dest_path Путь к файлу для записи изображения.
  * @param img Указатель на структуру `image`, данные которой необходимо записать в файл.
  * @return 0, если запись прошла успешно, или 1 в случае ошибки.
  */
 int write_image(const char *dest_path, const struct image *img) {
-    FILE *output = fopen(dest_path, "wb");
+    return write_image_format(dest_path, img, IMAGE_FORMAT_AUTO);
+}
+
+/**
+ * @brief Записывает изображение в файл в заданном формате.
+ *
+ * Открывает файл по указанному пути для записи (путь "-" - стандартный вывод).
+ * Затем записывает данные изображения функцией `bmp_to_file`, `qoi_to_file` или `tiff_to_file`; все они
+ * пишут данные строго последовательно и поэтому подходят для каналов.
+ * В случае ошибки выводит сообщение об ошибке и возвращает ненулевой код.
+ *
+ * @param dest_path Путь к файлу для записи изображения.
+ * @param img Указатель на структуру `image`, данные которой необходимо записать в файл.
+ * @param format Формат файла; `IMAGE_FORMAT_AUTO` - по расширению пути.
+ * @return 0, если запись прошла успешно, или 1 в случае ошибки.
+ */
+int write_image_format(const char *dest_path, const struct image *img, enum image_format format) {
+    format = image_format_resolve(dest_path, format);
+    FILE *output = open_output(dest_path);
     if (!output) {
         perror("Не удалось открыть выходной файл");
         return 1;
     }
 
-    enum write_status w_status = bmp_to_file(output, img);
-    fclose(output);
+    enum write_status w_status;
+    if (format == IMAGE_FORMAT_QOI) {
+        w_status = qoi_to_file(output, img);
+    } else if (format == IMAGE_FORMAT_TIFF) {
+        w_status = tiff_to_file(output, img);
+    } else {
+        warn_large_bmp(img->width, img->height);
+        w_status = bmp_to_file(output, img);
+    }
+    if (close_file(output) != 0 && w_status == WRITE_OK) {
+        w_status = WRITE_ROW_ERROR;
+    }
 
     if (w_status != WRITE_OK) {
-        fprintf(stderr, "Ошибка при записи BMP изображения: ");
-        switch (w_status) {
-            case WRITE_FILE_POINTER_NULL:
-                fprintf(stderr, "Указатель на файл NULL\n");
-                break;
-            case WRITE_IMAGE_POINTER_NULL:
-                fprintf(stderr, "Указатель на изображение NULL\n");
-                break;
-            case WRITE_IMAGE_TOO_LARGE:
-                fprintf(stderr, "Размеры изображения слишком большие\n");
-                break;
-            case WRITE_HEADER_ERROR:
-                fprintf(stderr, "Ошибка при записи заголовка BMP\n");
-                break;
-            case WRITE_ROW_ERROR:
-                fprintf(stderr, "Ошибка при записи строки изображения\n");
-                break;
-            default:
-                fprintf(stderr, "Неизвестная ошибка\n");
-                break;
-        }
-        remove(dest_path); // Удаление файла в случае ошибки
+        report_write_error(dest_path, format, w_status);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Записывает изображение в BMP или TIFF файл, получая его строки по одной от источника.
+ *
+ * @param dest_path Путь к файлу для записи изображения.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param format Формат файла; `IMAGE_FORMAT_AUTO` - по расширению пути.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return 0, если запись прошла успешно, или 1 в случае ошибки.
+ */
+int write_image_rows(const char *dest_path, uint64_t width, uint64_t height, enum image_format format,
+                     image_row_source source, void *ctx) {
+    format = image_format_resolve(dest_path, format);
+    if (!image_format_streams_rows(format)) {
+        fprintf(stderr, "Ошибка: построчная запись в формате %s не поддерживается\n", format_titles[format]);
+        return 1;
+    }
+    FILE *output = open_output(dest_path);
+    if (!output) {
+        perror("Не удалось открыть выходной файл");
+        return 1;
+    }
+
+    enum write_status w_status;
+    if (format == IMAGE_FORMAT_TIFF) {
+        w_status = tiff_write_rows(output, width, height, source, ctx);
+    } else {
+        warn_large_bmp(width, height);
+        w_status = bmp_write_rows(output, width, height, source, ctx);
+    }
+    if (close_file(output) != 0 && w_status == WRITE_OK) {
+        w_status = WRITE_ROW_ERROR;
+    }
+
+    if (w_status != WRITE_OK) {
+        report_write_error(dest_path, format, w_status);
         return 1;
     }
 
@@ -1,51 +1,457 @@
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "batch.h"
+#include "bench.h"
+#include "buffer.h"
+#include "compare.h"
 #include "image_io.h"
+#include "pipeline.h"
+#include "profile.h"
+#include "server.h"
 #include "transform.h"
 
+#define MAIN_PATH_MAX 4096           // Максимальная длина пути к файлу профиля
+#define MAIN_MAX_THREADS 256         // Наибольшее количество потоков в --workers и --threads (как у пула и планировщика)
+
+/**
+ * @brief Режим сравнения двух изображений.
+ */
+enum compare_mode {
+    COMPARE_NONE = 0,                // Сравнение не запрошено
+    COMPARE_EQUAL,                   // Только проверка равенства с ранним выходом (--compare)
+    COMPARE_STATS                    // Полная статистика различий (--diff)
+};
+
+/**
+ * @brief Параметры работы программы, не относящиеся к операциям над конкретным изображением.
+ */
+struct runtime_options {
+    struct server_options server;    // Параметры режима сервера (путь к сокету NULL - сервер не запускается)
+    struct batch_options batch;      // Параметры пакетной обработки (путь NULL - режим выключен)
+    struct buffer_options buffers;   // Параметры выделения буферов изображений
+    struct transform_profile engine; // Настройки механизма смены ориентации (из профиля и параметров)
+    int bench;                       // Признак режима измерения производительности
+    int tune;                        // Признак режима подбора профиля
+    enum compare_mode compare;       // Режим сравнения изображений
+    struct bench_options bench_options; // Параметры измерения производительности или подбора профиля
+};
+
+/**
+ * @brief Выводит справку по использованию программы.
+ *
+ * @param program Имя программы.
+ */
+static void print_usage(const char *program) {
+    fprintf(stderr, "Использование: %s [параметры] <source-image> <transformed-image> [[параметры] <transformed-image>]...\n",
+            program);
+    fprintf(stderr, "       %s --serve SOCKET [--workers N]\n", program);
+    fprintf(stderr, "       %s --batch FILE [--workers N] [--memory-budget N] [параметры]\n", program);
+    fprintf(stderr, "       %s --bench [ШxВ]\n", program);
+    fprintf(stderr, "       %s --tune [ШxВ]\n", program);
+    fprintf(stderr, "       %s --compare|--diff <image-a> <image-b>\n", program);
+    pipeline_print_usage(stderr);
+    fprintf(stderr,
+            "  путь \"-\" обозначает стандартный ввод или вывод\n"
+            "  после исходного пути можно указать до 16 результатов; параметры перед каждым дополняют общие,\n"
+            "  а источник читается один раз (см. pipeline_run_outputs)\n"
+            "  --serve SOCKET             принимать запросы на Unix-сокете (см. server.h)\n"
+            "  --workers N                количество потоков сервера или пакетной обработки (1..256)\n"
+            "  --batch FILE               выполнить задания из файла: строка - [--priority 0..3] [параметры]\n"
+            "                             <source-image> <transformed-image> (см. batch.h)\n"
+            "  --memory-budget N          бюджет памяти буферов одновременных загрузок в МиБ; загрузки ждут\n"
+            "                             освобождения памяти, слишком большие изображения обрабатываются\n"
+            "                             как с --out-of-core; в конце выводится пиковый RSS\n"
+            "  --bench [ШxВ]              измерить скорость ядер на синтетическом изображении\n"
+            "  --tune [ШxВ]               подобрать настройки под машину и записать профиль\n"
+            "                             (путь: $IMAGE_TRANSFORM_PROFILE или ~/.config/image_transform/profile)\n"
+            "  --compare                  сравнить пиксели двух изображений любых поддерживаемых форматов;\n"
+            "                             код завершения: 0 - совпадают, 1 - различаются, 2 - ошибка\n"
+            "  --diff                     то же, с выводом статистики: различающиеся пиксели, MSE, PSNR\n"
+            "  --huge-pages off|thp|explicit  большие страницы для буферов изображений\n"
+            "  --numa off|interleave|first-touch  размещение буферов по узлам NUMA\n"
+            "  --stream-threshold N|auto|off  размер результата в байтах, с которого запись идет в обход кэша\n"
+            "  --prefetch N               дальность предвыборки при смене ориентации (0 - выключить)\n"
+            "  --tile N                   сторона тайла смены ориентации в пикселях\n"
+            "  --threads N                количество потоков обработки (1..256)\n"
+            "  --kernels auto|generic|avx2  набор ядер смены ориентации\n");
+}
+
 /**
- * @brief Главная функция программы для поворота изображения на 90 градусов против часовой стрелки.
+ * @brief Разбирает количество потоков: десятичное число от 1 до `MAIN_MAX_THREADS` без знака.
+ *
+ * strtoul принимает знак минус и пробелы в начале, поэтому первый символ проверяется отдельно:
+ * иначе "-1" превратилось бы в 4294967295.
  *
- * Программа принимает на вход два аргумента: путь к исходному изображению и путь для сохранения трансформированного изображения.
- * Выполняет чтение изображения, его поворот, а затем сохраняет результат в указанный файл.
+ * @param value Значение параметра.
+ * @param count Указатель на результат.
+ * @return 0 при успехе или 1, если значение некорректно.
+ */
+static int parse_thread_count(const char *value, unsigned *count) {
+    if (value[0] < '0' || value[0] > '9') {
+        return 1;
+    }
+    char *end;
+    unsigned long parsed = strtoul(value, &end, 10);
+    if (*end != '\0' || parsed == 0 || parsed > MAIN_MAX_THREADS) {
+        return 1;
+    }
+    *count = (unsigned) parsed;
+    return 0;
+}
+
+/**
+ * @brief Разбирает параметр командной строки, относящийся к работе программы в целом.
  *
+ * @param options Указатель на параметры программы.
  * @param argc Количество аргументов командной строки.
  * @param argv Массив строк с аргументами командной строки.
- *             - argv[1] - путь к исходному изображению.
- *             - argv[2] - путь к выходному изображению.
- * @return Код завершения программы: 0 - успешное выполнение, 1 - ошибка.
+ * @param arg Указатель на индекс текущего аргумента; при успехе сдвигается за разобранный параметр.
+ * @return 0, если параметр разобран; 1, если значение некорректно; -1, если параметр не относится к программе в целом.
  */
-int main(int argc, char *argv[]) {
-    // Проверка количества аргументов командной строки
-    if (argc != 3) {
-        fprintf(stderr, "Использование: %s <source-image> <transformed-image>\n", argv[0]);
+static int parse_runtime_option(struct runtime_options *options, int argc, char *argv[], int *arg) {
+    const char *name = argv[*arg];
+    if (strcmp(name, "--compare") == 0 || strcmp(name, "--diff") == 0) {
+        options->compare = strcmp(name, "--diff") == 0 ? COMPARE_STATS : COMPARE_EQUAL;
+        *arg += 1;
+        return 0;
+    }
+    if (strcmp(name, "--bench") == 0 || strcmp(name, "--tune") == 0) {
+        unsigned long long width, height;
+        int consumed = 0;
+        if (strcmp(name, "--tune") == 0) {
+            options->tune = 1;
+            bench_tune_options_init(&options->bench_options);
+        } else {
+            options->bench = 1;
+        }
+        *arg += 1;
+        if (*arg < argc && sscanf(argv[*arg], "%llux%llu%n", &width, &height, &consumed) == 2
+            && argv[*arg][consumed] == '\0' && width > 0 && height > 0) {
+            options->bench_options.width = width;
+            options->bench_options.height = height;
+            *arg += 1;
+        }
+        return 0;
+    }
+    if (strcmp(name, "--serve") != 0 && strcmp(name, "--workers") != 0 && strcmp(name, "--batch") != 0
+        && strcmp(name, "--memory-budget") != 0 && strcmp(name, "--huge-pages") != 0
+        && strcmp(name, "--numa") != 0 && strcmp(name, "--stream-threshold") != 0
+        && strcmp(name, "--prefetch") != 0 && strcmp(name, "--kernels") != 0 && strcmp(name, "--tile") != 0
+        && strcmp(name, "--threads") != 0) {
+        return -1;
+    }
+    if (*arg + 1 >= argc) {
+        fprintf(stderr, "Ошибка: параметр '%s' требует значения\n", name);
         return 1;
     }
+    const char *value = argv[*arg + 1];
 
-    // Чтение исходного изображения
-    struct image img = {0};
-    if (read_image(argv[1], &img) != 0) {
-        fprintf(stderr, "Ошибка: Не удалось прочитать исходное изображение из '%s'\n", argv[1]);
-        return 1;
+    if (strcmp(name, "--serve") == 0) {
+        options->server.socket_path = value;
+    } else if (strcmp(name, "--workers") == 0) {
+        if (parse_thread_count(value, &options->server.workers) != 0) {
+            fprintf(stderr, "Ошибка: количество потоков '%s' должно быть от 1 до %d\n", value, MAIN_MAX_THREADS);
+            return 1;
+        }
+        options->batch.workers = options->server.workers;
+    } else if (strcmp(name, "--batch") == 0) {
+        options->batch.path = value;
+    } else if (strcmp(name, "--memory-budget") == 0) {
+        unsigned long long megabytes;
+        int consumed = 0;
+        if (sscanf(value, "%llu%n", &megabytes, &consumed) != 1 || value[consumed] != '\0' || megabytes == 0
+            || megabytes > UINT64_MAX >> 20) {
+            fprintf(stderr, "Ошибка: некорректный бюджет памяти '%s'\n", value);
+            return 1;
+        }
+        options->buffers.memory_budget = (uint64_t) megabytes << 20;
+        options->batch.memory_budget = options->buffers.memory_budget;
+    } else if (strcmp(name, "--huge-pages") == 0) {
+        if (buffer_huge_pages_from_name(value, &options->buffers.huge_pages) != 0) {
+            fprintf(stderr, "Ошибка: неизвестный режим больших страниц '%s'\n", value);
+            return 1;
+        }
+    } else if (strcmp(name, "--numa") == 0) {
+        if (buffer_numa_from_name(value, &options->buffers.numa) != 0) {
+            fprintf(stderr, "Ошибка: неизвестный режим NUMA '%s'\n", value);
+            return 1;
+        }
+    } else if (strcmp(name, "--kernels") == 0) {
+        if (orient_kernels_from_name(value, &options->engine.kernels) != 0) {
+            fprintf(stderr, "Ошибка: неизвестный набор ядер '%s'\n", value);
+            return 1;
+        }
+    } else if (strcmp(name, "--prefetch") == 0) {
+        unsigned long long lines;
+        int consumed = 0;
+        if (sscanf(value, "%llu%n", &lines, &consumed) != 1 || value[consumed] != '\0') {
+            fprintf(stderr, "Ошибка: некорректная дальность предвыборки '%s'\n", value);
+            return 1;
+        }
+        options->engine.prefetch_distance = lines;
+    } else if (strcmp(name, "--tile") == 0) {
+        unsigned long long size;
+        int consumed = 0;
+        if (sscanf(value, "%llu%n", &size, &consumed) != 1 || value[consumed] != '\0'
+            || size < TRANSFORM_MIN_TILE_SIZE || size > TRANSFORM_MAX_TILE_SIZE) {
+            fprintf(stderr, "Ошибка: сторона тайла должна быть от %d до %d\n", TRANSFORM_MIN_TILE_SIZE,
+                    TRANSFORM_MAX_TILE_SIZE);
+            return 1;
+        }
+        options->engine.tile_size = size;
+    } else if (strcmp(name, "--threads") == 0) {
+        if (parse_thread_count(value, &options->engine.threads) != 0) {
+            fprintf(stderr, "Ошибка: количество потоков '%s' должно быть от 1 до %d\n", value, MAIN_MAX_THREADS);
+            return 1;
+        }
+    } else {
+        unsigned long long bytes;
+        int consumed = 0;
+        if (strcmp(value, "auto") == 0) {
+            options->engine.stream_threshold = 0;
+        } else if (strcmp(value, "off") == 0) {
+            options->engine.stream_threshold = UINT64_MAX;
+        } else if (sscanf(value, "%llu%n", &bytes, &consumed) == 1 && value[consumed] == '\0' && bytes > 0) {
+            options->engine.stream_threshold = bytes;
+        } else {
+            fprintf(stderr, "Ошибка: некорректный порог потоковой записи '%s'\n", value);
+            return 1;
+        }
     }
 
-    // Поворот изображения на 90 градусов против часовой стрелки
-    struct image rotated_img = rotate_image_90_counterclockwise(&img);
-    destroy_image(&img); // Очистка оригинального изображения после его трансформации
+    *arg += 2;
+    return 0;
+}
 
-    // Проверка успешности поворота
-    if (rotated_img.data == NULL) {
-        fprintf(stderr, "Ошибка: Не удалось повернуть изображение\n");
-        return 1;
+/**
+ * @brief Выводит при завершении программы пиковое использование памяти буферами и пиковый RSS.
+ */
+static void report_memory(void) {
+    uint64_t budget = buffer_memory_budget();
+    fprintf(stderr, "# память: пик буферов %.1f МиБ", (double) buffer_peak_usage() / (1 << 20));
+    if (budget) {
+        fprintf(stderr, " при бюджете %.1f МиБ", (double) budget / (1 << 20));
+    }
+    fprintf(stderr, ", пиковый RSS %.1f МиБ\n", (double) buffer_peak_rss() / (1 << 20));
+}
+
+/**
+ * @brief Заполняет настройки механизма смены ориентации значениями по умолчанию и профилем машины.
+ *
+ * Профиль, записанный режимом `--tune`, читается при каждом запуске; параметры командной строки
+ * переопределяют его значения, а переменная `IMAGE_TRANSFORM_THREADS` - количество потоков.
+ * Набор ядер из профиля, не поддерживаемый процессором (профиль с другой машины), заменяется автоматическим.
+ *
+ * @param engine Указатель на настройки.
+ * @param path Путь к файлу профиля или NULL.
+ */
+static void load_profile(struct transform_profile *engine, const char *path) {
+    profile_capture(engine);
+    engine->threads = 0;
+    engine->stream_threshold = 0;
+    engine->kernels = ORIENT_KERNELS_AUTO;
+    if (!path || profile_load(path, engine) != 0) {
+        return;
+    }
+    if (getenv("IMAGE_TRANSFORM_THREADS")) {
+        engine->threads = 0;
+    }
+    if (engine->kernels != ORIENT_KERNELS_AUTO && orient_set_kernels(engine->kernels) != 0) {
+        fprintf(stderr, "Предупреждение: набор ядер '%s' из профиля не поддерживается\n",
+                orient_kernels_name(engine->kernels));
+        engine->kernels = ORIENT_KERNELS_AUTO;
     }
+}
+
+/**
+ * @brief Сравнивает пиксели двух изображений.
+ *
+ * Заголовки файлов, выравнивание строк и формат файла на результат не влияют.
+ *
+ * @param mode Режим сравнения.
+ * @param path_a Путь к первому изображению.
+ * @param path_b Путь ко второму изображению.
+ * @return 0, если изображения совпадают; 1, если различаются; 2 в случае ошибки.
+ */
+static int run_compare(enum compare_mode mode, const char *path_a, const char *path_b) {
+    struct image a = {0}, b = {0};
+    if (read_image(path_a, &a) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось прочитать изображение из '%s'\n", path_a);
+        return 2;
+    }
+    if (read_image(path_b, &b) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось прочитать изображение из '%s'\n", path_b);
+        destroy_image(&a);
+        return 2;
+    }
+
+    int status;
+    struct image_diff diff;
+    if (a.width != b.width || a.height != b.height) {
+        printf("размеры различаются: %llux%llu и %llux%llu\n", (unsigned long long) a.width,
+               (unsigned long long) a.height, (unsigned long long) b.width, (unsigned long long) b.height);
+        status = 1;
+    } else if (mode == COMPARE_EQUAL) {
+        status = image_equal(&a, &b) ? 0 : 1;
+    } else if (image_compare(&a, &b, &diff) != 0) {
+        fprintf(stderr, "Ошибка: не удалось выделить память для сравнения\n");
+        status = 2;
+    } else {
+        printf("различающихся пикселей: %llu из %llu (%.4f%%)\n", (unsigned long long) diff.differing,
+               (unsigned long long) diff.pixels,
+               diff.pixels ? 100.0 * (double) diff.differing / (double) diff.pixels : 0.0);
+        printf("наибольшая разность канала: %u\n", (unsigned) diff.max_diff);
+        printf("MSE: %.6f\n", image_diff_mse(&diff));
+        if (diff.differing == 0) {
+            printf("PSNR: inf\n");
+        } else {
+            printf("PSNR: %.2f дБ\n", image_diff_psnr(&diff));
+        }
+        status = diff.differing == 0 ? 0 : 1;
+    }
+    destroy_image(&a);
+    destroy_image(&b);
+    return status;
+}
 
-    // Запись повёрнутого изображения в выходной файл
-    if (write_image(argv[2], &rotated_img) != 0) {
-        fprintf(stderr, "Ошибка: Не удалось записать изображение в '%s'\n", argv[2]);
-        destroy_image(&rotated_img); // Очистка памяти, если запись не удалась
+/**
+ * @brief Разбирает результаты после исходного пути и строит их из одного прочитанного изображения.
+ *
+ * Каждый результат - необязательные параметры операций и путь назначения; его параметры дополняют
+ * параметры, заданные перед исходным путем.
+ *
+ * @param defaults Указатель на операции, заданные перед исходным путем.
+ * @param argc Количество аргументов командной строки.
+ * @param argv Массив строк с аргументами командной строки.
+ * @param arg Индекс исходного пути.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+static int run_outputs(const struct pipeline *defaults, int argc, char *argv[], int arg) {
+    const char *source_path = argv[arg++];
+    struct pipeline_output outputs[PIPELINE_MAX_OUTPUTS];
+    size_t count = 0;
+    while (arg < argc) {
+        if (count == PIPELINE_MAX_OUTPUTS) {
+            fprintf(stderr, "Ошибка: больше %d результатов\n", PIPELINE_MAX_OUTPUTS);
+            return 1;
+        }
+        outputs[count].pipeline = *defaults;
+        while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+            int parsed = pipeline_parse_option(&outputs[count].pipeline, argc, argv, &arg);
+            if (parsed < 0) {
+                fprintf(stderr, "Ошибка: неизвестный параметр результата '%s'\n", argv[arg]);
+            }
+            if (parsed != 0) {
+                return 1;
+            }
+        }
+        if (arg == argc) {
+            fprintf(stderr, "Ошибка: после параметров результата нужен путь к выходному изображению\n");
+            return 1;
+        }
+        outputs[count++].dest_path = argv[arg++];
+    }
+    return pipeline_run_outputs(source_path, outputs, count);
+}
+
+/**
+ * @brief Главная функция программы преобразования изображений.
+ *
+ * Основной режим: программа читает исходное изображение, применяет к нему операции и записывает один
+ * или несколько результатов. Без параметров изображение поворачивается на 90 градусов против часовой
+ * стрелки; необязательные параметры перед путями задают вырезание области, уменьшение, изменение размера,
+ * другую ориентацию, цветовые операции, фильтры и формат результата. После исходного пути можно указать
+ * несколько результатов, каждый со своими дополнительными параметрами: источник тогда читается
+ * и разбирается один раз (см. `pipeline_run_outputs`).
+ *
+ * Другие режимы выбираются параметрами: `--serve` - сервер, принимающий такие же запросы на Unix-сокете,
+ * `--batch` - задания из файла на планировщике с перехватом работы, `--bench` - замеры скорости основных
+ * ядер, `--tune` - подбор и сохранение профиля машины, `--compare` и `--diff` - сравнение пикселей
+ * двух изображений.
+ *
+ * @param argc Количество аргументов командной строки.
+ * @param argv Массив строк с аргументами командной строки. В основном режиме:
+ *             - необязательные параметры операций (см. `pipeline_print_usage`);
+ *             - путь к исходному изображению;
+ *             - путь к выходному изображению;
+ *             - необязательно: еще результаты, каждый - параметры, дополняющие общие, и путь к выходному изображению.
+ * @return Код завершения программы: 0 - успешное выполнение, 1 - ошибка.
+ */
+int main(int argc, char *argv[]) {
+    struct pipeline pipeline;
+    struct runtime_options runtime = {{NULL, 0}, {NULL, 0, 0}, {0}, {0}, 0, 0, COMPARE_NONE, {0}};
+    char profile_path[MAIN_PATH_MAX];
+    int has_profile_path = profile_default_path(profile_path, sizeof(profile_path)) == 0;
+    pipeline_init(&pipeline);
+    buffer_options_init(&runtime.buffers);
+    bench_options_init(&runtime.bench_options);
+    load_profile(&runtime.engine, has_profile_path ? profile_path : NULL);
+
+    // Разбор необязательных параметров
+    int arg = 1;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        int parsed = parse_runtime_option(&runtime, argc, argv, &arg);
+        if (parsed < 0) {
+            parsed = pipeline_parse_option(&pipeline, argc, argv, &arg);
+        }
+        if (parsed < 0) {
+            fprintf(stderr, "Ошибка: неизвестный параметр '%s'\n", argv[arg]);
+            print_usage(argv[0]);
+            return 1;
+        }
+        if (parsed > 0) {
+            return 1;
+        }
+    }
+
+    buffer_configure(&runtime.buffers);
+    if (runtime.buffers.memory_budget || runtime.batch.path) {
+        atexit(report_memory);
+    }
+    if (profile_apply(&runtime.engine) != 0) {
+        fprintf(stderr, "Ошибка: набор ядер '%s' не поддерживается\n", orient_kernels_name(runtime.engine.kernels));
         return 1;
     }
 
-    // Очистка памяти для повёрнутого изображения
-    destroy_image(&rotated_img);
-    return 0;
+    if (runtime.tune && arg == argc) {
+        if (!has_profile_path) {
+            fprintf(stderr, "Ошибка: не задан путь к профилю (IMAGE_TRANSFORM_PROFILE или HOME)\n");
+            return 1;
+        }
+        if (bench_tune(&runtime.bench_options, &runtime.engine) != 0) {
+            return 1;
+        }
+        if (profile_save(profile_path, &runtime.engine) != 0) {
+            fprintf(stderr, "Ошибка: не удалось записать профиль '%s'\n", profile_path);
+            return 1;
+        }
+        printf("# профиль записан в %s\n", profile_path);
+        return 0;
+    }
+    if (runtime.bench && arg == argc) {
+        return bench_run(&runtime.bench_options);
+    }
+    if (runtime.server.socket_path && arg == argc) {
+        return server_run(&runtime.server);
+    }
+    if (runtime.batch.path && arg == argc) {
+        return batch_run(&runtime.batch, &pipeline);
+    }
+
+    // Проверка количества аргументов командной строки
+    int compare = runtime.compare != COMPARE_NONE;
+    if (argc - arg < 2 || (compare && argc - arg != 2) || runtime.server.socket_path || runtime.batch.path
+        || runtime.bench || runtime.tune) {
+        print_usage(argv[0]);
+        return compare ? 2 : 1;
+    }
+    if (compare) {
+        return run_compare(runtime.compare, argv[arg], argv[arg + 1]);
+    }
+    if (argc - arg == 2) {
+        return pipeline_run(&pipeline, argv[arg], argv[arg + 1]);
+    }
+
+    return run_outputs(&pipeline, argc, argv, arg);
 }
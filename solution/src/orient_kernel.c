@@ -0,0 +1,282 @@
+#include "orient_kernel.h"
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define TRANSFORM_CACHE_LINE 64  // Размер строки кэша в байтах
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__)) \
+    && !defined(ORIENT_NO_AVX2)
+#define ORIENT_HAVE_AVX2 1
+#include <immintrin.h>
+#else
+#define ORIENT_HAVE_AVX2 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH_READ(address) __builtin_prefetch((address), 0, 3)
+#define PREFETCH_WRITE(address) __builtin_prefetch((address), 1, 3)
+#define KERNEL_INLINE inline __attribute__((always_inline))
+#else
+#define PREFETCH_READ(address) ((void) (address))
+#define PREFETCH_WRITE(address) ((void) (address))
+#define KERNEL_INLINE inline
+#endif
+
+#define KERNEL_CONCAT_(a, b) a##_##b
+#define KERNEL_CONCAT(a, b) KERNEL_CONCAT_(a, b)
+
+/**
+ * @brief Запрашивает предвыборку непрерывного участка памяти для чтения.
+ *
+ * @param address Начало участка.
+ * @param size Размер участка в байтах.
+ */
+static void prefetch_read_span(const void *address, size_t size) {
+    const uint8_t *bytes = address;
+    for (size_t offset = 0; offset < size; offset += TRANSFORM_CACHE_LINE) {
+        PREFETCH_READ(bytes + offset);
+    }
+    PREFETCH_READ(bytes + size - 1);
+}
+
+/**
+ * @brief Запрашивает предвыборку непрерывного участка памяти для записи.
+ *
+ * @param address Начало участка.
+ * @param size Размер участка в байтах.
+ */
+static void prefetch_write_span(void *address, size_t size) {
+    uint8_t *bytes = address;
+    for (size_t offset = 0; offset < size; offset += TRANSFORM_CACHE_LINE) {
+        PREFETCH_WRITE(bytes + offset);
+    }
+    PREFETCH_WRITE(bytes + size - 1);
+}
+
+/**
+ * @brief Возвращает указатель на пиксель результата с наименьшим адресом среди тех, куда попадает отрезок источника.
+ *
+ * При построчном обходе отрезок - часть строки источника `y` со столбцами `[x, x + count)`;
+ * при обходе по столбцам - часть столбца `x` со строками `[y, y + count)`.
+ * В обоих случаях он переходит в непрерывный отрезок результата длины `count`.
+ */
+static KERNEL_INLINE struct pixel *dest_run(const struct orient_job *job, uint64_t x, uint64_t y, uint64_t count,
+                                            int reverse) {
+    const struct orientation_map *map = &job->map;
+    struct pixel *dst = job->dest + (map->origin + (int64_t) x * map->step_x + (int64_t) y * map->step_y);
+    if (reverse) {
+        dst -= count - 1;
+    }
+    return dst;
+}
+
+/**
+ * @brief Запрашивает предвыборку данных тайла, до которых обход дойдет через `job->prefetch` отрезков.
+ *
+ * При построчном обходе запрашиваются строка источника и строка результата. При обходе по столбцам
+ * запрашивается строка результата, в которую попадет столбец источника, а строки источника
+ * следующего тайла запрашиваются по одной на каждый столбец, чтобы к переходу на него тайл уже был в кэше.
+ *
+ * @param job Параметры переноса.
+ * @param x0 Первый столбец тайла.
+ * @param y0 Первая строка тайла.
+ * @param cols Ширина тайла.
+ * @param rows Высота тайла.
+ * @param line Номер текущего отрезка (строки или столбца) в тайле.
+ * @param swap Признак обхода по столбцам.
+ * @param reverse Признак обратного направления записи.
+ * @param dest Признак предвыборки результата (не нужна при потоковой записи).
+ */
+static void prefetch_ahead(const struct orient_job *job, uint64_t x0, uint64_t y0, uint64_t cols, uint64_t rows,
+                           uint64_t line, int swap, int reverse, int dest) {
+    uint64_t distance = job->prefetch;
+    if (!swap) {
+        uint64_t y = y0 + line + distance;
+        if (y < job->height) {
+            prefetch_read_span(job->source + y * job->source_stride + x0, cols * sizeof(struct pixel));
+            if (dest) {
+                prefetch_write_span(dest_run(job, x0, y, cols, reverse), cols * sizeof(struct pixel));
+            }
+        }
+        return;
+    }
+
+    uint64_t x = x0 + line + distance;
+    if (dest && x < job->width) {
+        prefetch_write_span(dest_run(job, x, y0, rows, reverse), rows * sizeof(struct pixel));
+    }
+    uint64_t x1 = x0 + cols;
+    if (x1 < job->width && line < rows) {
+        uint64_t next = job->width - x1 > job->tile ? job->tile : job->width - x1;
+        prefetch_read_span(job->source + (y0 + line) * job->source_stride + x1, next * sizeof(struct pixel));
+    }
+}
+
+/**
+ * @brief Копирует пиксели в результат потоковой записью, минуя кэш.
+ *
+ * Выровненная по 16 байтам середина записывается невременными инструкциями SSE2, неполные края -
+ * обычными. Без SSE2 выполняется обычное копирование.
+ *
+ * @param dst Указатель на первый пиксель назначения.
+ * @param src Указатель на копируемые пиксели.
+ * @param count Количество пикселей.
+ */
+static void stream_store(struct pixel *dst, const struct pixel *src, uint64_t count) {
+#ifdef __SSE2__
+    uint8_t *out = (uint8_t *) dst;
+    const uint8_t *in = (const uint8_t *) src;
+    size_t size = count * sizeof(struct pixel);
+    size_t head = (16 - ((uintptr_t) out & 15)) & 15;
+    if (head > size) {
+        head = size;
+    }
+    memcpy(out, in, head);
+    out += head;
+    in += head;
+    size -= head;
+    for (; size >= 16; size -= 16, out += 16, in += 16) {
+        _mm_stream_si128((__m128i *) out, _mm_loadu_si128((const __m128i *) in));
+    }
+    memcpy(out, in, size);
+#else
+    memcpy(dst, src, count * sizeof(struct pixel));
+#endif
+}
+
+// Ядра без расширений набора инструкций, доступные на любом процессоре
+#define KERNEL_SUFFIX generic
+#define KERNEL_TARGET
+#define KERNEL_STREAM_STORE stream_store
+#include "orient_kernel.inc"
+#undef KERNEL_SUFFIX
+#undef KERNEL_TARGET
+#undef KERNEL_STREAM_STORE
+
+#if ORIENT_HAVE_AVX2
+/**
+ * @brief Копирует пиксели в результат потоковой записью AVX2, минуя кэш.
+ *
+ * @param dst Указатель на первый пиксель назначения.
+ * @param src Указатель на копируемые пиксели.
+ * @param count Количество пикселей.
+ */
+__attribute__((target("avx2")))
+static void stream_store_avx2(struct pixel *dst, const struct pixel *src, uint64_t count) {
+    uint8_t *out = (uint8_t *) dst;
+    const uint8_t *in = (const uint8_t *) src;
+    size_t size = count * sizeof(struct pixel);
+    size_t head = (32 - ((uintptr_t) out & 31)) & 31;
+    if (head > size) {
+        head = size;
+    }
+    memcpy(out, in, head);
+    out += head;
+    in += head;
+    size -= head;
+    for (; size >= 32; size -= 32, out += 32, in += 32) {
+        _mm256_stream_si256((__m256i *) out, _mm256_loadu_si256((const __m256i *) in));
+    }
+    memcpy(out, in, size);
+}
+
+// Те же ядра, собранные с AVX2: компилятор векторизует перестановку пикселей 256-битными регистрами
+#define KERNEL_SUFFIX avx2
+#define KERNEL_TARGET __attribute__((target("avx2")))
+#define KERNEL_STREAM_STORE stream_store_avx2
+#include "orient_kernel.inc"
+#undef KERNEL_SUFFIX
+#undef KERNEL_TARGET
+#undef KERNEL_STREAM_STORE
+#endif
+
+/**
+ * @brief Заполняет место тайла источника `[x0, x1) x [y0, y1)` в результате одним цветом.
+ *
+ * @param job Параметры переноса.
+ * @param x0 Первый столбец тайла.
+ * @param y0 Первая строка тайла.
+ * @param x1 Столбец, следующий за последним.
+ * @param y1 Строка, следующая за последней.
+ * @param color Цвет всех пикселей тайла.
+ */
+void orient_fill_tile(const struct orient_job *job, uint64_t x0, uint64_t y0, uint64_t x1, uint64_t y1,
+                      struct pixel color) {
+    if (job->stage) {
+        job->stage->apply(job->stage->ctx, &color, 1);
+    }
+    // Без смены осей строка тайла переходит в непрерывный отрезок результата, иначе - столбец
+    int swap = job->map.step_x != 1 && job->map.step_x != -1;
+    int reverse = swap ? job->map.step_y < 0 : job->map.step_x < 0;
+    uint64_t count = swap ? y1 - y0 : x1 - x0;
+    struct pixel line[TRANSFORM_MAX_TILE_SIZE];
+    for (uint64_t i = 0; i < count; i++) {
+        line[i] = color;
+    }
+    uint64_t begin = swap ? x0 : y0;
+    uint64_t end = swap ? x1 : y1;
+    for (uint64_t i = begin; i < end; i++) {
+        struct pixel *dst = swap ? dest_run(job, i, y0, count, reverse) : dest_run(job, x0, i, count, reverse);
+        uint64_t ahead = i + job->prefetch;
+        if (job->prefetch && !job->stream && ahead < end) {
+            prefetch_write_span(swap ? dest_run(job, ahead, y0, count, reverse) : dest_run(job, x0, ahead, count, reverse),
+                                count * sizeof(struct pixel));
+        }
+        if (job->stream) {
+            stream_store(dst, line, count);
+        } else {
+            memcpy(dst, line, count * sizeof(struct pixel));
+        }
+    }
+}
+
+/**
+ * @brief Проверяет, может ли текущий процессор выполнять ядра заданного набора.
+ *
+ * @param kernels Набор ядер (не `ORIENT_KERNELS_AUTO`).
+ * @return 1, если набор собран и поддерживается процессором, иначе 0.
+ */
+int orient_kernels_supported(enum orient_kernels kernels) {
+    switch (kernels) {
+        case ORIENT_KERNELS_GENERIC:
+            return 1;
+        case ORIENT_KERNELS_AVX2:
+#if ORIENT_HAVE_AVX2
+            return __builtin_cpu_supports("avx2") != 0;
+#else
+            return 0;
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * @brief Находит специализированное ядро для набора, ориентации и способа записи.
+ *
+ * @param kernels Поддерживаемый набор ядер (не `ORIENT_KERNELS_AUTO`).
+ * @param orientation Ориентация результата.
+ * @param stream Признак записи результата в обход кэша.
+ * @return Указатель на ядро.
+ */
+orient_kernel orient_kernel_find(enum orient_kernels kernels, enum orientation orientation, int stream) {
+#if ORIENT_HAVE_AVX2
+    if (kernels == ORIENT_KERNELS_AVX2) {
+        return orient_kernels_avx2[orientation][stream != 0];
+    }
+#else
+    (void) kernels;
+#endif
+    return orient_kernels_generic[orientation][stream != 0];
+}
+
+/**
+ * @brief Завершает потоковую запись, сделанную ядрами в текущем потоке.
+ */
+void orient_kernel_fence(void) {
+#ifdef __SSE2__
+    _mm_sfence();
+#endif
+}
@@ -0,0 +1,226 @@
+#include "out_of_core.h"
+#include "tile_cache.h"
+#include <stdio.h>
+#include <string.h>
+
+#define OOC_TILE OUT_OF_CORE_TILE_SIZE
+#define OOC_TILE_BYTES ((uint64_t) OOC_TILE * OOC_TILE * sizeof(struct pixel))
+
+/**
+ * @brief Состояние преобразования без хранения изображения в памяти.
+ *
+ * Координаты источника выражаются через координаты результата линейно:
+ * `x = x0 + x_ox * ox + x_oy * oy`, `y = y0 + y_ox * ox + y_oy * oy`.
+ */
+struct ooc_job {
+    enum orientation orientation;    // Ориентация результата
+    const struct color_ops *color;   // Цветовые операции над результатом
+    int bottom_up;                   // Признак записи строк результата снизу вверх
+    uint64_t cache_bytes;            // Запрошенный размер кэша тайлов в байтах
+    uint64_t width;                  // Ширина области источника
+    uint64_t height;                 // Высота области источника
+    uint64_t tiles_x;                // Количество тайлов по горизонтали
+    uint64_t tiles_y;                // Количество тайлов по вертикали
+    uint64_t out_width;              // Ширина результата
+    uint64_t out_height;             // Высота результата
+    int64_t x0, x_ox, x_oy;          // Обратное отображение для координаты X источника
+    int64_t y0, y_ox, y_oy;          // Обратное отображение для координаты Y источника
+    struct tile_cache cache;         // Кэш тайлов
+    int cache_ready;                 // Признак созданного кэша
+};
+
+/**
+ * @brief Заполняет обратное отображение координат результата в координаты источника.
+ */
+static void ooc_inverse_init(struct ooc_job *job) {
+    int64_t w = (int64_t) job->width - 1;
+    int64_t h = (int64_t) job->height - 1;
+    // Значения по умолчанию - тождественное отображение; для каждой ориентации меняются только отличия
+    job->x0 = 0; job->x_ox = 1; job->x_oy = 0;
+    job->y0 = 0; job->y_ox = 0; job->y_oy = 1;
+    switch (job->orientation) {
+        case ORIENTATION_FLIP_HORIZONTAL:
+            job->x0 = w; job->x_ox = -1;
+            break;
+        case ORIENTATION_FLIP_VERTICAL:
+            job->y0 = h; job->y_oy = -1;
+            break;
+        case ORIENTATION_ROTATE_180:
+            job->x0 = w; job->x_ox = -1;
+            job->y0 = h; job->y_oy = -1;
+            break;
+        case ORIENTATION_TRANSPOSE:
+            job->x_ox = 0; job->x_oy = 1;
+            job->y_ox = 1; job->y_oy = 0;
+            break;
+        case ORIENTATION_ROTATE_90_CCW:
+            job->x0 = w; job->x_ox = 0; job->x_oy = -1;
+            job->y_ox = 1; job->y_oy = 0;
+            break;
+        case ORIENTATION_ROTATE_90_CW:
+            job->x_ox = 0; job->x_oy = 1;
+            job->y0 = h; job->y_ox = -1; job->y_oy = 0;
+            break;
+        case ORIENTATION_TRANSVERSE:
+            job->x0 = w; job->x_ox = 0; job->x_oy = -1;
+            job->y0 = h; job->y_ox = -1; job->y_oy = 0;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Находит отрезок строки результата, который целиком берется из одного тайла источника.
+ *
+ * @param job Состояние преобразования.
+ * @param ox Первый столбец отрезка в результате.
+ * @param oy Строка результата.
+ * @param tile Указатель на номер тайла.
+ * @param offset Указатель на номер первого пикселя отрезка внутри тайла.
+ * @param step Указатель на шаг между пикселями отрезка внутри тайла.
+ * @return Длина отрезка в пикселях.
+ */
+static uint64_t ooc_run(const struct ooc_job *job, uint64_t ox, uint64_t oy, uint64_t *tile, uint64_t *offset,
+                        int64_t *step) {
+    uint64_t sx = (uint64_t) (job->x0 + job->x_ox * (int64_t) ox + job->x_oy * (int64_t) oy);
+    uint64_t sy = (uint64_t) (job->y0 + job->y_ox * (int64_t) ox + job->y_oy * (int64_t) oy);
+    uint64_t lx = sx % OOC_TILE;
+    uint64_t ly = sy % OOC_TILE;
+
+    // Вдоль строки результата меняется ровно одна координата источника
+    uint64_t length = job->x_ox > 0 ? OOC_TILE - lx
+                      : job->x_ox < 0 ? lx + 1
+                      : job->y_ox > 0 ? OOC_TILE - ly
+                      : ly + 1;
+    if (length > job->out_width - ox) {
+        length = job->out_width - ox;
+    }
+    *tile = (sy / OOC_TILE) * job->tiles_x + sx / OOC_TILE;
+    *offset = ly * OOC_TILE + lx;
+    *step = job->x_ox + job->y_ox * OOC_TILE;
+    return length;
+}
+
+/**
+ * @brief Подготавливает кэш тайлов, когда размер области источника уже известен.
+ *
+ * Места тайлов во временном файле назначаются в порядке их чтения при записи результата:
+ * строки BMP записываются снизу вверх, TIFF - сверху вниз, каждая слева направо.
+ */
+static int ooc_prepare(void *ctx, const struct image_rect *region) {
+    struct ooc_job *job = ctx;
+    int swap = orientation_swaps_axes(job->orientation);
+    job->width = region->width;
+    job->height = region->height;
+    job->tiles_x = (region->width + OOC_TILE - 1) / OOC_TILE;
+    job->tiles_y = (region->height + OOC_TILE - 1) / OOC_TILE;
+    job->out_width = swap ? region->height : region->width;
+    job->out_height = swap ? region->width : region->height;
+    ooc_inverse_init(job);
+
+    // Раскладке нужна полоса тайлов вдоль строки источника, сборке - вдоль строки результата
+    uint64_t band = swap && job->tiles_y > job->tiles_x ? job->tiles_y : job->tiles_x;
+    uint64_t capacity = job->cache_bytes / OOC_TILE_BYTES;
+    if (capacity < band + 1) {
+        capacity = band + 1;
+        fprintf(stderr, "Предупреждение: кэш тайлов увеличен до %llu МиБ, чтобы вместить полосу тайлов\n",
+                (unsigned long long) ((capacity * OOC_TILE_BYTES + (1u << 20) - 1) >> 20));
+    }
+    if (tile_cache_init(&job->cache, job->tiles_x * job->tiles_y, OOC_TILE_BYTES, capacity) != 0) {
+        return 1;
+    }
+    job->cache_ready = 1;
+
+    for (uint64_t i = 0; i < job->out_height; i++) {
+        uint64_t oy = job->bottom_up ? job->out_height - 1 - i : i;
+        for (uint64_t ox = 0; ox < job->out_width;) {
+            uint64_t tile, offset;
+            int64_t step;
+            ox += ooc_run(job, ox, oy, &tile, &offset, &step);
+            tile_cache_place(&job->cache, tile);
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Раскладывает строку области источника по тайлам.
+ */
+static int ooc_store_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct ooc_job *job = ctx;
+    uint64_t ty = y / OOC_TILE;
+    uint64_t line = (y % OOC_TILE) * OOC_TILE;
+    for (uint64_t tx = 0; tx < job->tiles_x; tx++) {
+        struct pixel *tile = (struct pixel *) tile_cache_get(&job->cache, ty * job->tiles_x + tx, 1);
+        if (!tile) {
+            return 1;
+        }
+        uint64_t x = tx * OOC_TILE;
+        uint64_t count = job->width - x < OOC_TILE ? job->width - x : OOC_TILE;
+        memcpy(tile + line, row + x, count * sizeof(struct pixel));
+    }
+    return 0;
+}
+
+/**
+ * @brief Собирает строку результата из тайлов и применяет к ней цветовые операции.
+ */
+static int ooc_emit_row(void *ctx, uint64_t oy, struct pixel *row) {
+    struct ooc_job *job = ctx;
+    for (uint64_t ox = 0; ox < job->out_width;) {
+        uint64_t tile, offset;
+        int64_t step;
+        uint64_t length = ooc_run(job, ox, oy, &tile, &offset, &step);
+        const struct pixel *data = (const struct pixel *) tile_cache_get(&job->cache, tile, 0);
+        if (!data) {
+            return 1;
+        }
+        const struct pixel *src = data + offset;
+        if (step == 1) {
+            memcpy(row + ox, src, length * sizeof(struct pixel));
+        } else {
+            for (uint64_t i = 0; i < length; i++) {
+                row[ox + i] = *src;
+                src += step;
+            }
+        }
+        ox += length;
+    }
+    if (job->color->active) {
+        color_apply_pixels(job->color, row, job->out_width);
+    }
+    return 0;
+}
+
+/**
+ * @brief Вырезает область, меняет ориентацию и применяет цветовые операции, не храня изображение в памяти целиком.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному файлу.
+ * @param format Формат результата, допускающий построчную запись.
+ * @param region Указатель на вырезаемую область или NULL для всего изображения.
+ * @param orientation Ориентация результата.
+ * @param color Цветовые операции над результатом.
+ * @param cache_bytes Размер кэша тайлов в байтах.
+ * @return 0, если преобразование выполнено успешно, или 1 в случае ошибки.
+ */
+int out_of_core_transform(const char *source_path, const char *dest_path, enum image_format format,
+                          const struct image_rect *region, enum orientation orientation, const struct color_ops *color, uint64_t cache_bytes) {
+    struct ooc_job job;
+    memset(&job, 0, sizeof(job));
+    job.orientation = orientation;
+    job.color = color;
+    job.cache_bytes = cache_bytes;
+    job.bottom_up = image_format_bottom_up(format);
+
+    struct region_consumer consumer = {ooc_prepare, ooc_store_row, NULL, &job};
+    int status = read_image_rows(source_path, region, &consumer);
+    if (status == 0) {
+        status = write_image_rows(dest_path, job.out_width, job.out_height, format, ooc_emit_row, &job);
+    }
+    if (job.cache_ready) {
+        tile_cache_destroy(&job.cache);
+    }
+    return status;
+}
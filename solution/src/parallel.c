@@ -0,0 +1,210 @@
+#include "parallel.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define PARALLEL_MAX_THREADS 256   // Верхняя граница размера пула
+
+/**
+ * @brief Текущая задача пула: параллельный цикл, элементы которого раздаются порциями.
+ */
+struct parallel_job {
+    parallel_range_fn fn;    // Функция обработки диапазона
+    void *ctx;               // Контекст функции
+    uint64_t count;          // Общее количество элементов
+    uint64_t grain;          // Размер порции
+    uint64_t next;           // Индекс первого нераспределенного элемента
+    uint64_t completed;      // Количество обработанных элементов
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t submit_lock = PTHREAD_MUTEX_INITIALIZER;  // Одновременно выполняется один цикл
+
+static struct parallel_job job;
+static uint64_t job_generation = 0;   // Номер текущей задачи, меняется при каждой публикации
+static unsigned workers_started = 0;  // Количество созданных рабочих потоков
+static unsigned thread_limit = 0;     // Количество потоков, включая вызывающий (0 - не определено)
+
+static __thread int inside_pool = 0;  // Признак того, что поток уже выполняет параллельный цикл
+static __thread parallel_executor thread_executor = NULL; // Способ выполнения циклов текущего потока
+static __thread void *thread_executor_ctx = NULL;        // Контекст способа выполнения
+
+/**
+ * @brief Определяет количество потоков по умолчанию.
+ *
+ * @return Значение переменной `IMAGE_TRANSFORM_THREADS`, если она задана, иначе количество процессоров.
+ */
+static unsigned default_thread_count(void) {
+    const char *env = getenv("IMAGE_TRANSFORM_THREADS");
+    long count = env ? strtol(env, NULL, 10) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (count < 1) {
+        count = 1;
+    }
+    if (count > PARALLEL_MAX_THREADS) {
+        count = PARALLEL_MAX_THREADS;
+    }
+    return (unsigned) count;
+}
+
+/**
+ * @brief Забирает и выполняет порции текущей задачи, пока они не закончатся.
+ *
+ * Вызывается с захваченным `pool_lock`; на время обработки порции блокировка отпускается.
+ */
+static void run_chunks(void) {
+    while (job.next < job.count) {
+        uint64_t begin = job.next;
+        uint64_t end = job.count - begin > job.grain ? begin + job.grain : job.count;
+        parallel_range_fn fn = job.fn;
+        void *ctx = job.ctx;
+        job.next = end;
+
+        pthread_mutex_unlock(&pool_lock);
+        fn(ctx, begin, end);
+        pthread_mutex_lock(&pool_lock);
+
+        job.completed += end - begin;
+        if (job.completed == job.count) {
+            pthread_cond_broadcast(&work_done);
+        }
+    }
+}
+
+/**
+ * @brief Основной цикл рабочего потока: ожидает новую задачу и участвует в ее выполнении.
+ *
+ * @param arg Порядковый номер потока в пуле.
+ * @return Не возвращает управление.
+ */
+static void *worker_main(void *arg) {
+    unsigned index = (unsigned) (uintptr_t) arg;
+    uint64_t seen = 0;
+
+    inside_pool = 1;
+    pthread_mutex_lock(&pool_lock);
+    for (;;) {
+        while (job_generation == seen) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        seen = job_generation;
+        // Потоки сверх текущего ограничения пропускают задачу
+        if (index + 1 < thread_limit) {
+            run_chunks();
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Создает недостающие рабочие потоки.
+ *
+ * Вызывается с захваченным `pool_lock`. Если поток создать не удалось, работа выполняется
+ * уже существующими потоками.
+ */
+static void start_workers(void) {
+    while (workers_started + 1 < thread_limit) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, (void *) (uintptr_t) workers_started) != 0) {
+            thread_limit = workers_started + 1;
+            break;
+        }
+        pthread_detach(thread);
+        workers_started++;
+    }
+}
+
+/**
+ * @brief Выполняет цикл по элементам `[0, count)` на общем пуле потоков.
+ *
+ * @param count Количество элементов.
+ * @param grain Размер порции элементов (0 трактуется как 1).
+ * @param fn Функция, обрабатывающая диапазон элементов.
+ * @param ctx Контекст, передаваемый функции.
+ */
+void parallel_for(uint64_t count, uint64_t grain, parallel_range_fn fn, void *ctx) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+    if (inside_pool || count <= grain) {
+        fn(ctx, 0, count);
+        return;
+    }
+    if (thread_executor) {
+        thread_executor(thread_executor_ctx, count, grain, fn, ctx);
+        return;
+    }
+    if (parallel_thread_count() == 1) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    pthread_mutex_lock(&submit_lock);
+    pthread_mutex_lock(&pool_lock);
+    start_workers();
+
+    job.fn = fn;
+    job.ctx = ctx;
+    job.count = count;
+    job.grain = grain;
+    job.next = 0;
+    job.completed = 0;
+    job_generation++;
+    pthread_cond_broadcast(&work_ready);
+
+    inside_pool = 1;
+    run_chunks();
+    inside_pool = 0;
+
+    while (job.completed < job.count) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&submit_lock);
+}
+
+/**
+ * @brief Возвращает количество потоков, участвующих в параллельных циклах.
+ *
+ * @return Количество потоков, включая вызывающий.
+ */
+unsigned parallel_thread_count(void) {
+    pthread_mutex_lock(&pool_lock);
+    if (thread_limit == 0) {
+        thread_limit = default_thread_count();
+    }
+    unsigned count = thread_limit;
+    pthread_mutex_unlock(&pool_lock);
+    return count;
+}
+
+/**
+ * @brief Задает количество потоков для последующих параллельных циклов.
+ *
+ * @param count Количество потоков, включая вызывающий (0 означает значение по умолчанию).
+ */
+void parallel_set_thread_count(unsigned count) {
+    if (count > PARALLEL_MAX_THREADS) {
+        count = PARALLEL_MAX_THREADS;
+    }
+    pthread_mutex_lock(&submit_lock);
+    pthread_mutex_lock(&pool_lock);
+    thread_limit = count ? count : default_thread_count();
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&submit_lock);
+}
+
+/**
+ * @brief Задает для текущего потока способ выполнения параллельных циклов вместо общего пула.
+ *
+ * @param executor Способ выполнения или NULL, чтобы вернуться к общему пулу.
+ * @param ctx Контекст, передаваемый способу выполнения.
+ */
+void parallel_set_executor(parallel_executor executor, void *ctx) {
+    thread_executor = executor;
+    thread_executor_ctx = ctx;
+}
@@ -0,0 +1,935 @@
+#include "pipeline.h"
+#include "buffer.h"
+#include "cache.h"
+#include "image_io.h"
+#include "out_of_core.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PIPELINE_MAX_SHRINK 4096   // Больший коэффициент переполняет 32-битные суммы блоков
+#define PIPELINE_CACHE_VERSION 1   // Версия описания результата; меняется вместе с алгоритмами операций
+
+/**
+ * @brief Разбирает описание области вида `x,y,ширина,высота`.
+ *
+ * @param text Строка с описанием области.
+ * @param region Указатель на структуру, в которую будет записана область.
+ * @return 0, если строка корректна, или 1 в случае ошибки.
+ */
+static int parse_rect(const char *text, struct image_rect *region) {
+    unsigned long long x, y, width, height;
+    int consumed = 0;
+    if (sscanf(text, "%llu,%llu,%llu,%llu%n", &x, &y, &width, &height, &consumed) != 4 || text[consumed] != '\0') {
+        return 1;
+    }
+    if (width == 0 || height == 0) {
+        return 1;
+    }
+    region->x = x;
+    region->y = y;
+    region->width = width;
+    region->height = height;
+    return 0;
+}
+
+/**
+ * @brief Разбирает размер вида `ширинаxвысота`, где одна из сторон может быть равна 0.
+ *
+ * @param text Строка с описанием размера.
+ * @param width Указатель на ширину.
+ * @param height Указатель на высоту.
+ * @return 0, если строка корректна, или 1 в случае ошибки.
+ */
+static int parse_size(const char *text, uint64_t *width, uint64_t *height) {
+    unsigned long long w, h;
+    int consumed = 0;
+    if (sscanf(text, "%llux%llu%n", &w, &h, &consumed) != 2 || text[consumed] != '\0') {
+        return 1;
+    }
+    if (w == 0 && h == 0) {
+        return 1;
+    }
+    *width = w;
+    *height = h;
+    return 0;
+}
+
+/**
+ * @brief Разбирает положительное целое число.
+ *
+ * @param text Строка с числом.
+ * @param value Указатель на результат.
+ * @return 0, если строка корректна, или 1 в случае ошибки.
+ */
+static int parse_count(const char *text, uint64_t *value) {
+    unsigned long long parsed;
+    int consumed = 0;
+    if (sscanf(text, "%llu%n", &parsed, &consumed) != 1 || text[consumed] != '\0' || parsed == 0) {
+        return 1;
+    }
+    *value = parsed;
+    return 0;
+}
+
+/**
+ * @brief Разбирает вещественное число.
+ *
+ * @param text Строка с числом.
+ * @param value Указатель на результат.
+ * @return 0, если строка корректна, или 1 в случае ошибки.
+ */
+static int parse_real(const char *text, double *value) {
+    int consumed = 0;
+    if (sscanf(text, "%lf%n", value, &consumed) != 1 || text[consumed] != '\0') {
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Читает из файла таблицы преобразования каналов: 256 байт для r, затем для g и для b.
+ *
+ * @param path Путь к файлу таблиц.
+ * @param lut Таблицы для каналов в порядке r, g, b.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+static int load_lut(const char *path, uint8_t lut[3][256]) {
+    FILE *input = fopen(path, "rb");
+    if (!input) {
+        perror("Не удалось открыть файл таблиц");
+        return 1;
+    }
+    size_t read = fread(lut, 1, 3 * 256, input);
+    int extra = fgetc(input);
+    fclose(input);
+    return read == 3 * 256 && extra == EOF ? 0 : 1;
+}
+
+/**
+ * @brief Разбирает параметр цветовой операции и добавляет ее в цепочку.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param name Имя параметра.
+ * @param value Значение параметра или NULL для параметров без значения.
+ * @return 0, если операция добавлена; 1, если значение некорректно.
+ */
+static int parse_color_option(struct pipeline *pipeline, const char *name, const char *value) {
+    double number = 0.0;
+
+    if (strcmp(name, "--grayscale") == 0) {
+        if (color_ops_grayscale(&pipeline->color) != 0) {
+            fprintf(stderr, "Ошибка: повторный перевод в оттенки серого после поканальных таблиц не поддерживается\n");
+            return 1;
+        }
+    } else if (strcmp(name, "--invert") == 0) {
+        color_ops_invert(&pipeline->color);
+    } else if (strcmp(name, "--lut") == 0) {
+        uint8_t lut[3][256];
+        if (load_lut(value, lut) != 0) {
+            fprintf(stderr, "Ошибка: файл таблиц '%s' должен содержать ровно 768 байт\n", value);
+            return 1;
+        }
+        color_ops_lut(&pipeline->color, (const uint8_t (*)[256]) lut);
+    } else if (parse_real(value, &number) != 0) {
+        fprintf(stderr, "Ошибка: некорректное значение '%s' параметра '%s'\n", value, name);
+        return 1;
+    } else if (strcmp(name, "--brightness") == 0) {
+        if (number < -255.0 || number > 255.0) {
+            fprintf(stderr, "Ошибка: яркость должна быть от -255 до 255\n");
+            return 1;
+        }
+        color_ops_brightness_contrast(&pipeline->color, (int) number, 1.0);
+    } else if (strcmp(name, "--contrast") == 0) {
+        if (number < 0.0) {
+            fprintf(stderr, "Ошибка: контраст не может быть отрицательным\n");
+            return 1;
+        }
+        color_ops_brightness_contrast(&pipeline->color, 0, number);
+    } else {
+        if (number <= 0.0) {
+            fprintf(stderr, "Ошибка: гамма должна быть положительной\n");
+            return 1;
+        }
+        color_ops_gamma(&pipeline->color, number);
+    }
+    return 0;
+}
+
+/**
+ * @brief Разбирает параметр фильтра свертки и добавляет фильтр в цепочку.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param name Имя параметра (`--blur`, `--gaussian` или `--sharpen`).
+ * @param value Значение параметра.
+ * @return 0, если фильтр добавлен; 1, если значение некорректно.
+ */
+static int parse_filter_option(struct pipeline *pipeline, const char *name, const char *value) {
+    if (pipeline->filter_count == PIPELINE_MAX_FILTERS) {
+        fprintf(stderr, "Ошибка: допускается не более %d фильтров свертки\n", PIPELINE_MAX_FILTERS);
+        return 1;
+    }
+    struct filter_op *op = &pipeline->filters[pipeline->filter_count];
+    op->radius = 0;
+    op->sigma = 1.0;
+    op->amount = 1.0;
+    op->threshold = 0;
+
+    int valid;
+    if (strcmp(name, "--blur") == 0) {
+        op->kind = FILTER_BOX_BLUR;
+        valid = parse_count(value, &op->radius) == 0 && op->radius <= FILTER_MAX_RADIUS;
+    } else if (strcmp(name, "--gaussian") == 0) {
+        op->kind = FILTER_GAUSSIAN_BLUR;
+        valid = parse_real(value, &op->sigma) == 0 && op->sigma > 0.0 && ceil(3.0 * op->sigma) <= FILTER_MAX_RADIUS;
+    } else {
+        unsigned threshold = 0;
+        int consumed = 0;
+        op->kind = FILTER_UNSHARP_MASK;
+        int fields = sscanf(value, "%lf%n,%lf%n,%u%n", &op->amount, &consumed, &op->sigma, &consumed, &threshold, &consumed);
+        valid = fields >= 1 && value[consumed] == '\0' && op->amount >= 0.0 && op->amount <= FILTER_MAX_AMOUNT
+                && op->sigma > 0.0 && ceil(3.0 * op->sigma) <= FILTER_MAX_RADIUS && threshold <= 255;
+        op->threshold = (uint8_t) threshold;
+    }
+    if (!valid) {
+        fprintf(stderr, "Ошибка: некорректное значение '%s' параметра '%s'\n", value, name);
+        return 1;
+    }
+    pipeline->filter_count++;
+    return 0;
+}
+
+/**
+ * @brief Заполняет описание операциями по умолчанию.
+ *
+ * @param pipeline Указатель на описание операций.
+ */
+void pipeline_init(struct pipeline *pipeline) {
+    memset(pipeline, 0, sizeof(*pipeline));
+    pipeline->shrink = 1;
+    pipeline->filter = RESIZE_FILTER_BOX;
+    pipeline->orientation = ORIENTATION_ROTATE_90_CCW;
+    color_ops_init(&pipeline->color);
+
+    const char *cache_dir = getenv("IMAGE_TRANSFORM_CACHE");
+    pipeline->cache_dir = cache_dir && cache_dir[0] != '\0' ? cache_dir : NULL;
+}
+
+/**
+ * @brief Разбирает параметр командной строки, относящийся к операциям над изображением.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param argc Количество аргументов командной строки.
+ * @param argv Массив строк с аргументами командной строки.
+ * @param arg Указатель на индекс текущего аргумента.
+ * @return 0, если параметр разобран; 1, если значение некорректно; -1, если параметр не относится к операциям.
+ */
+int pipeline_parse_option(struct pipeline *pipeline, int argc, char *argv[], int *arg) {
+    const char *name = argv[*arg];
+    if (strcmp(name, "--grayscale") == 0 || strcmp(name, "--invert") == 0) {
+        if (parse_color_option(pipeline, name, NULL) != 0) {
+            return 1;
+        }
+        *arg += 1;
+        return 0;
+    }
+    if (strcmp(name, "--stats") == 0) {
+        pipeline->stats = 1;
+        *arg += 1;
+        return 0;
+    }
+    if (strcmp(name, "--sparse") == 0) {
+        pipeline->sparse = 1;
+        *arg += 1;
+        return 0;
+    }
+    int color = strcmp(name, "--brightness") == 0 || strcmp(name, "--contrast") == 0
+                || strcmp(name, "--gamma") == 0 || strcmp(name, "--lut") == 0;
+    int filter = strcmp(name, "--blur") == 0 || strcmp(name, "--gaussian") == 0 || strcmp(name, "--sharpen") == 0;
+    if (!color && !filter && strcmp(name, "--crop") != 0 && strcmp(name, "--orient") != 0 && strcmp(name, "--resize") != 0
+        && strcmp(name, "--filter") != 0 && strcmp(name, "--shrink") != 0 && strcmp(name, "--cache") != 0
+        && strcmp(name, "--format") != 0 && strcmp(name, "--out-of-core") != 0) {
+        return -1;
+    }
+    if (*arg + 1 >= argc) {
+        fprintf(stderr, "Ошибка: параметр '%s' требует значения\n", name);
+        return 1;
+    }
+    const char *value = argv[*arg + 1];
+
+    if (color) {
+        if (parse_color_option(pipeline, name, value) != 0) {
+            return 1;
+        }
+    } else if (filter) {
+        if (parse_filter_option(pipeline, name, value) != 0) {
+            return 1;
+        }
+    } else if (strcmp(name, "--crop") == 0) {
+        if (parse_rect(value, &pipeline->region) != 0) {
+            fprintf(stderr, "Ошибка: некорректная область '%s', ожидается x,y,ширина,высота\n", value);
+            return 1;
+        }
+        pipeline->has_region = 1;
+    } else if (strcmp(name, "--orient") == 0) {
+        if (orientation_from_name(value, &pipeline->orientation) != 0) {
+            fprintf(stderr, "Ошибка: неизвестная ориентация '%s'\n", value);
+            return 1;
+        }
+    } else if (strcmp(name, "--resize") == 0) {
+        if (parse_size(value, &pipeline->width, &pipeline->height) != 0) {
+            fprintf(stderr, "Ошибка: некорректный размер '%s', ожидается ширинаxвысота\n", value);
+            return 1;
+        }
+        pipeline->has_resize = 1;
+    } else if (strcmp(name, "--cache") == 0) {
+        pipeline->cache_dir = value;
+    } else if (strcmp(name, "--format") == 0) {
+        if (image_format_from_name(value, &pipeline->format) != 0) {
+            fprintf(stderr, "Ошибка: неизвестный формат '%s'\n", value);
+            return 1;
+        }
+    } else if (strcmp(name, "--out-of-core") == 0) {
+        uint64_t megabytes;
+        if (parse_count(value, &megabytes) != 0 || megabytes < OUT_OF_CORE_MIN_CACHE_MB
+            || megabytes > (UINT64_MAX >> 20)) {
+            fprintf(stderr, "Ошибка: некорректный размер кэша тайлов '%s'\n", value);
+            return 1;
+        }
+        pipeline->out_of_core = megabytes << 20;
+    } else if (strcmp(name, "--filter") == 0) {
+        if (resize_filter_from_name(value, &pipeline->filter) != 0) {
+            fprintf(stderr, "Ошибка: неизвестный фильтр '%s'\n", value);
+            return 1;
+        }
+    } else {
+        if (parse_count(value, &pipeline->shrink) != 0 || pipeline->shrink > PIPELINE_MAX_SHRINK) {
+            fprintf(stderr, "Ошибка: коэффициент уменьшения должен быть от 1 до %d\n", PIPELINE_MAX_SHRINK);
+            return 1;
+        }
+    }
+
+    *arg += 2;
+    return 0;
+}
+
+/**
+ * @brief Выводит в поток описание параметров операций над изображением.
+ *
+ * @param out Поток для вывода.
+ */
+void pipeline_print_usage(FILE *out) {
+    fprintf(out,
+            "  --crop x,y,ширина,высота   читать и обрабатывать только заданную область\n"
+            "  --shrink N                 уменьшить в N раз усреднением прямо при чтении\n"
+            "  --resize ШxВ               изменить размер результата (0 - по пропорциям)\n"
+            "  --filter box|bilinear|lanczos  фильтр изменения размера (по умолчанию box)\n"
+            "  --orient none|ccw90|180|cw90|flip-h|flip-v|transpose|transverse\n"
+            "                             ориентация результата (по умолчанию ccw90)\n"
+            "  --grayscale                перевести в оттенки серого\n"
+            "  --invert                   инвертировать цвета\n"
+            "  --brightness N             сдвинуть яркость на N (-255..255)\n"
+            "  --contrast K               умножить контраст на K\n"
+            "  --gamma G                  гамма-коррекция с показателем G\n"
+            "  --lut FILE                 таблицы каналов: 768 байт (r, g, b по 256)\n"
+            "                             цветовые операции выполняются в порядке указания\n"
+            "  --blur R                   размытие средним по окну (2R+1)x(2R+1), R до 1000\n"
+            "  --gaussian SIGMA           размытие по Гауссу, SIGMA до 333 (радиус ядра 3*SIGMA)\n"
+            "  --sharpen K[,SIGMA[,T]]    нерезкое маскирование с силой K (до 100) и порогом T\n"
+            "                             фильтры выполняются после остальных операций\n"
+            "  --format auto|bmp|qoi|tiff формат результата (auto - по расширению: .qoi - QOI,\n"
+            "                             .tif/.tiff - TIFF, иначе BMP; TIFF больше 4 ГиБ - BigTIFF)\n"
+            "  --stats                    вывести гистограммы, минимум, максимум и среднее каналов\n"
+            "                             исходных пикселей (собираются при чтении)\n"
+            "  --sparse                   искать однотонные тайлы при чтении и заполнять их цветом\n"
+            "                             при смене ориентации (для изображений с большим фоном)\n"
+            "  --cache DIR                кэш результатов по хешу пикселей и операций\n"
+            "                             (по умолчанию $IMAGE_TRANSFORM_CACHE)\n"
+            "  --out-of-core N            обрабатывать изображение больше памяти через временный файл\n"
+            "                             с кэшем тайлов N МиБ (только --crop, --orient, цвет; BMP или TIFF)\n");
+}
+
+/**
+ * @brief Вычисляет недостающую сторону размера результата по пропорциям изображения.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_width Ширина изображения до изменения размера (в исходной ориентации).
+ * @param source_height Высота изображения до изменения размера.
+ * @param width Указатель на ширину результата.
+ * @param height Указатель на высоту результата.
+ */
+static void resolve_size(const struct pipeline *pipeline, uint64_t source_width, uint64_t source_height,
+                         uint64_t *width, uint64_t *height) {
+    int swap = orientation_swaps_axes(pipeline->orientation);
+    uint64_t in_width = swap ? source_height : source_width;
+    uint64_t in_height = swap ? source_width : source_height;
+
+    *width = pipeline->width;
+    *height = pipeline->height;
+    if (*width == 0) {
+        *width = (*height * in_width + in_height / 2) / in_height;
+    }
+    if (*height == 0) {
+        *height = (*width * in_height + in_width / 2) / in_width;
+    }
+    if (*width == 0) {
+        *width = 1;
+    }
+    if (*height == 0) {
+        *height = 1;
+    }
+}
+
+/**
+ * @brief Вычисляет размеры прочитанного изображения: после вырезания области и уменьшения при чтении.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param width Указатель на ширину исходного изображения; заменяется шириной прочитанного.
+ * @param height Указатель на высоту исходного изображения; заменяется высотой прочитанного.
+ */
+static void loaded_size(const struct pipeline *pipeline, uint64_t *width, uint64_t *height) {
+    if (pipeline->has_region) {
+        *width = pipeline->region.width < *width ? pipeline->region.width : *width;
+        *height = pipeline->region.height < *height ? pipeline->region.height : *height;
+    }
+    *width = (*width + pipeline->shrink - 1) / pipeline->shrink;
+    *height = (*height + pipeline->shrink - 1) / pipeline->shrink;
+}
+
+/**
+ * @brief Оценивает память буферов, получаемых из прочитанного изображения: результата и буфера фильтров.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param width Ширина прочитанного изображения (см. `loaded_size`).
+ * @param height Высота прочитанного изображения.
+ * @return Оценка в байтах.
+ */
+static uint64_t result_bytes(const struct pipeline *pipeline, uint64_t width, uint64_t height) {
+    uint64_t result = width * height;
+    if (pipeline->has_resize && result > 0) {
+        uint64_t resized_width, resized_height;
+        resolve_size(pipeline, width, height, &resized_width, &resized_height);
+        result = resized_width * resized_height;
+    }
+    uint64_t filtered = pipeline->filter_count > 0 ? result : 0;
+    return (result + filtered) * sizeof(struct pixel);
+}
+
+/**
+ * @brief Оценивает память, которую займут буферы изображений при выполнении операций.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param width Ширина исходного изображения.
+ * @param height Высота исходного изображения.
+ * @return Оценка в байтах.
+ */
+uint64_t pipeline_memory_estimate(const struct pipeline *pipeline, uint64_t width, uint64_t height) {
+    if (pipeline->out_of_core) {
+        return pipeline->out_of_core;
+    }
+    loaded_size(pipeline, &width, &height);
+    return width * height * sizeof(struct pixel) + result_bytes(pipeline, width, height);
+}
+
+/**
+ * @brief Накопитель описания результата для ключа кэша.
+ */
+struct cache_description {
+    uint8_t data[4096];              // Описание результата
+    size_t size;                     // Размер описания в байтах
+};
+
+/**
+ * @brief Дописывает в описание результата значение поля.
+ */
+static void describe(struct cache_description *description, const void *value, size_t size) {
+    memcpy(description->data + description->size, value, size);
+    description->size += size;
+}
+
+/**
+ * @brief Вычисляет ключ кэша для результата операций над изображением.
+ *
+ * Поля описания дописываются по одному, чтобы выравнивание структур не попадало в ключ.
+ * Положение области не учитывается: результат зависит только от прочитанных пикселей,
+ * а их размеры уже входят в хеш. Расширение пути назначения входит в ключ, поскольку от него
+ * может зависеть формат файла результата.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param digest Хеш исходных пикселей.
+ * @param dest_path Путь к выходному изображению.
+ * @param key Указатель на заполняемый ключ.
+ */
+static void pipeline_cache_key(const struct pipeline *pipeline, uint64_t digest, const char *dest_path,
+                               struct cache_key *key) {
+    struct cache_description description;
+    const struct color_ops *color = &pipeline->color;
+    const uint32_t version = PIPELINE_CACHE_VERSION;
+    const uint32_t orientation = pipeline->orientation;
+    const uint32_t resize_filter = pipeline->filter;
+    const uint32_t format = image_format_resolve(dest_path, pipeline->format);
+
+    description.size = 0;
+    describe(&description, &version, sizeof(version));
+    describe(&description, &digest, sizeof(digest));
+    describe(&description, &pipeline->shrink, sizeof(pipeline->shrink));
+    describe(&description, &orientation, sizeof(orientation));
+    if (pipeline->has_resize) {
+        describe(&description, &pipeline->width, sizeof(pipeline->width));
+        describe(&description, &pipeline->height, sizeof(pipeline->height));
+        describe(&description, &resize_filter, sizeof(resize_filter));
+    }
+    describe(&description, &color->active, sizeof(color->active));
+    if (color->active) {
+        describe(&description, &color->grayscale, sizeof(color->grayscale));
+        describe(&description, color->before, sizeof(color->before));
+        describe(&description, color->after, sizeof(color->after));
+    }
+    for (int i = 0; i < pipeline->filter_count; i++) {
+        const struct filter_op *op = &pipeline->filters[i];
+        const uint32_t kind = op->kind;
+        describe(&description, &kind, sizeof(kind));
+        describe(&description, &op->radius, sizeof(op->radius));
+        describe(&description, &op->sigma, sizeof(op->sigma));
+        describe(&description, &op->amount, sizeof(op->amount));
+        describe(&description, &op->threshold, sizeof(op->threshold));
+    }
+
+    const char *name = strrchr(dest_path, '/');
+    const char *extension = strrchr(name ? name : dest_path, '.');
+    if (extension) {
+        describe(&description, extension, strnlen(extension, 16));
+    }
+    describe(&description, &format, sizeof(format));
+
+    cache_key_init(key, description.data, description.size);
+}
+
+/**
+ * @brief Читает исходное изображение, выполняя при чтении все операции, которые можно совместить с ним.
+ *
+ * Вырезание области и уменьшение выполняются по мере чтения строк; если изменение размера не требуется,
+ * смена ориентации для области также выполняется при чтении.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_path Путь к исходному изображению.
+ * @param img Указатель на структуру для результата.
+ * @param oriented Указатель на признак того, что ориентация уже применена.
+ * @param observers Указатель на сведения об исходных пикселях или NULL, если они не нужны.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+static int pipeline_load(const struct pipeline *pipeline, const char *source_path, struct image *img, int *oriented,
+                         const struct read_observers *observers) {
+    const struct image_rect *region = pipeline->has_region ? &pipeline->region : NULL;
+
+    // Ориентацию всего изображения выгоднее менять тайлами после чтения, а область обычно мала
+    *oriented = !pipeline->has_resize && (region || pipeline->shrink > 1);
+    enum orientation orientation = *oriented ? pipeline->orientation : ORIENTATION_NONE;
+
+    if (pipeline->shrink > 1) {
+        return read_image_shrunk(source_path, region, pipeline->shrink, orientation, img, observers);
+    }
+    if (region || observers) {
+        return read_image_region_oriented(source_path, region, orientation, img, observers);
+    }
+    return read_image(source_path, img);
+}
+
+/**
+ * @brief Проверяет, можно ли выполнить операции без загрузки изображения в память целиком.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param format Формат результата (не `IMAGE_FORMAT_AUTO`).
+ * @return 1, если можно, иначе 0.
+ */
+static int out_of_core_supports(const struct pipeline *pipeline, enum image_format format) {
+    return !pipeline->has_resize && pipeline->shrink <= 1 && pipeline->filter_count == 0 && !pipeline->stats
+           && image_format_streams_rows(format);
+}
+
+/**
+ * @brief Выполняет операции без загрузки изображения в память целиком.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному изображению.
+ * @param cache_bytes Размер кэша тайлов в байтах.
+ * @return 0, если все операции выполнены успешно, или 1 в случае ошибки.
+ */
+static int pipeline_run_out_of_core(const struct pipeline *pipeline, const char *source_path,
+                                    const char *dest_path, uint64_t cache_bytes) {
+    enum image_format format = image_format_resolve(dest_path, pipeline->format);
+    if (!out_of_core_supports(pipeline, format)) {
+        fprintf(stderr, "Ошибка: с --out-of-core доступны только --crop, --orient и цветовые операции "
+                        "с записью в BMP или TIFF\n");
+        return 1;
+    }
+    if (out_of_core_transform(source_path, dest_path, format, pipeline->has_region ? &pipeline->region : NULL,
+                              pipeline->orientation, &pipeline->color, cache_bytes) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось преобразовать изображение из '%s' в '%s'\n", source_path, dest_path);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Предупреждает, что загрузка одна больше бюджета памяти и будет выполнена без других загрузок.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param estimate Оценка памяти загрузки в байтах.
+ * @param budget Бюджет памяти в байтах.
+ */
+static void warn_over_budget(const char *source_path, uint64_t estimate, uint64_t budget) {
+    fprintf(stderr, "Предупреждение: изображению '%s' нужно около %llu МиБ при бюджете %llu МиБ; "
+                    "оно будет обработано в памяти без других загрузок\n",
+            source_path, (unsigned long long) (estimate >> 20), (unsigned long long) (budget >> 20));
+}
+
+/**
+ * @brief Сообщает учету памяти ожидаемый объем буферов или выбирает обработку без загрузки в память.
+ *
+ * Если задан бюджет памяти, объем оценивается по заголовку исходного изображения. Изображение,
+ * которое одно не помещается в бюджет, обрабатывается через кэш тайлов размером в половину бюджета,
+ * если операции это допускают; иначе - в памяти, когда других загрузок не останется.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному изображению.
+ * @return Размер кэша тайлов в байтах, если нужна обработка без загрузки в память, иначе 0.
+ */
+static uint64_t pipeline_admit(const struct pipeline *pipeline, const char *source_path, const char *dest_path) {
+    uint64_t budget = buffer_memory_budget();
+    uint64_t width, height;
+    if (budget == 0 || read_image_size(source_path, &width, &height) != 0) {
+        return 0;
+    }
+    uint64_t estimate = pipeline_memory_estimate(pipeline, width, height);
+    if (estimate <= budget) {
+        buffer_expect(estimate);
+        return 0;
+    }
+    if (out_of_core_supports(pipeline, image_format_resolve(dest_path, pipeline->format))) {
+        uint64_t minimum = (uint64_t) OUT_OF_CORE_MIN_CACHE_MB << 20;
+        return budget / 2 > minimum ? budget / 2 : minimum;
+    }
+    warn_over_budget(source_path, estimate, budget);
+    buffer_expect(estimate);
+    return 0;
+}
+
+/**
+ * @brief Применяет к результату оставшиеся операции, записывает его и освобождает.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param dest_path Путь к выходному изображению.
+ * @param result Указатель на результат смены ориентации или изменения размера (data NULL - ошибка).
+ * @param colored Признак того, что цветовые операции уже выполнены.
+ * @param key Указатель на ключ кэша или NULL, если кэш не используется.
+ * @return 0, если все операции выполнены успешно, или 1 в случае ошибки.
+ */
+static int pipeline_finish(const struct pipeline *pipeline, const char *dest_path, struct image *result, int colored,
+                           const struct cache_key *key) {
+    if (result->data == NULL) {
+        fprintf(stderr, "Ошибка: Не удалось преобразовать изображение\n");
+        return 1;
+    }
+    if (!colored) {
+        color_apply_image(&pipeline->color, result);
+    }
+
+    for (int i = 0; i < pipeline->filter_count; i++) {
+        struct image filtered = filter_image(result, &pipeline->filters[i]);
+        destroy_image(result);
+        if (filtered.data == NULL) {
+            fprintf(stderr, "Ошибка: Не удалось применить фильтр к изображению\n");
+            return 1;
+        }
+        *result = filtered;
+    }
+
+    if (key) {
+        cache_detach(dest_path);
+    }
+    if (write_image_format(dest_path, result, pipeline->format) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось записать изображение в '%s'\n", dest_path);
+        destroy_image(result);
+        return 1;
+    }
+
+    destroy_image(result);
+    if (key && cache_store(pipeline->cache_dir, key, dest_path) != 0) {
+        fprintf(stderr, "Предупреждение: не удалось сохранить результат в кэш '%s'\n", pipeline->cache_dir);
+    }
+    return 0;
+}
+
+/**
+ * @brief Читает исходное изображение, выполняет над ним операции и записывает результат.
+ *
+ * @param pipeline Указатель на описание операций.
+ * @param source_path Путь к исходному изображению.
+ * @param dest_path Путь к выходному изображению.
+ * @return 0, если все операции выполнены успешно, или 1 в случае ошибки.
+ */
+int pipeline_run(const struct pipeline *pipeline, const char *source_path, const char *dest_path) {
+    if (pipeline->out_of_core) {
+        return pipeline_run_out_of_core(pipeline, source_path, dest_path, pipeline->out_of_core);
+    }
+    uint64_t cache_bytes = pipeline_admit(pipeline, source_path, dest_path);
+    if (cache_bytes) {
+        return pipeline_run_out_of_core(pipeline, source_path, dest_path, cache_bytes);
+    }
+
+    struct image img = {0};
+    int oriented = 0;
+    int colored = 0;
+    uint64_t digest = 0;
+    struct cache_key key;
+    int cached = pipeline->cache_dir && !image_path_is_stream(dest_path) && cache_accepts(dest_path);
+
+    struct image_stats stats;
+    struct uniform_tiles tiles = {0};
+    // Карта тайлов нужна, только если ориентация всего изображения меняется тайлами после чтения
+    int sparse = pipeline->sparse && !pipeline->has_resize && !pipeline->has_region && pipeline->shrink <= 1;
+    struct read_observers observers = {cached ? &digest : NULL, pipeline->stats ? &stats : NULL,
+                                       sparse ? &tiles : NULL, orient_tile_size()};
+    int observed = cached || pipeline->stats || sparse;
+    if (pipeline_load(pipeline, source_path, &img, &oriented, observed ? &observers : NULL) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось прочитать исходное изображение из '%s'\n", source_path);
+        return 1;
+    }
+    if (pipeline->stats) {
+        image_stats_print(image_path_is_stream(dest_path) ? stderr : stdout, &stats);
+    }
+    if (cached) {
+        pipeline_cache_key(pipeline, digest, dest_path, &key);
+        if (cache_fetch(pipeline->cache_dir, &key, dest_path) == 0) {
+            destroy_image(&img);
+            uniform_tiles_destroy(&tiles);
+            return 0;
+        }
+    }
+
+    struct image result = img;
+    if (pipeline->has_resize) {
+        uint64_t width, height;
+        resolve_size(pipeline, img.width, img.height, &width, &height);
+        result = resize_oriented_image(&img, width, height, pipeline->filter, pipeline->orientation);
+        destroy_image(&img);
+    } else if (!oriented) {
+        // Цветовые операции выполняются над каждым тайлом сразу после его переноса
+        struct pixel_stage stage;
+        struct image_rect full = {0, 0, img.width, img.height};
+        result = orient_region_sparse(&img, &full, pipeline->orientation, color_ops_stage(&pipeline->color, &stage),
+                                      sparse ? &tiles : NULL);
+        destroy_image(&img);
+        colored = 1;
+    }
+
+    uniform_tiles_destroy(&tiles);
+    return pipeline_finish(pipeline, dest_path, &result, colored, cached ? &key : NULL);
+}
+
+/**
+ * @brief Проверяет, читают ли два описания операций одни и те же пиксели источника.
+ *
+ * @return 1, если область и уменьшение при чтении совпадают, иначе 0.
+ */
+static int pipeline_same_read(const struct pipeline *a, const struct pipeline *b) {
+    if (a->has_region != b->has_region || a->shrink != b->shrink) {
+        return 0;
+    }
+    return !a->has_region || (a->region.x == b->region.x && a->region.y == b->region.y
+                              && a->region.width == b->region.width && a->region.height == b->region.height);
+}
+
+/**
+ * @brief Допускает общее чтение к выполнению в пределах бюджета памяти, как `pipeline_admit` - одну загрузку.
+ *
+ * Память общего чтения - прочитанное изображение (один раз) и буферы всех результатов. Если она
+ * больше бюджета, из общего чтения с конца исключаются результаты, которые можно обработать без
+ * загрузки в память, пока оценка не поместится в бюджет: они выполняются отдельно через `pipeline_run`.
+ * Если и после этого оценка больше бюджета (или источник - стандартный ввод, который читается
+ * один раз), общее чтение выполняется в памяти без других загрузок.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param outputs Результаты.
+ * @param members Номера результатов общего чтения по возрастанию; исключенные удаляются из массива.
+ * @param count Количество результатов общего чтения.
+ * @return Количество результатов, оставшихся в общем чтении.
+ */
+static size_t pipeline_admit_shared(const char *source_path, const struct pipeline_output *outputs, size_t *members,
+                                    size_t count) {
+    uint64_t budget = buffer_memory_budget();
+    uint64_t width, height;
+    if (budget == 0 || count == 0 || read_image_size(source_path, &width, &height) != 0) {
+        return count;
+    }
+    loaded_size(&outputs[members[0]].pipeline, &width, &height);
+    uint64_t estimate = width * height * sizeof(struct pixel);
+    for (size_t i = 0; i < count; i++) {
+        estimate += result_bytes(&outputs[members[i]].pipeline, width, height);
+    }
+
+    for (size_t i = count; i-- > 0 && estimate > budget && !image_path_is_stream(source_path);) {
+        const struct pipeline_output *output = &outputs[members[i]];
+        if (out_of_core_supports(&output->pipeline, image_format_resolve(output->dest_path, output->pipeline.format))) {
+            estimate -= result_bytes(&output->pipeline, width, height);
+            memmove(&members[i], &members[i + 1], (count - i - 1) * sizeof(*members));
+            count--;
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    if (estimate > budget) {
+        warn_over_budget(source_path, estimate, budget);
+    }
+    buffer_expect(estimate);
+    return count;
+}
+
+/**
+ * @brief Строит результаты с одинаковым чтением источника из одного прочитанного изображения.
+ *
+ * Вызывается после `pipeline_admit_shared`, которая сообщает учету памяти объем общего чтения.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param outputs Результаты.
+ * @param members Номера результатов, получаемых из общего чтения (не меньше одного).
+ * @param count Количество таких результатов.
+ * @return 0, если все результаты записаны, или 1, если хотя бы один не записан.
+ */
+static int pipeline_run_shared(const char *source_path, const struct pipeline_output *outputs, const size_t *members,
+                               size_t count) {
+    const struct pipeline *reference = &outputs[members[0]].pipeline;
+    int cached[PIPELINE_MAX_OUTPUTS];
+    int any_cached = 0, any_stats = 0, any_sparse = 0, stats_to_stderr = 0;
+    for (size_t i = 0; i < count; i++) {
+        const struct pipeline_output *output = &outputs[members[i]];
+        cached[i] = output->pipeline.cache_dir && !image_path_is_stream(output->dest_path)
+                    && cache_accepts(output->dest_path);
+        any_cached |= cached[i];
+        any_stats |= output->pipeline.stats;
+        any_sparse |= output->pipeline.sparse && !output->pipeline.has_resize;
+        stats_to_stderr |= image_path_is_stream(output->dest_path);
+    }
+
+    // Источник читается один раз без смены ориентации: она у каждого результата своя
+    struct pipeline read = *reference;
+    read.orientation = ORIENTATION_NONE;
+    struct image img = {0};
+    int oriented;
+    uint64_t digest = 0;
+    struct image_stats stats;
+    struct uniform_tiles tiles = {0};
+    int sparse = any_sparse && !read.has_region && read.shrink <= 1;
+    struct read_observers observers = {any_cached ? &digest : NULL, any_stats ? &stats : NULL,
+                                       sparse ? &tiles : NULL, orient_tile_size()};
+    int observed = any_cached || any_stats || sparse;
+    if (pipeline_load(&read, source_path, &img, &oriented, observed ? &observers : NULL) != 0) {
+        fprintf(stderr, "Ошибка: Не удалось прочитать исходное изображение из '%s'\n", source_path);
+        return 1;
+    }
+    if (any_stats) {
+        image_stats_print(stats_to_stderr ? stderr : stdout, &stats);
+    }
+
+    // Результаты из кэша не вычисляются; без изменения размера все строятся одним обходом тайлов
+    struct cache_key keys[PIPELINE_MAX_OUTPUTS];
+    struct image results[PIPELINE_MAX_OUTPUTS];
+    int pending[PIPELINE_MAX_OUTPUTS];
+    enum orientation orientations[PIPELINE_MAX_OUTPUTS];
+    struct pixel_stage stage_storage[PIPELINE_MAX_OUTPUTS];
+    const struct pixel_stage *stages[PIPELINE_MAX_OUTPUTS];
+    size_t oriented_members[PIPELINE_MAX_OUTPUTS];
+    size_t oriented_count = 0;
+    for (size_t i = 0; i < count; i++) {
+        const struct pipeline *pipeline = &outputs[members[i]].pipeline;
+        results[i].data = NULL;
+        pending[i] = 1;
+        if (cached[i]) {
+            pipeline_cache_key(pipeline, digest, outputs[members[i]].dest_path, &keys[i]);
+            pending[i] = cache_fetch(pipeline->cache_dir, &keys[i], outputs[members[i]].dest_path) != 0;
+        }
+        if (pending[i] && !pipeline->has_resize) {
+            orientations[oriented_count] = pipeline->orientation;
+            stages[oriented_count] = color_ops_stage(&pipeline->color, &stage_storage[oriented_count]);
+            oriented_members[oriented_count++] = i;
+        }
+    }
+
+    struct image_rect full = {0, 0, img.width, img.height};
+    struct image fanout[PIPELINE_MAX_OUTPUTS];
+    if (oriented_count > 0
+        && orient_region_fanout(&img, &full, oriented_count, orientations, stages, sparse ? &tiles : NULL,
+                                fanout) == 0) {
+        for (size_t k = 0; k < oriented_count; k++) {
+            results[oriented_members[k]] = fanout[k];
+        }
+    }
+    uniform_tiles_destroy(&tiles);
+    for (size_t i = 0; i < count; i++) {
+        const struct pipeline *pipeline = &outputs[members[i]].pipeline;
+        if (pending[i] && pipeline->has_resize) {
+            uint64_t width, height;
+            resolve_size(pipeline, img.width, img.height, &width, &height);
+            results[i] = resize_oriented_image(&img, width, height, pipeline->filter, pipeline->orientation);
+        }
+    }
+    destroy_image(&img);
+
+    int status = 0;
+    for (size_t i = 0; i < count; i++) {
+        const struct pipeline_output *output = &outputs[members[i]];
+        if (pending[i]) {
+            status |= pipeline_finish(&output->pipeline, output->dest_path, &results[i],
+                                      !output->pipeline.has_resize, cached[i] ? &keys[i] : NULL);
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief Строит несколько результатов из одного исходного изображения.
+ *
+ * @param source_path Путь к исходному изображению.
+ * @param outputs Результаты: операции и пути назначения.
+ * @param count Количество результатов (от 1 до `PIPELINE_MAX_OUTPUTS`).
+ * @return 0, если все результаты записаны, или 1, если хотя бы один не записан.
+ */
+int pipeline_run_outputs(const char *source_path, const struct pipeline_output *outputs, size_t count) {
+    if (count == 0 || count > PIPELINE_MAX_OUTPUTS) {
+        fprintf(stderr, "Ошибка: количество результатов должно быть от 1 до %d\n", PIPELINE_MAX_OUTPUTS);
+        return 1;
+    }
+    if (count == 1) {
+        return pipeline_run(&outputs[0].pipeline, source_path, outputs[0].dest_path);
+    }
+
+    // Общее чтение задает первый результат, обрабатываемый в памяти; остальные с другим чтением - отдельно
+    size_t members[PIPELINE_MAX_OUTPUTS];
+    size_t shared = 0;
+    for (size_t i = 0; i < count; i++) {
+        const struct pipeline *pipeline = &outputs[i].pipeline;
+        if (!pipeline->out_of_core && (shared == 0 || pipeline_same_read(&outputs[members[0]].pipeline, pipeline))) {
+            members[shared++] = i;
+        }
+    }
+    if (shared < count && image_path_is_stream(source_path)) {
+        fprintf(stderr, "Ошибка: стандартный ввод читается один раз, поэтому все результаты должны читать "
+                        "одну область с одним уменьшением и без --out-of-core\n");
+        return 1;
+    }
+
+    shared = pipeline_admit_shared(source_path, outputs, members, shared);
+    int status = shared > 0 ? pipeline_run_shared(source_path, outputs, members, shared) : 0;
+    for (size_t i = 0, next = 0; i < count; i++) {
+        if (next < shared && members[next] == i) {
+            next++;
+            continue;
+        }
+        status |= pipeline_run(&outputs[i].pipeline, source_path, outputs[i].dest_path);
+    }
+    return status;
+}
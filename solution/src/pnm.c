@@ -0,0 +1,271 @@
+#include "pnm.h"
+#include "raster.h"
+#include <string.h>
+
+#define PNM_TOKEN_MAX 32             // Максимальная длина слова заголовка PAM
+
+/**
+ * @brief Источник байт текстового заголовка: сначала уже прочитанные байты, затем поток.
+ */
+struct pnm_reader {
+    FILE *in;                        // Файл для чтения
+    const uint8_t *prefix;           // Уже прочитанные первые байты файла
+    size_t prefix_size;              // Количество уже прочитанных байт
+    uint64_t position;               // Количество байт, выданных с начала файла
+};
+
+/**
+ * @brief Возвращает следующий байт заголовка или EOF.
+ */
+static int next_byte(struct pnm_reader *reader) {
+    int c = reader->position < reader->prefix_size ? reader->prefix[reader->position] : getc(reader->in);
+    if (c != EOF) {
+        reader->position++;
+    }
+    return c;
+}
+
+/**
+ * @brief Проверяет, является ли байт пробельным символом заголовка.
+ */
+static int is_space(int c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v' || c == '\f';
+}
+
+/**
+ * @brief Читает слово заголовка, пропуская пробелы и комментарии.
+ *
+ * Слово завершается одним пробельным символом, который тоже считывается: после последнего поля
+ * заголовка PGM и PPM ровно один такой символ отделяет его от пиксельных данных.
+ *
+ * @param reader Источник байт.
+ * @param token Буфер для слова.
+ * @param size Размер буфера.
+ * @return 0, если слово прочитано, или 1 в случае ошибки.
+ */
+static int next_token(struct pnm_reader *reader, char *token, size_t size) {
+    int c = next_byte(reader);
+    while (is_space(c) || c == '#') {
+        if (c == '#') {
+            while (c != '\n' && c != EOF) {
+                c = next_byte(reader);
+            }
+        }
+        c = next_byte(reader);
+    }
+    size_t length = 0;
+    while (c != EOF && !is_space(c)) {
+        if (length + 1 >= size) {
+            return 1;
+        }
+        token[length++] = (char) c;
+        c = next_byte(reader);
+    }
+    token[length] = '\0';
+    return length == 0 || c == EOF;
+}
+
+/**
+ * @brief Разбирает десятичное число из слова заголовка.
+ *
+ * @param token Слово заголовка.
+ * @param limit Максимально допустимое значение.
+ * @param value Указатель на результат.
+ * @return 0, если число корректно и положительно, или 1 в случае ошибки.
+ */
+static int parse_number(const char *token, uint64_t limit, uint64_t *value) {
+    uint64_t result = 0;
+    for (const char *c = token; *c; c++) {
+        if (*c < '0' || *c > '9') {
+            return 1;
+        }
+        result = result * 10 + (uint64_t) (*c - '0');
+        if (result > limit) {
+            return 1;
+        }
+    }
+    *value = result;
+    return result == 0;
+}
+
+/**
+ * @brief Проверяет, похожи ли первые байты файла на заголовок PGM, PPM или PAM в двоичной форме.
+ *
+ * @param magic Первые байты файла.
+ * @param size Количество байт.
+ * @return 1, если сигнатура распознана, иначе 0.
+ */
+int pnm_sniff(const uint8_t *magic, size_t size) {
+    return size >= 3 && magic[0] == 'P' && (magic[1] == '5' || magic[1] == '6' || magic[1] == '7')
+           && (is_space(magic[2]) || magic[2] == '#');
+}
+
+/**
+ * @brief Читает поля заголовка PGM или PPM: ширину, высоту и максимальное значение.
+ */
+static enum read_status read_pnm_fields(struct pnm_reader *reader, struct pnm_header *header) {
+    char token[PNM_TOKEN_MAX];
+    uint64_t maxval;
+    if (next_token(reader, token, sizeof(token)) != 0 || parse_number(token, PNM_MAX_DIMENSION, &header->width) != 0
+        || next_token(reader, token, sizeof(token)) != 0 || parse_number(token, PNM_MAX_DIMENSION, &header->height) != 0
+        || next_token(reader, token, sizeof(token)) != 0 || parse_number(token, UINT16_MAX, &maxval) != 0) {
+        return READ_INVALID_HEADER;
+    }
+    header->maxval = (uint32_t) maxval;
+    return READ_OK;
+}
+
+/**
+ * @brief Читает строки заголовка PAM вида `КЛЮЧ значение` до строки `ENDHDR`.
+ *
+ * Тип кортежа не проверяется: каналы определяются полем DEPTH.
+ */
+static enum read_status read_pam_fields(struct pnm_reader *reader, struct pnm_header *header) {
+    char token[PNM_TOKEN_MAX];
+    uint64_t width = 0, height = 0, depth = 0, maxval = 0;
+    for (;;) {
+        if (next_token(reader, token, sizeof(token)) != 0) {
+            return READ_INVALID_HEADER;
+        }
+        if (strcmp(token, "ENDHDR") == 0) {
+            break;
+        }
+        uint64_t *field = strcmp(token, "WIDTH") == 0 ? &width
+                          : strcmp(token, "HEIGHT") == 0 ? &height
+                          : strcmp(token, "DEPTH") == 0 ? &depth
+                          : strcmp(token, "MAXVAL") == 0 ? &maxval : NULL;
+        uint64_t limit = field == &maxval ? UINT16_MAX : PNM_MAX_DIMENSION;
+        if (next_token(reader, token, sizeof(token)) != 0 || (field && parse_number(token, limit, field) != 0)) {
+            return READ_INVALID_HEADER;
+        }
+    }
+    if (width == 0 || height == 0 || maxval == 0) {
+        return READ_INVALID_HEADER;
+    }
+    if (depth == 0 || depth > 4) {
+        return READ_INVALID_BITS;
+    }
+    header->width = width;
+    header->height = height;
+    header->depth = (uint32_t) depth;
+    header->maxval = (uint32_t) maxval;
+    return READ_OK;
+}
+
+/**
+ * @brief Возвращает размер пикселя в файле в байтах.
+ */
+static uint64_t pnm_pixel_size(const struct pnm_header *header) {
+    return (uint64_t) header->depth * (header->maxval > UINT8_MAX ? 2 : 1);
+}
+
+/**
+ * @brief Дочитывает и проверяет текстовый заголовок PGM, PPM или PAM, первые байты которого уже прочитаны.
+ *
+ * Пиксельные данные, выходящие за конец файла, отклоняются сразу, до выделения памяти под изображение.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param prefix Уже прочитанные первые байты файла.
+ * @param prefix_size Количество уже прочитанных байт.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения (`READ_OK`, `READ_INVALID_HEADER`, `READ_INVALID_BITS`, и т.д.).
+ */
+enum read_status pnm_read_header(FILE *in, const uint8_t *prefix, size_t prefix_size, struct pnm_header *header) {
+    if (!in || !header) return READ_INVALID_HEADER;
+
+    struct pnm_reader reader = {in, prefix, prefix_size, 0};
+    char magic[PNM_TOKEN_MAX];
+    if (next_token(&reader, magic, sizeof(magic)) != 0) {
+        return READ_IO_ERROR;
+    }
+
+    enum read_status status;
+    if (strcmp(magic, "P5") == 0 || strcmp(magic, "P6") == 0) {
+        header->depth = magic[1] == '5' ? 1 : 3;
+        status = read_pnm_fields(&reader, header);
+    } else if (strcmp(magic, "P7") == 0) {
+        status = read_pam_fields(&reader, header);
+    } else {
+        status = READ_INVALID_SIGNATURE;
+    }
+    header->data_offset = reader.position;
+    if (status != READ_OK) {
+        return status;
+    }
+
+    uint64_t pixel_size = pnm_pixel_size(header);
+    struct raster_layout layout = {
+        header->width, header->height, header->data_offset, header->data_offset,
+        header->width * pixel_size, pixel_size, 0, NULL, NULL
+    };
+    return raster_check_size(in, &layout);
+}
+
+/**
+ * @brief Приводит значение канала к диапазону 0..255 с округлением.
+ */
+static uint8_t scale_sample(uint32_t value, uint32_t maxval) {
+    if (value >= maxval) {
+        return 255;
+    }
+    return (uint8_t) ((value * 255u + maxval / 2) / maxval);
+}
+
+/**
+ * @brief Преобразует пиксели PGM, PPM или PAM в `struct pixel`.
+ *
+ * @param ctx Указатель на `struct pnm_header`.
+ * @param out Указатель на результат.
+ * @param in Указатель на пиксели файла.
+ * @param count Количество пикселей.
+ */
+static void pnm_convert(const void *ctx, struct pixel *out, const uint8_t *in, uint64_t count) {
+    const struct pnm_header *header = ctx;
+    uint32_t depth = header->depth;
+
+    // Самый частый случай - 8-битный PPM - обрабатывается без масштабирования
+    if (header->maxval == 255 && depth == 3) {
+        for (uint64_t i = 0; i < count; i++, in += 3) {
+            out[i].r = in[0];
+            out[i].g = in[1];
+            out[i].b = in[2];
+        }
+        return;
+    }
+
+    uint32_t wide = header->maxval > UINT8_MAX;
+    uint32_t sample_size = wide ? 2 : 1;
+    uint32_t color = depth >= 3;
+    for (uint64_t i = 0; i < count; i++, in += depth * sample_size) {
+        uint32_t samples[3];
+        for (uint32_t c = 0; c < 3; c++) {
+            const uint8_t *sample = in + (color ? c : 0) * sample_size;
+            samples[c] = wide ? (uint32_t) sample[0] << 8 | sample[1] : sample[0];
+        }
+        out[i].r = scale_sample(samples[0], header->maxval);
+        out[i].g = scale_sample(samples[1], header->maxval);
+        out[i].b = scale_sample(samples[2], header->maxval);
+    }
+}
+
+/**
+ * @brief Читает строки заданной области и передает их обработчику.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status pnm_read_region(FILE *in, const struct pnm_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx) {
+    if (!in || !header || !region || !handler) return READ_INVALID_HEADER;
+
+    uint64_t pixel_size = pnm_pixel_size(header);
+    struct raster_layout layout = {
+        header->width, header->height, header->data_offset, header->data_offset,
+        header->width * pixel_size, pixel_size, 0, pnm_convert, header
+    };
+    return raster_read_region(in, &layout, region, handler, ctx);
+}
@@ -0,0 +1,237 @@
+#include "profile.h"
+#include "parallel.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PROFILE_PATH_MAX 4096        // Максимальная длина пути к файлу профиля
+#define PROFILE_LINE_MAX 256         // Максимальная длина строки файла профиля
+
+/**
+ * @brief Заполняет профиль действующими настройками механизма смены ориентации.
+ *
+ * @param profile Указатель на профиль.
+ */
+void profile_capture(struct transform_profile *profile) {
+    profile->tile_size = orient_tile_size();
+    profile->threads = parallel_thread_count();
+    profile->prefetch_distance = orient_prefetch_distance();
+    profile->stream_threshold = orient_stream_threshold();
+    profile->kernels = orient_active_kernels();
+}
+
+/**
+ * @brief Применяет настройки профиля ко всему процессу.
+ *
+ * @param profile Указатель на профиль.
+ * @return 0 при успехе или 1, если набор ядер профиля не поддерживается.
+ */
+int profile_apply(const struct transform_profile *profile) {
+    orient_set_tile_size(profile->tile_size);
+    parallel_set_thread_count(profile->threads);
+    orient_set_prefetch_distance(profile->prefetch_distance);
+    orient_set_stream_threshold(profile->stream_threshold);
+    return orient_set_kernels(profile->kernels);
+}
+
+/**
+ * @brief Определяет путь к файлу профиля.
+ *
+ * @param path Буфер для пути.
+ * @param size Размер буфера в байтах.
+ * @return 0, если путь определен, или 1 в случае ошибки.
+ */
+int profile_default_path(char *path, size_t size) {
+    const char *env = getenv("IMAGE_TRANSFORM_PROFILE");
+    const char *config = getenv("XDG_CONFIG_HOME");
+    const char *home = getenv("HOME");
+    int length;
+
+    if (env && *env) {
+        length = snprintf(path, size, "%s", env);
+    } else if (config && *config) {
+        length = snprintf(path, size, "%s/image_transform/profile", config);
+    } else if (home && *home) {
+        length = snprintf(path, size, "%s/.config/image_transform/profile", home);
+    } else {
+        return 1;
+    }
+    return length > 0 && (size_t) length < size ? 0 : 1;
+}
+
+/**
+ * @brief Разбирает целое неотрицательное значение ключа профиля.
+ *
+ * @param value Строка значения.
+ * @param result Указатель на результат.
+ * @return 0 при успехе или 1, если строка не является числом.
+ */
+static int parse_number(const char *value, uint64_t *result) {
+    unsigned long long number;
+    int consumed = 0;
+    if (sscanf(value, "%llu%n", &number, &consumed) != 1 || value[consumed] != '\0') {
+        return 1;
+    }
+    *result = number;
+    return 0;
+}
+
+/**
+ * @brief Применяет к профилю одну пару `ключ=значение`.
+ *
+ * @param profile Указатель на профиль.
+ * @param key Ключ.
+ * @param value Значение.
+ * @return 0, если значение принято или ключ неизвестен, или 1, если значение некорректно.
+ */
+static int parse_entry(struct transform_profile *profile, const char *key, const char *value) {
+    uint64_t number;
+
+    if (strcmp(key, "version") == 0) {
+        return parse_number(value, &number) != 0 || number != PROFILE_VERSION;
+    }
+    if (strcmp(key, "tile") == 0) {
+        if (parse_number(value, &number) != 0 || number < TRANSFORM_MIN_TILE_SIZE || number > TRANSFORM_MAX_TILE_SIZE) {
+            return 1;
+        }
+        profile->tile_size = number;
+    } else if (strcmp(key, "threads") == 0) {
+        if (parse_number(value, &number) != 0 || number > UINT32_MAX) {
+            return 1;
+        }
+        profile->threads = (unsigned) number;
+    } else if (strcmp(key, "prefetch") == 0) {
+        if (parse_number(value, &number) != 0) {
+            return 1;
+        }
+        profile->prefetch_distance = number;
+    } else if (strcmp(key, "stream-threshold") == 0) {
+        if (strcmp(value, "auto") == 0) {
+            profile->stream_threshold = 0;
+        } else if (strcmp(value, "off") == 0) {
+            profile->stream_threshold = UINT64_MAX;
+        } else if (parse_number(value, &number) != 0 || number == 0) {
+            return 1;
+        } else {
+            profile->stream_threshold = number;
+        }
+    } else if (strcmp(key, "kernels") == 0) {
+        return orient_kernels_from_name(value, &profile->kernels);
+    }
+    return 0;
+}
+
+/**
+ * @brief Читает профиль из файла.
+ *
+ * @param path Путь к файлу профиля.
+ * @param profile Указатель на профиль, дополняемый прочитанными значениями.
+ * @return 0 при успехе; 1, если файла нет; -1, если файл поврежден.
+ */
+int profile_load(const char *path, struct transform_profile *profile) {
+    FILE *in = fopen(path, "r");
+    if (!in) {
+        if (errno == ENOENT) {
+            return 1;
+        }
+        fprintf(stderr, "Предупреждение: не удалось открыть профиль '%s'\n", path);
+        return -1;
+    }
+
+    struct transform_profile loaded = *profile;
+    char line[PROFILE_LINE_MAX];
+    unsigned number = 0;
+    int status = 0;
+    while (status == 0 && fgets(line, sizeof(line), in)) {
+        number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') {
+            continue;
+        }
+        char *separator = strchr(line, '=');
+        if (!separator) {
+            status = -1;
+            break;
+        }
+        *separator = '\0';
+        if (parse_entry(&loaded, line, separator + 1) != 0) {
+            status = -1;
+        }
+    }
+    if (status == 0 && ferror(in)) {
+        status = -1;
+    }
+    fclose(in);
+
+    if (status != 0) {
+        fprintf(stderr, "Предупреждение: профиль '%s' поврежден (строка %u) и не используется\n", path, number);
+        return -1;
+    }
+    *profile = loaded;
+    return 0;
+}
+
+/**
+ * @brief Создает каталоги, ведущие к файлу, если их еще нет.
+ *
+ * @param path Путь к файлу.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+static int make_parent_dirs(const char *path) {
+    char dir[PROFILE_PATH_MAX];
+    int length = snprintf(dir, sizeof(dir), "%s", path);
+    if (length <= 0 || length >= (int) sizeof(dir)) {
+        return 1;
+    }
+    for (char *slash = strchr(dir + 1, '/'); slash; slash = strchr(slash + 1, '/')) {
+        *slash = '\0';
+        if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+            return 1;
+        }
+        *slash = '/';
+    }
+    return 0;
+}
+
+/**
+ * @brief Записывает профиль в файл, создавая недостающие каталоги.
+ *
+ * @param path Путь к файлу профиля.
+ * @param profile Указатель на профиль.
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+int profile_save(const char *path, const struct transform_profile *profile) {
+    char temp[PROFILE_PATH_MAX];
+    int length = snprintf(temp, sizeof(temp), "%s.%ld.tmp", path, (long) getpid());
+    if (length <= 0 || length >= (int) sizeof(temp) || make_parent_dirs(path) != 0) {
+        return 1;
+    }
+
+    FILE *out = fopen(temp, "w");
+    if (!out) {
+        return 1;
+    }
+    fprintf(out, "# Профиль image_transform, создан режимом --tune\n");
+    fprintf(out, "version=%d\n", PROFILE_VERSION);
+    fprintf(out, "tile=%llu\n", (unsigned long long) profile->tile_size);
+    fprintf(out, "threads=%u\n", profile->threads);
+    fprintf(out, "prefetch=%llu\n", (unsigned long long) profile->prefetch_distance);
+    if (profile->stream_threshold == UINT64_MAX) {
+        fprintf(out, "stream-threshold=off\n");
+    } else if (profile->stream_threshold == 0) {
+        fprintf(out, "stream-threshold=auto\n");
+    } else {
+        fprintf(out, "stream-threshold=%llu\n", (unsigned long long) profile->stream_threshold);
+    }
+    fprintf(out, "kernels=%s\n", orient_kernels_name(profile->kernels));
+
+    int failed = ferror(out);
+    if (fclose(out) != 0 || failed || rename(temp, path) != 0) {
+        remove(temp);
+        return 1;
+    }
+    return 0;
+}
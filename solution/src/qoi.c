@@ -0,0 +1,392 @@
+#include "qoi.h"
+#include "parallel.h"
+#include "raster.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00            // 00xxxxxx: цвет из таблицы
+#define QOI_OP_DIFF 0x40             // 01xxxxxx: малая разность каналов
+#define QOI_OP_LUMA 0x80             // 10xxxxxx: разность, зависящая от зеленого канала
+#define QOI_OP_RUN 0xc0              // 11xxxxxx: повтор предыдущего пикселя
+#define QOI_OP_RGB 0xfe              // 11111110: цвет целиком
+#define QOI_MAX_RUN 62               // Максимальная длина повтора в одной операции
+#define QOI_MAX_OP_SIZE 4            // Максимальный размер операции для трехканального изображения
+#define QOI_CHUNK_PIXELS (256u << 10) // Примерное количество пикселей в полосе параллельного кодирования
+#define QOI_CHUNKS_PER_THREAD 2      // Количество полос на поток, кодируемых до очередной записи
+#define QOI_OP_RGBA 0xff             // 11111111: цвет с альфой целиком
+#define QOI_MASK_2 0xc0              // Маска двухбитного кода операции
+#define QOI_READ_BUFFER (64u << 10)  // Размер буфера чтения при декодировании
+
+/**
+ * @brief Полоса строк изображения, кодируемая независимо от остальных.
+ */
+struct qoi_chunk {
+    uint64_t first_row;              // Первая строка полосы
+    uint64_t rows;                   // Количество строк полосы
+    uint8_t *data;                   // Закодированные данные
+    uint64_t size;                   // Размер закодированных данных в байтах
+};
+
+/**
+ * @brief Параметры параллельного кодирования группы полос.
+ */
+struct qoi_job {
+    const struct image *img;         // Кодируемое изображение
+    struct qoi_chunk *chunks;        // Полосы группы
+};
+
+/**
+ * @brief Буферизованный источник байт закодированного потока.
+ */
+struct qoi_input {
+    FILE *in;                        // Файл для чтения
+    uint8_t *buffer;                 // Буфер прочитанных байт
+    size_t size;                     // Количество байт в буфере
+    size_t pos;                      // Позиция следующего байта в буфере
+    int failed;                      // Признак преждевременного конца файла или ошибки чтения
+};
+
+/**
+ * @brief Цвет с альфа-каналом в порядке полей заголовка QOI.
+ */
+struct qoi_rgba {
+    uint8_t r, g, b, a;
+};
+
+/**
+ * @brief Упаковывает пиксель в 32-битное значение с непрозрачной альфой.
+ *
+ * Пустые элементы таблицы цветов равны нулю, то есть имеют нулевую альфу и не совпадают ни с одним пикселем.
+ */
+static inline uint32_t qoi_pack(struct pixel px) {
+    return (uint32_t) px.r | (uint32_t) px.g << 8 | (uint32_t) px.b << 16 | 0xff000000u;
+}
+
+/**
+ * @brief Вычисляет позицию цвета в таблице QOI.
+ */
+static inline uint32_t qoi_hash(struct pixel px) {
+    return (px.r * 3u + px.g * 5u + px.b * 7u + 255u * 11u) % 64u;
+}
+
+/**
+ * @brief Записывает 32-битное число в порядке байтов от старшего к младшему.
+ */
+static void put_u32_be(uint8_t *out, uint32_t value) {
+    out[0] = (uint8_t) (value >> 24);
+    out[1] = (uint8_t) (value >> 16);
+    out[2] = (uint8_t) (value >> 8);
+    out[3] = (uint8_t) value;
+}
+
+/**
+ * @brief Кодирует одну полосу строк.
+ *
+ * Предыдущий пиксель берется из изображения (последний пиксель предыдущей полосы), поэтому повторы
+ * и разности на границе полос кодируются так же, как внутри. Таблица цветов начинается пустой:
+ * операция `QOI_OP_INDEX` используется только для цветов, записанных в таблицу этой же полосой,
+ * а такие элементы совпадают у кодера и декодера.
+ *
+ * @param img Кодируемое изображение.
+ * @param chunk Полоса; поле `data` должно вмещать `QOI_MAX_OP_SIZE` байт на пиксель.
+ */
+static void encode_chunk(const struct image *img, struct qoi_chunk *chunk) {
+    uint32_t index[64];
+    memset(index, 0, sizeof(index));
+
+    const struct pixel *px = image_pixel(img, 0, chunk->first_row);
+    const struct pixel *end = px + chunk->rows * img->width;
+    struct pixel prev = chunk->first_row > 0 ? px[-1] : (struct pixel) {0, 0, 0};
+    uint32_t prev_packed = qoi_pack(prev);
+    uint8_t *out = chunk->data;
+    uint32_t run = 0;
+
+    for (; px < end; px++) {
+        struct pixel cur = *px;
+        uint32_t packed = qoi_pack(cur);
+        if (packed == prev_packed) {
+            if (++run == QOI_MAX_RUN) {
+                *out++ = (uint8_t) (QOI_OP_RUN | (run - 1));
+                run = 0;
+            }
+            continue;
+        }
+        if (run > 0) {
+            *out++ = (uint8_t) (QOI_OP_RUN | (run - 1));
+            run = 0;
+        }
+
+        uint32_t slot = qoi_hash(cur);
+        if (index[slot] == packed) {
+            *out++ = (uint8_t) (QOI_OP_INDEX | slot);
+        } else {
+            index[slot] = packed;
+
+            int8_t vr = (int8_t) (cur.r - prev.r);
+            int8_t vg = (int8_t) (cur.g - prev.g);
+            int8_t vb = (int8_t) (cur.b - prev.b);
+            int8_t vg_r = (int8_t) (vr - vg);
+            int8_t vg_b = (int8_t) (vb - vg);
+
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+                *out++ = (uint8_t) (QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2));
+            } else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+                *out++ = (uint8_t) (QOI_OP_LUMA | (vg + 32));
+                *out++ = (uint8_t) ((vg_r + 8) << 4 | (vg_b + 8));
+            } else {
+                *out++ = QOI_OP_RGB;
+                *out++ = cur.r;
+                *out++ = cur.g;
+                *out++ = cur.b;
+            }
+        }
+        prev = cur;
+        prev_packed = packed;
+    }
+    if (run > 0) {
+        *out++ = (uint8_t) (QOI_OP_RUN | (run - 1));
+    }
+    chunk->size = (uint64_t) (out - chunk->data);
+}
+
+/**
+ * @brief Кодирует полосы с номерами `[begin, end)`; вызывается из пула потоков.
+ */
+static void encode_chunks(void *ctx, uint64_t begin, uint64_t end) {
+    struct qoi_job *job = ctx;
+    for (uint64_t i = begin; i < end; i++) {
+        encode_chunk(job->img, &job->chunks[i]);
+    }
+}
+
+/**
+ * @brief Читает 32-битное число в порядке байтов от старшего к младшему.
+ */
+static uint32_t get_u32_be(const uint8_t *in) {
+    return (uint32_t) in[0] << 24 | (uint32_t) in[1] << 16 | (uint32_t) in[2] << 8 | in[3];
+}
+
+/**
+ * @brief Проверяет, начинается ли файл с сигнатуры QOI.
+ *
+ * @param magic Первые байты файла.
+ * @param size Количество байт.
+ * @return 1, если сигнатура распознана, иначе 0.
+ */
+int qoi_sniff(const uint8_t *magic, size_t size) {
+    return size >= 4 && memcmp(magic, "qoif", 4) == 0;
+}
+
+/**
+ * @brief Дочитывает и проверяет заголовок QOI, первые байты которого уже прочитаны.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param prefix Уже прочитанные первые байты файла.
+ * @param prefix_size Количество уже прочитанных байт.
+ * @param header Указатель на структуру, в которую будет записан заголовок.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_SIGNATURE`, и т.д.).
+ */
+enum read_status qoi_read_header(FILE *in, const uint8_t *prefix, size_t prefix_size, struct qoi_header *header) {
+    if (!in || !header || prefix_size > QOI_HEADER_SIZE) return READ_INVALID_HEADER;
+
+    uint8_t bytes[QOI_HEADER_SIZE];
+    if (prefix_size > 0) {
+        memcpy(bytes, prefix, prefix_size);
+    }
+    if (fread(bytes + prefix_size, QOI_HEADER_SIZE - prefix_size, 1, in) != 1)
+        return READ_IO_ERROR;
+
+    if (!qoi_sniff(bytes, sizeof(bytes)))
+        return READ_INVALID_SIGNATURE;
+
+    header->width = get_u32_be(bytes + 4);
+    header->height = get_u32_be(bytes + 8);
+    header->channels = bytes[12];
+    header->colorspace = bytes[13];
+    if (header->channels != 3 && header->channels != 4)
+        return READ_INVALID_BITS;
+
+    if (header->width == 0 || header->height == 0 || header->colorspace > 1)
+        return READ_INVALID_HEADER;
+
+    // Одна команда повтора кодирует не больше QOI_MAX_RUN пикселей, поэтому короткий файл
+    // не может содержать изображение заявленного размера и отклоняется до выделения памяти
+    uint64_t file_size = raster_file_size(in);
+    uint64_t pixels = header->width * header->height;
+    if (file_size != UINT64_MAX
+        && (file_size < QOI_HEADER_SIZE || (pixels + QOI_MAX_RUN - 1) / QOI_MAX_RUN > file_size - QOI_HEADER_SIZE))
+        return READ_INVALID_HEADER;
+
+    return READ_OK;
+}
+
+/**
+ * @brief Возвращает следующий байт закодированного потока, при необходимости дочитывая буфер.
+ *
+ * За концом файла возвращает 0 и выставляет признак ошибки, который проверяется после каждой строки.
+ */
+static inline uint8_t qoi_next(struct qoi_input *input) {
+    if (input->pos == input->size) {
+        input->size = fread(input->buffer, 1, QOI_READ_BUFFER, input->in);
+        input->pos = 0;
+        if (input->size == 0) {
+            input->failed = 1;
+            return 0;
+        }
+    }
+    return input->buffer[input->pos++];
+}
+
+/**
+ * @brief Декодирует изображение QOI и передает обработчику строки заданной области.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param header Указатель на прочитанный заголовок.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status qoi_read_region(FILE *in, const struct qoi_header *header, const struct image_rect *region,
+                                 image_row_handler handler, void *ctx) {
+    if (!in || !header || !region || !handler) return READ_INVALID_HEADER;
+
+    if (!image_rect_fits(region, header->width, header->height))
+        return READ_INVALID_REGION;
+
+    struct pixel *row = malloc(header->width * sizeof(struct pixel));
+    uint8_t *buffer = malloc(QOI_READ_BUFFER);
+    if (!row || !buffer) {
+        free(row);
+        free(buffer);
+        return READ_MEMORY_ERROR;
+    }
+
+    struct qoi_input input = {in, buffer, 0, 0, 0};
+    struct qoi_rgba index[64];
+    struct qoi_rgba px = {0, 0, 0, 255};
+    uint32_t run = 0;
+    memset(index, 0, sizeof(index));
+
+    enum read_status status = READ_OK;
+    uint64_t last_row = region->y + region->height;
+    for (uint64_t y = 0; y < last_row && status == READ_OK; y++) {
+        for (uint64_t x = 0; x < header->width; x++) {
+            if (run > 0) {
+                run--;
+            } else {
+                uint8_t op = qoi_next(&input);
+                if (op == QOI_OP_RGB) {
+                    px.r = qoi_next(&input);
+                    px.g = qoi_next(&input);
+                    px.b = qoi_next(&input);
+                } else if (op == QOI_OP_RGBA) {
+                    px.r = qoi_next(&input);
+                    px.g = qoi_next(&input);
+                    px.b = qoi_next(&input);
+                    px.a = qoi_next(&input);
+                } else if ((op & QOI_MASK_2) == QOI_OP_INDEX) {
+                    px = index[op];
+                } else if ((op & QOI_MASK_2) == QOI_OP_DIFF) {
+                    px.r = (uint8_t) (px.r + ((op >> 4) & 3) - 2);
+                    px.g = (uint8_t) (px.g + ((op >> 2) & 3) - 2);
+                    px.b = (uint8_t) (px.b + (op & 3) - 2);
+                } else if ((op & QOI_MASK_2) == QOI_OP_LUMA) {
+                    uint8_t next = qoi_next(&input);
+                    int vg = (op & 0x3f) - 32;
+                    px.r = (uint8_t) (px.r + vg - 8 + ((next >> 4) & 0x0f));
+                    px.g = (uint8_t) (px.g + vg);
+                    px.b = (uint8_t) (px.b + vg - 8 + (next & 0x0f));
+                } else {
+                    run = op & 0x3f;
+                }
+                index[(px.r * 3u + px.g * 5u + px.b * 7u + px.a * 11u) % 64u] = px;
+            }
+            row[x].r = px.r;
+            row[x].g = px.g;
+            row[x].b = px.b;
+        }
+        if (input.failed) {
+            status = READ_IO_ERROR;
+        } else if (y >= region->y && handler(ctx, y - region->y, row + region->x) != 0) {
+            status = READ_IO_ERROR;
+        }
+    }
+
+    free(row);
+    free(buffer);
+    return status;
+}
+
+/**
+ * @brief Записывает изображение в формате QOI.
+ *
+ * @param out Указатель на файл для записи.
+ * @param img Указатель на структуру `image` для записи.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status qoi_to_file(FILE *out, const struct image *img) {
+    if (!out) {
+        return WRITE_FILE_POINTER_NULL;
+    }
+    if (!img) {
+        return WRITE_IMAGE_POINTER_NULL;
+    }
+    if (img->width == 0 || img->height == 0 || img->width > UINT32_MAX || img->height > UINT32_MAX) {
+        return WRITE_IMAGE_TOO_LARGE;
+    }
+
+    uint8_t header[QOI_HEADER_SIZE] = {'q', 'o', 'i', 'f'};
+    put_u32_be(header + 4, (uint32_t) img->width);
+    put_u32_be(header + 8, (uint32_t) img->height);
+    header[12] = 3;                  // Каналы: RGB
+    header[13] = 0;                  // Цветовое пространство: sRGB с линейной альфой
+    if (fwrite(header, 1, sizeof(header), out) != sizeof(header)) {
+        return WRITE_HEADER_ERROR;
+    }
+
+    // Полосы кодируются группами, чтобы буферы занимали память пропорционально числу потоков, а не изображению
+    uint64_t rows_per_chunk = img->width >= QOI_CHUNK_PIXELS ? 1 : QOI_CHUNK_PIXELS / img->width;
+    uint64_t group = (uint64_t) parallel_thread_count() * QOI_CHUNKS_PER_THREAD;
+    uint64_t capacity = rows_per_chunk * img->width * QOI_MAX_OP_SIZE;
+    struct qoi_chunk *chunks = calloc(group, sizeof(struct qoi_chunk));
+    if (!chunks) {
+        return WRITE_ROW_ERROR;
+    }
+    enum write_status status = WRITE_OK;
+    for (uint64_t i = 0; i < group && status == WRITE_OK; i++) {
+        chunks[i].data = malloc(capacity);
+        if (!chunks[i].data) {
+            status = WRITE_ROW_ERROR;
+        }
+    }
+
+    for (uint64_t row = 0; row < img->height && status == WRITE_OK;) {
+        uint64_t count = 0;
+        for (; count < group && row < img->height; count++) {
+            chunks[count].first_row = row;
+            chunks[count].rows = img->height - row > rows_per_chunk ? rows_per_chunk : img->height - row;
+            row += chunks[count].rows;
+        }
+
+        struct qoi_job job = {img, chunks};
+        parallel_for(count, 1, encode_chunks, &job);
+
+        for (uint64_t i = 0; i < count && status == WRITE_OK; i++) {
+            if (fwrite(chunks[i].data, 1, chunks[i].size, out) != chunks[i].size) {
+                status = WRITE_ROW_ERROR;
+            }
+        }
+    }
+
+    for (uint64_t i = 0; i < group; i++) {
+        free(chunks[i].data);
+    }
+    free(chunks);
+
+    static const uint8_t end_marker[QOI_END_MARKER_SIZE] = {0, 0, 0, 0, 0, 0, 0, 1};
+    if (status == WRITE_OK && fwrite(end_marker, 1, sizeof(end_marker), out) != sizeof(end_marker)) {
+        status = WRITE_ROW_ERROR;
+    }
+    return status;
+}
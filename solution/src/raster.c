@@ -0,0 +1,203 @@
+#include "raster.h"
+#include <stdlib.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Читает блок данных из файла по заданному смещению.
+ *
+ * Использует позиционное чтение, которое не зависит от текущей позиции потока и не требует
+ * последовательного прохода по пропускаемым данным.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param buffer Буфер для хранения прочитанных данных.
+ * @param size Количество байт для чтения.
+ * @param offset Смещение от начала файла в байтах.
+ * @return 0, если чтение прошло успешно, или -1 в случае ошибки.
+ */
+static int read_at(FILE *in, uint8_t *buffer, uint64_t size, uint64_t offset) {
+#ifdef _WIN32
+    if (fseek(in, (long) offset, SEEK_SET) != 0 || fread(buffer, 1, size, in) != size) {
+        return -1;
+    }
+    return 0;
+#else
+    int fd = fileno(in);
+    while (size > 0) {
+        ssize_t n = pread(fd, buffer, size, (off_t) offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        buffer += n;
+        size -= (uint64_t) n;
+        offset += (uint64_t) n;
+    }
+    return 0;
+#endif
+}
+
+/**
+ * @brief Проверяет, поддерживает ли файл позиционное чтение.
+ *
+ * Каналы, сокеты и терминалы (например, стандартный ввод в конвейере) читаются только последовательно.
+ *
+ * @param in Указатель на файл для чтения.
+ * @return 1, если файл допускает чтение по смещению, иначе 0.
+ */
+static int is_seekable(FILE *in) {
+#ifdef _WIN32
+    return fseek(in, 0, SEEK_CUR) == 0;
+#else
+    return lseek(fileno(in), 0, SEEK_CUR) >= 0;
+#endif
+}
+
+/**
+ * @brief Пропускает заданное количество байт последовательного потока, читая их.
+ *
+ * @param in Указатель на файл для чтения.
+ * @param buffer Вспомогательный буфер.
+ * @param buffer_size Размер вспомогательного буфера в байтах (больше 0).
+ * @param size Количество пропускаемых байт.
+ * @return 0, если данные пропущены, или -1 в случае ошибки.
+ */
+static int skip_forward(FILE *in, uint8_t *buffer, uint64_t buffer_size, uint64_t size) {
+    while (size > 0) {
+        uint64_t chunk = size < buffer_size ? size : buffer_size;
+        if (fread(buffer, 1, chunk, in) != chunk) {
+            return -1;
+        }
+        size -= chunk;
+    }
+    return 0;
+}
+
+/**
+ * @brief Возвращает размер обычного файла, не читая его.
+ *
+ * @param in Указатель на файл.
+ * @return Размер файла в байтах или `UINT64_MAX`, если размер заранее неизвестен.
+ */
+uint64_t raster_file_size(FILE *in) {
+#ifdef _WIN32
+    (void) in;
+    return UINT64_MAX;
+#else
+    struct stat info;
+    if (!in || fstat(fileno(in), &info) != 0 || !S_ISREG(info.st_mode) || info.st_size < 0) {
+        return UINT64_MAX;
+    }
+    return (uint64_t) info.st_size;
+#endif
+}
+
+/**
+ * @brief Проверяет, что все строки изображения помещаются в файл.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param layout Указатель на расположение строк в файле.
+ * @return `READ_OK` или `READ_INVALID_HEADER`, если данные изображения выходят за конец файла.
+ */
+enum read_status raster_check_size(FILE *in, const struct raster_layout *layout) {
+    if (!in || !layout || layout->width == 0 || layout->height == 0 || layout->pixel_size == 0)
+        return READ_INVALID_HEADER;
+
+    uint64_t file_size = raster_file_size(in);
+    if (file_size == UINT64_MAX) {
+        return READ_OK;
+    }
+    // Конец последней строки: смещение данных, шаг строк до нее и сами пиксели без выравнивания
+    if (layout->data_offset > file_size || layout->width > (file_size - layout->data_offset) / layout->pixel_size) {
+        return READ_INVALID_HEADER;
+    }
+    uint64_t available = file_size - layout->data_offset - layout->width * layout->pixel_size;
+    if (layout->row_stride != 0 && layout->height - 1 > available / layout->row_stride) {
+        return READ_INVALID_HEADER;
+    }
+    return READ_OK;
+}
+
+/**
+ * @brief Возвращает номер строки изображения для строки файла с заданным номером.
+ */
+static uint64_t raster_image_row(const struct raster_layout *layout, uint64_t file_row) {
+    return layout->bottom_up ? layout->height - 1 - file_row : file_row;
+}
+
+/**
+ * @brief Читает строки заданной области и передает их обработчику.
+ *
+ * @param in Указатель на файл, заголовок которого уже прочитан.
+ * @param layout Указатель на расположение строк в файле.
+ * @param region Указатель на читаемую область изображения.
+ * @param handler Обработчик, получающий строки области.
+ * @param ctx Контекст, передаваемый обработчику.
+ * @return Статус чтения (`READ_OK`, `READ_IO_ERROR`, `READ_INVALID_REGION`, и т.д.).
+ */
+enum read_status raster_read_region(FILE *in, const struct raster_layout *layout, const struct image_rect *region,
+                                    image_row_handler handler, void *ctx) {
+    if (!in || !layout || !region || !handler) return READ_INVALID_HEADER;
+
+    if (!image_rect_fits(region, layout->width, layout->height))
+        return READ_INVALID_REGION;
+
+    int seekable = is_seekable(in);
+    if (!seekable && layout->data_offset < layout->position) {
+        return READ_IO_ERROR;
+    }
+
+    // Последовательно читается начало строки до правого края области, позиционно - только сама область
+    uint64_t skipped = seekable ? region->x * layout->pixel_size : 0;
+    uint64_t read_size = (region->x + region->width) * layout->pixel_size - skipped;
+    uint64_t buffer_size = seekable ? read_size : layout->row_stride;
+    uint8_t *raw = malloc(buffer_size);
+    struct pixel *pixels = layout->convert ? malloc(region->width * sizeof(struct pixel)) : NULL;
+    if (!raw || (layout->convert && !pixels)) {
+        free(raw);
+        free(pixels);
+        return READ_MEMORY_ERROR;
+    }
+
+    uint64_t first_row = layout->bottom_up ? layout->height - (region->y + region->height) : region->y;
+    uint64_t position = layout->data_offset + first_row * layout->row_stride;
+    enum read_status status = READ_OK;
+    if (!seekable && skip_forward(in, raw, buffer_size, position - layout->position) != 0) {
+        status = READ_IO_ERROR;
+    }
+
+    for (uint64_t i = 0; status == READ_OK && i < region->height; i++) {
+        uint64_t y = raster_image_row(layout, first_row + i) - region->y;
+        int failed;
+        if (seekable) {
+            failed = read_at(in, raw, read_size, position + skipped) != 0;
+        } else {
+            failed = (i > 0 && skip_forward(in, raw, buffer_size, layout->row_stride - read_size) != 0)
+                     || fread(raw, 1, read_size, in) != read_size;
+        }
+        if (failed) {
+            status = READ_IO_ERROR;
+            break;
+        }
+
+        const uint8_t *start = raw + (read_size - region->width * layout->pixel_size);
+        const struct pixel *row = (const struct pixel *) start;
+        if (layout->convert) {
+            layout->convert(layout->convert_ctx, pixels, start, region->width);
+            row = pixels;
+        }
+        if (handler(ctx, y, row) != 0) {
+            status = READ_IO_ERROR;
+        }
+        position += layout->row_stride;
+    }
+
+    free(raw);
+    free(pixels);
+    return status;
+}
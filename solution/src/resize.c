@@ -0,0 +1,465 @@
+#include "resize.h"
+#include "parallel.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define RESIZE_PRECISION_BITS 22     // Число дробных бит весов фильтра в фиксированной точке
+#define RESIZE_ROWS_PER_TASK 16      // Количество строк, обрабатываемых одной порцией пула потоков
+
+static const char *const resize_filter_names[RESIZE_FILTER_COUNT] = {"box", "bilinear", "lanczos"};
+
+/**
+ * @brief Веса фильтра вдоль одной оси: для каждого пикселя результата - диапазон источника и веса.
+ */
+struct resample_axis {
+    uint64_t size;           // Количество пикселей результата вдоль оси
+    uint64_t taps;           // Максимальное количество весов на пиксель результата
+    uint64_t *first;         // Первый пиксель источника для каждого пикселя результата
+    uint64_t *count;         // Количество пикселей источника для каждого пикселя результата
+    int32_t *weights;        // Веса, по `taps` на каждый пиксель результата
+};
+
+/**
+ * @brief Находит фильтр по его имени.
+ *
+ * @param name Имя фильтра.
+ * @param filter Указатель, по которому будет записан найденный фильтр.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int resize_filter_from_name(const char *name, enum resize_filter *filter) {
+    for (int i = 0; i < RESIZE_FILTER_COUNT; i++) {
+        if (strcmp(name, resize_filter_names[i]) == 0) {
+            *filter = (enum resize_filter) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Возвращает имя фильтра.
+ *
+ * @param filter Фильтр.
+ * @return Имя фильтра или "unknown" для некорректного значения.
+ */
+const char *resize_filter_name(enum resize_filter filter) {
+    if ((unsigned) filter >= RESIZE_FILTER_COUNT) {
+        return "unknown";
+    }
+    return resize_filter_names[filter];
+}
+
+/**
+ * @brief Нормированный синус `sin(pi x) / (pi x)`.
+ */
+static double sinc(double x) {
+    if (x == 0.0) {
+        return 1.0;
+    }
+    x *= M_PI;
+    return sin(x) / x;
+}
+
+/**
+ * @brief Возвращает радиус фильтра в пикселях источника при увеличении.
+ */
+static double filter_support(enum resize_filter filter) {
+    switch (filter) {
+        case RESIZE_FILTER_BILINEAR:
+            return 1.0;
+        case RESIZE_FILTER_LANCZOS3:
+            return 3.0;
+        case RESIZE_FILTER_BOX:
+        default:
+            return 0.5;
+    }
+}
+
+/**
+ * @brief Вычисляет значение ядра фильтра в точке `x`.
+ */
+static double filter_value(enum resize_filter filter, double x) {
+    switch (filter) {
+        case RESIZE_FILTER_BILINEAR:
+            x = fabs(x);
+            return x < 1.0 ? 1.0 - x : 0.0;
+        case RESIZE_FILTER_LANCZOS3:
+            return (x > -3.0 && x < 3.0) ? sinc(x) * sinc(x / 3.0) : 0.0;
+        case RESIZE_FILTER_BOX:
+        default:
+            return (x > -0.5 && x <= 0.5) ? 1.0 : 0.0;
+    }
+}
+
+/**
+ * @brief Освобождает память весов оси.
+ */
+static void resample_axis_destroy(struct resample_axis *axis) {
+    free(axis->first);
+    free(axis->count);
+    free(axis->weights);
+    axis->first = NULL;
+    axis->count = NULL;
+    axis->weights = NULL;
+}
+
+/**
+ * @brief Вычисляет веса фильтра вдоль оси.
+ *
+ * При уменьшении ядро растягивается на коэффициент уменьшения, поэтому каждый пиксель результата
+ * усредняет всю покрываемую им область источника. Веса нормируются и переводятся в фиксированную точку.
+ *
+ * @param axis Указатель на заполняемую структуру.
+ * @param in_size Размер источника вдоль оси.
+ * @param out_size Размер результата вдоль оси.
+ * @param filter Фильтр пересчета.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+static int resample_axis_init(struct resample_axis *axis, uint64_t in_size, uint64_t out_size, enum resize_filter filter) {
+    double scale = (double) in_size / (double) out_size;
+    double filter_scale = scale < 1.0 ? 1.0 : scale;
+    double support = filter_support(filter) * filter_scale;
+
+    axis->size = out_size;
+    axis->taps = (uint64_t) ceil(support) * 2 + 1;
+    axis->first = malloc(out_size * sizeof(uint64_t));
+    axis->count = malloc(out_size * sizeof(uint64_t));
+    axis->weights = calloc(out_size * axis->taps, sizeof(int32_t));
+    double *kernel = malloc(axis->taps * sizeof(double));
+    if (!axis->first || !axis->count || !axis->weights || !kernel) {
+        free(kernel);
+        resample_axis_destroy(axis);
+        return 1;
+    }
+
+    for (uint64_t i = 0; i < out_size; i++) {
+        double center = ((double) i + 0.5) * scale;
+        double low = center - support + 0.5;
+        double high = center + support + 0.5;
+        uint64_t first = low > 0.0 ? (uint64_t) low : 0;
+        uint64_t last = high < (double) in_size ? (uint64_t) high : in_size;
+        if (last > first + axis->taps) {
+            last = first + axis->taps;
+        }
+        if (last <= first) {
+            // Ядро не покрыло ни одного пикселя: берем ближайший
+            first = center < (double) in_size ? (uint64_t) center : in_size - 1;
+            last = first + 1;
+        }
+
+        double total = 0.0;
+        for (uint64_t k = 0; k < last - first; k++) {
+            kernel[k] = filter_value(filter, ((double) (first + k) - center + 0.5) / filter_scale);
+            total += kernel[k];
+        }
+
+        int32_t *weights = axis->weights + i * axis->taps;
+        for (uint64_t k = 0; k < last - first; k++) {
+            double weight = total != 0.0 ? kernel[k] / total : 1.0 / (double) (last - first);
+            weights[k] = (int32_t) lround(weight * (double) (1 << RESIZE_PRECISION_BITS));
+        }
+        axis->first[i] = first;
+        axis->count[i] = last - first;
+    }
+
+    free(kernel);
+    return 0;
+}
+
+/**
+ * @brief Переводит накопленную сумму в фиксированной точке в значение канала с насыщением.
+ */
+static inline uint8_t clamp_channel(int32_t value) {
+    value = (value + (1 << (RESIZE_PRECISION_BITS - 1))) >> RESIZE_PRECISION_BITS;
+    if (value < 0) {
+        return 0;
+    }
+    return value > 255 ? 255 : (uint8_t) value;
+}
+
+/**
+ * @brief Параметры двухпроходного пересчета, общие для всех потоков.
+ */
+struct resample_job {
+    const struct image *source;      // Исходное изображение
+    struct resample_axis horizontal; // Веса по горизонтали
+    struct resample_axis vertical;   // Веса по вертикали
+    struct pixel *temp;              // Промежуточный результат горизонтального прохода
+    uint64_t temp_width;             // Ширина промежуточного результата
+    uint64_t temp_first;             // Первая строка источника, участвующая в пересчете
+    struct image *dest;              // Изображение-результат
+    struct orientation_map map;      // Отображение строк результата с учетом ориентации
+    int failed;                      // Признак того, что потоку не хватило памяти
+};
+
+/**
+ * @brief Горизонтальный проход: пересчитывает строки источника `[begin, end)` в промежуточный буфер.
+ *
+ * @param ctx Указатель на `struct resample_job`.
+ * @param begin Номер первой строки относительно `temp_first`.
+ * @param end Номер строки, следующей за последней.
+ */
+static void resample_rows(void *ctx, uint64_t begin, uint64_t end) {
+    const struct resample_job *job = ctx;
+    const struct resample_axis *axis = &job->horizontal;
+
+    for (uint64_t row = begin; row < end; row++) {
+        const struct pixel *src = image_pixel(job->source, 0, job->temp_first + row);
+        struct pixel *dst = job->temp + row * job->temp_width;
+        for (uint64_t x = 0; x < axis->size; x++) {
+            const struct pixel *in = src + axis->first[x];
+            const int32_t *weights = axis->weights + x * axis->taps;
+            int32_t r = 0, g = 0, b = 0;
+            for (uint64_t k = 0; k < axis->count[x]; k++) {
+                r += weights[k] * in[k].r;
+                g += weights[k] * in[k].g;
+                b += weights[k] * in[k].b;
+            }
+            dst[x].r = clamp_channel(r);
+            dst[x].g = clamp_channel(g);
+            dst[x].b = clamp_channel(b);
+        }
+    }
+}
+
+/**
+ * @brief Вертикальный проход: вычисляет строки результата `[begin, end)` и записывает их с учетом ориентации.
+ *
+ * Внутренний цикл идет по непрерывному массиву каналов строки, что позволяет компилятору векторизовать его.
+ *
+ * @param ctx Указатель на `struct resample_job`.
+ * @param begin Номер первой строки результата.
+ * @param end Номер строки, следующей за последней.
+ */
+static void resample_columns(void *ctx, uint64_t begin, uint64_t end) {
+    struct resample_job *job = ctx;
+    const struct resample_axis *axis = &job->vertical;
+    uint64_t channels = job->temp_width * sizeof(struct pixel);
+
+    int32_t *acc = malloc(channels * sizeof(int32_t));
+    struct pixel *row = malloc(job->temp_width * sizeof(struct pixel));
+    if (!acc || !row) {
+        free(acc);
+        free(row);
+        job->failed = 1;
+        return;
+    }
+
+    for (uint64_t y = begin; y < end; y++) {
+        const int32_t *weights = axis->weights + y * axis->taps;
+        memset(acc, 0, channels * sizeof(int32_t));
+        for (uint64_t k = 0; k < axis->count[y]; k++) {
+            const uint8_t *in = (const uint8_t *) (job->temp + (axis->first[y] + k - job->temp_first) * job->temp_width);
+            int32_t weight = weights[k];
+            for (uint64_t c = 0; c < channels; c++) {
+                acc[c] += weight * in[c];
+            }
+        }
+        uint8_t *out = (uint8_t *) row;
+        for (uint64_t c = 0; c < channels; c++) {
+            out[c] = clamp_channel(acc[c]);
+        }
+        orient_row(job->dest, &job->map, y, row, job->temp_width);
+    }
+
+    free(acc);
+    free(row);
+}
+
+/**
+ * @brief Изменяет размер изображения и одновременно приводит его к заданной ориентации.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param width Ширина результата (после смены ориентации) в пикселях.
+ * @param height Высота результата (после смены ориентации) в пикселях.
+ * @param filter Фильтр пересчета.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. Если параметры некорректны или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image resize_oriented_image(const struct image *source, uint64_t width, uint64_t height,
+                                   enum resize_filter filter, enum orientation orientation) {
+    struct image result = {0};
+    if (source == NULL || source->data == NULL || width == 0 || height == 0
+        || (unsigned) filter >= RESIZE_FILTER_COUNT || (unsigned) orientation >= ORIENTATION_COUNT) {
+        return result;
+    }
+
+    // Размер до смены ориентации
+    uint64_t out_width = orientation_swaps_axes(orientation) ? height : width;
+    uint64_t out_height = orientation_swaps_axes(orientation) ? width : height;
+
+    struct resample_job job = {0};
+    job.source = source;
+    if (resample_axis_init(&job.horizontal, source->width, out_width, filter) != 0) {
+        return result;
+    }
+    if (resample_axis_init(&job.vertical, source->height, out_height, filter) != 0) {
+        resample_axis_destroy(&job.horizontal);
+        return result;
+    }
+
+    // Горизонтальный проход нужен только для строк, которые использует вертикальный
+    uint64_t last = job.vertical.first[out_height - 1] + job.vertical.count[out_height - 1];
+    job.temp_first = job.vertical.first[0];
+    job.temp_width = out_width;
+    job.temp = malloc((last - job.temp_first) * out_width * sizeof(struct pixel));
+    result = create_image_uninit(width, height);
+
+    if (job.temp && result.data) {
+        job.dest = &result;
+        orientation_map_init(&job.map, orientation, out_width, out_height);
+        parallel_for(last - job.temp_first, RESIZE_ROWS_PER_TASK, resample_rows, &job);
+        parallel_for(out_height, RESIZE_ROWS_PER_TASK, resample_columns, &job);
+    }
+    if (!job.temp || job.failed) {
+        destroy_image(&result);
+    }
+
+    free(job.temp);
+    resample_axis_destroy(&job.horizontal);
+    resample_axis_destroy(&job.vertical);
+    return result;
+}
+
+/**
+ * @brief Изменяет размер изображения.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param width Ширина результата в пикселях.
+ * @param height Высота результата в пикселях.
+ * @param filter Фильтр пересчета.
+ * @return Новая структура `image`. При ошибке поле `data` равно NULL.
+ */
+struct image resize_image(const struct image *source, uint64_t width, uint64_t height, enum resize_filter filter) {
+    return resize_oriented_image(source, width, height, filter, ORIENTATION_NONE);
+}
+
+/**
+ * @brief Вычисляет размер изображения после уменьшения в целое число раз.
+ *
+ * @param size Размер источника в пикселях.
+ * @param factor Коэффициент уменьшения.
+ * @return Размер результата в пикселях.
+ */
+uint64_t shrink_size(uint64_t size, uint64_t factor) {
+    return (size + factor - 1) / factor;
+}
+
+/**
+ * @brief Подготавливает уменьшение изображения во время чтения и выделяет память под результат.
+ *
+ * @param reader Указатель на состояние уменьшения.
+ * @param width Ширина источника в пикселях.
+ * @param height Высота источника в пикселях.
+ * @param factor Коэффициент уменьшения.
+ * @param orientation Ориентация результата.
+ * @param dest Указатель на структуру `image`, в которую будет записан результат.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int shrink_reader_init(struct shrink_reader *reader, uint64_t width, uint64_t height, uint64_t factor,
+                       enum orientation orientation, struct image *dest) {
+    uint64_t out_width = shrink_size(width, factor);
+    uint64_t out_height = shrink_size(height, factor);
+
+    reader->dest = dest;
+    reader->source_width = width;
+    reader->source_height = height;
+    reader->factor = factor;
+    reader->band = 0;
+    reader->band_rows = 0;
+    orientation_map_init(&reader->map, orientation, out_width, out_height);
+
+    *dest = create_image_uninit(reader->map.width, reader->map.height);
+    reader->sums = calloc(out_width * sizeof(struct pixel), sizeof(uint32_t));
+    reader->row = malloc(out_width * sizeof(struct pixel));
+    if (!dest->data || !reader->sums || !reader->row) {
+        shrink_reader_destroy(reader);
+        destroy_image(dest);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Усредняет накопленную полосу блоков и записывает ее как строку результата.
+ *
+ * @param reader Указатель на состояние уменьшения.
+ * @param rows Количество строк источника в полосе.
+ */
+static void shrink_emit_band(struct shrink_reader *reader, uint64_t rows) {
+    uint64_t out_width = shrink_size(reader->source_width, reader->factor);
+    uint8_t *out = (uint8_t *) reader->row;
+
+    for (uint64_t x = 0; x < out_width; x++) {
+        uint64_t columns = reader->source_width - x * reader->factor;
+        if (columns > reader->factor) {
+            columns = reader->factor;
+        }
+        uint32_t area = (uint32_t) (columns * rows);
+        for (uint64_t c = 0; c < sizeof(struct pixel); c++) {
+            uint32_t *sum = &reader->sums[x * sizeof(struct pixel) + c];
+            out[x * sizeof(struct pixel) + c] = (uint8_t) ((*sum + area / 2) / area);
+            *sum = 0;
+        }
+    }
+    orient_row(reader->dest, &reader->map, reader->band, reader->row, out_width);
+}
+
+/**
+ * @brief Обработчик строки источника для `image_row_handler`.
+ *
+ * @param ctx Указатель на `struct shrink_reader`.
+ * @param y Номер строки источника.
+ * @param row Пиксели строки источника.
+ * @return 0 при успехе или 1, если строки полосы поступили не подряд.
+ */
+int shrink_reader_row(void *ctx, uint64_t y, const struct pixel *row) {
+    struct shrink_reader *reader = ctx;
+    uint64_t band = y / reader->factor;
+
+    if (reader->band_rows == 0) {
+        reader->band = band;
+    } else if (band != reader->band) {
+        return 1;
+    }
+
+    const uint8_t *in = (const uint8_t *) row;
+    uint32_t *sums = reader->sums;
+    uint64_t block = reader->factor * sizeof(struct pixel);
+    for (uint64_t x = 0; x < reader->source_width * sizeof(struct pixel); x += block) {
+        uint64_t end = x + block < reader->source_width * sizeof(struct pixel) ? x + block : reader->source_width * sizeof(struct pixel);
+        uint32_t b0 = 0, b1 = 0, b2 = 0;
+        for (uint64_t i = x; i < end; i += sizeof(struct pixel)) {
+            b0 += in[i];
+            b1 += in[i + 1];
+            b2 += in[i + 2];
+        }
+        sums[0] += b0;
+        sums[1] += b1;
+        sums[2] += b2;
+        sums += sizeof(struct pixel);
+    }
+
+    uint64_t band_height = reader->source_height - band * reader->factor;
+    if (band_height > reader->factor) {
+        band_height = reader->factor;
+    }
+    if (++reader->band_rows == band_height) {
+        shrink_emit_band(reader, band_height);
+        reader->band_rows = 0;
+    }
+    return 0;
+}
+
+/**
+ * @brief Освобождает служебную память уменьшения.
+ *
+ * @param reader Указатель на состояние уменьшения.
+ */
+void shrink_reader_destroy(struct shrink_reader *reader) {
+    free(reader->sums);
+    free(reader->row);
+    reader->sums = NULL;
+    reader->row = NULL;
+}
@@ -0,0 +1,493 @@
+#include "scheduler.h"
+#include "parallel.h"
+#include <stdlib.h>
+
+#define SCHEDULER_DEQUE_INITIAL 16   // Начальная вместимость очереди билетов
+
+/**
+ * @brief Параллельный цикл задачи, разделенный на порции по `grain` элементов.
+ */
+struct scheduler_loop {
+    pthread_mutex_t lock;            // Защищает счетчики порций и билетов
+    parallel_range_fn fn;            // Функция обработки диапазона
+    void *ctx;                       // Контекст функции
+    uint64_t count;                  // Общее количество элементов
+    uint64_t grain;                  // Размер порции
+    uint64_t chunks;                 // Количество порций
+    uint64_t next;                   // Номер первой невыданной порции
+    uint64_t done;                   // Количество выполненных порций
+    unsigned tickets;                // Количество билетов цикла в очередях и в работе
+    unsigned priority;               // Приоритет задачи, которой принадлежит цикл
+};
+
+/**
+ * @brief Двусторонняя очередь билетов (указателей на циклы) в кольцевом буфере.
+ */
+struct ticket_deque {
+    struct scheduler_loop **items;   // Кольцевой буфер
+    size_t capacity;                 // Вместимость буфера
+    size_t first;                    // Индекс первого билета
+    size_t count;                    // Количество билетов
+};
+
+/**
+ * @brief Поток планировщика со своими очередями билетов по приоритетам.
+ */
+struct scheduler_worker {
+    struct scheduler *scheduler;     // Планировщик, которому принадлежит поток
+    pthread_t thread;                // Поток
+    unsigned index;                  // Номер потока
+    pthread_mutex_t lock;            // Защищает очереди билетов потока
+    struct ticket_deque deques[SCHEDULER_PRIORITIES]; // Билеты по приоритетам
+    unsigned priority;               // Приоритет выполняемой задачи
+    int in_chunk;                    // Признак выполнения порции: вложенные циклы выполняются на месте
+};
+
+/**
+ * @brief Сообщает ожидающим потокам о появлении работы или завершении.
+ */
+static void notify(struct scheduler *scheduler) {
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->version++;
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+/**
+ * @brief Возвращает текущий номер изменения планировщика.
+ */
+static uint64_t current_version(struct scheduler *scheduler) {
+    pthread_mutex_lock(&scheduler->lock);
+    uint64_t version = scheduler->version;
+    pthread_mutex_unlock(&scheduler->lock);
+    return version;
+}
+
+/**
+ * @brief Ждет, пока номер изменения не станет отличен от `version`.
+ */
+static void wait_for_work(struct scheduler *scheduler, uint64_t version) {
+    pthread_mutex_lock(&scheduler->lock);
+    while (scheduler->version == version) {
+        pthread_cond_wait(&scheduler->wake, &scheduler->lock);
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+/**
+ * @brief Кладет билет в конец очереди потока.
+ *
+ * @return 0 при успехе или 1, если не удалось расширить очередь.
+ */
+static int push_ticket(struct scheduler_worker *worker, struct scheduler_loop *loop) {
+    struct ticket_deque *deque = &worker->deques[loop->priority];
+    int status = 0;
+    pthread_mutex_lock(&worker->lock);
+    if (deque->count == deque->capacity) {
+        size_t capacity = deque->capacity ? deque->capacity * 2 : SCHEDULER_DEQUE_INITIAL;
+        struct scheduler_loop **items = malloc(capacity * sizeof(*items));
+        if (items) {
+            for (size_t i = 0; i < deque->count; i++) {
+                items[i] = deque->items[(deque->first + i) % deque->capacity];
+            }
+            free(deque->items);
+            deque->items = items;
+            deque->capacity = capacity;
+            deque->first = 0;
+        } else {
+            status = 1;
+        }
+    }
+    if (status == 0) {
+        deque->items[(deque->first + deque->count) % deque->capacity] = loop;
+        deque->count++;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return status;
+}
+
+/**
+ * @brief Забирает билет заданного приоритета из очереди потока.
+ *
+ * Владелец берет последний положенный билет (данные его цикла вероятнее в кэше),
+ * другие потоки перехватывают первый.
+ *
+ * @param worker Поток, из очереди которого забирается билет.
+ * @param priority Приоритет билета.
+ * @param back Признак того, что билет берется с конца очереди.
+ * @return Указатель на цикл билета или NULL, если очередь пуста.
+ */
+static struct scheduler_loop *pop_ticket(struct scheduler_worker *worker, unsigned priority, int back) {
+    struct ticket_deque *deque = &worker->deques[priority];
+    struct scheduler_loop *loop = NULL;
+    pthread_mutex_lock(&worker->lock);
+    if (deque->count > 0) {
+        if (back) {
+            loop = deque->items[(deque->first + deque->count - 1) % deque->capacity];
+        } else {
+            loop = deque->items[deque->first];
+            deque->first = (deque->first + 1) % deque->capacity;
+        }
+        deque->count--;
+    }
+    pthread_mutex_unlock(&worker->lock);
+    return loop;
+}
+
+/**
+ * @brief Перехватывает билет заданного приоритета у других потоков.
+ */
+static struct scheduler_loop *steal_ticket(struct scheduler_worker *worker, unsigned priority) {
+    struct scheduler *scheduler = worker->scheduler;
+    for (unsigned i = 1; i < scheduler->worker_count; i++) {
+        struct scheduler_worker *victim = &scheduler->workers[(worker->index + i) % scheduler->worker_count];
+        struct scheduler_loop *loop = pop_ticket(victim, priority, 0);
+        if (loop) {
+            return loop;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Выполняет порцию цикла с заданным номером.
+ */
+static void run_chunk(struct scheduler_worker *worker, struct scheduler_loop *loop, uint64_t chunk) {
+    uint64_t begin = chunk * loop->grain;
+    uint64_t end = loop->count - begin > loop->grain ? begin + loop->grain : loop->count;
+    worker->in_chunk = 1;
+    loop->fn(loop->ctx, begin, end);
+    worker->in_chunk = 0;
+}
+
+/**
+ * @brief Выполняет одну порцию цикла по билету.
+ *
+ * Если невыданные порции остались, билет возвращается в очередь текущего потока, иначе гасится.
+ * После погашения последнего билета цикл может быть уничтожен владельцем, поэтому к нему
+ * больше нет обращений.
+ */
+static void run_ticket(struct scheduler_worker *worker, struct scheduler_loop *loop) {
+    pthread_mutex_lock(&loop->lock);
+    int claimed = loop->next < loop->chunks;
+    uint64_t chunk = loop->next;
+    if (claimed) {
+        loop->next++;
+    } else {
+        loop->tickets--;
+    }
+    pthread_mutex_unlock(&loop->lock);
+
+    if (claimed) {
+        run_chunk(worker, loop, chunk);
+        pthread_mutex_lock(&loop->lock);
+        loop->done++;
+        int requeue = loop->next < loop->chunks;
+        pthread_mutex_unlock(&loop->lock);
+        if (requeue && push_ticket(worker, loop) != 0) {
+            requeue = 0;
+        }
+        if (!requeue) {
+            pthread_mutex_lock(&loop->lock);
+            loop->tickets--;
+            pthread_mutex_unlock(&loop->lock);
+        }
+    }
+    notify(worker->scheduler);
+}
+
+/**
+ * @brief Забирает из очереди первую задачу заданного приоритета, допустимую по памяти.
+ *
+ * Первая задача очереди допускается, если помещается в бюджет или других задач не выполняется;
+ * следующие - только если помещаются вместе с резервом первой, чтобы та не ждала бесконечно.
+ *
+ * @return Указатель на задачу или NULL, если допустимых задач нет.
+ */
+static struct scheduler_job *take_job(struct scheduler *scheduler, unsigned priority) {
+    pthread_mutex_lock(&scheduler->lock);
+    struct scheduler_job *previous = NULL;
+    struct scheduler_job *job = scheduler->head[priority];
+    uint64_t reserved = 0;
+    while (job) {
+        uint64_t used = scheduler->memory_used + reserved;
+        if (scheduler->memory_budget == 0 || used == 0
+            || (used <= scheduler->memory_budget && job->memory <= scheduler->memory_budget - used)) {
+            break;
+        }
+        if (!previous) {
+            reserved = job->memory;
+        }
+        previous = job;
+        job = job->next;
+    }
+    if (job) {
+        if (previous) {
+            previous->next = job->next;
+        } else {
+            scheduler->head[priority] = job->next;
+        }
+        if (scheduler->tail[priority] == job) {
+            scheduler->tail[priority] = previous;
+        }
+        scheduler->memory_used += job->memory;
+    }
+    pthread_mutex_unlock(&scheduler->lock);
+    return job;
+}
+
+/**
+ * @brief Выполняет задачу и возвращает ее память в бюджет.
+ */
+static void run_job(struct scheduler_worker *worker, struct scheduler_job *job) {
+    struct scheduler *scheduler = worker->scheduler;
+    uint64_t memory = job->memory;
+    worker->priority = job->priority;
+    job->run(job->ctx);
+
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->memory_used -= memory;
+    scheduler->finished++;
+    scheduler->version++;
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+/**
+ * @brief Выполняет самую приоритетную доступную работу.
+ *
+ * На каждом уровне приоритета, начиная с высшего, сначала берется новая задача (если разрешено),
+ * затем свой билет, затем билет другого потока.
+ *
+ * @param worker Текущий поток.
+ * @param jobs Признак того, что можно начинать новые задачи.
+ * @return 1, если работа выполнена, или 0, если работы нет.
+ */
+static int run_next(struct scheduler_worker *worker, int jobs) {
+    for (unsigned level = SCHEDULER_PRIORITIES; level-- > 0;) {
+        struct scheduler_job *job = jobs ? take_job(worker->scheduler, level) : NULL;
+        if (job) {
+            run_job(worker, job);
+            return 1;
+        }
+        struct scheduler_loop *loop = pop_ticket(worker, level, 1);
+        if (!loop) {
+            loop = steal_ticket(worker, level);
+        }
+        if (loop) {
+            run_ticket(worker, loop);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Выполняет параллельный цикл задачи порциями, которые могут перехватить другие потоки.
+ *
+ * Поток задачи раздает билеты, сам выполняет порции, а затем, пока помощники заканчивают свои,
+ * выполняет билеты любых циклов, но не берет новых задач.
+ */
+static void scheduler_for(void *executor, uint64_t count, uint64_t grain, parallel_range_fn fn, void *ctx) {
+    struct scheduler_worker *worker = executor;
+    struct scheduler *scheduler = worker->scheduler;
+    if (worker->in_chunk) {
+        fn(ctx, 0, count);
+        return;
+    }
+
+    struct scheduler_loop loop;
+    pthread_mutex_init(&loop.lock, NULL);
+    loop.fn = fn;
+    loop.ctx = ctx;
+    loop.count = count;
+    loop.grain = grain;
+    loop.chunks = (count + grain - 1) / grain;
+    loop.next = 0;
+    loop.done = 0;
+    loop.tickets = 0;
+    loop.priority = worker->priority;
+
+    uint64_t helpers = scheduler->worker_count - 1 < loop.chunks - 1 ? scheduler->worker_count - 1 : loop.chunks - 1;
+    for (uint64_t i = 0; i < helpers && push_ticket(worker, &loop) == 0; i++) {
+        loop.tickets++;
+    }
+    if (loop.tickets > 0) {
+        notify(scheduler);
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&loop.lock);
+        int claimed = loop.next < loop.chunks;
+        uint64_t chunk = loop.next;
+        if (claimed) {
+            loop.next++;
+        }
+        pthread_mutex_unlock(&loop.lock);
+        if (!claimed) {
+            break;
+        }
+        run_chunk(worker, &loop, chunk);
+        pthread_mutex_lock(&loop.lock);
+        loop.done++;
+        pthread_mutex_unlock(&loop.lock);
+    }
+
+    for (;;) {
+        uint64_t version = current_version(scheduler);
+        pthread_mutex_lock(&loop.lock);
+        int complete = loop.done == loop.chunks && loop.tickets == 0;
+        pthread_mutex_unlock(&loop.lock);
+        if (complete) {
+            break;
+        }
+        if (!run_next(worker, 0)) {
+            wait_for_work(scheduler, version);
+        }
+    }
+    pthread_mutex_destroy(&loop.lock);
+}
+
+/**
+ * @brief Основной цикл потока планировщика: выполняет работу, пока не выполнены все задачи.
+ *
+ * @param arg Указатель на `struct scheduler_worker`.
+ * @return NULL.
+ */
+static void *worker_main(void *arg) {
+    struct scheduler_worker *worker = arg;
+    struct scheduler *scheduler = worker->scheduler;
+    parallel_set_executor(scheduler_for, worker);
+    for (;;) {
+        pthread_mutex_lock(&scheduler->lock);
+        uint64_t version = scheduler->version;
+        int done = scheduler->closed && scheduler->finished == scheduler->submitted;
+        pthread_mutex_unlock(&scheduler->lock);
+        if (done) {
+            break;
+        }
+        if (!run_next(worker, 1)) {
+            wait_for_work(scheduler, version);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Освобождает очереди билетов потоков.
+ */
+static void destroy_workers(struct scheduler_worker *workers, unsigned count) {
+    for (unsigned i = 0; i < count; i++) {
+        for (int level = 0; level < SCHEDULER_PRIORITIES; level++) {
+            free(workers[i].deques[level].items);
+        }
+        pthread_mutex_destroy(&workers[i].lock);
+    }
+    free(workers);
+}
+
+/**
+ * @brief Запускает потоки планировщика.
+ *
+ * @param scheduler Указатель на планировщик.
+ * @param workers Количество потоков (0 - по `parallel_thread_count`).
+ * @param memory_budget Бюджет памяти задач в байтах (0 - без ограничения).
+ * @return 0 при успехе или 1 в случае ошибки.
+ */
+int scheduler_start(struct scheduler *scheduler, unsigned workers, uint64_t memory_budget) {
+    if (workers == 0) {
+        workers = parallel_thread_count();
+    }
+    if (workers > SCHEDULER_MAX_WORKERS) {
+        workers = SCHEDULER_MAX_WORKERS;
+    }
+    struct scheduler_worker *list = calloc(workers, sizeof(*list));
+    if (!list) {
+        return 1;
+    }
+
+    pthread_mutex_init(&scheduler->lock, NULL);
+    pthread_cond_init(&scheduler->wake, NULL);
+    scheduler->version = 0;
+    for (int level = 0; level < SCHEDULER_PRIORITIES; level++) {
+        scheduler->head[level] = NULL;
+        scheduler->tail[level] = NULL;
+    }
+    scheduler->memory_budget = memory_budget;
+    scheduler->memory_used = 0;
+    scheduler->submitted = 0;
+    scheduler->finished = 0;
+    scheduler->closed = 0;
+    scheduler->workers = list;
+    for (unsigned i = 0; i < workers; i++) {
+        list[i].scheduler = scheduler;
+        list[i].index = i;
+        pthread_mutex_init(&list[i].lock, NULL);
+    }
+
+    // Потоки ждут блокировку, пока не станет известно, сколько из них удалось запустить
+    pthread_mutex_lock(&scheduler->lock);
+    unsigned started = 0;
+    scheduler->worker_count = workers;
+    for (; started < workers; started++) {
+        if (pthread_create(&list[started].thread, NULL, worker_main, &list[started]) != 0) {
+            break;
+        }
+    }
+    for (unsigned i = started; i < workers; i++) {
+        pthread_mutex_destroy(&list[i].lock);
+    }
+    scheduler->worker_count = started;
+    pthread_mutex_unlock(&scheduler->lock);
+    if (started == 0) {
+        free(list);
+        pthread_cond_destroy(&scheduler->wake);
+        pthread_mutex_destroy(&scheduler->lock);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Ставит задачу в очередь ее приоритета.
+ *
+ * @param scheduler Указатель на запущенный планировщик.
+ * @param job Указатель на задачу.
+ */
+void scheduler_submit(struct scheduler *scheduler, struct scheduler_job *job) {
+    unsigned level = job->priority < SCHEDULER_PRIORITIES ? job->priority : SCHEDULER_PRIORITIES - 1;
+    job->priority = level;
+    job->next = NULL;
+    pthread_mutex_lock(&scheduler->lock);
+    if (scheduler->tail[level]) {
+        scheduler->tail[level]->next = job;
+    } else {
+        scheduler->head[level] = job;
+    }
+    scheduler->tail[level] = job;
+    scheduler->submitted++;
+    scheduler->version++;
+    pthread_cond_broadcast(&scheduler->wake);
+    pthread_mutex_unlock(&scheduler->lock);
+}
+
+/**
+ * @brief Дожидается выполнения всех поставленных задач, останавливает потоки и освобождает память.
+ *
+ * @param scheduler Указатель на запущенный планировщик.
+ */
+void scheduler_finish(struct scheduler *scheduler) {
+    pthread_mutex_lock(&scheduler->lock);
+    scheduler->closed = 1;
+    scheduler->version++;
+    pthread_cond_broadcast(&scheduler->wake);
+    unsigned count = scheduler->worker_count;
+    pthread_mutex_unlock(&scheduler->lock);
+
+    for (unsigned i = 0; i < count; i++) {
+        pthread_join(scheduler->workers[i].thread, NULL);
+    }
+    destroy_workers(scheduler->workers, count);
+    pthread_cond_destroy(&scheduler->wake);
+    pthread_mutex_destroy(&scheduler->lock);
+}
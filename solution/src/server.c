@@ -0,0 +1,307 @@
+#define _GNU_SOURCE
+#include "server.h"
+#include "image_io.h"
+#include "parallel.h"
+#include "pipeline.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SERVER_MAX_REQUEST 8192      // Максимальный размер запроса в байтах
+#define SERVER_MAX_ARGS 64           // Максимальное количество аргументов запроса
+#define SERVER_MAX_FDS 8             // Максимальное количество дескрипторов, передаваемых с запросом
+#define SERVER_BACKLOG 128           // Длина очереди ожидающих соединений
+#define SERVER_FD_PATH_SIZE 32       // Размер буфера пути вида /proc/self/fd/N
+#define SERVER_MIN_BACKOFF_MS 10     // Первая пауза после нехватки ресурсов при приеме соединения
+#define SERVER_MAX_BACKOFF_MS 1000   // Наибольшая пауза после нехватки ресурсов
+
+/**
+ * @brief Запрос клиента вместе с переданными дескрипторами.
+ */
+struct server_request {
+    char buffer[SERVER_MAX_REQUEST + 1]; // Аргументы, разделенные нулевыми байтами
+    size_t length;                   // Длина запроса в байтах
+    int fds[SERVER_MAX_FDS];         // Переданные файловые дескрипторы
+    int fd_count;                    // Количество переданных дескрипторов
+};
+
+/**
+ * @brief Создает Unix-сокет и начинает принимать на нем соединения.
+ *
+ * Оставшийся от предыдущего запуска сокет с тем же путем удаляется.
+ *
+ * @param path Путь к сокету.
+ * @return Дескриптор слушающего сокета или -1 в случае ошибки.
+ */
+static int open_listener(const char *path) {
+    struct sockaddr_un address;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        fprintf(stderr, "Ошибка: слишком длинный путь к сокету '%s'\n", path);
+        return -1;
+    }
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+
+    struct stat info;
+    if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) {
+        unlink(path);
+    }
+
+    int listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (listener < 0) {
+        perror("Не удалось создать сокет");
+        return -1;
+    }
+    if (bind(listener, (const struct sockaddr *) &address, sizeof(address)) != 0
+        || listen(listener, SERVER_BACKLOG) != 0) {
+        perror("Не удалось открыть сокет для приема соединений");
+        close(listener);
+        return -1;
+    }
+    return listener;
+}
+
+/**
+ * @brief Закрывает дескрипторы, переданные с запросом.
+ */
+static void close_request_fds(struct server_request *request) {
+    for (int i = 0; i < request->fd_count; i++) {
+        close(request->fds[i]);
+    }
+    request->fd_count = 0;
+}
+
+/**
+ * @brief Принимает очередной запрос соединения.
+ *
+ * @param conn Дескриптор соединения.
+ * @param request Указатель на структуру для запроса.
+ * @return 1, если запрос принят; 0, если соединение закрыто или не читается; -1, если запрос не поместился в буфер.
+ */
+static int receive_request(int conn, struct server_request *request) {
+    union {
+        struct cmsghdr header;
+        char space[CMSG_SPACE(sizeof(int) * SERVER_MAX_FDS)];
+    } control;
+    struct iovec iov = {request->buffer, SERVER_MAX_REQUEST};
+    struct msghdr message = {0};
+    message.msg_iov = &iov;
+    message.msg_iovlen = 1;
+    message.msg_control = control.space;
+    message.msg_controllen = sizeof(control.space);
+
+    ssize_t received;
+    do {
+        received = recvmsg(conn, &message, MSG_CMSG_CLOEXEC);
+    } while (received < 0 && errno == EINTR);
+    if (received <= 0) {
+        return 0;
+    }
+
+    request->length = (size_t) received;
+    request->buffer[request->length] = '\0';
+    request->fd_count = 0;
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&message); cmsg; cmsg = CMSG_NXTHDR(&message, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+            continue;
+        }
+        size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        for (size_t i = 0; i < count; i++) {
+            int fd;
+            memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+            if (request->fd_count < SERVER_MAX_FDS) {
+                request->fds[request->fd_count++] = fd;
+            } else {
+                close(fd);
+            }
+        }
+    }
+    if (message.msg_flags & (MSG_TRUNC | MSG_CTRUNC)) {
+        close_request_fds(request);
+        return -1;
+    }
+    return 1;
+}
+
+/**
+ * @brief Заменяет путь вида `fd:N` путем к N-му переданному дескриптору.
+ *
+ * Файл открывается заново через /proc/self/fd, поэтому функции чтения и записи работают
+ * с переданным memfd так же, как с обычным файлом. Путь "-" отклоняется: иначе поток сервера
+ * читал бы стандартный ввод демона или писал бы изображение в его стандартный вывод.
+ *
+ * @param request Указатель на запрос.
+ * @param arg Путь из запроса.
+ * @param buffer Буфер для пути к дескриптору.
+ * @return Путь для открытия или NULL, если путь обозначает стандартный поток или дескриптора с таким номером нет.
+ */
+static const char *resolve_path(const struct server_request *request, const char *arg, char *buffer) {
+    if (image_path_is_stream(arg)) {
+        fprintf(stderr, "Ошибка: стандартные потоки недоступны в запросах к серверу\n");
+        return NULL;
+    }
+    if (strncmp(arg, "fd:", 3) != 0) {
+        return arg;
+    }
+    unsigned index;
+    int consumed = 0;
+    if (sscanf(arg + 3, "%u%n", &index, &consumed) != 1 || arg[3 + consumed] != '\0'
+        || index >= (unsigned) request->fd_count) {
+        fprintf(stderr, "Ошибка: в запросе нет дескриптора '%s'\n", arg);
+        return NULL;
+    }
+    snprintf(buffer, SERVER_FD_PATH_SIZE, "/proc/self/fd/%d", request->fds[index]);
+    return buffer;
+}
+
+/**
+ * @brief Выполняет один запрос.
+ *
+ * @param request Указатель на запрос.
+ * @return 0, если операции выполнены успешно, или 1 в случае ошибки.
+ */
+static int handle_request(struct server_request *request) {
+    char *argv[SERVER_MAX_ARGS];
+    int argc = 0;
+    for (size_t offset = 0; offset < request->length;) {
+        if (argc == SERVER_MAX_ARGS) {
+            fprintf(stderr, "Ошибка: в запросе больше %d аргументов\n", SERVER_MAX_ARGS);
+            return 1;
+        }
+        argv[argc++] = request->buffer + offset;
+        offset += strlen(request->buffer + offset) + 1;
+    }
+
+    struct pipeline pipeline;
+    pipeline_init(&pipeline);
+    int arg = 0;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        int parsed = pipeline_parse_option(&pipeline, argc, argv, &arg);
+        if (parsed < 0) {
+            fprintf(stderr, "Ошибка: неизвестный параметр '%s'\n", argv[arg]);
+        }
+        if (parsed != 0) {
+            return 1;
+        }
+    }
+    if (argc - arg != 2) {
+        fprintf(stderr, "Ошибка: запрос должен содержать исходный и выходной путь\n");
+        return 1;
+    }
+
+    char source_buffer[SERVER_FD_PATH_SIZE];
+    char dest_buffer[SERVER_FD_PATH_SIZE];
+    const char *source_path = resolve_path(request, argv[arg], source_buffer);
+    const char *dest_path = resolve_path(request, argv[arg + 1], dest_buffer);
+    if (!source_path || !dest_path) {
+        return 1;
+    }
+    return pipeline_run(&pipeline, source_path, dest_path);
+}
+
+/**
+ * @brief Обслуживает запросы одного соединения, пока клиент его не закроет.
+ *
+ * @param conn Дескриптор соединения.
+ * @param request Буфер запроса потока.
+ */
+static void serve_connection(int conn, struct server_request *request) {
+    for (;;) {
+        int received = receive_request(conn, request);
+        if (received == 0) {
+            return;
+        }
+        int status = received > 0 ? handle_request(request) : 1;
+        close_request_fds(request);
+
+        const char *reply = status == 0 ? "OK" : "ERROR";
+        if (send(conn, reply, strlen(reply), MSG_NOSIGNAL) < 0) {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Приостанавливает поток на заданное количество миллисекунд.
+ */
+static void sleep_ms(unsigned ms) {
+    struct timespec pause = {ms / 1000, (long) (ms % 1000) * 1000000L};
+    nanosleep(&pause, NULL);
+}
+
+/**
+ * @brief Основной цикл потока сервера: принимает соединения и обслуживает их.
+ *
+ * Ошибки приема делятся на три вида. Прерывание вызова и соединения, разорванные до приема,
+ * повторяются сразу. При нехватке дескрипторов или памяти (EMFILE, ENFILE, ENOBUFS, ENOMEM)
+ * поток выводит сообщение один раз за серию ошибок и ждет с удвоением паузы до секунды, чтобы
+ * не занимать процессор, пока другие соединения не закроются. Остальные ошибки означают, что
+ * слушающий сокет непригоден, и поток завершается.
+ *
+ * @param arg Дескриптор слушающего сокета.
+ * @return NULL после неустранимой ошибки приема соединений.
+ */
+static void *server_worker(void *arg) {
+    int listener = (int) (intptr_t) arg;
+    struct server_request request;
+    unsigned backoff = 0;
+
+    for (;;) {
+        int conn = accept4(listener, NULL, NULL, SOCK_CLOEXEC);
+        if (conn < 0) {
+            int error = errno;
+            if (error == EINTR || error == ECONNABORTED || error == EPROTO || error == EAGAIN) {
+                continue;
+            }
+            if (error != EMFILE && error != ENFILE && error != ENOBUFS && error != ENOMEM) {
+                perror("Ошибка: сервер не может принимать соединения");
+                return NULL;
+            }
+            if (backoff == 0) {
+                perror("Предупреждение: сервер временно не может принять соединение");
+                backoff = SERVER_MIN_BACKOFF_MS;
+            } else if (backoff < SERVER_MAX_BACKOFF_MS) {
+                backoff = 2 * backoff < SERVER_MAX_BACKOFF_MS ? 2 * backoff : SERVER_MAX_BACKOFF_MS;
+            }
+            sleep_ms(backoff);
+            continue;
+        }
+        backoff = 0;
+        serve_connection(conn, &request);
+        close(conn);
+    }
+}
+
+/**
+ * @brief Запускает долгоживущий сервер, выполняющий операции над изображениями по запросам.
+ *
+ * @param options Указатель на параметры сервера.
+ * @return 1, если сервер не удалось запустить или слушающий сокет стал непригоден; при нормальной работе
+ *         функция не возвращает управление.
+ */
+int server_run(const struct server_options *options) {
+    int listener = open_listener(options->socket_path);
+    if (listener < 0) {
+        return 1;
+    }
+
+    unsigned workers = options->workers ? options->workers : parallel_thread_count();
+    for (unsigned i = 1; i < workers; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, server_worker, (void *) (intptr_t) listener) != 0) {
+            break;
+        }
+        pthread_detach(thread);
+    }
+    fprintf(stderr, "Сервер принимает запросы на '%s'\n", options->socket_path);
+    server_worker((void *) (intptr_t) listener);
+    return 1;
+}
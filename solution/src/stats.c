@@ -0,0 +1,130 @@
+#include "stats.h"
+#include <string.h>
+
+/**
+ * @brief Подготавливает пустую статистику.
+ *
+ * @param stats Указатель на статистику.
+ */
+void image_stats_init(struct image_stats *stats) {
+    memset(stats, 0, sizeof(*stats));
+}
+
+/**
+ * @brief Переносит частичные гистограммы в итоговые и обнуляет их.
+ */
+static void flush_partial(struct image_stats *stats) {
+    for (int s = 0; s < STATS_SUBHISTOGRAMS; s++) {
+        for (int c = 0; c < 3; c++) {
+            for (int v = 0; v < 256; v++) {
+                stats->histogram[c][v] += stats->partial[s][c][v];
+            }
+        }
+    }
+    memset(stats->partial, 0, sizeof(stats->partial));
+    stats->pending = 0;
+}
+
+/**
+ * @brief Добавляет к статистике пиксели строки.
+ *
+ * @param stats Указатель на статистику.
+ * @param row Указатель на пиксели строки.
+ * @param count Количество пикселей.
+ */
+void image_stats_add(struct image_stats *stats, const struct pixel *row, uint64_t count) {
+    while (count > 0) {
+        // Счетчик частичной гистограммы растет не больше чем на 1 за пиксель, поэтому сводим до переполнения
+        uint64_t room = UINT32_MAX - stats->pending;
+        if (room == 0) {
+            flush_partial(stats);
+            continue;
+        }
+        uint64_t n = count < room ? count : room;
+        uint64_t i = 0;
+        for (; i + STATS_SUBHISTOGRAMS <= n; i += STATS_SUBHISTOGRAMS) {
+            const struct pixel *p = row + i;
+            stats->partial[0][0][p[0].b]++;
+            stats->partial[0][1][p[0].g]++;
+            stats->partial[0][2][p[0].r]++;
+            stats->partial[1][0][p[1].b]++;
+            stats->partial[1][1][p[1].g]++;
+            stats->partial[1][2][p[1].r]++;
+            stats->partial[2][0][p[2].b]++;
+            stats->partial[2][1][p[2].g]++;
+            stats->partial[2][2][p[2].r]++;
+            stats->partial[3][0][p[3].b]++;
+            stats->partial[3][1][p[3].g]++;
+            stats->partial[3][2][p[3].r]++;
+        }
+        for (; i < n; i++) {
+            stats->partial[0][0][row[i].b]++;
+            stats->partial[0][1][row[i].g]++;
+            stats->partial[0][2][row[i].r]++;
+        }
+        stats->pending += n;
+        stats->pixels += n;
+        row += n;
+        count -= n;
+    }
+}
+
+/**
+ * @brief Сводит частичные гистограммы и вычисляет минимум, максимум и среднее каналов.
+ *
+ * @param stats Указатель на статистику.
+ */
+void image_stats_finish(struct image_stats *stats) {
+    flush_partial(stats);
+    for (int c = 0; c < 3; c++) {
+        uint64_t sum = 0;
+        int min = -1, max = 0;
+        for (int v = 0; v < 256; v++) {
+            if (stats->histogram[c][v] == 0) {
+                continue;
+            }
+            if (min < 0) {
+                min = v;
+            }
+            max = v;
+            sum += stats->histogram[c][v] * (uint64_t) v;
+        }
+        stats->min[c] = (uint8_t) (min < 0 ? 0 : min);
+        stats->max[c] = (uint8_t) max;
+        stats->mean[c] = stats->pixels ? (double) sum / (double) stats->pixels : 0.0;
+    }
+}
+
+/**
+ * @brief Вычисляет статистику изображения в памяти отдельным проходом.
+ *
+ * @param stats Указатель на заполняемую статистику.
+ * @param img Указатель на изображение.
+ */
+void image_stats_compute(struct image_stats *stats, const struct image *img) {
+    image_stats_init(stats);
+    image_stats_add(stats, img->data, img->width * img->height);
+    image_stats_finish(stats);
+}
+
+/**
+ * @brief Выводит статистику: строку с минимумом, максимумом и средним и гистограмму для каждого канала.
+ *
+ * @param out Поток для вывода.
+ * @param stats Указатель на сведенную статистику.
+ */
+void image_stats_print(FILE *out, const struct image_stats *stats) {
+    static const char names[3] = {'b', 'g', 'r'};
+    fprintf(out, "# статистика исходных пикселей: %llu пикселей\n", (unsigned long long) stats->pixels);
+    for (int c = 2; c >= 0; c--) {
+        fprintf(out, "%c: мин %u, макс %u, среднее %.3f\n", names[c], (unsigned) stats->min[c],
+                (unsigned) stats->max[c], stats->mean[c]);
+    }
+    for (int c = 2; c >= 0; c--) {
+        fprintf(out, "гистограмма %c:", names[c]);
+        for (int v = 0; v < 256; v++) {
+            fprintf(out, " %llu", (unsigned long long) stats->histogram[c][v]);
+        }
+        fputc('\n', out);
+    }
+}
@@ -0,0 +1,314 @@
+#include "tiff.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define TIFF_CLASSIC_MAGIC 42        // Классический TIFF: 32-битные смещения
+#define TIFF_BIG_MAGIC 43            // BigTIFF: 64-битные смещения
+#define TIFF_CLASSIC_HEADER_SIZE 8
+#define TIFF_BIG_HEADER_SIZE 16
+#define TIFF_ENTRY_COUNT 13          // Количество тегов в каталоге
+#define TIFF_EXTRA_SIZE 24           // Вынесенные из каталога значения, кроме смещений полос (с запасом)
+
+// Типы значений тегов
+#define TIFF_SHORT 3
+#define TIFF_LONG 4
+#define TIFF_RATIONAL 5
+#define TIFF_LONG8 16
+
+// Теги базового RGB изображения в порядке возрастания, как требует формат
+#define TIFF_TAG_IMAGE_WIDTH 256
+#define TIFF_TAG_IMAGE_LENGTH 257
+#define TIFF_TAG_BITS_PER_SAMPLE 258
+#define TIFF_TAG_COMPRESSION 259
+#define TIFF_TAG_PHOTOMETRIC 262
+#define TIFF_TAG_STRIP_OFFSETS 273
+#define TIFF_TAG_SAMPLES_PER_PIXEL 277
+#define TIFF_TAG_ROWS_PER_STRIP 278
+#define TIFF_TAG_STRIP_BYTE_COUNTS 279
+#define TIFF_TAG_X_RESOLUTION 282
+#define TIFF_TAG_Y_RESOLUTION 283
+#define TIFF_TAG_PLANAR_CONFIG 284
+#define TIFF_TAG_RESOLUTION_UNIT 296
+
+/**
+ * @brief Каталог тегов TIFF, собираемый в памяти перед записью.
+ *
+ * Значения, не помещающиеся в поле записи (4 байта в классическом TIFF, 8 в BigTIFF),
+ * размещаются сразу после каталога, а в записи хранится их смещение в файле.
+ */
+struct tiff_directory {
+    uint8_t *data;                   // Каталог и вынесенные значения
+    int big;                         // Признак BigTIFF
+    uint64_t offset;                 // Смещение каталога в файле
+    size_t entry;                    // Позиция следующей записи
+    size_t extra;                    // Позиция следующего вынесенного значения
+};
+
+/**
+ * @brief Записывает число в буфер в порядке байт little-endian.
+ *
+ * @param data Указатель на буфер.
+ * @param value Записываемое число.
+ * @param size Размер числа в байтах.
+ */
+static void put_le(uint8_t *data, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+/**
+ * @brief Возвращает размер одного элемента значения тега в байтах.
+ */
+static size_t tiff_type_size(uint16_t type) {
+    return type == TIFF_SHORT ? 2 : type == TIFF_LONG8 ? 8 : 4;
+}
+
+/**
+ * @brief Добавляет запись в каталог тегов.
+ *
+ * @param dir Каталог тегов.
+ * @param tag Номер тега.
+ * @param type Тип значения.
+ * @param count Количество значений (для RATIONAL - количество дробей).
+ * @param values Значения; дробь RATIONAL задается двумя элементами - числителем и знаменателем.
+ */
+static void tiff_entry(struct tiff_directory *dir, uint16_t tag, uint16_t type, uint64_t count,
+                       const uint64_t *values) {
+    size_t field = dir->big ? 8 : 4;
+    size_t item = tiff_type_size(type);
+    uint64_t items = type == TIFF_RATIONAL ? count * 2 : count;
+    uint8_t *entry = dir->data + dir->entry;
+
+    put_le(entry, tag, 2);
+    put_le(entry + 2, type, 2);
+    put_le(entry + 4, count, field);
+    uint8_t *value = entry + 4 + field;
+    memset(value, 0, field);
+    if (items * item > field) {
+        put_le(value, dir->offset + dir->extra, field);
+        value = dir->data + dir->extra;
+        dir->extra += items * item;
+    }
+    for (uint64_t i = 0; i < items; i++) {
+        put_le(value + i * item, values[i], item);
+    }
+    dir->entry += 4 + 2 * field;
+}
+
+/**
+ * @brief Расположение данных в TIFF файле.
+ */
+struct tiff_layout {
+    uint64_t width;                  // Ширина изображения в пикселях
+    uint64_t height;                 // Высота изображения в пикселях
+    uint64_t row_bytes;              // Размер строки в байтах
+    uint64_t rows_per_strip;         // Количество строк в полосе
+    uint64_t strips;                 // Количество полос
+    uint64_t header_size;            // Размер заголовка файла
+    uint64_t directory;              // Смещение каталога тегов (после пикселей, четное)
+    int big;                         // Признак BigTIFF
+};
+
+/**
+ * @brief Вычисляет расположение данных и выбирает между классическим TIFF и BigTIFF.
+ *
+ * @param layout Указатель на расположение данных.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @return 0, если изображение можно записать, или 1, если оно слишком большое.
+ */
+static int tiff_layout_init(struct tiff_layout *layout, uint64_t width, uint64_t height) {
+    if (width == 0 || height == 0 || width > UINT32_MAX || height > UINT32_MAX) {
+        return 1;
+    }
+    layout->width = width;
+    layout->height = height;
+    layout->row_bytes = width * sizeof(struct pixel);
+    if (height > (UINT64_MAX >> 1) / layout->row_bytes) {
+        return 1;
+    }
+    layout->rows_per_strip = TIFF_STRIP_BYTES / layout->row_bytes;
+    if (layout->rows_per_strip == 0) {
+        layout->rows_per_strip = 1;
+    }
+    if (layout->rows_per_strip > height) {
+        layout->rows_per_strip = height;
+    }
+    layout->strips = (height + layout->rows_per_strip - 1) / layout->rows_per_strip;
+
+    // BigTIFF нужен, если конец классического файла с каталогом не помещается в 32-битные смещения
+    uint64_t data_bytes = layout->row_bytes * height;
+    uint64_t classic_end = TIFF_CLASSIC_HEADER_SIZE + data_bytes + 1 + 2 + TIFF_ENTRY_COUNT * 12 + 4
+                           + TIFF_EXTRA_SIZE + layout->strips * 2 * 4;
+    layout->big = classic_end > UINT32_MAX;
+    layout->header_size = layout->big ? TIFF_BIG_HEADER_SIZE : TIFF_CLASSIC_HEADER_SIZE;
+    uint64_t data_end = layout->header_size + data_bytes;
+    layout->directory = data_end + (data_end & 1);
+    return 0;
+}
+
+/**
+ * @brief Записывает заголовок TIFF со смещением каталога тегов.
+ */
+static enum write_status tiff_write_header(FILE *out, const struct tiff_layout *layout) {
+    uint8_t header[TIFF_BIG_HEADER_SIZE] = {'I', 'I'};
+    if (layout->big) {
+        put_le(header + 2, TIFF_BIG_MAGIC, 2);
+        put_le(header + 4, 8, 2);   // Размер смещений
+        put_le(header + 6, 0, 2);
+        put_le(header + 8, layout->directory, 8);
+    } else {
+        put_le(header + 2, TIFF_CLASSIC_MAGIC, 2);
+        put_le(header + 4, layout->directory, 4);
+    }
+    if (fwrite(header, layout->header_size, 1, out) != 1) {
+        return WRITE_HEADER_ERROR;
+    }
+    return WRITE_OK;
+}
+
+/**
+ * @brief Записывает пиксели полосами строк сверху вниз.
+ *
+ * @param out Указатель на файл для записи.
+ * @param layout Расположение данных.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @param strip Буфер на одну полосу строк.
+ * @return Статус записи.
+ */
+static enum write_status tiff_write_strips(FILE *out, const struct tiff_layout *layout, image_row_source source,
+                                           void *ctx, struct pixel *strip) {
+    for (uint64_t y0 = 0; y0 < layout->height; y0 += layout->rows_per_strip) {
+        uint64_t rows = layout->height - y0 < layout->rows_per_strip ? layout->height - y0 : layout->rows_per_strip;
+        for (uint64_t y = 0; y < rows; y++) {
+            if (source(ctx, y0 + y, strip + y * layout->width) != 0) {
+                return WRITE_ROW_ERROR;
+            }
+        }
+        // TIFF хранит каналы в порядке RGB, а пиксели изображения - в порядке BGR
+        uint64_t pixels = rows * layout->width;
+        for (uint64_t i = 0; i < pixels; i++) {
+            uint8_t b = strip[i].b;
+            strip[i].b = strip[i].r;
+            strip[i].r = b;
+        }
+        if (fwrite(strip, layout->row_bytes, rows, out) != rows) {
+            return WRITE_ROW_ERROR;
+        }
+    }
+    uint64_t data_end = layout->header_size + layout->row_bytes * layout->height;
+    if (layout->directory != data_end && fputc(0, out) == EOF) {
+        return WRITE_ROW_ERROR;
+    }
+    return WRITE_OK;
+}
+
+/**
+ * @brief Собирает и записывает каталог тегов с вынесенными значениями.
+ *
+ * @param out Указатель на файл для записи.
+ * @param layout Расположение данных.
+ * @param offsets Буфер на `2 * layout->strips` чисел для смещений и размеров полос.
+ * @return Статус записи.
+ */
+static enum write_status tiff_write_directory(FILE *out, const struct tiff_layout *layout, uint64_t *offsets) {
+    size_t field = layout->big ? 8 : 4;
+    size_t count_size = layout->big ? 8 : 2;
+    size_t directory_size = count_size + TIFF_ENTRY_COUNT * (4 + 2 * field) + field;
+    struct tiff_directory dir = {NULL, layout->big, layout->directory, count_size, directory_size};
+    dir.data = malloc(directory_size + TIFF_EXTRA_SIZE + layout->strips * 2 * field);
+    if (!dir.data) {
+        return WRITE_ROW_ERROR;
+    }
+
+    uint64_t *counts = offsets + layout->strips;
+    for (uint64_t s = 0; s < layout->strips; s++) {
+        uint64_t y0 = s * layout->rows_per_strip;
+        uint64_t rows = layout->height - y0 < layout->rows_per_strip ? layout->height - y0 : layout->rows_per_strip;
+        offsets[s] = layout->header_size + y0 * layout->row_bytes;
+        counts[s] = rows * layout->row_bytes;
+    }
+
+    uint16_t offset_type = layout->big ? TIFF_LONG8 : TIFF_LONG;
+    const uint64_t bits[3] = {8, 8, 8};
+    const uint64_t resolution[2] = {72, 1};
+    const uint64_t width = layout->width, height = layout->height, rows_per_strip = layout->rows_per_strip;
+    const uint64_t no_compression = 1, rgb = 2, channels = 3, chunky = 1, inch = 2;
+    put_le(dir.data, TIFF_ENTRY_COUNT, count_size);
+    tiff_entry(&dir, TIFF_TAG_IMAGE_WIDTH, TIFF_LONG, 1, &width);
+    tiff_entry(&dir, TIFF_TAG_IMAGE_LENGTH, TIFF_LONG, 1, &height);
+    tiff_entry(&dir, TIFF_TAG_BITS_PER_SAMPLE, TIFF_SHORT, 3, bits);
+    tiff_entry(&dir, TIFF_TAG_COMPRESSION, TIFF_SHORT, 1, &no_compression);
+    tiff_entry(&dir, TIFF_TAG_PHOTOMETRIC, TIFF_SHORT, 1, &rgb);
+    tiff_entry(&dir, TIFF_TAG_STRIP_OFFSETS, offset_type, layout->strips, offsets);
+    tiff_entry(&dir, TIFF_TAG_SAMPLES_PER_PIXEL, TIFF_SHORT, 1, &channels);
+    tiff_entry(&dir, TIFF_TAG_ROWS_PER_STRIP, TIFF_LONG, 1, &rows_per_strip);
+    tiff_entry(&dir, TIFF_TAG_STRIP_BYTE_COUNTS, offset_type, layout->strips, counts);
+    tiff_entry(&dir, TIFF_TAG_X_RESOLUTION, TIFF_RATIONAL, 1, resolution);
+    tiff_entry(&dir, TIFF_TAG_Y_RESOLUTION, TIFF_RATIONAL, 1, resolution);
+    tiff_entry(&dir, TIFF_TAG_PLANAR_CONFIG, TIFF_SHORT, 1, &chunky);
+    tiff_entry(&dir, TIFF_TAG_RESOLUTION_UNIT, TIFF_SHORT, 1, &inch);
+    put_le(dir.data + dir.entry, 0, field);  // Следующего каталога нет
+
+    enum write_status status = fwrite(dir.data, dir.extra, 1, out) == 1 ? WRITE_OK : WRITE_ROW_ERROR;
+    free(dir.data);
+    return status;
+}
+
+/**
+ * @brief Источник строк, копирующий их из изображения в памяти.
+ */
+static int image_rows(void *ctx, uint64_t y, struct pixel *row) {
+    const struct image *img = ctx;
+    memcpy(row, image_pixel(img, 0, y), img->width * sizeof(struct pixel));
+    return 0;
+}
+
+/**
+ * @brief Записывает изображение в формате TIFF без сжатия, 8 бит на канал RGB.
+ *
+ * @param out Указатель на файл для записи.
+ * @param img Указатель на структуру `image` для записи.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status tiff_to_file(FILE *out, const struct image *img) {
+    if (!img) {
+        return WRITE_IMAGE_POINTER_NULL;
+    }
+    return tiff_write_rows(out, img->width, img->height, image_rows, (void *) img);
+}
+
+/**
+ * @brief Записывает TIFF файл, получая строки изображения по одной от источника.
+ *
+ * @param out Указатель на файл для записи.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param source Источник строк.
+ * @param ctx Контекст, передаваемый источнику.
+ * @return Статус записи (`WRITE_OK` или соответствующий статус ошибки).
+ */
+enum write_status tiff_write_rows(FILE *out, uint64_t width, uint64_t height, image_row_source source, void *ctx) {
+    if (!out) {
+        return WRITE_FILE_POINTER_NULL;
+    }
+    struct tiff_layout layout;
+    if (tiff_layout_init(&layout, width, height) != 0) {
+        return WRITE_IMAGE_TOO_LARGE;
+    }
+
+    uint64_t *offsets = malloc(layout.strips * 2 * sizeof(uint64_t));
+    struct pixel *strip = malloc(layout.rows_per_strip * layout.row_bytes);
+    enum write_status status = offsets && strip ? tiff_write_header(out, &layout) : WRITE_ROW_ERROR;
+    if (status == WRITE_OK) {
+        status = tiff_write_strips(out, &layout, source, ctx, strip);
+    }
+    if (status == WRITE_OK) {
+        status = tiff_write_directory(out, &layout, offsets);
+    }
+    free(strip);
+    free(offsets);
+    return status;
+}
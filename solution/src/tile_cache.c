@@ -0,0 +1,245 @@
+#include "tile_cache.h"
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#define TILE_CACHE_SCRATCH_NAME "/image_transform.XXXXXX" // Шаблон имени временного файла
+
+/**
+ * @brief Создает временный файл в каталоге `$TMPDIR` (или /tmp) и сразу удаляет его имя.
+ *
+ * @return Указатель на открытый файл или NULL в случае ошибки.
+ */
+static FILE *open_scratch(void) {
+#ifdef _WIN32
+    return tmpfile();
+#else
+    const char *dir = getenv("TMPDIR");
+    if (!dir || dir[0] == '\0') {
+        dir = "/tmp";
+    }
+    size_t length = strlen(dir);
+    char *path = malloc(length + sizeof(TILE_CACHE_SCRATCH_NAME));
+    if (!path) {
+        return NULL;
+    }
+    memcpy(path, dir, length);
+    memcpy(path + length, TILE_CACHE_SCRATCH_NAME, sizeof(TILE_CACHE_SCRATCH_NAME));
+
+    FILE *file = NULL;
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+        file = fdopen(fd, "w+b");
+        if (!file) {
+            close(fd);
+        }
+    }
+    free(path);
+    return file;
+#endif
+}
+
+/**
+ * @brief Читает или записывает блок временного файла по заданному смещению.
+ *
+ * @param file Временный файл.
+ * @param data Буфер данных.
+ * @param size Размер блока в байтах.
+ * @param offset Смещение от начала файла в байтах.
+ * @param write Признак записи.
+ * @return 0 при успехе или -1 в случае ошибки.
+ */
+static int transfer_at(FILE *file, uint8_t *data, uint64_t size, uint64_t offset, int write) {
+#ifdef _WIN32
+    if (_fseeki64(file, (__int64) offset, SEEK_SET) != 0) {
+        return -1;
+    }
+    size_t done = write ? fwrite(data, 1, size, file) : fread(data, 1, size, file);
+    return done == size ? 0 : -1;
+#else
+    int fd = fileno(file);
+    while (size > 0) {
+        ssize_t n = write ? pwrite(fd, data, size, (off_t) offset) : pread(fd, data, size, (off_t) offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        data += n;
+        size -= (uint64_t) n;
+        offset += (uint64_t) n;
+    }
+    return 0;
+#endif
+}
+
+/**
+ * @brief Создает пустой кэш тайлов.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile_count Количество тайлов.
+ * @param tile_bytes Размер тайла в байтах.
+ * @param capacity Максимальное количество тайлов в памяти.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int tile_cache_init(struct tile_cache *cache, uint64_t tile_count, uint64_t tile_bytes, uint64_t capacity) {
+    memset(cache, 0, sizeof(*cache));
+    cache->tile_bytes = tile_bytes;
+    cache->tile_count = tile_count;
+    cache->capacity = capacity < tile_count ? capacity : tile_count;
+    cache->head = TILE_CACHE_NONE;
+    cache->tail = TILE_CACHE_NONE;
+    cache->slots = malloc(tile_count * sizeof(uint64_t));
+    cache->resident = malloc(tile_count * sizeof(uint64_t));
+    cache->stored = calloc(tile_count, 1);
+    cache->entries = calloc(cache->capacity, sizeof(struct tile_cache_entry));
+    if (!cache->slots || !cache->resident || !cache->stored || !cache->entries) {
+        tile_cache_destroy(cache);
+        return 1;
+    }
+    for (uint64_t i = 0; i < tile_count; i++) {
+        cache->slots[i] = TILE_CACHE_NONE;
+        cache->resident[i] = TILE_CACHE_NONE;
+    }
+    return 0;
+}
+
+/**
+ * @brief Назначает тайлу следующее свободное место во временном файле, если место еще не назначено.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile Номер тайла.
+ */
+void tile_cache_place(struct tile_cache *cache, uint64_t tile) {
+    if (cache->slots[tile] == TILE_CACHE_NONE) {
+        cache->slots[tile] = cache->next_slot++;
+    }
+}
+
+/**
+ * @brief Исключает элемент из списка LRU.
+ */
+static void unlink_entry(struct tile_cache *cache, uint64_t index) {
+    struct tile_cache_entry *entry = &cache->entries[index];
+    if (entry->prev != TILE_CACHE_NONE) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+    if (entry->next != TILE_CACHE_NONE) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+/**
+ * @brief Помещает элемент в начало списка LRU.
+ */
+static void push_front(struct tile_cache *cache, uint64_t index) {
+    struct tile_cache_entry *entry = &cache->entries[index];
+    entry->prev = TILE_CACHE_NONE;
+    entry->next = cache->head;
+    if (cache->head != TILE_CACHE_NONE) {
+        cache->entries[cache->head].prev = index;
+    } else {
+        cache->tail = index;
+    }
+    cache->head = index;
+}
+
+/**
+ * @brief Освобождает давно не использованный элемент, записывая измененный тайл во временный файл.
+ *
+ * @return Номер освобожденного элемента или `TILE_CACHE_NONE` при ошибке ввода-вывода.
+ */
+static uint64_t evict(struct tile_cache *cache) {
+    uint64_t index = cache->tail;
+    struct tile_cache_entry *entry = &cache->entries[index];
+    if (entry->dirty) {
+        if (!cache->scratch && !(cache->scratch = open_scratch())) {
+            return TILE_CACHE_NONE;
+        }
+        tile_cache_place(cache, entry->tile);
+        if (transfer_at(cache->scratch, entry->data, cache->tile_bytes,
+                        cache->slots[entry->tile] * cache->tile_bytes, 1) != 0) {
+            return TILE_CACHE_NONE;
+        }
+        cache->stored[entry->tile] = 1;
+        entry->dirty = 0;
+    }
+    unlink_entry(cache, index);
+    cache->resident[entry->tile] = TILE_CACHE_NONE;
+    entry->tile = TILE_CACHE_NONE;
+    return index;
+}
+
+/**
+ * @brief Возвращает данные тайла, при необходимости читая его из временного файла.
+ *
+ * @param cache Указатель на кэш.
+ * @param tile Номер тайла.
+ * @param write Признак изменения тайла вызывающим.
+ * @return Указатель на данные тайла или NULL при ошибке ввода-вывода.
+ */
+uint8_t *tile_cache_get(struct tile_cache *cache, uint64_t tile, int write) {
+    uint64_t index = cache->resident[tile];
+    if (index != TILE_CACHE_NONE) {
+        if (cache->head != index) {
+            unlink_entry(cache, index);
+            push_front(cache, index);
+        }
+    } else {
+        if (cache->used < cache->capacity) {
+            index = cache->used;
+            cache->entries[index].data = malloc(cache->tile_bytes);
+            if (!cache->entries[index].data) {
+                return NULL;
+            }
+            cache->used++;
+        } else if ((index = evict(cache)) == TILE_CACHE_NONE) {
+            return NULL;
+        }
+
+        struct tile_cache_entry *entry = &cache->entries[index];
+        if (cache->stored[tile] && transfer_at(cache->scratch, entry->data, cache->tile_bytes,
+                                               cache->slots[tile] * cache->tile_bytes, 0) != 0) {
+            entry->tile = TILE_CACHE_NONE;
+            return NULL;
+        }
+        entry->tile = tile;
+        entry->dirty = 0;
+        cache->resident[tile] = index;
+        push_front(cache, index);
+    }
+    if (write) {
+        cache->entries[index].dirty = 1;
+    }
+    return cache->entries[index].data;
+}
+
+/**
+ * @brief Освобождает память кэша и удаляет временный файл.
+ *
+ * @param cache Указатель на кэш.
+ */
+void tile_cache_destroy(struct tile_cache *cache) {
+    if (cache->entries) {
+        for (uint64_t i = 0; i < cache->used; i++) {
+            free(cache->entries[i].data);
+        }
+    }
+    if (cache->scratch) {
+        fclose(cache->scratch);
+    }
+    free(cache->entries);
+    free(cache->slots);
+    free(cache->resident);
+    free(cache->stored);
+    memset(cache, 0, sizeof(*cache));
+}
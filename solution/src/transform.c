@@ -1,60 +1,569 @@
 #include "transform.h"
+#include "uniform.h"
+#include "orient_kernel.h"
+#include "parallel.h"
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#define TRANSFORM_DEFAULT_LLC_SIZE (32ull << 20) // Размер кэша последнего уровня, если его не удалось определить
+#define TRANSFORM_DEFAULT_PREFETCH 8 // Дальность предвыборки по умолчанию в строках
+
+// Минимальный размер результата в байтах для потоковой записи (0 - размер кэша последнего уровня)
+static uint64_t stream_threshold = 0;
+
+// Дальность программной предвыборки в строках (0 - без предвыборки)
+static uint64_t prefetch_distance = TRANSFORM_DEFAULT_PREFETCH;
+
+// Сторона тайла в пикселях
+static uint64_t tile_size = TRANSFORM_TILE_SIZE;
+
+// Выбранный набор ядер смены ориентации
+static enum orient_kernels kernel_set = ORIENT_KERNELS_AUTO;
+
+static const char *const kernel_set_names[ORIENT_KERNELS_COUNT] = {"auto", "generic", "avx2"};
+
+static const char *const orientation_names[ORIENTATION_COUNT] = {
+    "none", "ccw90", "180", "cw90", "flip-h", "flip-v", "transpose", "transverse"
+};
+
+/**
+ * @brief Строит отображение координат для заданной ориентации и размеров исходного изображения.
+ *
+ * @param map Указатель на структуру, в которую будет записано отображение.
+ * @param orientation Ориентация результата.
+ * @param width Ширина исходного изображения в пикселях.
+ * @param height Высота исходного изображения в пикселях.
+ */
+void orientation_map_init(struct orientation_map *map, enum orientation orientation, uint64_t width, uint64_t height) {
+    int64_t w = (int64_t) width;
+    int64_t h = (int64_t) height;
+
+    map->width = orientation_swaps_axes(orientation) ? height : width;
+    map->height = orientation_swaps_axes(orientation) ? width : height;
+
+    switch (orientation) {
+        case ORIENTATION_ROTATE_90_CCW:
+            map->origin = (w - 1) * h;
+            map->step_x = -h;
+            map->step_y = 1;
+            break;
+        case ORIENTATION_ROTATE_180:
+            map->origin = w * h - 1;
+            map->step_x = -1;
+            map->step_y = -w;
+            break;
+        case ORIENTATION_ROTATE_90_CW:
+            map->origin = h - 1;
+            map->step_x = h;
+            map->step_y = -1;
+            break;
+        case ORIENTATION_FLIP_HORIZONTAL:
+            map->origin = w - 1;
+            map->step_x = -1;
+            map->step_y = w;
+            break;
+        case ORIENTATION_FLIP_VERTICAL:
+            map->origin = (h - 1) * w;
+            map->step_x = 1;
+            map->step_y = -w;
+            break;
+        case ORIENTATION_TRANSPOSE:
+            map->origin = 0;
+            map->step_x = h;
+            map->step_y = 1;
+            break;
+        case ORIENTATION_TRANSVERSE:
+            map->origin = (w - 1) * h + h - 1;
+            map->step_x = -h;
+            map->step_y = -1;
+            break;
+        case ORIENTATION_NONE:
+        default:
+            map->origin = 0;
+            map->step_x = 1;
+            map->step_y = w;
+            break;
+    }
+}
+
+/**
+ * @brief Проверяет, меняет ли ориентация местами ширину и высоту изображения.
+ *
+ * @param orientation Ориентация результата.
+ * @return 1, если ширина и высота меняются местами, иначе 0.
+ */
+int orientation_swaps_axes(enum orientation orientation) {
+    return orientation == ORIENTATION_ROTATE_90_CCW || orientation == ORIENTATION_ROTATE_90_CW
+           || orientation == ORIENTATION_TRANSPOSE || orientation == ORIENTATION_TRANSVERSE;
+}
+
+/**
+ * @brief Находит ориентацию по ее имени.
+ *
+ * @param name Имя ориентации.
+ * @param orientation Указатель, по которому будет записана найденная ориентация.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int orientation_from_name(const char *name, enum orientation *orientation) {
+    for (int i = 0; i < ORIENTATION_COUNT; i++) {
+        if (strcmp(name, orientation_names[i]) == 0) {
+            *orientation = (enum orientation) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Возвращает имя ориентации.
+ *
+ * @param orientation Ориентация.
+ * @return Имя ориентации или "unknown" для некорректного значения.
+ */
+const char *orientation_name(enum orientation orientation) {
+    if ((unsigned) orientation >= ORIENTATION_COUNT) {
+        return "unknown";
+    }
+    return orientation_names[orientation];
+}
+
+/**
+ * @brief Определяет размер кэша последнего уровня.
+ *
+ * @return Размер L3 (или L2, если L3 нет) в байтах либо `TRANSFORM_DEFAULT_LLC_SIZE`, если его не удалось узнать.
+ */
+static uint64_t last_level_cache_size(void) {
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+    if (size <= 0) {
+        size = sysconf(_SC_LEVEL2_CACHE_SIZE);
+    }
+    if (size > 0) {
+        return (uint64_t) size;
+    }
+#endif
+    return TRANSFORM_DEFAULT_LLC_SIZE;
+}
+
+/**
+ * @brief Задает минимальный размер результата, начиная с которого он записывается в обход кэша.
+ *
+ * @param bytes Порог в байтах; 0 - размер кэша последнего уровня, `UINT64_MAX` - не использовать потоковую запись.
+ */
+void orient_set_stream_threshold(uint64_t bytes) {
+    stream_threshold = bytes;
+}
+
+/**
+ * @brief Возвращает действующий порог потоковой записи результата.
+ *
+ * @return Порог в байтах.
+ */
+uint64_t orient_stream_threshold(void) {
+    return stream_threshold ? stream_threshold : last_level_cache_size();
+}
+
+/**
+ * @brief Задает дальность программной предвыборки при смене ориентации.
+ *
+ * @param lines Дальность в строках; 0 отключает предвыборку.
+ */
+void orient_set_prefetch_distance(uint64_t lines) {
+    prefetch_distance = lines;
+}
+
+/**
+ * @brief Возвращает действующую дальность программной предвыборки при смене ориентации.
+ *
+ * @return Дальность в строках.
+ */
+uint64_t orient_prefetch_distance(void) {
+    return prefetch_distance;
+}
+
+/**
+ * @brief Задает сторону тайла, которыми обрабатывается изображение при смене ориентации.
+ *
+ * @param size Сторона тайла в пикселях.
+ * @return 0, если размер допустим, или 1, если он вне `[TRANSFORM_MIN_TILE_SIZE, TRANSFORM_MAX_TILE_SIZE]`.
+ */
+int orient_set_tile_size(uint64_t size) {
+    if (size < TRANSFORM_MIN_TILE_SIZE || size > TRANSFORM_MAX_TILE_SIZE) {
+        return 1;
+    }
+    tile_size = size;
+    return 0;
+}
+
+/**
+ * @brief Возвращает действующую сторону тайла при смене ориентации.
+ *
+ * @return Сторона тайла в пикселях.
+ */
+uint64_t orient_tile_size(void) {
+    return tile_size;
+}
+
+/**
+ * @brief Находит набор ядер смены ориентации по его имени.
+ *
+ * @param name Имя набора.
+ * @param kernels Указатель, по которому будет записан найденный набор.
+ * @return 0, если имя распознано, или 1 в случае ошибки.
+ */
+int orient_kernels_from_name(const char *name, enum orient_kernels *kernels) {
+    for (int i = 0; i < ORIENT_KERNELS_COUNT; i++) {
+        if (strcmp(name, kernel_set_names[i]) == 0) {
+            *kernels = (enum orient_kernels) i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Возвращает имя набора ядер смены ориентации.
+ *
+ * @param kernels Набор ядер.
+ * @return Имя набора или "unknown" для некорректного значения.
+ */
+const char *orient_kernels_name(enum orient_kernels kernels) {
+    if ((unsigned) kernels >= ORIENT_KERNELS_COUNT) {
+        return "unknown";
+    }
+    return kernel_set_names[kernels];
+}
+
+/**
+ * @brief Выбирает набор специализированных ядер смены ориентации.
+ *
+ * @param kernels Набор ядер; `ORIENT_KERNELS_AUTO` - лучший из поддерживаемых процессором.
+ * @return 0, если набор выбран, или 1, если процессор или сборка его не поддерживает.
+ */
+int orient_set_kernels(enum orient_kernels kernels) {
+    if ((unsigned) kernels >= ORIENT_KERNELS_COUNT
+        || (kernels != ORIENT_KERNELS_AUTO && !orient_kernels_supported(kernels))) {
+        return 1;
+    }
+    kernel_set = kernels;
+    return 0;
+}
 
 /**
- * @brief Копирует строку из исходного изображения в соответствующий столбец повернутого изображения.
+ * @brief Возвращает действующий набор ядер смены ориентации.
  *
- * Эта функция копирует пиксели из заданной строки исходного изображения и размещает их в соответствующем столбце повернутого изображения,
- * реализуя поворот изображения на 90 градусов против часовой стрелки.
+ * @return Набор ядер (не `ORIENT_KERNELS_AUTO`).
+ */
+enum orient_kernels orient_active_kernels(void) {
+    if (kernel_set != ORIENT_KERNELS_AUTO) {
+        return kernel_set;
+    }
+    return orient_kernels_supported(ORIENT_KERNELS_AVX2) ? ORIENT_KERNELS_AVX2 : ORIENT_KERNELS_GENERIC;
+}
+
+/**
+ * @brief Переносит один тайл полосы в результат или заполняет его цветом, если он однотонный.
+ *
+ * @param job Параметры переноса.
+ * @param band Номер полосы тайлов.
+ * @param x0 Первый столбец тайла.
+ */
+static void orient_tile(const struct orient_job *job, uint64_t band, uint64_t x0) {
+    uint64_t tile = job->tile;
+    uint64_t y0 = band * tile;
+    uint64_t y1 = job->height - y0 > tile ? y0 + tile : job->height;
+    uint64_t x1 = job->width - x0 > tile ? x0 + tile : job->width;
+    // Признак однотонности и цвет тайла из карты текущей полосы
+    if (job->uniform && job->uniform->uniform[band * job->uniform->tiles_x + x0 / tile]) {
+        orient_fill_tile(job, x0, y0, x1, y1, job->uniform->colors[band * job->uniform->tiles_x + x0 / tile]);
+    } else {
+        job->kernel(job, x0, y0, x1, y1);
+    }
+}
+
+/**
+ * @brief Переносит полосы тайлов с номерами `[begin, end)`; вызывается из пула потоков.
+ *
+ * @param ctx Указатель на `struct orient_job`.
+ * @param begin Номер первой полосы тайлов.
+ * @param end Номер полосы, следующей за последней.
+ */
+static void orient_bands(void *ctx, uint64_t begin, uint64_t end) {
+    const struct orient_job *job = ctx;
+
+    for (uint64_t band = begin; band < end; band++) {
+        for (uint64_t x0 = 0; x0 < job->width; x0 += job->tile) {
+            orient_tile(job, band, x0);
+        }
+    }
+    if (job->stream) {
+        orient_kernel_fence();
+    }
+}
+
+/**
+ * @brief Задания переноса одной области в несколько результатов.
+ */
+struct orient_fanout {
+    struct orient_job jobs[ORIENT_MAX_OUTPUTS]; // Задания результатов с одинаковой сеткой тайлов
+    size_t count;                    // Количество результатов
+    int stream;                      // Признак записи результатов в обход кэша
+};
+
+/**
+ * @brief Переносит полосы тайлов с номерами `[begin, end)` во все результаты; вызывается из пула потоков.
+ *
+ * Каждый тайл источника переносится во все результаты подряд, пока он еще в кэше.
+ *
+ * @param ctx Указатель на `struct orient_fanout`.
+ * @param begin Номер первой полосы тайлов.
+ * @param end Номер полосы, следующей за последней.
+ */
+static void orient_fanout_bands(void *ctx, uint64_t begin, uint64_t end) {
+    const struct orient_fanout *fanout = ctx;
+    const struct orient_job *first = &fanout->jobs[0];
+
+    for (uint64_t band = begin; band < end; band++) {
+        for (uint64_t x0 = 0; x0 < first->width; x0 += first->tile) {
+            for (size_t i = 0; i < fanout->count; i++) {
+                orient_tile(&fanout->jobs[i], band, x0);
+            }
+        }
+    }
+    if (fanout->stream) {
+        orient_kernel_fence();
+    }
+}
+
+/**
+ * @brief Заполняет параметры переноса области в результат, общие для всех тайлов.
+ *
+ * @param job Указатель на заполняемые параметры.
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на область, лежащую внутри изображения.
+ * @param orientation Ориентация результата.
+ * @param stage Указатель на поэлементную операцию или NULL.
+ * @param tiles Указатель на карту однотонных тайлов области или NULL.
+ * @param stream Признак записи результата в обход кэша.
+ */
+static void orient_job_init(struct orient_job *job, const struct image *source, const struct image_rect *region,
+                            enum orientation orientation, const struct pixel_stage *stage,
+                            const struct uniform_tiles *tiles, int stream) {
+    job->source = image_pixel(source, region->x, region->y);
+    job->source_stride = source->width;
+    job->width = region->width;
+    job->height = region->height;
+    job->stage = stage;
+    orientation_map_init(&job->map, orientation, region->width, region->height);
+    job->dest = NULL;
+    job->stream = stream;
+    job->prefetch = prefetch_distance;
+    job->tile = tile_size;
+    job->kernel = orient_kernel_find(orient_active_kernels(), orientation, stream);
+    // Карта пригодна, только если построена для этой же области с той же сеткой тайлов
+    job->uniform = tiles && tiles->tile == job->tile && tiles->width == job->width && tiles->height == job->height
+                   ? tiles : NULL;
+}
+
+/**
+ * @brief Вырезает область изображения и приводит ее к заданной ориентации за один проход.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. Если область некорректна или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image orient_region(const struct image *source, const struct image_rect *region, enum orientation orientation) {
+    return orient_region_staged(source, region, orientation, NULL);
+}
+
+/**
+ * @brief Вырезает область, приводит ее к заданной ориентации и применяет к пикселям поэлементную операцию за один проход.
  *
  * @param source Указатель на исходное изображение.
- * @param rotated Указатель на изображение, в которое будут скопированы данные.
- * @param row Номер строки в исходном изображении, которую необходимо скопировать.
+ * @param region Указатель на вырезаемую область.
+ * @param orientation Ориентация результата.
+ * @param stage Указатель на поэлементную операцию или NULL.
+ * @return Новая структура `image`. Если область некорректна или выделение памяти не удалось, поле `data` равно NULL.
  */
-void copy_row_to_column(const struct image *source, struct image *rotated, uint64_t row) {
-    // Получаем указатель на начало строки в исходном изображении
-    const struct pixel *source_row_ptr = image_pixel(source, 0, row);
-    struct pixel *rotated_pixel_ptr = image_pixel(rotated, row, rotated->height - 1);
+struct image orient_region_staged(const struct image *source, const struct image_rect *region,
+                                  enum orientation orientation, const struct pixel_stage *stage) {
+    return orient_region_sparse(source, region, orientation, stage, NULL);
+}
 
-    // Копирование пикселей строки в столбец повернутого изображения
-    for (uint64_t x = 0; x < source->width; x++) {
-        *rotated_pixel_ptr = *source_row_ptr;
+/**
+ * @brief Вырезает область, приводит ее к заданной ориентации и применяет поэлементную операцию,
+ * заполняя однотонные тайлы цветом вместо переноса пикселей.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область.
+ * @param orientation Ориентация результата.
+ * @param stage Указатель на поэлементную операцию или NULL.
+ * @param tiles Указатель на карту однотонных тайлов области или NULL.
+ * @return Новая структура `image`. Если область некорректна или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image orient_region_sparse(const struct image *source, const struct image_rect *region,
+                                  enum orientation orientation, const struct pixel_stage *stage,
+                                  const struct uniform_tiles *tiles) {
+    if (source == NULL || source->data == NULL || !image_rect_fits(region, source->width, source->height)
+        || (unsigned) orientation >= ORIENTATION_COUNT) {
+        struct image empty = {0};
+        return empty;
+    }
 
-        // Переходим к следующему пикселю в исходной строке
-        source_row_ptr++;
+    struct orient_job job;
+    uint64_t bytes = region->width * region->height * sizeof(struct pixel);
+    orient_job_init(&job, source, region, orientation, stage, tiles, bytes >= orient_stream_threshold());
 
-        // Переходим к следующему пикселю в столбце повернутого изображения (сдвигаемся вверх)
-        rotated_pixel_ptr -= rotated->width;
+    struct image result = create_image_uninit(job.map.width, job.map.height);
+    if (result.data == NULL) {
+        return result;
     }
+    job.dest = result.data;
+
+    uint64_t bands = (job.height + job.tile - 1) / job.tile;
+    parallel_for(bands, 1, orient_bands, &job);
+
+    return result;
 }
 
 /**
- * @brief Поворачивает изображение на 90 градусов против часовой стрелки.
+ * @brief Строит несколько результатов смены ориентации одной области за один обход тайлов источника.
  *
- * Создает новое изображение, в котором ширина и высота исходного изображения меняются местами.
- * Каждый пиксель исходного изображения копируется в новое положение, соответствующее повороту на 90 градусов.
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область.
+ * @param count Количество результатов (от 1 до `ORIENT_MAX_OUTPUTS`).
+ * @param orientations Ориентации результатов.
+ * @param stages Поэлементные операции результатов (элементы могут быть NULL) или NULL.
+ * @param tiles Указатель на карту однотонных тайлов области или NULL.
+ * @param results Массив, в который будут записаны `count` результатов.
+ * @return 0 при успехе или 1, если параметры некорректны или выделение памяти не удалось.
+ */
+int orient_region_fanout(const struct image *source, const struct image_rect *region, size_t count,
+                         const enum orientation *orientations, const struct pixel_stage *const *stages,
+                         const struct uniform_tiles *tiles, struct image *results) {
+    if (source == NULL || source->data == NULL || !image_rect_fits(region, source->width, source->height)
+        || count == 0 || count > ORIENT_MAX_OUTPUTS) {
+        return 1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if ((unsigned) orientations[i] >= ORIENTATION_COUNT) {
+            return 1;
+        }
+    }
+
+    // Порог потоковой записи сравнивается с суммой результатов: вместе они вытесняют источник из кэша
+    struct orient_fanout fanout;
+    uint64_t bytes = count * region->width * region->height * sizeof(struct pixel);
+    fanout.count = count;
+    fanout.stream = bytes >= orient_stream_threshold();
+    int status = 0;
+    for (size_t i = 0; i < count; i++) {
+        struct orient_job *job = &fanout.jobs[i];
+        orient_job_init(job, source, region, orientations[i], stages ? stages[i] : NULL, tiles, fanout.stream);
+        results[i] = create_image_uninit(job->map.width, job->map.height);
+        job->dest = results[i].data;
+        status |= job->dest == NULL;
+    }
+    if (status != 0) {
+        for (size_t i = 0; i < count; i++) {
+            destroy_image(&results[i]);
+        }
+        return 1;
+    }
+
+    uint64_t bands = (region->height + tile_size - 1) / tile_size;
+    parallel_for(bands, 1, orient_fanout_bands, &fanout);
+    return 0;
+}
+
+/**
+ * @brief Создает изображение в заданной ориентации.
  *
  * @param source Указатель на исходное изображение.
- * @return Новая структура `image`, содержащая повернутое изображение. Если выделение памяти не удалось, структура будет содержать NULL в поле `data`.
+ * @param orientation Ориентация результата.
+ * @return Новая структура `image`. Если выделение памяти не удалось, поле `data` равно NULL.
  */
-struct image rotate_image_90_counterclockwise(const struct image *source) {
-    // Проверяем, что указатель на исходное изображение и данные изображения не NULL
+struct image orient_image(const struct image *source, enum orientation orientation) {
     if (source == NULL || source->data == NULL) {
         struct image empty = {0};
         return empty;
     }
+    struct image_rect full = {0, 0, source->width, source->height};
+    return orient_region(source, &full, orientation);
+}
 
-    // Создаем новое изображение с шириной и высотой, поменянными местами
-    struct image rotated = create_image(source->height, source->width);
+/**
+ * @brief Помещает строку исходного изображения в результат согласно отображению ориентации.
+ *
+ * @param dest Указатель на изображение-результат.
+ * @param map Указатель на отображение, построенное для размеров исходного изображения.
+ * @param y Номер строки в исходном изображении.
+ * @param row Пиксели исходной строки.
+ * @param width Количество пикселей в строке.
+ */
+void orient_row(struct image *dest, const struct orientation_map *map, uint64_t y, const struct pixel *row, uint64_t width) {
+    struct pixel *dst = dest->data + (map->origin + (int64_t) y * map->step_y);
 
-    // Проверка успешного выделения памяти
-    if (rotated.data == NULL) {
-        return rotated;
+    if (map->step_x == 1) {
+        memcpy(dst, row, width * sizeof(struct pixel));
+        return;
     }
-
-    // Копирование данных с поворотом на 90 градусов
-    for (uint64_t y = 0; y < source->height; y++) {
-        copy_row_to_column(source, &rotated, y);
+    for (uint64_t x = 0; x < width; x++) {
+        *dst = row[x];
+        dst += map->step_x;
     }
+}
 
-    return rotated;
+/**
+ * @brief Помещает строку исходного изображения в соответствующий столбец повернутого изображения.
+ *
+ * Пиксель с координатой X исходной строки `y` попадает в столбец `y` повернутого изображения,
+ * в строку `rotated->height - 1 - X`, что соответствует повороту на 90 градусов против часовой стрелки.
+ *
+ * @param rotated Указатель на повернутое изображение.
+ * @param y Номер строки в исходном изображении.
+ * @param row Пиксели исходной строки; их количество равно высоте повернутого изображения.
+ */
+void rotate_row_90_counterclockwise(struct image *rotated, uint64_t y, const struct pixel *row) {
+    struct orientation_map map;
+    orientation_map_init(&map, ORIENTATION_ROTATE_90_CCW, rotated->height, rotated->width);
+    orient_row(rotated, &map, y, row, rotated->height);
+}
+
+/**
+ * @brief Поворачивает изображение на 90 градусов против часовой стрелки.
+ *
+ * Создает новое изображение, в котором ширина и высота исходного изображения меняются местами.
+ * Каждый пиксель исходного изображения копируется в новое положение, соответствующее повороту на 90 градусов.
+ *
+ * @param source Указатель на исходное изображение.
+ * @return Новая структура `image`, содержащая повернутое изображение. Если выделение памяти не удалось, структура будет содержать NULL в поле `data`.
+ */
+struct image rotate_image_90_counterclockwise(const struct image *source) {
+    return orient_image(source, ORIENTATION_ROTATE_90_CCW);
+}
+
+/**
+ * @brief Вырезает прямоугольную область изображения.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область.
+ * @return Новая структура `image` с копией области. Если область некорректна или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image crop_image(const struct image *source, const struct image_rect *region) {
+    return orient_region(source, region, ORIENTATION_NONE);
+}
+
+/**
+ * @brief Вырезает область изображения и поворачивает ее на 90 градусов против часовой стрелки за один проход.
+ *
+ * @param source Указатель на исходное изображение.
+ * @param region Указатель на вырезаемую область.
+ * @return Новая структура `image` с повернутой областью. Если область некорректна или выделение памяти не удалось, поле `data` равно NULL.
+ */
+struct image rotate_region_90_counterclockwise(const struct image *source, const struct image_rect *region) {
+    return orient_region(source, region, ORIENTATION_ROTATE_90_CCW);
 }
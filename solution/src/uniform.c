@@ -0,0 +1,128 @@
+#include "uniform.h"
+#include <stdlib.h>
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#define UNIFORM_BLOCK 16             // Пикселей в блоке SSE2: три 16-байтных вектора
+
+/**
+ * @brief Проверяет, что все пиксели отрезка строки равны заданному цвету.
+ *
+ * @param row Указатель на первый пиксель отрезка.
+ * @param count Количество пикселей.
+ * @param color Ожидаемый цвет.
+ * @return 1, если все пиксели равны цвету, иначе 0.
+ */
+static int span_is_uniform(const struct pixel *row, uint64_t count, struct pixel color) {
+    uint64_t x = 0;
+#ifdef __SSE2__
+    if (count >= UNIFORM_BLOCK) {
+        // Три вектора повторяют цвет так, что вместе покрывают ровно 16 пикселей
+        struct pixel pattern[UNIFORM_BLOCK];
+        for (int i = 0; i < UNIFORM_BLOCK; i++) {
+            pattern[i] = color;
+        }
+        const __m128i p0 = _mm_loadu_si128((const __m128i *) pattern);
+        const __m128i p1 = _mm_loadu_si128((const __m128i *) ((const uint8_t *) pattern + 16));
+        const __m128i p2 = _mm_loadu_si128((const __m128i *) ((const uint8_t *) pattern + 32));
+        for (; x + UNIFORM_BLOCK <= count; x += UNIFORM_BLOCK) {
+            const uint8_t *bytes = (const uint8_t *) (row + x);
+            __m128i equal = _mm_and_si128(
+                _mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) bytes), p0),
+                              _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (bytes + 16)), p1)),
+                _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (bytes + 32)), p2));
+            if (_mm_movemask_epi8(equal) != 0xFFFF) {
+                return 0;
+            }
+        }
+    }
+#endif
+    for (; x < count; x++) {
+        if (row[x].b != color.b || row[x].g != color.g || row[x].r != color.r) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * @brief Подготавливает карту, в которой все тайлы считаются однотонными до проверки.
+ *
+ * @param tiles Указатель на карту.
+ * @param width Ширина изображения в пикселях.
+ * @param height Высота изображения в пикселях.
+ * @param tile Сторона тайла в пикселях.
+ * @return 0 при успехе или 1, если не удалось выделить память.
+ */
+int uniform_tiles_init(struct uniform_tiles *tiles, uint64_t width, uint64_t height, uint64_t tile) {
+    memset(tiles, 0, sizeof(*tiles));
+    tiles->tile = tile;
+    tiles->width = width;
+    tiles->height = height;
+    tiles->tiles_x = (width + tile - 1) / tile;
+    tiles->tiles_y = (height + tile - 1) / tile;
+    uint64_t count = tiles->tiles_x * tiles->tiles_y;
+    tiles->colors = malloc((count ? count : 1) * sizeof(struct pixel));
+    tiles->uniform = malloc(count ? count : 1);
+    tiles->seen = calloc(tiles->tiles_y ? tiles->tiles_y : 1, 1);
+    if (!tiles->colors || !tiles->uniform || !tiles->seen) {
+        uniform_tiles_destroy(tiles);
+        return 1;
+    }
+    memset(tiles->uniform, 1, count);
+    return 0;
+}
+
+/**
+ * @brief Учитывает строку изображения.
+ *
+ * @param tiles Указатель на карту.
+ * @param y Номер строки.
+ * @param row Указатель на пиксели строки.
+ */
+void uniform_tiles_row(struct uniform_tiles *tiles, uint64_t y, const struct pixel *row) {
+    uint64_t band = y / tiles->tile;
+    uint64_t first = band * tiles->tiles_x;
+    int starts = !tiles->seen[band];
+    tiles->seen[band] = 1;
+    for (uint64_t tx = 0; tx < tiles->tiles_x; tx++) {
+        uint64_t x0 = tx * tiles->tile;
+        uint64_t count = tiles->width - x0 < tiles->tile ? tiles->width - x0 : tiles->tile;
+        if (starts) {
+            tiles->colors[first + tx] = row[x0];
+        }
+        if (tiles->uniform[first + tx] && !span_is_uniform(row + x0, count, tiles->colors[first + tx])) {
+            tiles->uniform[first + tx] = 0;
+        }
+    }
+}
+
+/**
+ * @brief Возвращает количество однотонных тайлов.
+ *
+ * @param tiles Указатель на заполненную карту.
+ * @return Количество тайлов с признаком однотонности.
+ */
+uint64_t uniform_tiles_count(const struct uniform_tiles *tiles) {
+    uint64_t count = 0;
+    for (uint64_t i = 0; i < tiles->tiles_x * tiles->tiles_y; i++) {
+        count += tiles->uniform[i];
+    }
+    return count;
+}
+
+/**
+ * @brief Освобождает память карты.
+ *
+ * @param tiles Указатель на карту.
+ */
+void uniform_tiles_destroy(struct uniform_tiles *tiles) {
+    free(tiles->colors);
+    free(tiles->uniform);
+    free(tiles->seen);
+    tiles->colors = NULL;
+    tiles->uniform = NULL;
+    tiles->seen = NULL;
+}
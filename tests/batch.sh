@@ -0,0 +1,69 @@
+#!/bin/sh
+# Пакетная обработка (--batch) под бюджетом памяти: результаты заданий совпадают с отдельными запусками,
+# пик памяти буферов не превышает бюджета, ошибочные строки учитываются в итоге и коде завершения.
+. "$(dirname "$0")/common.sh"
+
+# Каждое изображение около 0,3 МиБ: два задания с исходным и результирующим буфером в бюджет 1 МиБ
+# не помещаются, поэтому часть заданий ждет освобождения памяти
+for i in 1 2 3 4 5 6; do
+    ppm source$i.ppm $((360 + i * 7)) $((270 + i * 3))
+done
+
+# Строка задания и такой же отдельный запуск: job <параметры строки>... <источник> <результат>
+: > jobs.txt
+: > single.txt
+job() {
+    echo "$*" >> jobs.txt
+    echo "$*" | sed 's/--priority [0-9] //; s/ \([^ ]*\)$/ single.\1/' >> single.txt
+}
+echo "# Задания с разными приоритетами и форматами" >> jobs.txt
+job --priority 3 --orient cw90 source1.ppm out1.bmp
+job --invert source2.ppm out2.tiff
+echo >> jobs.txt
+job --priority 1 --crop 5,5,100,80 source3.ppm out3.qoi
+job source4.ppm out4.bmp
+job --priority 2 --orient 180 --grayscale source5.ppm out5.bmp
+job --resize 100x0 --sharpen 1 source6.ppm out6.bmp
+
+"$program" --batch jobs.txt --workers 2 --memory-budget 1 > report.txt 2> memory.txt
+grep -q '^# заданий 6, ошибок 0,' report.txt || fail "итог пакета: $(cat report.txt)"
+# Задание дает тот же результат, что и отдельный запуск с параметрами его строки
+while read -r line; do
+    "$program" $line
+done < single.txt
+for i in 1 2 3 4 5 6; do
+    result=$(ls out$i.*)
+    same single.$result $result "задание $i"
+done
+echo "ok: задания пакета"
+
+# Отчет о памяти: пик буферов не больше бюджета
+peak=$(sed -n 's/^# память: пик буферов \([0-9.]*\) МиБ при бюджете 1.0 МиБ.*/\1/p' memory.txt)
+[ -n "$peak" ] || fail "нет отчета о памяти: $(cat memory.txt)"
+awk -v peak="$peak" 'BEGIN { exit !(peak > 0 && peak <= 1.0) }' || fail "пик буферов $peak МиБ при бюджете 1 МиБ"
+echo "ok: бюджет памяти"
+
+# Общие параметры командной строки дополняются параметрами строки
+printf 'source1.ppm common1.bmp\n--invert source2.ppm common2.bmp\n' > common.txt
+"$program" --batch common.txt --workers 2 --memory-budget 1 --orient none > /dev/null 2>&1
+"$program" --orient none source1.ppm single_common1.bmp
+"$program" --orient none --invert source2.ppm single_common2.bmp
+same single_common1.bmp common1.bmp "общие параметры"
+same single_common2.bmp common2.bmp "общие параметры и параметры строки"
+echo "ok: общие параметры"
+
+# Неразобранная строка и отсутствующий источник - ошибки, остальные задания выполняются
+cat > errors.txt <<EOF
+--unknown source1.ppm bad1.bmp
+missing.ppm bad2.bmp
+--orient cw90 source1.ppm good.bmp
+EOF
+set +e
+"$program" --batch errors.txt --workers 2 --memory-budget 1 > report.txt 2> /dev/null
+status=$?
+set -e
+[ $status = 1 ] || fail "код завершения пакета с ошибками $status"
+grep -q '^# заданий 3, ошибок 2,' report.txt || fail "итог пакета с ошибками: $(cat report.txt)"
+same single.out1.bmp good.bmp "задание после ошибок"
+[ ! -e bad1.bmp ] && [ ! -e bad2.bmp ] || fail "результат ошибочного задания"
+echo "ok: ошибки заданий"
@@ -0,0 +1,76 @@
+#!/bin/sh
+# Кэш результатов (--cache): повторный запуск с теми же пикселями и операциями берет результат из кэша,
+# измененные операции или пиксели дают промах, а перезапись файла, связанного с записью кэша жесткой
+# ссылкой, не портит запись.
+. "$(dirname "$0")/common.sh"
+
+rm -rf cache
+ppm source.ppm 173 91
+"$program" --orient cw90 source.ppm reference.bmp
+
+# Выводит количество записей кэша, проверяя, что временных файлов не осталось
+entries() {
+    ! ls cache | grep -q '\.tmp$' || fail "в кэше остались временные файлы: $(ls cache)"
+    ls cache | wc -l | tr -d ' '
+}
+
+# Путь к единственной записи кэша, созданной последней
+newest() {
+    echo "cache/$(ls -t cache | head -n 1)"
+}
+
+# Первый запуск записывает результат в кэш, второй дает тот же результат
+"$program" --cache cache --orient cw90 source.ppm out.bmp
+same reference.bmp out.bmp "результат с пустым кэшем"
+[ "$(entries)" = 1 ] || fail "ожидалась одна запись кэша"
+entry=$(newest)
+same reference.bmp "$entry" "запись кэша"
+"$program" --cache cache --orient cw90 source.ppm out.bmp
+same reference.bmp out.bmp "результат из кэша"
+[ "$(entries)" = 1 ] || fail "попадание создало новую запись"
+echo "ok: запись и попадание"
+
+# Попадание доказывается подменой записи: файл заменяется переименованием, поэтому жесткая ссылка
+# результата на прежнюю запись не меняет ее содержимого
+cp "$entry" tampered.bmp
+put tampered.bmp 54 '\001\002\003'
+cp tampered.bmp "$entry.new"
+mv "$entry.new" "$entry"
+same reference.bmp out.bmp "прежний результат после подмены записи"
+"$program" --cache cache --orient cw90 source.ppm out.bmp
+same tampered.bmp out.bmp "результат из подмененной записи"
+# Ключ зависит от пикселей, а не от файла: те же пиксели в QOI и кэш из переменной окружения - попадание
+"$program" --orient none source.ppm source.qoi
+IMAGE_TRANSFORM_CACHE=cache "$program" --orient cw90 source.qoi env.bmp
+same tampered.bmp env.bmp "попадание для тех же пикселей в QOI"
+echo "ok: ключ по пикселям и операциям"
+
+# Другие операции по тому же пути - промах; запись результата не меняет запись кэша,
+# с которой файл назначения мог быть связан жесткой ссылкой
+"$program" --orient 180 source.ppm reference180.bmp
+"$program" --cache cache --orient 180 source.ppm out.bmp
+same reference180.bmp out.bmp "промах при других операциях"
+[ "$(entries)" = 2 ] || fail "промах не создал запись"
+same tampered.bmp "$entry" "запись кэша после перезаписи связанного файла"
+"$program" --cache cache --orient cw90 --invert source.ppm inverted.bmp
+"$program" --orient cw90 --invert source.ppm reference_inverted.bmp
+same reference_inverted.bmp inverted.bmp "промах при добавленной цветовой операции"
+# Другой формат результата - промах
+"$program" --cache cache --orient cw90 source.ppm out.tiff
+"$program" --orient cw90 source.ppm reference.tiff
+same reference.tiff out.tiff "промах при другом формате"
+[ "$(entries)" = 4 ] || fail "ожидалось четыре записи кэша"
+echo "ok: промах при других операциях"
+
+# Измененные пиксели - промах, даже если размер и путь файла прежние
+cp source.ppm changed.ppm
+put changed.ppm $((14 + 3 * (173 * 40 + 60))) '\000\000\000'
+status_is 1 --compare source.ppm changed.ppm
+"$program" --orient cw90 changed.ppm reference_changed.bmp
+"$program" --cache cache --orient cw90 changed.ppm out.bmp
+same reference_changed.bmp out.bmp "промах при измененных пикселях"
+[ "$(entries)" = 5 ] || fail "промах не создал запись"
+# Результат в стандартный вывод не кэшируется
+"$program" --cache cache --orient flip-h source.ppm - > piped.bmp
+[ "$(entries)" = 5 ] || fail "результат в stdout попал в кэш"
+echo "ok: промах при других пикселях"
@@ -0,0 +1,109 @@
+# Общие функции тестов tests/*.sh.
+#
+# Тест запускается как <тест>.sh <программа> <рабочий каталог> [аргументы теста] (цели CTest,
+# см. CMakeLists.txt) и подключает этот файл: . "$(dirname "$0")/common.sh"
+# После подключения текущий каталог - рабочий, аргументы теста остаются в "$@".
+# Изображения создаются тестами из детерминированных узоров, поэтому ожидаемые пиксели
+# можно вычислить в самом тесте (`pattern_value`).
+set -eu
+
+program=$1
+work=$2
+shift 2
+
+mkdir -p "$work"
+cd "$work"
+# Профиль машины пользователя не должен влиять на выбор ядер
+IMAGE_TRANSFORM_PROFILE="$work/profile"
+export IMAGE_TRANSFORM_PROFILE
+
+fail() {
+    echo "ОШИБКА: $*" >&2
+    exit 1
+}
+
+# Беззнаковое целое little-endian из файла: u <файл> <смещение> <байт>
+u() {
+    od -An -t "u$3" -j "$2" -N "$3" "$1" | tr -d ' '
+}
+
+# Три байта из файла в виде "a b c": pixel <файл> <смещение>
+pixel() {
+    od -An -t u1 -j "$2" -N 3 "$1" | tr -s ' ' | sed 's/^ //; s/ $//'
+}
+
+# Записывает байты по смещению, не обрезая файл: put <файл> <смещение> <восьмеричные байты>
+put() {
+    printf "$3" | dd of="$1" bs=1 seek="$2" conv=notrunc status=none
+}
+
+# Выводит 16- и 32-битное целое little-endian: le16 <число>, le32 <число>
+le16() {
+    printf "\\$(printf %03o $(($1 & 255)))\\$(printf %03o $(($1 >> 8 & 255)))"
+}
+le32() {
+    le16 $(($1 & 65535))
+    le16 $(($1 >> 16 & 65535))
+}
+
+# Проверяет, что файлы совпадают побайтно: same <a> <b> <что сравнивается>
+same() {
+    cmp -s "$1" "$2" || fail "$3: '$1' и '$2' различаются"
+}
+
+# Проверяет код завершения программы, скрывая ее вывод: status_is <код> <аргументы программы>...
+status_is() {
+    expected=$1
+    shift
+    set +e
+    "$program" "$@" > /dev/null 2>&1
+    actual=$?
+    set -e
+    [ "$actual" = "$expected" ] || fail "код завершения $actual вместо $expected: $*"
+}
+
+# Значение канала c (0 - r, 1 - g, 2 - b) пикселя (x, y) узора: pattern_value <узор> <x> <y> <c> <ширина> <высота>
+# Узоры: noise - без повторов соседних пикселей, blocks - квадраты 8x8 (серии для QOI),
+# blank - белый фон с пестрым прямоугольником 37x23 (однотонные тайлы для --sparse)
+pattern_value() {
+    case $1 in
+        blocks) echo $((($2 / 8 * 7 + $3 / 8 * 13 + $4 * 61) % 256)) ;;
+        blank) if [ "$2" -ge $(($5 / 3)) ] && [ "$2" -lt $(($5 / 3 + 37)) ] && [ "$3" -ge $(($6 / 2)) ] \
+                  && [ "$3" -lt $(($6 / 2 + 23)) ]; then
+                   echo $((($2 * 7 + $3 * 13 + $4 * 61) % 256))
+               else
+                   echo 255
+               fi ;;
+        *) echo $((($2 * 7 + $3 * 13 + $4 * 61 + $2 * $3 / 3) % 256)) ;;
+    esac
+}
+
+# Выводит отсчеты узора построчно сверху вниз: samples <ширина> <высота> <каналов> <maxval> <узор> [gray]
+# С gray цветовые каналы равны каналу r узора, а при 1-2 каналах цветовой канал один. Каналы после
+# цветовых - альфа. При maxval 65535 отсчеты 16-битные (старший байт первым) и равны
+# 8-битным, умноженным на 257, так что декодер должен получить те же пиксели.
+samples() {
+    LC_ALL=C awk -v w="$1" -v h="$2" -v d="$3" -v m="$4" -v pattern="$5" -v gray="${6:-}" '
+        function value(x, y, c) {
+            if (pattern == "blocks") return (int(x / 8) * 7 + int(y / 8) * 13 + c * 61) % 256
+            if (pattern == "blank") {
+                if (x >= int(w / 3) && x < int(w / 3) + 37 && y >= int(h / 2) && y < int(h / 2) + 23)
+                    return (x * 7 + y * 13 + c * 61) % 256
+                return 255
+            }
+            return (x * 7 + y * 13 + c * 61 + int(x * y / 3)) % 256
+        }
+        BEGIN {
+            colors = gray == "gray" && d < 3 ? 1 : 3
+            for (y = 0; y < h; y++) for (x = 0; x < w; x++) for (c = 0; c < d; c++) {
+                v = c < colors ? value(x, y, gray == "gray" ? 0 : c) : (x + 2 * y) % 256
+                if (m > 255) printf "%c%c", int(v * 257 / 256), v * 257 % 256
+                else printf "%c", v
+            }
+        }'
+}
+
+# Создает 8-битный PPM с узором: ppm <файл> <ширина> <высота> [узор]
+ppm() {
+    { printf 'P6\n%d %d\n255\n' "$2" "$3"; samples "$2" "$3" 3 255 "${4:-noise}"; } > "$1"
+}
@@ -0,0 +1,49 @@
+#!/bin/sh
+# Сравнение изображений: коды завершения --compare и --diff (0 - совпадают, 1 - различаются, 2 - ошибка)
+# и статистика --diff для изображений, различающихся в одном канале одного пикселя.
+. "$(dirname "$0")/common.sh"
+
+ppm source.ppm 40 30
+"$program" --orient none source.ppm same.bmp
+"$program" --orient none source.ppm same.qoi
+# Пиксель (5, 3): канал r узора равен 79, увеличивается на 40
+cp source.ppm changed.ppm
+[ "$(pattern_value noise 5 3 0 40 30)" = 79 ] || fail "узор noise"
+put changed.ppm $((13 + (3 * 40 + 5) * 3)) '\167'
+"$program" --orient cw90 source.ppm turned.bmp
+
+# Формат файла и выравнивание строк не влияют на результат
+status_is 0 --compare source.ppm same.bmp
+status_is 0 --compare same.bmp same.qoi
+status_is 0 --diff source.ppm same.qoi
+status_is 1 --compare source.ppm changed.ppm
+status_is 1 --diff same.bmp changed.ppm
+status_is 1 --compare source.ppm turned.bmp
+status_is 1 --diff source.ppm turned.bmp
+echo "ok: совпадение и различие"
+
+# Ошибка чтения и неверное количество путей
+printf 'P6\n40 30\n255\n' > truncated.ppm
+status_is 2 --compare source.ppm missing.bmp
+status_is 2 --compare missing.bmp source.ppm
+status_is 2 --diff source.ppm truncated.ppm
+status_is 2 --compare source.ppm
+status_is 2 --compare source.ppm same.bmp same.qoi
+echo "ok: ошибки"
+
+# Статистика: 1 из 1200 пикселей, разность 40, MSE = 40^2 / (1200 * 3)
+"$program" --diff source.ppm changed.ppm > diff.txt || true
+cat > expected.txt <<EOF
+различающихся пикселей: 1 из 1200 (0.0833%)
+наибольшая разность канала: 40
+MSE: 0.444444
+PSNR: 51.65 дБ
+EOF
+same expected.txt diff.txt "вывод --diff"
+"$program" --diff source.ppm same.bmp > diff.txt
+printf 'различающихся пикселей: 0 из 1200 (0.0000%%)\nнаибольшая разность канала: 0\nMSE: 0.000000\nPSNR: inf\n' \
+    > expected.txt
+same expected.txt diff.txt "вывод --diff для совпадающих"
+"$program" --diff source.ppm turned.bmp > diff.txt || true
+[ "$(cat diff.txt)" = "размеры различаются: 40x30 и 30x40" ] || fail "вывод --diff для разных размеров"
+echo "ok: статистика --diff"
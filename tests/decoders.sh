@@ -0,0 +1,97 @@
+#!/bin/sh
+# Декодеры входных форматов: PGM, PPM и PAM с 8- и 16-битными отсчетами, BMP со строками сверху вниз
+# и 32-битный BMP с масками каналов дают те же пиксели, что и эталонный 8-битный PPM.
+. "$(dirname "$0")/common.sh"
+
+width=37                                # Нечетная ширина: строки 24-битного BMP дополняются до 4 байт
+height=19
+ppm color.ppm $width $height
+{ printf 'P6\n%d %d\n255\n' $width $height; samples $width $height 3 255 noise gray; } > gray.ppm
+
+# Заголовок PAM: pam <ширина> <высота> <каналов> <maxval> <тип кортежа>
+pam() {
+    printf 'P7\nWIDTH %d\nHEIGHT %d\nDEPTH %d\nMAXVAL %d\nTUPLTYPE %s\nENDHDR\n' "$@"
+}
+
+# PPM и PGM: 16-битные отсчеты (v * 257) и комментарий в заголовке
+{ printf 'P6\n# 16 бит\n%d %d\n65535\n' $width $height; samples $width $height 3 65535 noise; } > color16.ppm
+{ printf 'P5\n%d %d\n255\n' $width $height; samples $width $height 1 255 noise gray; } > gray.pgm
+{ printf 'P5\n%d %d\n65535\n' $width $height; samples $width $height 1 65535 noise gray; } > gray16.pgm
+status_is 0 --compare color.ppm color16.ppm
+for name in gray.pgm gray16.pgm; do
+    status_is 0 --compare gray.ppm $name
+done
+# Отсчеты с другим maxval приводятся к 0..255 с округлением
+printf 'P5\n4 1\n3\n\000\001\002\003' > scaled.pgm
+"$program" --orient none scaled.pgm scaled.bmp
+[ "$(pixel scaled.bmp 54) $(pixel scaled.bmp 57)" = "0 0 0 85 85 85" ] || fail "масштабирование maxval 3"
+[ "$(pixel scaled.bmp 60) $(pixel scaled.bmp 63)" = "170 170 170 255 255 255" ] || fail "масштабирование maxval 3"
+echo "ok: PPM и PGM"
+
+# PAM: альфа-канал отбрасывается, один канал (с альфой или без) - оттенки серого
+{ pam $width $height 3 255 RGB; samples $width $height 3 255 noise; } > rgb.pam
+{ pam $width $height 4 255 RGB_ALPHA; samples $width $height 4 255 noise; } > rgba.pam
+{ pam $width $height 4 65535 RGB_ALPHA; samples $width $height 4 65535 noise; } > rgba16.pam
+{ pam $width $height 1 255 GRAYSCALE; samples $width $height 1 255 noise gray; } > gray.pam
+{ pam $width $height 2 65535 GRAYSCALE_ALPHA; samples $width $height 2 65535 noise gray; } > graya16.pam
+for name in rgb.pam rgba.pam rgba16.pam; do
+    status_is 0 --compare color.ppm $name
+done
+for name in gray.pam graya16.pam; do
+    status_is 0 --compare gray.ppm $name
+done
+# Больше четырех каналов не поддерживается
+{ pam $width $height 5 255 RGB_ALPHA; samples $width $height 5 255 noise; } > depth5.pam
+status_is 2 --compare color.ppm depth5.pam
+echo "ok: PAM"
+
+# Создает BMP с узором noise: bmp <файл> <бит на пиксель> <сверху вниз: 0 или 1> <маски: 0 или 1>
+# Четвертый байт 32-битного пикселя заполнен мусором: декодер должен его отбрасывать.
+bmp() {
+    pixel_size=$(($2 / 8))
+    row=$(((width * pixel_size + 3) / 4 * 4))
+    offset=$((54 + $4 * 12))
+    rows=$height
+    [ "$3" = 1 ] && rows=$((-height))
+    {
+        printf 'BM'; le32 $((offset + row * height)); le32 0; le32 $offset
+        le32 40; le32 $width; le32 $rows; le16 1; le16 "$2"; le32 $((3 * $4)); le32 $((row * height))
+        le32 0; le32 0; le32 0; le32 0
+        [ "$4" = 1 ] && { le32 16711680; le32 65280; le32 255; }
+        LC_ALL=C awk -v w=$width -v h=$height -v size=$pixel_size -v row=$row -v top="$3" '
+            function value(x, y, c) { return (x * 7 + y * 13 + c * 61 + int(x * y / 3)) % 256 }
+            BEGIN {
+                for (i = 0; i < h; i++) {
+                    y = top == 1 ? i : h - 1 - i
+                    for (x = 0; x < w; x++) {
+                        printf "%c%c%c", value(x, y, 2), value(x, y, 1), value(x, y, 0)
+                        if (size == 4) printf "%c", 170
+                    }
+                    for (p = w * size; p < row; p++) printf "%c", 0
+                }
+            }'
+    } > "$1"
+}
+bmp bottom24.bmp 24 0 0
+bmp top24.bmp 24 1 0
+bmp bottom32.bmp 32 0 0
+bmp top32.bmp 32 1 0
+bmp fields32.bmp 32 0 1
+bmp top_fields32.bmp 32 1 1
+"$program" --orient none color.ppm written.bmp
+same written.bmp bottom24.bmp "BMP, созданный тестом и программой"
+for name in top24 bottom32 top32 fields32 top_fields32; do
+    status_is 0 --compare color.ppm $name.bmp
+    # Запись всегда 24-битная снизу вверх
+    "$program" --orient none $name.bmp $name.out.bmp
+    same written.bmp $name.out.bmp "$name.bmp после перезаписи"
+done
+# Поворот читает строки файла в другом порядке
+"$program" --orient cw90 color.ppm turned.bmp
+"$program" --orient cw90 top_fields32.bmp top_turned.bmp
+same turned.bmp top_turned.bmp "поворот BMP со строками сверху вниз"
+# Маски, отличные от BGRX, не поддерживаются
+cp fields32.bmp rgbx32.bmp
+put rgbx32.bmp 54 '\000\000\000\377'
+status_is 2 --compare color.ppm rgbx32.bmp
+echo "ok: BMP сверху вниз и с масками"
@@ -0,0 +1,94 @@
+#!/bin/sh
+# Проверка изображений больше 4 ГиБ: 64-битные смещения при чтении BMP, запись BMP с нулевыми полями
+# размеров и запись BigTIFF.
+#
+# Запуск: large_files.sh <программа> <рабочий каталог>  (цель CTest large_files при
+# -DIMAGE_TRANSFORM_LARGE_TESTS=ON, метка large)
+# Исходный BMP 40000x36000 (4.3 ГБ пиксельных данных) создается разреженным через truncate, в него
+# записываются несколько известных пикселей. Результаты пишутся через --out-of-core, так что
+# программа не держит изображение в памяти; на диске нужно около 9 ГБ свободного места.
+. "$(dirname "$0")/common.sh"
+
+width=40000
+height=36000
+row=$((width * 3))                      # Строка без выравнивания: 120000 делится на 4
+data=$((row * height))                  # 4320000000 > 4 ГиБ
+
+rm -f source.bmp crop.bmp copy.bmp big.tif
+
+# Заголовок 54 байта: BI_RGB, 24 бита, снизу вверх; bfileSize и biSizeImage равны 0, как у файлов больше 4 ГиБ
+{
+    printf 'BM'; le32 0; le32 0; le32 54
+    le32 40; le32 $width; le32 $height; printf '\001\000\030\000'; le32 0; le32 0
+    le32 2835; le32 2835; le32 0; le32 0
+} > source.bmp
+truncate -s $((54 + data)) source.bmp
+
+# Смещение пикселя (x, y) в исходном файле: строки хранятся снизу вверх
+source_offset() {
+    echo $((54 + (height - 1 - $2) * row + $1 * 3))
+}
+put source.bmp "$(source_offset 0 0)" '\001\002\003'
+put source.bmp "$(source_offset 39999 0)" '\004\005\006'                 # Последние байты файла
+put source.bmp "$(source_offset 20000 100)" '\007\010\011'
+put source.bmp "$(source_offset 0 35999)" '\012\013\014'                 # Первый пиксель данных
+
+# 1. Вырезание у конца файла: смещения чтения больше 4 ГиБ
+"$program" --orient none --crop 39990,0,10,10 source.bmp crop.bmp
+[ "$(u crop.bmp 18 4)" = 10 ] && [ "$(u crop.bmp 22 4)" = 10 ] || fail "размер вырезанной области"
+crop_row=32                                                              # 30 байт с выравниванием до 4
+[ "$(pixel crop.bmp $((54 + 9 * crop_row + 27)))" = "4 5 6" ] || fail "пиксель (39999, 0) вырезанной области"
+[ "$(pixel crop.bmp $((54 + 9 * crop_row)))" = "0 0 0" ] || fail "пиксель (39990, 0) вырезанной области"
+cat source.bmp | "$program" --orient none --crop 39990,0,10,10 - crop.bmp   # Последовательное чтение канала
+[ "$(pixel crop.bmp $((54 + 9 * crop_row + 27)))" = "4 5 6" ] || fail "пиксель (39999, 0) вырезанной из канала области"
+echo "ok: вырезание у конца файла"
+
+# 2. BigTIFF: 64-битные смещения полос
+"$program" --orient none --out-of-core 64 --format tiff source.bmp big.tif
+[ "$(u big.tif 2 2)" = 43 ] && [ "$(u big.tif 4 2)" = 8 ] || fail "заголовок BigTIFF"
+ifd=$(u big.tif 8 8)
+entries=$(u big.tif "$ifd" 8)
+strips=0; offsets=0; rows_per_strip=0; tiff_width=0; tiff_height=0
+i=0
+while [ $i -lt "$entries" ]; do
+    entry=$((ifd + 8 + i * 20))
+    case $(u big.tif $entry 2) in
+        256) tiff_width=$(u big.tif $((entry + 12)) 4) ;;
+        257) tiff_height=$(u big.tif $((entry + 12)) 4) ;;
+        273) [ "$(u big.tif $((entry + 2)) 2)" = 16 ] || fail "тип смещений полос не LONG8"
+             strips=$(u big.tif $((entry + 4)) 8); offsets=$(u big.tif $((entry + 12)) 8) ;;
+        278) rows_per_strip=$(u big.tif $((entry + 12)) 4) ;;
+    esac
+    i=$((i + 1))
+done
+[ "$tiff_width" = $width ] && [ "$tiff_height" = $height ] || fail "размер BigTIFF ${tiff_width}x${tiff_height}"
+[ "$strips" = $(((height + rows_per_strip - 1) / rows_per_strip)) ] || fail "количество полос $strips"
+last_strip=$(u big.tif $((offsets + (strips - 1) * 8)) 8)
+[ "$last_strip" -gt 4294967295 ] || fail "смещение последней полосы $last_strip меньше 4 ГиБ"
+
+# Смещение пикселя (x, y) в BigTIFF: строки сверху вниз, каналы в порядке RGB
+tiff_offset() {
+    strip=$(u big.tif $((offsets + $2 / rows_per_strip * 8)) 8)
+    echo $((strip + $2 % rows_per_strip * row + $1 * 3))
+}
+[ "$(pixel big.tif "$(tiff_offset 0 0)")" = "3 2 1" ] || fail "пиксель BigTIFF (0, 0)"
+[ "$(pixel big.tif "$(tiff_offset 39999 0)")" = "6 5 4" ] || fail "пиксель BigTIFF (39999, 0)"
+[ "$(pixel big.tif "$(tiff_offset 20000 100)")" = "9 8 7" ] || fail "пиксель BigTIFF (20000, 100)"
+[ "$(pixel big.tif "$(tiff_offset 0 35999)")" = "12 11 10" ] || fail "пиксель BigTIFF (0, 35999)"
+[ "$(pixel big.tif "$(tiff_offset 1 35999)")" = "0 0 0" ] || fail "пиксель BigTIFF (1, 35999)"
+rm -f big.tif
+echo "ok: BigTIFF"
+
+# 3. BMP больше 4 ГиБ: поля размеров записываются нулями, размер файла вычисляется по ширине и высоте
+"$program" --out-of-core 64 --orient 180 source.bmp copy.bmp
+[ "$(u copy.bmp 2 4)" = 0 ] && [ "$(u copy.bmp 34 4)" = 0 ] || fail "поля размеров BMP не нулевые"
+[ "$(u copy.bmp 18 4)" = $width ] && [ "$(u copy.bmp 22 4)" = $height ] || fail "размер BMP"
+[ "$(wc -c < copy.bmp | tr -d ' ')" = $((54 + data)) ] || fail "размер файла BMP"
+# После поворота на 180 градусов пиксель (x, y) переходит в (width - 1 - x, height - 1 - y)
+[ "$(pixel copy.bmp "$(source_offset 39999 35999)")" = "1 2 3" ] || fail "пиксель BMP (39999, 35999)"
+[ "$(pixel copy.bmp "$(source_offset 0 35999)")" = "4 5 6" ] || fail "пиксель BMP (0, 35999)"
+[ "$(pixel copy.bmp "$(source_offset 19999 35899)")" = "7 8 9" ] || fail "пиксель BMP (19999, 35899)"
+[ "$(pixel copy.bmp "$(source_offset 39999 0)")" = "10 11 12" ] || fail "пиксель BMP (39999, 0)"
+echo "ok: BMP больше 4 ГиБ"
+
+rm -f source.bmp crop.bmp copy.bmp
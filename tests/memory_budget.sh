@@ -0,0 +1,62 @@
+#!/bin/sh
+# Бюджет памяти (--memory-budget): изображение больше бюджета обрабатывается через временный файл,
+# а если это невозможно - в памяти с предупреждением; результаты совпадают с запуском без бюджета,
+# а пик памяти буферов по отчету не превышает бюджета.
+. "$(dirname "$0")/common.sh"
+
+# 900x800 - около 2 МиБ пикселей: больше бюджета в 1 МиБ
+ppm big.ppm 900 800
+"$program" --orient none big.ppm big.bmp
+
+# Проверяет отчет о памяти: within_budget <файл stderr> <бюджет в МиБ>
+within_budget() {
+    peak=$(sed -n "s/^# память: пик буферов \([0-9.]*\) МиБ при бюджете $2.0 МиБ.*/\1/p" "$1")
+    [ -n "$peak" ] || fail "нет отчета о памяти: $(cat "$1")"
+    awk -v peak="$peak" -v budget="$2" 'BEGIN { exit !(peak <= budget) }' || fail "пик буферов $peak МиБ при бюджете $2 МиБ"
+}
+
+# Сравнивает результат под бюджетом с результатом без бюджета: check <бюджет> <имя результата> <параметры>...
+check() {
+    budget=$1
+    name=$2
+    shift 2
+    "$program" "$@" big.bmp free.$name
+    "$program" --memory-budget $budget "$@" big.bmp budget.$name 2> memory.txt
+    same free.$name budget.$name "--memory-budget $budget $*"
+    within_budget memory.txt $budget
+    ! grep -q '^Предупреждение' memory.txt || fail "предупреждение при --memory-budget $budget $*: $(cat memory.txt)"
+}
+
+check 1 bmp --orient cw90
+check 1 bmp --crop 100,50,700,600 --invert --orient transpose
+check 1 tiff --orient 180 --grayscale
+check 8 bmp --orient cw90 --sharpen 1
+echo "ok: один результат"
+
+# Уменьшение и QOI недоступны через временный файл: изображение обрабатывается в памяти с предупреждением
+for options in "--resize 300x0" "--orient cw90 --format qoi"; do
+    "$program" $options big.bmp free.out
+    "$program" --memory-budget 1 $options big.bmp budget.out 2> memory.txt
+    same free.out budget.out "--memory-budget 1 $options"
+    grep -q "^Предупреждение: изображению 'big.bmp' нужно около" memory.txt || fail "нет предупреждения: $options"
+done
+echo "ok: обработка в памяти сверх бюджета"
+
+# Несколько результатов из одного чтения: через временный файл при бюджете 1 МиБ и в памяти при 8 МиБ
+"$program" big.bmp --orient cw90 free1.bmp --orient 180 --invert free2.tiff
+for budget in 1 8; do
+    "$program" --memory-budget $budget big.bmp --orient cw90 fan1.bmp --orient 180 --invert fan2.tiff 2> memory.txt
+    same free1.bmp fan1.bmp "несколько результатов при бюджете $budget МиБ"
+    same free2.tiff fan2.tiff "несколько результатов при бюджете $budget МиБ"
+    within_budget memory.txt $budget
+done
+echo "ok: несколько результатов"
+
+# Пакет из заданий, каждое из которых больше бюджета
+printf -- '--orient cw90 big.bmp batch1.bmp\n--orient 180 --invert big.bmp batch2.tiff\n' > jobs.txt
+"$program" --batch jobs.txt --workers 2 --memory-budget 1 > report.txt 2> memory.txt
+grep -q '^# заданий 2, ошибок 0,' report.txt || fail "итог пакета: $(cat report.txt)"
+same free1.bmp batch1.bmp "задание пакета при бюджете 1 МиБ"
+same free2.tiff batch2.tiff "задание пакета при бюджете 1 МиБ"
+within_budget memory.txt 1
+echo "ok: пакет"
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Обработка через временный файл: результат --out-of-core побайтно совпадает с обработкой в памяти
+# для всех ориентаций, вырезания и цветовых операций, в BMP и TIFF.
+. "$(dirname "$0")/common.sh"
+
+# 800x700 - около 1,6 МиБ пикселей: больше кэша тайлов в 1 МиБ, поэтому тайлы вытесняются и читаются повторно
+ppm source.ppm 800 700
+"$program" --orient none source.ppm source.bmp
+
+# Сравнивает результат в памяти и через временный файл: check <имя результата> <параметры>...
+check() {
+    name=$1
+    shift
+    "$program" "$@" source.bmp memory.$name
+    "$program" --out-of-core 1 "$@" source.bmp disk.$name
+    same memory.$name disk.$name "--out-of-core $*"
+}
+
+for orientation in none ccw90 180 cw90 flip-h flip-v transpose transverse; do
+    check bmp --orient $orientation
+done
+echo "ok: смена ориентации"
+
+check bmp --crop 13,7,501,333 --orient cw90
+check bmp --crop 100,650,700,50 --orient transverse
+check bmp --invert --brightness 20 --orient 180
+check bmp --grayscale --gamma 1.8 --crop 1,1,798,698
+echo "ok: вырезание и цвет"
+
+check tiff --orient cw90
+check tiff --crop 50,40,333,222 --invert
+# Количество потоков не влияет на результат
+"$program" --out-of-core 1 --threads 3 --orient transpose source.bmp threads.bmp
+check bmp --orient transpose
+same memory.bmp threads.bmp "--out-of-core в 3 потока"
+echo "ok: TIFF и потоки"
@@ -0,0 +1,63 @@
+#!/bin/sh
+# Неинициализированные буферы: программа, собранная с BUFFER_POISON (буферы заполнены байтом 0xA5, см. buffer.c),
+# дает те же байты, что и обычная, для всех производителей буферов без обнуления - чтения, смены ориентации,
+# уменьшения, изменения размера и фильтров. Незаписанный пиксель проявился бы как различие.
+# Запуск: poison.sh <программа> <рабочий каталог> <программа с BUFFER_POISON>
+. "$(dirname "$0")/common.sh"
+
+poisoned=$1
+
+# Нечетные размеры: неполные тайлы, полосы потоков и строки BMP с выравниванием
+ppm noise.ppm 211 97
+ppm blank.ppm 300 200 blank
+"$program" --orient none noise.ppm noise.bmp
+"$program" --orient none noise.ppm noise.qoi
+
+# Сравнивает результаты обеих программ: check <имя результата> <аргументы>...
+# В аргументах OUT заменяется путем результата
+check() {
+    name=$1
+    shift
+    normal=""
+    poison=""
+    for arg in "$@"; do
+        case $arg in
+            OUT*) normal="$normal normal${arg#OUT}"; poison="$poison poison${arg#OUT}" ;;
+            *) normal="$normal $arg"; poison="$poison $arg" ;;
+        esac
+    done
+    "$program" $normal
+    "$poisoned" $poison
+    for result in $normal; do
+        case $result in
+            normal*) same "$result" "poison${result#normal}" "$name" ;;
+        esac
+    done
+}
+
+for source in noise.ppm noise.bmp noise.qoi; do
+    for orientation in none ccw90 180 cw90 flip-h flip-v transpose transverse; do
+        check "$orientation из $source" --orient $orientation $source OUT.bmp
+    done
+done
+echo "ok: чтение и смена ориентации"
+
+for threads in 1 3; do
+    for options in "--crop 7,5,150,61" "--shrink 3" "--shrink 2 --crop 1,1,200,90" "--resize 100x0" \
+                   "--resize 333x150 --filter bilinear" "--resize 90x40 --filter lanczos" \
+                   "--blur 2" "--gaussian 1.5" "--sharpen 1,1,4" "--grayscale --invert --gamma 0.7"; do
+        check "$options в $threads потоков" --threads $threads $options --orient cw90 noise.ppm OUT.bmp
+    done
+done
+echo "ok: вырезание, уменьшение, изменение размера и фильтры"
+
+check "QOI" --orient 180 noise.ppm OUT.qoi
+check "TIFF" --orient transpose noise.ppm OUT.tiff
+check "--sparse" --sparse --orient cw90 blank.ppm OUT.bmp
+check "несколько результатов" noise.ppm --orient cw90 OUT1.bmp --orient 180 --invert OUT2.tiff --resize 50x0 OUT3.qoi
+check "--out-of-core" --out-of-core 1 --orient cw90 --crop 3,3,200,90 noise.bmp OUT.bmp
+cat noise.bmp | "$program" --orient ccw90 - normal.pipe.bmp
+cat noise.bmp | "$poisoned" --orient ccw90 - poison.pipe.bmp
+same normal.pipe.bmp poison.pipe.bmp "чтение из канала"
+"$poisoned" --compare noise.ppm noise.bmp || fail "--compare с BUFFER_POISON"
+echo "ok: форматы и режимы"
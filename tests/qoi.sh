@@ -0,0 +1,41 @@
+#!/bin/sh
+# Запись и чтение QOI: результат читается обратно без потерь, заголовок и маркер конца соответствуют
+# формату, а параллельное кодирование полосами дает те же байты, что и однопоточное.
+. "$(dirname "$0")/common.sh"
+
+# Выводит байты файла в десятичном виде через пробел: bytes <файл> <смещение> <количество>
+bytes() {
+    od -An -t u1 -j "$2" -N "$3" "$1" | tr -s ' \n' '  ' | sed 's/^ //; s/ $//'
+}
+
+# Пестрый узор кодируется в основном цветами целиком, квадраты - сериями и ссылками на таблицу цветов.
+# Квадраты 640x512 больше одной полосы параллельного кодирования (256 Кпикс)
+ppm noise.ppm 123 77 noise
+ppm blocks.ppm 640 512 blocks
+for name in noise blocks; do
+    "$program" --orient none $name.ppm $name.qoi
+    status_is 0 --compare $name.ppm $name.qoi
+    "$program" --orient none $name.ppm $name.bmp
+    "$program" --orient none $name.qoi back.bmp
+    same $name.bmp back.bmp "BMP из $name.qoi"
+done
+[ "$(wc -c < blocks.qoi)" -lt $((640 * 512)) ] || fail "квадраты не сжаты"
+echo "ok: QOI читается без потерь"
+
+# Заголовок: "qoif", ширина и высота big-endian, 3 канала, sRGB; в конце 7 нулей и 1
+[ "$(bytes noise.qoi 0 14)" = "113 111 105 102 0 0 0 123 0 0 0 77 3 0" ] || fail "заголовок QOI"
+size=$(wc -c < noise.qoi)
+[ "$(bytes noise.qoi $((size - 8)) 8)" = "0 0 0 0 0 0 0 1" ] || fail "маркер конца QOI"
+echo "ok: заголовок и маркер конца"
+
+# Смена ориентации при записи QOI и разбивка на полосы не зависят от количества потоков
+"$program" --threads 1 --orient cw90 blocks.ppm one.qoi
+"$program" --threads 4 --orient cw90 blocks.ppm four.qoi
+same one.qoi four.qoi "QOI в 1 и 4 потока"
+"$program" --orient cw90 blocks.bmp turned.bmp
+"$program" --orient none four.qoi turned_back.bmp
+same turned.bmp turned_back.bmp "повернутый QOI"
+# Формат задается и параметром, независимо от расширения
+"$program" --orient none --format qoi noise.ppm forced.bin
+same noise.qoi forced.bin "--format qoi"
+echo "ok: параллельное кодирование"
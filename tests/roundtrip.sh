@@ -0,0 +1,72 @@
+#!/bin/sh
+# Чтение и запись BMP и TIFF, смена ориентации и каналы: обратимые преобразования возвращают
+# исходные байты, а пиксели результата совпадают с узором исходного изображения.
+. "$(dirname "$0")/common.sh"
+
+width=173                               # Нечетная ширина: строки BMP дополняются до 4 байт
+height=91
+ppm source.ppm $width $height
+"$program" --orient none source.ppm copy.bmp
+status_is 0 --compare source.ppm copy.bmp
+[ "$(u copy.bmp 18 4)" = $width ] && [ "$(u copy.bmp 22 4)" = $height ] || fail "размер BMP"
+row=$(((width * 3 + 3) / 4 * 4))
+# BMP хранит строки снизу вверх и каналы в порядке BGR
+for point in "0 0" "172 0" "5 90" "100 45"; do
+    set -- $point
+    expected="$(pattern_value noise $1 $2 2 $width $height) $(pattern_value noise $1 $2 1 $width $height)"
+    expected="$expected $(pattern_value noise $1 $2 0 $width $height)"
+    [ "$(pixel copy.bmp $((54 + (height - 1 - $2) * row + $1 * 3)))" = "$expected" ] || fail "пиксель BMP ($1, $2)"
+done
+echo "ok: запись BMP"
+
+# Четыре поворота на 90 градусов и двойные отражения возвращают исходный файл
+cp copy.bmp turned0.bmp
+for i in 1 2 3 4; do
+    "$program" --orient cw90 turned$((i - 1)).bmp turned$i.bmp
+done
+[ "$(u turned1.bmp 18 4)" = $height ] || fail "ширина после поворота"
+same copy.bmp turned4.bmp "четыре поворота cw90"
+for orientation in 180 flip-h flip-v transpose; do
+    "$program" --orient $orientation copy.bmp once.bmp
+    "$program" --orient $orientation once.bmp twice.bmp
+    same copy.bmp twice.bmp "двойное $orientation"
+done
+"$program" --orient cw90 copy.bmp cw.bmp
+"$program" --orient ccw90 cw.bmp back.bmp
+same copy.bmp back.bmp "cw90 и ccw90"
+# Поворот по умолчанию - на 90 градусов против часовой стрелки
+"$program" copy.bmp default.bmp
+"$program" --orient ccw90 copy.bmp ccw.bmp
+same default.bmp ccw.bmp "ориентация по умолчанию"
+echo "ok: смена ориентации"
+
+# Стандартные потоки: результат через канал совпадает с записью в файл
+cat copy.bmp | "$program" --orient cw90 - - > piped.bmp
+same cw.bmp piped.bmp "чтение и запись через канал"
+echo "ok: стандартные потоки"
+
+# Классический TIFF: заголовок, размеры и пиксели в порядке RGB сверху вниз
+"$program" --orient none source.ppm copy.tiff
+[ "$(u copy.tiff 0 2)" = 18761 ] && [ "$(u copy.tiff 2 2)" = 42 ] || fail "заголовок TIFF"
+ifd=$(u copy.tiff 4 4)
+entries=$(u copy.tiff "$ifd" 2)
+strip=0; tiff_width=0; tiff_height=0
+i=0
+while [ $i -lt "$entries" ]; do
+    entry=$((ifd + 2 + i * 12))
+    case $(u copy.tiff $entry 2) in
+        256) tiff_width=$(u copy.tiff $((entry + 8)) 4) ;;
+        257) tiff_height=$(u copy.tiff $((entry + 8)) 4) ;;
+        273) [ "$(u copy.tiff $((entry + 4)) 4)" = 1 ] || fail "ожидалась одна полоса"
+             strip=$(u copy.tiff $((entry + 8)) 4) ;;
+    esac
+    i=$((i + 1))
+done
+[ "$tiff_width" = $width ] && [ "$tiff_height" = $height ] || fail "размер TIFF ${tiff_width}x${tiff_height}"
+for point in "0 0" "172 90"; do
+    set -- $point
+    expected="$(pattern_value noise $1 $2 0 $width $height) $(pattern_value noise $1 $2 1 $width $height)"
+    expected="$expected $(pattern_value noise $1 $2 2 $width $height)"
+    [ "$(pixel copy.tiff $((strip + ($2 * width + $1) * 3)))" = "$expected" ] || fail "пиксель TIFF ($1, $2)"
+done
+echo "ok: запись TIFF"
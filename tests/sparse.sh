@@ -0,0 +1,51 @@
+#!/bin/sh
+# Однотонные тайлы (--sparse): результат побайтно совпадает с обычной сменой ориентации при любых
+# ориентациях, размерах тайла, количестве потоков, цветовых операциях и нескольких результатах.
+. "$(dirname "$0")/common.sh"
+
+# Белый фон с пестрым прямоугольником: почти все тайлы однотонные, прямоугольник задевает несколько тайлов.
+# Квадраты 8x8 при тайле 8 однотонны все, при тайле 12 - ни один.
+ppm blank.ppm 1000 700 blank
+ppm blocks.ppm 256 200 blocks
+ppm noise.ppm 123 77 noise
+
+# Сравнивает результат с --sparse и без: check <источник> <параметры>...
+check() {
+    source=$1
+    shift
+    "$program" "$@" $source dense.bmp
+    "$program" --sparse "$@" $source sparse.bmp
+    same dense.bmp sparse.bmp "--sparse $* $source"
+}
+
+for orientation in none ccw90 180 cw90 flip-h flip-v transpose transverse; do
+    check blank.ppm --orient $orientation
+done
+echo "ok: смена ориентации"
+
+for tile in 8 12 64 100; do
+    check blank.ppm --tile $tile --orient cw90
+    check blocks.ppm --tile $tile --orient transpose
+done
+check noise.ppm --orient 180
+for threads in 1 3; do
+    check blank.ppm --threads $threads --orient ccw90
+    check blocks.ppm --threads $threads --tile 8 --orient flip-h
+done
+echo "ok: размеры тайлов и потоки"
+
+# Цветовые операции применяются и к цвету однотонных тайлов
+check blank.ppm --invert --orient cw90
+check blocks.ppm --tile 8 --grayscale --brightness -30 --orient 180
+# Операции, при которых тайлы не ищутся, дают обычный результат
+check blank.ppm --crop 300,300,200,100 --orient cw90
+check blank.ppm --resize 500x0 --orient cw90
+echo "ok: цвет"
+
+# Несколько результатов из одного чтения, TIFF и QOI
+"$program" blank.ppm --orient cw90 fan1.bmp --orient 180 --invert fan2.tiff --orient none fan3.qoi
+"$program" --sparse blank.ppm --orient cw90 sparse1.bmp --orient 180 --invert sparse2.tiff --orient none sparse3.qoi
+same fan1.bmp sparse1.bmp "несколько результатов с --sparse (BMP)"
+same fan2.tiff sparse2.tiff "несколько результатов с --sparse (TIFF)"
+same fan3.qoi sparse3.qoi "несколько результатов с --sparse (QOI)"
+echo "ok: несколько результатов"
@@ -0,0 +1,66 @@
+#!/bin/sh
+# Статистика --stats: минимум, максимум, среднее и гистограммы каналов известного изображения,
+# независимость от формата, ориентации и потоков, учет --crop и вывод в stderr при записи в stdout.
+. "$(dirname "$0")/common.sh"
+
+# Выводит строку гистограммы: histogram <канал> [<значение> <количество>]...
+histogram() {
+    channel=$1
+    shift
+    LC_ALL=C awk -v channel="$channel" -v bins="$*" 'BEGIN {
+        n = split(bins, list, " ")
+        for (i = 1; i < n; i += 2) count[list[i]] += list[i + 1]
+        printf "гистограмма %s:", channel
+        for (v = 0; v < 256; v++) printf " %d", count[v]
+        printf "\n"
+    }'
+}
+
+# Пиксели 2x2 (r g b): (0 1 2), (255 128 64) / (8 8 8), (255 255 255)
+printf 'P6\n2 2\n255\n\000\001\002\377\200\100\010\010\010\377\377\377' > known.ppm
+{
+    echo "# статистика исходных пикселей: 4 пикселей"
+    echo "r: мин 0, макс 255, среднее 129.500"
+    echo "g: мин 1, макс 255, среднее 98.000"
+    echo "b: мин 2, макс 255, среднее 82.250"
+    histogram r 0 1 8 1 255 2
+    histogram g 1 1 8 1 128 1 255 1
+    histogram b 2 1 8 1 64 1 255 1
+} > expected.txt
+"$program" --stats known.ppm known.bmp > stats.txt
+same expected.txt stats.txt "статистика 2x2"
+# Формат источника и ориентация результата не влияют, статистика собирается до уменьшения
+"$program" --orient none known.ppm known.qoi
+for options in "--orient 180" "--orient transpose --invert" "--shrink 2"; do
+    "$program" --stats $options known.qoi result.bmp > stats.txt
+    same expected.txt stats.txt "статистика с $options"
+done
+echo "ok: известное изображение"
+
+# С --crop учитываются только прочитанные пиксели: правый столбец (255 128 64), (255 255 255)
+{
+    echo "# статистика исходных пикселей: 2 пикселей"
+    echo "r: мин 255, макс 255, среднее 255.000"
+    echo "g: мин 128, макс 255, среднее 191.500"
+    echo "b: мин 64, макс 255, среднее 159.500"
+    histogram r 255 2
+    histogram g 128 1 255 1
+    histogram b 64 1 255 1
+} > expected.txt
+"$program" --stats --crop 1,0,1,2 known.ppm crop.bmp > stats.txt
+same expected.txt stats.txt "статистика с --crop"
+# При записи результата в stdout статистика выводится в stderr
+"$program" --stats --crop 1,0,1,2 known.ppm - > piped.bmp 2> stats.txt
+same expected.txt stats.txt "статистика в stderr"
+same crop.bmp piped.bmp "результат с --stats в stdout"
+echo "ok: --crop и stdout"
+
+# Суммы гистограмм равны числу пикселей, а статистика не зависит от количества потоков
+ppm noise.ppm 301 203
+"$program" --stats --threads 1 noise.ppm one.bmp > one.txt
+"$program" --stats --threads 3 noise.ppm three.bmp > three.txt
+same one.txt three.txt "статистика в 1 и 3 потока"
+[ "$(head -n 1 one.txt)" = "# статистика исходных пикселей: 61103 пикселей" ] || fail "количество пикселей"
+sums=$(awk '/^гистограмма/ { s = 0; for (i = 3; i <= NF; i++) s += $i; printf "%d ", s }' one.txt)
+[ "$sums" = "61103 61103 61103 " ] || fail "суммы гистограмм: $sums"
+echo "ok: потоки"